@@ -0,0 +1,719 @@
+#include "BenchmarkApp.h"
+
+#include <stdexcept> //std::runtime_error
+#include <iostream> //cout
+#include <fstream>
+#include <sstream>
+#include <iomanip>  //setprecision
+#include <array>
+#include <chrono>
+#include <cmath>    //ceil, sqrt
+#include <cstring>  //strcmp
+
+//Shared
+#include "Shin/Utilities/Macros.h"
+#include "Shin/Vertex/ColorVertex.h"
+#include "Shin/Vertex/TextureVertex.h"
+#include "Shin/Mesh.h"
+#include "Shin/Texture.h"
+#include "Shin/DrawPipeline.h"
+#include "Shin/Profiler.h"
+
+VkAllocationCallbacks* g_allocator = nullptr; //Always use default allocator
+
+const std::vector<const char*> g_requiredVulkanLayers = {
+    "VK_LAYER_KHRONOS_validation"
+};
+
+//Headless: no surface extensions
+const std::vector<const char*> g_requiredInstanceExtensions = {
+#ifdef ENABLE_VULKAN_DEBUG
+    VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
+#endif
+};
+
+const std::vector<ColorVertex> g_colorVertices = {
+    {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
+    {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
+    {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}},
+    {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}},
+};
+
+const std::vector<TextureVertex> g_texVertices = {
+    {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+    {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
+    {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
+    {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f}}
+};
+
+const std::vector<uint16_t> g_indices = {
+    0, 1, 2, 2, 3, 0,
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+BenchmarkApp::BenchmarkApp()
+    : m_instance(VK_NULL_HANDLE), m_physicalDevice(VK_NULL_HANDLE), m_logicalDevice(VK_NULL_HANDLE)
+    , m_texDescriptorSetLayout(VK_NULL_HANDLE), m_colorDescriptorSetLayout(VK_NULL_HANDLE)
+    , m_descriptorPool(VK_NULL_HANDLE), m_commandPool(VK_NULL_HANDLE)
+    , m_texMesh(nullptr), m_colorMesh(nullptr), m_texture(nullptr)
+    , m_queryPool(VK_NULL_HANDLE), m_timestampsSupported(false), m_timestampPeriodNs(1.0), m_timestampMask(0)
+    , m_graphicsQueue(VK_NULL_HANDLE)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::Run(const BenchmarkParams& params) {
+    m_params = params;
+    if (m_params.NumFramesInFlight < 1 || m_params.NumObjects < 1 || m_params.NumFrames < 1) {
+        throw std::runtime_error("invalid benchmark parameters!");
+    }
+
+    Init();
+
+#ifdef ENABLE_VULKAN_DEBUG
+    if (VK_SUCCESS != m_Debug.Init(m_instance)) {
+        throw std::runtime_error("failed to set up debug messenger!");
+    }
+#endif //ENABLE_VULKAN_DEBUG
+
+    Loop();
+    CleanUp();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::Init() {
+
+    VkApplicationInfo appInfo = {};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "Benchmark";
+    appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.pEngineName = "No Engine";
+    appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.apiVersion = VK_API_VERSION_1_0;
+
+#ifdef ENABLE_VULKAN_DEBUG
+    InitVulkanDebugInstance(appInfo, g_requiredInstanceExtensions);
+#else
+    InitVulkanInstance(appInfo, g_requiredInstanceExtensions);
+#endif
+
+    PickPhysicalDevice();
+    CreateLogicalDevice();
+    CreateDescriptorSetLayout();
+    CreateCommandPool();
+
+    //Init texture
+    m_texture = new Shin::Texture();
+    m_texture->Init(m_physicalDevice, m_logicalDevice, g_allocator, m_commandPool,m_graphicsQueue,
+        "../Resources/Textures/statue.jpg"
+    );
+
+    //Model
+    const uint32_t numIndices = static_cast<uint32_t>(g_indices.size());
+    m_texMesh = new Shin::Mesh();
+    m_texMesh->Init(m_physicalDevice, m_logicalDevice, g_allocator, m_commandPool,m_graphicsQueue,
+        reinterpret_cast<const char*>(g_texVertices.data()), static_cast<uint32_t>(sizeof(g_texVertices[0]) * g_texVertices.size()),
+        reinterpret_cast<const char*>(g_indices.data()), static_cast<uint32_t>(sizeof(g_indices[0]) * numIndices),
+        numIndices
+    );
+    m_colorMesh = new Shin::Mesh();
+    m_colorMesh->Init(m_physicalDevice, m_logicalDevice, g_allocator, m_commandPool,m_graphicsQueue,
+        reinterpret_cast<const char*>(g_colorVertices.data()), static_cast<uint32_t>(sizeof(g_colorVertices[0]) * g_colorVertices.size()),
+        reinterpret_cast<const char*>(g_indices.data()), static_cast<uint32_t>(sizeof(g_indices[0]) * numIndices),
+        numIndices
+    );
+
+    CreateSyncObjects();
+    CreateQueryPool();
+
+    //Init pipelines
+    const uint32_t NUM_DRAW_PIPELINES = 2;
+    m_drawPipelines.resize(NUM_DRAW_PIPELINES);
+    for (uint32_t i = 0; i < NUM_DRAW_PIPELINES; ++i) {
+        m_drawPipelines[i] = new Shin::DrawPipeline();
+    }
+
+    #define SHADER_PATH "../Shared/Shaders/"
+    m_drawPipelines[0]->Init(m_logicalDevice, g_allocator,
+        SHADER_PATH "Texture.vert.spv",
+        SHADER_PATH "Texture.frag.spv",
+        TextureVertex::GetBindingDescription(),
+        TextureVertex::GetAttributeDescriptions(),
+        m_texDescriptorSetLayout
+    );
+    m_drawPipelines[1]->Init(m_logicalDevice, g_allocator,
+        SHADER_PATH "Color.vert.spv",
+        SHADER_PATH "Color.frag.spv",
+        ColorVertex::GetBindingDescription(),
+        ColorVertex::GetAttributeDescriptions(),
+        m_colorDescriptorSetLayout
+    );
+    #undef SHADER_PATH
+
+    //Init drawObjects: a grid of alternating textured and colored quads. Deterministic, no random placement
+    const uint32_t numObjects = m_params.NumObjects;
+    const uint32_t numColumns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(numObjects))));
+    const float cellSize = 2.0f / static_cast<float>(numColumns);
+    m_drawObjects.resize(numObjects);
+    for (uint32_t i = 0; i < numObjects; ++i) {
+        const bool textured = (0 == (i % 2));
+        if (textured) {
+            m_drawObjects[i].Init(m_logicalDevice, g_allocator, m_texMesh, m_texture);
+        } else {
+            m_drawObjects[i].Init(m_logicalDevice, g_allocator, m_colorMesh, static_cast<Shin::Texture*>(nullptr));
+        }
+        const uint32_t row = i / numColumns;
+        const uint32_t col = i % numColumns;
+        m_drawObjects[i].SetPos(-1.0f + (col + 0.5f) * cellSize, -1.0f + (row + 0.5f) * cellSize, 0.0f);
+        m_drawObjects[i].SetScale(cellSize);
+        m_drawPipelines[textured ? 0 : 1]->AddDrawObject(&m_drawObjects[i]);
+    }
+
+    m_offScreenPass.Init(m_params.Width, m_params.Height, false, false, VK_FORMAT_UNDEFINED);
+
+    //Per frame in flight objects. Created once: there is no swap chain to be recreated
+    const uint32_t numImages = m_params.NumFramesInFlight;
+    CreateDescriptorPool();
+    m_offScreenPass.RecreateSwapChainObjects(m_physicalDevice, m_logicalDevice, g_allocator, numImages);
+    for (uint32_t i = 0; i < NUM_DRAW_PIPELINES; ++i) {
+        m_drawPipelines[i]->RecreateSwapChainObjects(m_physicalDevice, m_logicalDevice, g_allocator,
+            m_descriptorPool, numImages, m_offScreenPass.GetRenderPass(), m_offScreenPass.GetExtent()
+        );
+    }
+    CreateCommandBuffers();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+#ifdef ENABLE_VULKAN_DEBUG
+
+void BenchmarkApp::InitVulkanDebugInstance(const VkApplicationInfo& appInfo, const std::vector<const char*>& extensions)
+{
+    VkInstanceCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    createInfo.pApplicationInfo = &appInfo;
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
+
+    const VkDebugUtilsMessengerCreateInfoEXT& debugCreateInfo
+        = static_cast<const VulkanDebugMessenger>(m_Debug).GetCreateInfo();
+
+    if (!CheckRequiredVulkanLayersAvailability(g_requiredVulkanLayers)) {
+        throw std::runtime_error("Required Vulkan layers are requested, but some are not available!");
+    }
+    createInfo.enabledLayerCount = static_cast<uint32_t>(g_requiredVulkanLayers.size());
+    createInfo.ppEnabledLayerNames = g_requiredVulkanLayers.data();
+
+    createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*) &debugCreateInfo;
+
+    if (vkCreateInstance(&createInfo, nullptr, &m_instance) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create instance!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool BenchmarkApp::CheckRequiredVulkanLayersAvailability(const std::vector<const char*> requiredLayers) {
+    uint32_t layerCount;
+    vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+
+    std::vector<VkLayerProperties> availableLayers(layerCount);
+    vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+
+    for (const char* layerName : requiredLayers) {
+        bool layerFound = false;
+
+        for (const VkLayerProperties& layerProperties : availableLayers) {
+            if (strcmp(layerName, layerProperties.layerName) == 0) {
+                layerFound = true;
+                break;
+            }
+        }
+
+        if (!layerFound) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#else
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::InitVulkanInstance(const VkApplicationInfo& appInfo, const std::vector<const char*>& extensions) {
+    VkInstanceCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    createInfo.pApplicationInfo = &appInfo;
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
+    createInfo.enabledLayerCount = 0;
+
+    if (vkCreateInstance(&createInfo, nullptr, &m_instance) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create instance!");
+    }
+}
+
+#endif //ENABLE_VULKAN_DEBUG
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::PickPhysicalDevice()  {
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(m_instance, &deviceCount, nullptr);
+    if (deviceCount == 0) {
+        throw std::runtime_error("failed to find GPUs with Vulkan support!");
+    }
+
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(m_instance, &deviceCount, devices.data());
+
+    for (uint32_t i = 0; i < deviceCount; ++i) {
+        if (UINT32_MAX != m_params.DeviceIndex && i != m_params.DeviceIndex)
+            continue;
+
+        const VkPhysicalDevice& device = devices[i];
+
+        //Check features
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+        if (!supportedFeatures.samplerAnisotropy)
+            continue;
+
+        //Check required queue family
+        QueueFamilyIndices curIndices = QueryVulkanQueueFamilyIndices(device);
+        if (curIndices.IsComplete()) {
+            m_physicalDevice = device;
+            m_queueFamilyIndices = curIndices;
+            break;
+        }
+    }
+
+    if (m_physicalDevice == VK_NULL_HANDLE) {
+        throw std::runtime_error("failed to find a suitable GPU!");
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+    m_deviceName = properties.deviceName;
+    m_timestampPeriodNs = static_cast<double>(properties.limits.timestampPeriod);
+
+    //Timestamps are optional. If unsupported, only CPU times are reported
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, queueFamilies.data());
+    const uint32_t validBits = queueFamilies[m_queueFamilyIndices.GetGraphicsIndex()].timestampValidBits;
+    m_timestampsSupported = (validBits > 0);
+    m_timestampMask = (validBits >= 64) ? UINT64_MAX : ((static_cast<uint64_t>(1) << validBits) - 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::CreateLogicalDevice()  {
+    const float queuePriority = 1.0f;
+    VkDeviceQueueCreateInfo queueCreateInfo = {};
+    queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueCreateInfo.queueFamilyIndex = m_queueFamilyIndices.GetGraphicsIndex();
+    queueCreateInfo.queueCount = 1;
+    queueCreateInfo.pQueuePriorities = &queuePriority;
+
+    VkPhysicalDeviceFeatures deviceFeatures = {};
+    deviceFeatures.samplerAnisotropy = VK_TRUE;
+
+    VkDeviceCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pQueueCreateInfos = &queueCreateInfo;
+    createInfo.queueCreateInfoCount = 1;
+    createInfo.pEnabledFeatures = &deviceFeatures;
+    createInfo.enabledExtensionCount = 0;
+    createInfo.enabledLayerCount =  0;
+
+    if (VK_SUCCESS !=vkCreateDevice(m_physicalDevice, &createInfo, nullptr, &m_logicalDevice) ) {
+        throw std::runtime_error("failed to create logical device!");
+    }
+
+    vkGetDeviceQueue(m_logicalDevice, m_queueFamilyIndices.GetGraphicsIndex(), 0, &m_graphicsQueue);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::CreateDescriptorSetLayout() {
+    //Uniform buffer
+    VkDescriptorSetLayoutBinding uboLayoutBinding = {};
+    uboLayoutBinding.binding = 0;
+    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    uboLayoutBinding.descriptorCount = 1;
+    uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    uboLayoutBinding.pImmutableSamplers = nullptr;
+
+    {
+        //Texture Sampler
+        VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
+        samplerLayoutBinding.binding = 1;
+        samplerLayoutBinding.descriptorCount = 1;
+        samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        samplerLayoutBinding.pImmutableSamplers = nullptr;
+
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings = {uboLayoutBinding, samplerLayoutBinding};
+        VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        if (vkCreateDescriptorSetLayout(m_logicalDevice, &layoutInfo, g_allocator, &m_texDescriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+    }
+
+    {
+        std::array<VkDescriptorSetLayoutBinding, 1> bindings = {uboLayoutBinding};
+        VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        if (vkCreateDescriptorSetLayout(m_logicalDevice, &layoutInfo, g_allocator, &m_colorDescriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::CreateDescriptorPool() {
+    const uint32_t maxDescriptorCount = m_params.NumObjects * m_params.NumFramesInFlight;
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[0].descriptorCount = maxDescriptorCount;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[1].descriptorCount = maxDescriptorCount;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = maxDescriptorCount;
+
+    if (vkCreateDescriptorPool(m_logicalDevice, &poolInfo, g_allocator, &m_descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::CreateCommandPool() {
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = m_queueFamilyIndices.GetGraphicsIndex();
+    poolInfo.flags = 0;
+
+    if (vkCreateCommandPool(m_logicalDevice, &poolInfo, g_allocator, &m_commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create command pool!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::CreateCommandBuffers() {
+    const uint32_t numCommandBuffers = m_params.NumFramesInFlight;
+    m_commandBuffers.resize(numCommandBuffers);
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = numCommandBuffers;
+
+    if (vkAllocateCommandBuffers(m_logicalDevice, &allocInfo, m_commandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate command buffers!");
+    }
+
+    for (uint32_t i = 0; i < numCommandBuffers; ++i) {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        if (vkBeginCommandBuffer(m_commandBuffers[i], &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording command buffer!");
+        }
+
+        if (m_timestampsSupported) {
+            vkCmdResetQueryPool(m_commandBuffers[i], m_queryPool, i * 2, 2);
+            vkCmdWriteTimestamp(m_commandBuffers[i], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, i * 2);
+        }
+
+        const VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
+
+        VkRenderPassBeginInfo renderPassInfo = {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = m_offScreenPass.GetRenderPass();
+        renderPassInfo.framebuffer = m_offScreenPass.GetFrameBuffer(i);
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = m_offScreenPass.GetExtent();
+        renderPassInfo.clearValueCount = 1;
+        renderPassInfo.pClearValues = &clearColor;
+        vkCmdBeginRenderPass(m_commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        const uint32_t numPipelines = static_cast<uint32_t>(m_drawPipelines.size());
+        for (uint32_t j = 0; j < numPipelines; ++j) {
+            m_drawPipelines[j]->Bind(m_commandBuffers[i], m_offScreenPass.GetExtent());
+            m_drawPipelines[j]->DrawToCommandBuffer(m_commandBuffers[i], i);
+        }
+        vkCmdEndRenderPass(m_commandBuffers[i]);
+
+        if (m_timestampsSupported) {
+            vkCmdWriteTimestamp(m_commandBuffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, i * 2 + 1);
+        }
+
+        if (vkEndCommandBuffer(m_commandBuffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record command buffer!");
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::CreateSyncObjects() {
+    const uint32_t numFramesInFlight = m_params.NumFramesInFlight;
+    m_inFlightFences.resize(numFramesInFlight);
+    m_submittedFrames.resize(numFramesInFlight, UINT32_MAX);
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (uint32_t i = 0; i < numFramesInFlight; i++) {
+        if (vkCreateFence(m_logicalDevice, &fenceInfo, g_allocator, &m_inFlightFences[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create synchronization objects for a frame!");
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::CreateQueryPool() {
+    if (!m_timestampsSupported)
+        return;
+
+    VkQueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = m_params.NumFramesInFlight * 2;
+
+    if (vkCreateQueryPool(m_logicalDevice, &queryPoolInfo, g_allocator, &m_queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create query pool!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::Loop() {
+    const uint32_t numWarmUpFrames = m_params.NumWarmUpFrames;
+    const uint32_t numTotalFrames = numWarmUpFrames + m_params.NumFrames;
+    m_cpuFrameTimes.Reserve(m_params.NumFrames);
+    m_gpuFrameTimes.Reserve(m_params.NumFrames);
+
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < numTotalFrames; ++frame) {
+        if (frame == numWarmUpFrames) {
+            startTime = std::chrono::steady_clock::now();
+        }
+
+        const std::chrono::steady_clock::time_point frameStartTime = std::chrono::steady_clock::now();
+        DrawFrame(frame);
+        const std::chrono::steady_clock::time_point frameEndTime = std::chrono::steady_clock::now();
+
+        if (frame >= numWarmUpFrames) {
+            m_cpuFrameTimes.AddSample(std::chrono::duration<double, std::milli>(frameEndTime - frameStartTime).count());
+        }
+    }
+
+    //Wait until all vulkan operations are finished, and collect the remaining GPU times
+    vkDeviceWaitIdle(m_logicalDevice);
+    const double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    const uint32_t numFramesInFlight = m_params.NumFramesInFlight;
+    for (uint32_t i = 0; i < numFramesInFlight; ++i) {
+        double gpuTimeMs = 0;
+        if (UINT32_MAX != m_submittedFrames[i] && m_submittedFrames[i] >= numWarmUpFrames && ReadGPUTimeInto(i, &gpuTimeMs)) {
+            m_gpuFrameTimes.AddSample(gpuTimeMs);
+        }
+    }
+
+    WriteResults(totalSeconds);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::DrawFrame(const uint32_t frame) {
+    SHIN_PROFILE_FUNCTION();
+
+    const uint32_t imageIndex = frame % m_params.NumFramesInFlight;
+    vkWaitForFences(m_logicalDevice, 1, &m_inFlightFences[imageIndex], VK_TRUE, UINT64_MAX);
+
+    //The previous frame that used this slot has finished. Its timestamps are available
+    const uint32_t prevFrame = m_submittedFrames[imageIndex];
+    double gpuTimeMs = 0;
+    if (UINT32_MAX != prevFrame && prevFrame >= m_params.NumWarmUpFrames && ReadGPUTimeInto(imageIndex, &gpuTimeMs)) {
+        m_gpuFrameTimes.AddSample(gpuTimeMs);
+    }
+
+    //Fixed time step instead of the wall clock, so that every run renders exactly the same frames
+    UpdateVulkanUniformBuffers(imageIndex, static_cast<float>(frame) * m_params.TimeStep);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &m_commandBuffers[imageIndex];
+
+    vkResetFences(m_logicalDevice, 1, &m_inFlightFences[imageIndex]);
+    if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[imageIndex]) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit draw command buffer!");
+    }
+    m_submittedFrames[imageIndex] = frame;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::UpdateVulkanUniformBuffers(const uint32_t imageIndex, const float time) {
+    SHIN_PROFILE_FUNCTION();
+
+    const uint32_t numObjects = static_cast<uint32_t>(m_drawObjects.size());
+    for (uint32_t i = 0; i < numObjects; ++i) {
+        m_drawObjects[i].Rotate(time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        m_drawObjects[i].UpdateUniformBuffers(m_logicalDevice, imageIndex);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool BenchmarkApp::ReadGPUTimeInto(const uint32_t imageIndex, double* gpuTimeMs) {
+    if (!m_timestampsSupported)
+        return false;
+
+    std::array<uint64_t, 2> timestamps = {};
+    const VkResult result = vkGetQueryPoolResults(m_logicalDevice, m_queryPool, imageIndex * 2, 2,
+        sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (VK_SUCCESS != result)
+        return false;
+
+    const uint64_t elapsedTicks = ((timestamps[1] & m_timestampMask) - (timestamps[0] & m_timestampMask)) & m_timestampMask;
+    *gpuTimeMs = static_cast<double>(elapsedTicks) * m_timestampPeriodNs * 1.0e-6;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::WriteResults(const double totalSeconds) const {
+    const double framesPerSecond = (totalSeconds > 0.0) ? (m_params.NumFrames / totalSeconds) : 0.0;
+
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(4);
+    os << "{\n";
+    os << "  \"device\": \"" << m_deviceName << "\",\n";
+    os << "  \"params\": {\"objects\": " << m_params.NumObjects
+       << ", \"width\": " << m_params.Width
+       << ", \"height\": " << m_params.Height
+       << ", \"frames_in_flight\": " << m_params.NumFramesInFlight
+       << ", \"frames\": " << m_params.NumFrames
+       << ", \"warm_up_frames\": " << m_params.NumWarmUpFrames
+       << ", \"time_step\": " << m_params.TimeStep << "},\n";
+    os << "  \"total_seconds\": " << totalSeconds << ",\n";
+    os << "  \"throughput\": {\"frames_per_second\": " << framesPerSecond
+       << ", \"objects_per_second\": " << (framesPerSecond * m_params.NumObjects) << "},\n";
+    WriteStatisticsJSON(os, "cpu_frame_ms", m_cpuFrameTimes);
+    os << ",\n";
+    WriteStatisticsJSON(os, "gpu_frame_ms", m_gpuFrameTimes);
+    os << "\n}\n";
+
+    std::cout << os.str();
+
+    if (!m_params.OutputPath.empty()) {
+        std::ofstream file(m_params.OutputPath, std::ios::out | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open the benchmark output file!");
+        }
+        file << os.str();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+QueueFamilyIndices BenchmarkApp::QueryVulkanQueueFamilyIndices(const VkPhysicalDevice& device) {
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilyProperties.data());
+
+    QueueFamilyIndices indices;
+    for (uint32_t i = 0; i < queueFamilyCount && !indices.IsComplete(); ++i) {
+        if (queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            indices.SetGraphicsIndex(i);
+        }
+    }
+    return indices;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void BenchmarkApp::CleanUp() {
+    if (VK_NULL_HANDLE != m_logicalDevice) {
+        vkDeviceWaitIdle(m_logicalDevice);
+    }
+
+    for (VkFence& fence : m_inFlightFences) {
+        vkDestroyFence(m_logicalDevice, fence, g_allocator);
+    }
+    m_inFlightFences.clear();
+    m_submittedFrames.clear();
+
+    if (!m_commandBuffers.empty()) {
+        vkFreeCommandBuffers(m_logicalDevice, m_commandPool, static_cast<uint32_t>(m_commandBuffers.size()), m_commandBuffers.data());
+        m_commandBuffers.clear();
+    }
+
+    SAFE_DESTROY_QUERY_POOL(m_logicalDevice, m_queryPool, g_allocator);
+
+    //Draw Pipelines
+    const uint32_t numDrawPipelines = static_cast<uint32_t>(m_drawPipelines.size());
+    for (uint32_t i = 0; i < numDrawPipelines; ++i) {
+        m_drawPipelines[i]->CleanUpSwapChainObjects(m_logicalDevice, g_allocator);
+        m_drawPipelines[i]->CleanUp(m_logicalDevice, g_allocator);
+        delete(m_drawPipelines[i]);
+    }
+    m_drawPipelines.clear();
+
+    SAFE_DESTROY_DESCRIPTOR_POOL(m_logicalDevice, m_descriptorPool, g_allocator);
+    SAFE_DESTROY_DESCRIPTOR_SET_LAYOUT(m_logicalDevice,m_texDescriptorSetLayout,g_allocator);
+    SAFE_DESTROY_DESCRIPTOR_SET_LAYOUT(m_logicalDevice,m_colorDescriptorSetLayout,g_allocator);
+
+    m_offScreenPass.CleanUp(m_logicalDevice, g_allocator);
+
+    //Draw Objects
+    const uint32_t numDrawObjects = static_cast<uint32_t>(m_drawObjects.size());
+    for (uint32_t i = 0; i < numDrawObjects; ++i) {
+        m_drawObjects[i].CleanUp(m_logicalDevice, g_allocator);
+    }
+    m_drawObjects.clear();
+
+    SAFE_CLEANUP_PTR(m_logicalDevice, g_allocator, m_texture);
+    SAFE_CLEANUP_PTR(m_logicalDevice, g_allocator, m_texMesh);
+    SAFE_CLEANUP_PTR(m_logicalDevice, g_allocator, m_colorMesh);
+
+    SAFE_DESTROY_COMMAND_POOL(m_logicalDevice, m_commandPool, g_allocator);
+    m_graphicsQueue = VK_NULL_HANDLE;
+    SAFE_DESTROY_DEVICE(m_logicalDevice, g_allocator);
+
+    if (VK_NULL_HANDLE != m_instance) {
+#ifdef ENABLE_VULKAN_DEBUG
+        m_Debug.Shutdown(m_instance);
+#endif
+        vkDestroyInstance(m_instance, g_allocator);
+        m_instance = VK_NULL_HANDLE;
+    }
+}
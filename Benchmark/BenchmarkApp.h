@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+//Shared
+#include "Shin/SharedConfig.h"
+#include "Shin/VulkanDebugMessenger.h"
+#include "Shin/DrawObject.h"
+#include "Shin/OffScreenPass.h"
+
+#include "QueueFamilyIndices.h"
+#include "FrameStatistics.h"
+
+namespace Shin {
+    class Texture;
+    class Mesh;
+    class DrawPipeline;
+}
+
+struct BenchmarkParams {
+    uint32_t    NumObjects          = 64;
+    uint32_t    Width               = 1280;
+    uint32_t    Height              = 720;
+    uint32_t    NumFramesInFlight   = 2;
+    uint32_t    NumFrames           = 1000;
+    uint32_t    NumWarmUpFrames     = 60;      //Not included in the results
+    uint32_t    DeviceIndex         = UINT32_MAX; //UINT32_MAX: the first suitable device
+    float       TimeStep            = 1.0f / 60.0f;
+    std::string OutputPath;                    //Empty: print to stdout only
+
+    //Jobs mode (JobBenchmark)
+    bool        JobsMode            = false;
+    uint32_t    MaxThreads          = 0;       //Measured with 1 to MaxThreads threads. 0: the hardware threads
+    uint32_t    BatchSize           = 256;     //The number of objects per job
+
+    //Color conversion mode (ColorConversionBenchmark). Uses Width, Height and MaxThreads
+    bool        ColorMode           = false;
+
+    //Encoder mode (EncoderBenchmark). Uses Width, Height, and NumFramesInFlight as the number of inputs
+    bool        EncoderMode         = false;
+    int32_t     EncodeRate          = -1;      //Frames per second. 0: as fast as possible. Negative: several rates
+    float       EncodeLatencyMs     = 4.0f;    //Of the fake encoder, per frame
+};
+
+//Renders the NvEncoding scene (without the encoder) headless, for a fixed number of frames with a fixed time step,
+//so that the results of different runs and commits can be compared.
+class BenchmarkApp {
+public:
+    BenchmarkApp();
+    void Run(const BenchmarkParams& params);
+    void CleanUp();
+
+private:
+    void Init();
+
+#ifdef ENABLE_VULKAN_DEBUG
+    void InitVulkanDebugInstance(const VkApplicationInfo& appInfo, const std::vector<const char*>& extensions);
+    bool CheckRequiredVulkanLayersAvailability(const std::vector<const char*> requiredLayers);
+    VulkanDebugMessenger m_Debug;
+#else
+    void InitVulkanInstance(const VkApplicationInfo& appInfo, const std::vector<const char*>& extensions);
+#endif //ENABLE_VULKAN_DEBUG
+
+    void PickPhysicalDevice();
+    void CreateLogicalDevice();
+
+    void CreateDescriptorSetLayout();
+    void CreateDescriptorPool();
+    void CreateCommandPool();
+    void CreateCommandBuffers();
+    void CreateSyncObjects();
+    void CreateQueryPool();
+
+    void Loop();
+    void DrawFrame(const uint32_t frame);
+    void UpdateVulkanUniformBuffers(const uint32_t imageIndex, const float time);
+    bool ReadGPUTimeInto(const uint32_t imageIndex, double* gpuTimeMs);
+
+    void WriteResults(const double totalSeconds) const;
+
+    static QueueFamilyIndices QueryVulkanQueueFamilyIndices(const VkPhysicalDevice& device);
+
+    BenchmarkParams                 m_params;
+    Shin::OffScreenPass             m_offScreenPass;
+
+    VkInstance                      m_instance;
+    VkPhysicalDevice                m_physicalDevice;
+    std::string                     m_deviceName;
+    VkDevice                        m_logicalDevice;
+    VkDescriptorSetLayout           m_texDescriptorSetLayout;
+    VkDescriptorSetLayout           m_colorDescriptorSetLayout;
+    VkDescriptorPool                m_descriptorPool;
+
+    std::vector<Shin::DrawObject>   m_drawObjects;
+    std::vector<Shin::DrawPipeline*>m_drawPipelines;
+    VkCommandPool                   m_commandPool;
+
+    Shin::Mesh*                     m_texMesh;
+    Shin::Mesh*                     m_colorMesh;
+    Shin::Texture*                  m_texture;
+
+    std::vector<VkCommandBuffer>    m_commandBuffers; //One per frame in flight
+    std::vector<VkFence>            m_inFlightFences;
+    std::vector<uint32_t>           m_submittedFrames; //The last frame submitted for each frame in flight. UINT32_MAX: none
+
+    //GPU timing. Two timestamps per frame in flight
+    VkQueryPool                     m_queryPool;
+    bool                            m_timestampsSupported;
+    double                          m_timestampPeriodNs;
+    uint64_t                        m_timestampMask;
+
+    QueueFamilyIndices              m_queueFamilyIndices;
+    VkQueue                         m_graphicsQueue;
+
+    FrameStatistics                 m_cpuFrameTimes;
+    FrameStatistics                 m_gpuFrameTimes;
+};
@@ -0,0 +1,164 @@
+#include "ColorConversionBenchmark.h"
+
+#include <stdexcept> //std::runtime_error
+#include <iostream> //cout
+#include <fstream>
+#include <sstream>
+#include <iomanip>  //setprecision
+#include <algorithm> //std::max
+#include <chrono>
+#include <thread>   //hardware_concurrency
+
+//Shared
+#include "Shin/JobSystem.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+
+ColorConversionBenchmark::ColorConversionBenchmark() : m_supportedSIMDLevel(Shin::SIMD_LEVEL_SCALAR) {
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ColorConversionBenchmark::Run(const BenchmarkParams& params) {
+    m_params = params;
+    if (m_params.Width < 2 || m_params.Height < 2 || m_params.NumFrames < 1) {
+        throw std::runtime_error("invalid benchmark parameters!");
+    }
+
+    uint32_t maxThreads = m_params.MaxThreads;
+    if (0 == maxThreads) {
+        maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_supportedSIMDLevel = Shin::ColorConversion::GetSupportedSIMDLevel();
+    GenerateFrameInto(m_params.Width, m_params.Height, &m_frame);
+
+    //Each SIMD level on one thread. The first result of each format is the scalar one
+    std::vector<Result> results;
+    const Shin::YUVFormat formats[] = { Shin::YUV_FORMAT_I420, Shin::YUV_FORMAT_NV12 };
+    for (const Shin::YUVFormat format : formats) {
+        for (uint32_t level = Shin::SIMD_LEVEL_SCALAR; level <= m_supportedSIMDLevel; ++level) {
+            results.emplace_back();
+            RunInto(static_cast<Shin::SIMDLevel>(level), format, 1, &results.back());
+        }
+    }
+
+    //The conversion of the cpu encoder
+    for (uint32_t numThreads = 2; numThreads <= maxThreads; ++numThreads) {
+        results.emplace_back();
+        RunInto(m_supportedSIMDLevel, Shin::YUV_FORMAT_I420, numThreads, &results.back());
+    }
+
+    WriteResults(results);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Noise over gradients, so that neighbouring pixels differ and every byte value occurs
+void ColorConversionBenchmark::GenerateFrameInto(const uint32_t width, const uint32_t height,
+    std::vector<uint8_t>* rgba)
+{
+    rgba->resize(static_cast<size_t>(width) * height * 4);
+    uint32_t state = 0x12345678u;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            uint8_t* pixel = rgba->data() + (static_cast<size_t>(y) * width + x) * 4;
+            for (uint32_t c = 0; c < 4; ++c) {
+                state = state * 1664525u + 1013904223u;
+                const uint32_t gradient = (c & 1) ? (x * 255 / width) : (y * 255 / height);
+                pixel[c] = static_cast<uint8_t>(gradient + (state >> 24) / 2);
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ColorConversionBenchmark::RunInto(const Shin::SIMDLevel simd, const Shin::YUVFormat format,
+    const uint32_t numThreads, Result* result) const
+{
+    Shin::JobSystem jobSystem;
+    jobSystem.Init(numThreads);
+
+    Shin::ColorConversionDesc desc = {};
+    desc.Width = m_params.Width;
+    desc.Height = m_params.Height;
+    desc.SrcRowPitch = m_params.Width * 4;
+    desc.Matrix = Shin::COLOR_MATRIX_BT601;
+    desc.Format = format;
+    desc.SIMD = simd;
+    std::vector<uint8_t> yuv(Shin::ColorConversion::GetYUVSize(desc.Width, desc.Height));
+
+    const uint32_t numWarmUpFrames = m_params.NumWarmUpFrames;
+    const uint32_t numTotalFrames = numWarmUpFrames + m_params.NumFrames;
+    result->SIMD = simd;
+    result->Format = format;
+    result->NumThreads = numThreads;
+    result->FrameTimes.Reserve(m_params.NumFrames);
+
+    //One thread converts on the calling thread, without the job system
+    Shin::JobSystem* frameJobSystem = (numThreads > 1) ? &jobSystem : nullptr;
+    for (uint32_t frame = 0; frame < numTotalFrames; ++frame) {
+        const std::chrono::steady_clock::time_point frameStartTime = std::chrono::steady_clock::now();
+        Shin::ColorConversion::Convert(desc, m_frame.data(), yuv.data(), frameJobSystem);
+
+        if (frame >= numWarmUpFrames) {
+            result->FrameTimes.AddSample(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - frameStartTime).count());
+        }
+    }
+
+    jobSystem.CleanUp();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//speed_up: relative to the scalar conversion of the same format on one thread
+void ColorConversionBenchmark::WriteResults(const std::vector<Result>& results) const {
+    const double megaPixels = static_cast<double>(m_params.Width) * m_params.Height / 1000000.0;
+
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(4);
+    os << "{\n";
+    os << "  \"mode\": \"color\",\n";
+    os << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    os << "  \"simd_level\": \"" << Shin::ColorConversion::GetSIMDLevelName(m_supportedSIMDLevel) << "\",\n";
+    os << "  \"params\": {\"width\": " << m_params.Width
+       << ", \"height\": " << m_params.Height
+       << ", \"frames\": " << m_params.NumFrames
+       << ", \"warm_up_frames\": " << m_params.NumWarmUpFrames << "},\n";
+    os << "  \"results\": [\n";
+
+    const size_t numResults = results.size();
+    for (size_t i = 0; i < numResults; ++i) {
+        const Result& result = results[i];
+        double scalarMs = 0.0;
+        for (const Result& other : results) {
+            if (other.Format == result.Format && Shin::SIMD_LEVEL_SCALAR == other.SIMD && 1 == other.NumThreads) {
+                scalarMs = other.FrameTimes.GetMean();
+            }
+        }
+        const double meanMs = result.FrameTimes.GetMean();
+        const double speedUp = (meanMs > 0.0) ? (scalarMs / meanMs) : 0.0;
+        const double megaPixelsPerSecond = (meanMs > 0.0) ? (megaPixels * 1000.0 / meanMs) : 0.0;
+
+        os << "  {\"simd\": \"" << Shin::ColorConversion::GetSIMDLevelName(result.SIMD) << "\""
+           << ", \"format\": \"" << ((Shin::YUV_FORMAT_NV12 == result.Format) ? "NV12" : "I420") << "\""
+           << ", \"threads\": " << result.NumThreads
+           << ", \"speed_up\": " << speedUp
+           << ", \"megapixels_per_second\": " << megaPixelsPerSecond << ",\n";
+        WriteStatisticsJSON(os, "frame_ms", result.FrameTimes);
+        os << "}" << ((i + 1 < numResults) ? ",\n" : "\n");
+    }
+    os << "  ]\n}\n";
+
+    std::cout << os.str();
+
+    if (!m_params.OutputPath.empty()) {
+        std::ofstream file(m_params.OutputPath, std::ios::out | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open the benchmark output file!");
+        }
+        file << os.str();
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+//Shared
+#include "Shin/ColorConversion.h"
+
+#include "BenchmarkApp.h" //BenchmarkParams
+#include "FrameStatistics.h"
+
+//Measures the RGBA to YUV conversion of the cpu encoder on synthetic frames of Width x Height: every SIMD level of
+//the CPU on one thread, and the widest one from 1 to N threads.
+//Before that, every SIMD level is checked against the scalar conversion, for both matrices and formats and for an
+//odd size: they have to produce exactly the same bytes. No Vulkan objects are created.
+class ColorConversionBenchmark {
+public:
+    ColorConversionBenchmark();
+    void Run(const BenchmarkParams& params);
+
+private:
+    struct Result {
+        Shin::SIMDLevel SIMD;
+        Shin::YUVFormat Format;
+        uint32_t        NumThreads;
+        FrameStatistics FrameTimes;
+    };
+
+    static void GenerateFrameInto(const uint32_t width, const uint32_t height, std::vector<uint8_t>* rgba);
+    void RunInto(const Shin::SIMDLevel simd, const Shin::YUVFormat format, const uint32_t numThreads,
+        Result* result) const;
+    void WriteResults(const std::vector<Result>& results) const;
+
+    BenchmarkParams         m_params;
+    Shin::SIMDLevel         m_supportedSIMDLevel;
+    std::vector<uint8_t>    m_frame; //RGBA
+};
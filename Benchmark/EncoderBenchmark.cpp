@@ -0,0 +1,247 @@
+#include "EncoderBenchmark.h"
+
+#include <stdexcept> //std::runtime_error
+#include <iostream> //cout
+#include <fstream>
+#include <sstream>
+#include <iomanip>  //setprecision
+#include <iterator> //std::begin, std::end
+#include <chrono>
+#include <thread>   //sleep_until
+
+#include "NvEncoder.h"
+#include "Cuda/CudaApi.h"
+#include "Cuda/FakeCudaApi.h"
+#include "Cuda/CudaContext.h"
+#include "Cuda/CudaImage.h"
+
+//Frames per second of the runs, if no rate is given. 0: as fast as possible
+static const uint32_t ENCODER_BENCHMARK_RATES[] = { 60, 120, 240, 0 };
+
+//---------------------------------------------------------------------------------------------------------------------
+
+EncoderBenchmark::EncoderBenchmark() {
+    m_nvenc = { NV_ENCODE_API_FUNCTION_LIST_VER };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void EncoderBenchmark::Run(const BenchmarkParams& params) {
+    m_params = params;
+    if (m_params.Width < 2 || m_params.Height < 2 || m_params.NumFrames < 1 || m_params.NumFramesInFlight < 1
+        || m_params.EncodeLatencyMs < 0.0f)
+    {
+        throw std::runtime_error("invalid benchmark parameters!");
+    }
+
+    CudaFunctionList cuda = {};
+    FakeCudaApi::FillFunctionList(&cuda);
+    CudaApi::SetFunctionList(cuda);
+
+    FakeNvEncodeParams fakeParams = {};
+    fakeParams.EncodeLatencyMs = m_params.EncodeLatencyMs;
+    fakeParams.BitstreamSize = m_params.Width * m_params.Height / 100;
+    fakeParams.KeyFrameBitstreamSize = m_params.Width * m_params.Height / 20;
+    fakeParams.AsyncEncodeSupported = true;
+    FakeNvEncodeApi::FillFunctionList(fakeParams, &m_nvenc);
+
+    std::vector<uint32_t> rates;
+    if (m_params.EncodeRate >= 0) {
+        rates.push_back(static_cast<uint32_t>(m_params.EncodeRate));
+    } else {
+        rates.assign(std::begin(ENCODER_BENCHMARK_RATES), std::end(ENCODER_BENCHMARK_RATES));
+    }
+
+    std::vector<Result> results(rates.size());
+    for (size_t i = 0; i < rates.size(); ++i) {
+        RunInto(rates[i], &results[i]);
+    }
+
+    WriteResults(results);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void EncoderBenchmark::RunInto(const uint32_t rate, Result* result) const {
+    const uint32_t numInputs = m_params.NumFramesInFlight;
+    const VkExtent2D extent = { m_params.Width, m_params.Height };
+    const VkDeviceSize imageSize = static_cast<VkDeviceSize>(m_params.Width) * m_params.Height * 4;
+
+    FakeNvEncodeApi::ResetCounters();
+
+    const std::chrono::steady_clock::time_point setupStartTime = std::chrono::steady_clock::now();
+    CudaContext cudaContext;
+    cudaContext.InitWithDeviceUUID(FakeCudaApi::GetDeviceUUID());
+
+    //FakeCudaApi doesn't use the exported handles
+    std::vector<CudaImage> cudaImages(numInputs);
+    for (uint32_t i = 0; i < numInputs; ++i) {
+        cudaImages[i].InitWithHandle(reinterpret_cast<void*>(static_cast<uintptr_t>(i + 1)), imageSize, extent);
+    }
+
+    NvEncoder encoder;
+    encoder.SetApi(m_nvenc);
+    encoder.Init(NV_ENC_DEVICE_TYPE_CUDA, cudaContext.GetContext(), m_params.Width, m_params.Height);
+    encoder.CreateBuffers(numInputs);
+    for (uint32_t i = 0; i < numInputs; ++i) {
+        FrameEncoderInput input = {};
+        input.Type = FRAME_ENCODER_INPUT_TYPE_CUDA_ARRAY;
+        input.Resource = cudaImages[i].GetArray();
+        encoder.RegisterInput(i, input);
+    }
+    const std::chrono::steady_clock::time_point setupEndTime = std::chrono::steady_clock::now();
+
+    result->Rate = rate;
+    result->SetupMs = std::chrono::duration<double, std::milli>(setupEndTime - setupStartTime).count();
+    result->NumRetrievedBytes = 0;
+    result->EncodeTimes.Reserve(m_params.NumFrames);
+
+    const uint32_t numWarmUpFrames = m_params.NumWarmUpFrames;
+    const uint32_t numTotalFrames = numWarmUpFrames + m_params.NumFrames;
+    const uint32_t resizeFrame = numWarmUpFrames + m_params.NumFrames / 2;
+    const std::chrono::steady_clock::duration framePeriod = (rate > 0)
+        ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rate))
+        : std::chrono::steady_clock::duration::zero();
+
+    FakeNvEncodeCounters startCounters = {};
+    uint64_t startNumRetrievedFrames = 0;
+    uint64_t startNumDroppedFrames = 0;
+    uint64_t startNumDiscardedBitstreams = 0;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point nextFrameTime = startTime;
+    uint32_t numFramesInFlight = 0; //Encoded, but not retrieved yet
+    std::vector<uint8_t> bitstream;
+    for (uint32_t frame = 0; frame < numTotalFrames; ++frame) {
+        if (rate > 0) {
+            std::this_thread::sleep_until(nextFrameTime);
+            nextFrameTime += framePeriod;
+        }
+
+        if (frame == numWarmUpFrames) {
+            startCounters = FakeNvEncodeApi::GetCounters();
+            startNumRetrievedFrames = encoder.GetNumRetrievedFrames();
+            startNumDroppedFrames = encoder.GetNumDroppedFrames();
+            startNumDiscardedBitstreams = encoder.GetNumDiscardedBitstreams();
+            startTime = std::chrono::steady_clock::now();
+        }
+
+        //Like NvEncodingApp: one input per frame in flight, and Reconfigure() before each frame.
+        //The inputs keep the full size: they stay registered
+        const uint32_t encodeWidth = (frame < resizeFrame) ? m_params.Width : m_params.Width / 2;
+        const uint32_t encodeHeight = (frame < resizeFrame) ? m_params.Height : m_params.Height / 2;
+        const std::chrono::steady_clock::time_point encodeStartTime = std::chrono::steady_clock::now();
+        const uint64_t numDroppedFrames = encoder.GetNumDroppedFrames();
+        encoder.Reconfigure(encodeWidth, encodeHeight);
+        encoder.EncodeFrame(frame % numInputs);
+        if (frame >= numWarmUpFrames) {
+            result->EncodeTimes.AddSample(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - encodeStartTime).count());
+        }
+        if (encoder.GetNumDroppedFrames() == numDroppedFrames) {
+            ++numFramesInFlight;
+        }
+
+        //As fast as possible: the next frame is encoded once one of the inputs has been retrieved
+        bool isInputFree = false;
+        while (!isInputFree) {
+            while (encoder.RetrieveBitstream(&bitstream)) {
+                --numFramesInFlight;
+                if (frame >= numWarmUpFrames) {
+                    result->NumRetrievedBytes += bitstream.size();
+                }
+            }
+
+            isInputFree = (rate > 0 || numFramesInFlight < numInputs);
+            if (!isInputFree) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    result->Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    result->Counters = SubtractCounters(FakeNvEncodeApi::GetCounters(), startCounters);
+    result->NumRetrievedFrames = encoder.GetNumRetrievedFrames() - startNumRetrievedFrames;
+    result->NumDroppedFrames = encoder.GetNumDroppedFrames() - startNumDroppedFrames;
+    result->NumDiscardedBitstreams = encoder.GetNumDiscardedBitstreams() - startNumDiscardedBitstreams;
+    result->AverageLatencyMs = encoder.GetAverageLatencyMs();
+    result->MaxLatencyMs = encoder.GetMaxLatencyMs();
+
+    encoder.DestroyBuffers();
+    encoder.CleanUp();
+    for (uint32_t i = 0; i < numInputs; ++i) {
+        cudaImages[i].CleanUp();
+    }
+    cudaContext.CleanUp();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+FakeNvEncodeCounters EncoderBenchmark::SubtractCounters(const FakeNvEncodeCounters& end,
+    const FakeNvEncodeCounters& start)
+{
+    FakeNvEncodeCounters counters = {};
+    counters.NumRegisteredResources = end.NumRegisteredResources - start.NumRegisteredResources;
+    counters.NumUnregisteredResources = end.NumUnregisteredResources - start.NumUnregisteredResources;
+    counters.NumMappedResources = end.NumMappedResources - start.NumMappedResources;
+    counters.NumUnmappedResources = end.NumUnmappedResources - start.NumUnmappedResources;
+    counters.NumEncodedPictures = end.NumEncodedPictures - start.NumEncodedPictures;
+    counters.NumLockedBitstreams = end.NumLockedBitstreams - start.NumLockedBitstreams;
+    counters.NumReconfigurations = end.NumReconfigurations - start.NumReconfigurations;
+    return counters;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The driver calls are per measured frame
+void EncoderBenchmark::WriteResults(const std::vector<Result>& results) const {
+    const double numFrames = static_cast<double>(m_params.NumFrames);
+
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(4);
+    os << "{\n";
+    os << "  \"mode\": \"encoder\",\n";
+    os << "  \"params\": {\"width\": " << m_params.Width
+       << ", \"height\": " << m_params.Height
+       << ", \"inputs\": " << m_params.NumFramesInFlight
+       << ", \"encode_latency_ms\": " << m_params.EncodeLatencyMs
+       << ", \"frames\": " << m_params.NumFrames
+       << ", \"warm_up_frames\": " << m_params.NumWarmUpFrames << "},\n";
+    os << "  \"results\": [\n";
+
+    const size_t numResults = results.size();
+    for (size_t i = 0; i < numResults; ++i) {
+        const Result& result = results[i];
+        const FakeNvEncodeCounters& counters = result.Counters;
+        const double retrievedFPS = (result.Seconds > 0.0) ? (result.NumRetrievedFrames / result.Seconds) : 0.0;
+
+        os << "  {\"rate\": " << result.Rate
+           << ", \"setup_ms\": " << result.SetupMs
+           << ", \"retrieved_fps\": " << retrievedFPS
+           << ", \"retrieved_frames\": " << result.NumRetrievedFrames
+           << ", \"retrieved_bytes\": " << result.NumRetrievedBytes
+           << ", \"dropped_frames\": " << result.NumDroppedFrames
+           << ", \"discarded_bitstreams\": " << result.NumDiscardedBitstreams
+           << ", \"latency_ms\": {\"mean\": " << result.AverageLatencyMs << ", \"max\": " << result.MaxLatencyMs
+           << "},\n";
+        os << "  \"calls_per_frame\": {\"register\": " << counters.NumRegisteredResources / numFrames
+           << ", \"unregister\": " << counters.NumUnregisteredResources / numFrames
+           << ", \"map\": " << counters.NumMappedResources / numFrames
+           << ", \"unmap\": " << counters.NumUnmappedResources / numFrames
+           << ", \"encode\": " << counters.NumEncodedPictures / numFrames
+           << ", \"lock\": " << counters.NumLockedBitstreams / numFrames
+           << ", \"reconfigure\": " << counters.NumReconfigurations / numFrames << "},\n";
+        WriteStatisticsJSON(os, "encode_frame_ms", result.EncodeTimes);
+        os << "}" << ((i + 1 < numResults) ? ",\n" : "\n");
+    }
+    os << "  ]\n}\n";
+
+    std::cout << os.str();
+
+    if (!m_params.OutputPath.empty()) {
+        std::ofstream file(m_params.OutputPath, std::ios::out | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open the benchmark output file!");
+        }
+        file << os.str();
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "FakeNvEncodeApi.h"
+
+#include "BenchmarkApp.h" //BenchmarkParams
+#include "FrameStatistics.h"
+
+//Measures NvEncoder and the CUDA wrappers on FakeNvEncodeApi and FakeCudaApi, so that it runs without a GPU: the
+//time spent in our own code, not in the driver. Every run sets up a CudaContext, NumFramesInFlight CudaImages and
+//an NvEncoder, encodes frames at a fixed rate (or as fast as possible) while retrieving the bitstreams, and cleans
+//everything up again. Halfway through the measured frames, the encoded size is halved.
+//The driver calls of the measured frames are counted. NvEncoderTests checks which calls NvEncoder makes
+class EncoderBenchmark {
+public:
+    EncoderBenchmark();
+    void Run(const BenchmarkParams& params);
+
+private:
+    struct Result {
+        uint32_t                Rate;               //Frames per second. 0: as fast as possible
+        double                  SetupMs;            //From CudaContext to the registration of the inputs
+        double                  Seconds;            //Of the measured frames
+        uint64_t                NumRetrievedFrames; //Of the measured frames
+        uint64_t                NumDroppedFrames;   //Of the measured frames
+        uint64_t                NumDiscardedBitstreams;
+        uint64_t                NumRetrievedBytes;
+        double                  AverageLatencyMs;   //Of every frame, warm-up included
+        double                  MaxLatencyMs;
+        FakeNvEncodeCounters    Counters;           //Of the measured frames
+        FrameStatistics         EncodeTimes;        //EncodeFrame()
+    };
+
+    void RunInto(const uint32_t rate, Result* result) const;
+    void WriteResults(const std::vector<Result>& results) const;
+
+    static FakeNvEncodeCounters SubtractCounters(const FakeNvEncodeCounters& end, const FakeNvEncodeCounters& start);
+
+    BenchmarkParams                 m_params;
+    NV_ENCODE_API_FUNCTION_LIST     m_nvenc;
+};
@@ -0,0 +1,83 @@
+#include "FrameStatistics.h"
+#include <algorithm> //sort, min_element, max_element
+#include <numeric>   //accumulate
+#include <cmath>     //ceil
+#include <ostream>
+
+FrameStatistics::FrameStatistics() : m_sorted(false) {
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameStatistics::Reserve(const uint32_t numSamples) {
+    m_samples.reserve(numSamples);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+double FrameStatistics::GetMin() const {
+    if (m_samples.empty())
+        return 0.0;
+
+    return *std::min_element(m_samples.begin(), m_samples.end());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+double FrameStatistics::GetMax() const {
+    if (m_samples.empty())
+        return 0.0;
+
+    return *std::max_element(m_samples.begin(), m_samples.end());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+double FrameStatistics::GetMean() const {
+    if (m_samples.empty())
+        return 0.0;
+
+    return std::accumulate(m_samples.begin(), m_samples.end(), 0.0) / static_cast<double>(m_samples.size());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+double FrameStatistics::GetPercentile(const double percentile) const {
+    const std::vector<double>& sorted = GetSortedSamples();
+    if (sorted.empty())
+        return 0.0;
+
+    const size_t numSamples = sorted.size();
+    const size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(numSamples)));
+    const size_t index = (rank > 0) ? std::min(rank - 1, numSamples - 1) : 0;
+    return sorted[index];
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+const std::vector<double>& FrameStatistics::GetSortedSamples() const {
+    if (!m_sorted) {
+        m_sortedSamples = m_samples;
+        std::sort(m_sortedSamples.begin(), m_sortedSamples.end());
+        m_sorted = true;
+    }
+    return m_sortedSamples;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void WriteStatisticsJSON(std::ostream& os, const char* name, const FrameStatistics& stats) {
+    os << "  \"" << name << "\": ";
+    if (0 == stats.GetNumSamples()) {
+        os << "null";
+        return;
+    }
+
+    os << "{\"samples\": " << stats.GetNumSamples()
+       << ", \"min\": " << stats.GetMin()
+       << ", \"mean\": " << stats.GetMean()
+       << ", \"p50\": " << stats.GetPercentile(50.0)
+       << ", \"p90\": " << stats.GetPercentile(90.0)
+       << ", \"p99\": " << stats.GetPercentile(99.0)
+       << ", \"max\": " << stats.GetMax() << "}";
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <iosfwd>
+
+//Collects per-frame samples (in milliseconds) and computes summary statistics
+class FrameStatistics {
+public:
+    FrameStatistics();
+
+    void Reserve(const uint32_t numSamples);
+    inline void AddSample(const double ms);
+
+    inline uint32_t GetNumSamples() const;
+    double GetMin() const;
+    double GetMax() const;
+    double GetMean() const;
+
+    //percentile: [0..100]. Uses the nearest-rank method on the sorted samples
+    double GetPercentile(const double percentile) const;
+
+private:
+    const std::vector<double>& GetSortedSamples() const;
+
+    std::vector<double>         m_samples;
+    mutable std::vector<double> m_sortedSamples;
+    mutable bool                m_sorted;
+};
+
+//Writes "name": {samples, min, mean, p50, p90, p99, max}, or "name": null if there are no samples
+void WriteStatisticsJSON(std::ostream& os, const char* name, const FrameStatistics& stats);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameStatistics::AddSample(const double ms) { m_samples.push_back(ms); m_sorted = false; }
+uint32_t FrameStatistics::GetNumSamples() const { return static_cast<uint32_t>(m_samples.size()); }
@@ -0,0 +1,170 @@
+#include "JobBenchmark.h"
+
+#include <stdexcept> //std::runtime_error
+#include <iostream> //cout
+#include <fstream>
+#include <sstream>
+#include <iomanip>  //setprecision
+#include <algorithm> //std::max
+#include <atomic>
+#include <chrono>
+#include <cmath>    //ceil, sqrt, abs
+#include <thread>   //hardware_concurrency
+
+//Shared
+#include "Shin/JobSystem.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+
+JobBenchmark::JobBenchmark() {
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void JobBenchmark::Run(const BenchmarkParams& params) {
+    m_params = params;
+    if (m_params.NumObjects < 1 || m_params.NumFrames < 1) {
+        throw std::runtime_error("invalid benchmark parameters!");
+    }
+
+    uint32_t maxThreads = m_params.MaxThreads;
+    if (0 == maxThreads) {
+        maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    InitDrawObjects();
+
+    std::vector<Result> results(maxThreads);
+    for (uint32_t i = 0; i < maxThreads; ++i) {
+        RunWithThreadsInto(i + 1, &results[i]);
+    }
+
+    WriteResults(results);
+
+    //Every thread count computes the same frames
+    for (const Result& result : results) {
+        if (result.NumVisibleObjects != results[0].NumVisibleObjects) {
+            throw std::runtime_error("failed to run the job benchmark: the visible objects differ between threads!");
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The same grid as BenchmarkApp, but with perspective so that culling has something to do
+void JobBenchmark::InitDrawObjects() {
+    const uint32_t numObjects = m_params.NumObjects;
+    const uint32_t numColumns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(numObjects))));
+    const float cellSize = 8.0f / static_cast<float>(numColumns);
+    const float aspect = static_cast<float>(m_params.Width) / static_cast<float>(m_params.Height);
+
+    m_drawObjects.resize(numObjects);
+    for (uint32_t i = 0; i < numObjects; ++i) {
+        const uint32_t row = i / numColumns;
+        const uint32_t col = i % numColumns;
+        m_drawObjects[i].SetPos(-4.0f + (col + 0.5f) * cellSize, -4.0f + (row + 0.5f) * cellSize, 0.0f);
+        m_drawObjects[i].SetScale(cellSize);
+        m_drawObjects[i].SetProj(aspect);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void JobBenchmark::RunWithThreadsInto(const uint32_t numThreads, Result* result) {
+    Shin::JobSystem jobSystem;
+    jobSystem.Init(numThreads);
+
+    const uint32_t numWarmUpFrames = m_params.NumWarmUpFrames;
+    const uint32_t numTotalFrames = numWarmUpFrames + m_params.NumFrames;
+    result->NumThreads = numThreads;
+    result->FrameTimes.Reserve(m_params.NumFrames);
+
+    for (uint32_t frame = 0; frame < numTotalFrames; ++frame) {
+        const std::chrono::steady_clock::time_point frameStartTime = std::chrono::steady_clock::now();
+
+        //Fixed time step, so that every thread count computes exactly the same frames
+        result->NumVisibleObjects = UpdateDrawObjects(&jobSystem, static_cast<float>(frame) * m_params.TimeStep);
+
+        if (frame >= numWarmUpFrames) {
+            result->FrameTimes.AddSample(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - frameStartTime).count());
+        }
+    }
+
+    jobSystem.CleanUp();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Returns the number of visible objects
+uint32_t JobBenchmark::UpdateDrawObjects(Shin::JobSystem* jobSystem, const float time) {
+    std::atomic<uint32_t> numVisibleObjects(0);
+
+    const uint32_t numObjects = static_cast<uint32_t>(m_drawObjects.size());
+    jobSystem->ParallelFor(numObjects, m_params.BatchSize, [this, time, &numVisibleObjects](
+        const uint32_t begin, const uint32_t end)
+    {
+        uint32_t numVisible = 0;
+        for (uint32_t i = begin; i < end; ++i) {
+            Shin::DrawObject& drawObject = m_drawObjects[i];
+            //90 degrees per second, like the apps
+            drawObject.Rotate((time + i * 0.01f) * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+            drawObject.UpdateModelMat();
+
+            //Cull the center of the object
+            const MVPUniform& mvp = drawObject.GetMVP();
+            const glm::vec4 clipPos = mvp.ProjMat * mvp.ViewMat * mvp.ModelMat * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            if (clipPos.w > 0.0f && std::abs(clipPos.x) <= clipPos.w && std::abs(clipPos.y) <= clipPos.w
+                && clipPos.z >= 0.0f && clipPos.z <= clipPos.w)
+            {
+                ++numVisible;
+            }
+        }
+        numVisibleObjects.fetch_add(numVisible, std::memory_order_relaxed);
+    });
+
+    return numVisibleObjects.load();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void JobBenchmark::WriteResults(const std::vector<Result>& results) const {
+    const double singleThreadMs = results[0].FrameTimes.GetMean();
+
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(4);
+    os << "{\n";
+    os << "  \"mode\": \"jobs\",\n";
+    os << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    os << "  \"params\": {\"objects\": " << m_params.NumObjects
+       << ", \"batch_size\": " << m_params.BatchSize
+       << ", \"frames\": " << m_params.NumFrames
+       << ", \"warm_up_frames\": " << m_params.NumWarmUpFrames
+       << ", \"time_step\": " << m_params.TimeStep << "},\n";
+    os << "  \"results\": [\n";
+
+    const size_t numResults = results.size();
+    for (size_t i = 0; i < numResults; ++i) {
+        const Result& result = results[i];
+        const double meanMs = result.FrameTimes.GetMean();
+        const double speedUp = (meanMs > 0.0) ? (singleThreadMs / meanMs) : 0.0;
+
+        os << "  {\"threads\": " << result.NumThreads
+           << ", \"visible_objects\": " << result.NumVisibleObjects
+           << ", \"speed_up\": " << speedUp
+           << ", \"efficiency\": " << (speedUp / result.NumThreads) << ",\n";
+        WriteStatisticsJSON(os, "frame_ms", result.FrameTimes);
+        os << "}" << ((i + 1 < numResults) ? ",\n" : "\n");
+    }
+    os << "  ]\n}\n";
+
+    std::cout << os.str();
+
+    if (!m_params.OutputPath.empty()) {
+        std::ofstream file(m_params.OutputPath, std::ios::out | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open the benchmark output file!");
+        }
+        file << os.str();
+    }
+}
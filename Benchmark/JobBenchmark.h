@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+//Shared
+#include "Shin/DrawObject.h"
+
+#include "BenchmarkApp.h" //BenchmarkParams
+#include "FrameStatistics.h"
+
+namespace Shin {
+    class JobSystem;
+}
+
+//Measures how Shin::JobSystem scales from 1 to N threads. Every frame, the transforms of synthetic DrawObjects are
+//updated and the objects are culled against the view frustum with ParallelFor(). No Vulkan objects are created.
+class JobBenchmark {
+public:
+    JobBenchmark();
+    void Run(const BenchmarkParams& params);
+
+private:
+    struct Result {
+        uint32_t        NumThreads;
+        uint32_t        NumVisibleObjects; //Of the last frame. Has to be the same for every thread count
+        FrameStatistics FrameTimes;
+    };
+
+    void InitDrawObjects();
+    void RunWithThreadsInto(const uint32_t numThreads, Result* result);
+    uint32_t UpdateDrawObjects(Shin::JobSystem* jobSystem, const float time);
+    void WriteResults(const std::vector<Result>& results) const;
+
+    BenchmarkParams                 m_params;
+    std::vector<Shin::DrawObject>   m_drawObjects;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+//Headless: only a graphics queue is needed
+class QueueFamilyIndices {
+public :
+    QueueFamilyIndices() : m_graphicsIndex(0), m_graphicsSet(false) { }
+
+    bool IsComplete() {
+        return m_graphicsSet;
+    }
+
+    inline bool IsGraphicsIndexSet() const;
+    inline void SetGraphicsIndex(uint32_t id);
+    inline uint32_t GetGraphicsIndex() const;
+
+private:
+    uint32_t m_graphicsIndex;
+    bool m_graphicsSet;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool QueueFamilyIndices::IsGraphicsIndexSet()       const { return m_graphicsSet; };
+void QueueFamilyIndices::SetGraphicsIndex(uint32_t id) { m_graphicsIndex = id; m_graphicsSet = true;}
+uint32_t QueueFamilyIndices::GetGraphicsIndex() const  { return m_graphicsIndex; }
+
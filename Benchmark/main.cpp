@@ -0,0 +1,140 @@
+#include <iostream> //std::exception, EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>  //strcmp
+#include <cstdlib>  //atoi, atof
+#include "BenchmarkApp.h"
+#include "JobBenchmark.h"
+#include "ColorConversionBenchmark.h"
+#include "EncoderBenchmark.h"
+
+const uint32_t JOBS_MODE_DEFAULT_NUM_OBJECTS = 100000;
+const uint32_t COLOR_MODE_DEFAULT_NUM_FRAMES = 200;
+const uint32_t ENCODER_MODE_DEFAULT_NUM_FRAMES = 300;
+const uint32_t ENCODER_MODE_DEFAULT_NUM_INPUTS = 3;
+
+static void PrintUsage() {
+    std::cout << "Usage: Benchmark [--objects N] [--width W] [--height H] [--frames-in-flight N] [--frames N]" 
+        << " [--warm-up N] [--time-step seconds] [--device index] [--output result.json]" << std::endl;
+    std::cout << "       Benchmark --mode jobs [--objects N] [--threads max] [--batch N] [--frames N] [--warm-up N]"
+        << " [--output result.json]" << std::endl;
+    std::cout << "       Benchmark --mode color [--width W] [--height H] [--threads max] [--frames N] [--warm-up N]"
+        << " [--output result.json]" << std::endl;
+    std::cout << "       Benchmark --mode encoder [--width W] [--height H] [--frames-in-flight N] [--rate fps]"
+        << " [--encode-latency ms] [--frames N] [--warm-up N] [--output result.json]" << std::endl;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    BenchmarkParams params;
+    bool numObjectsSet = false;
+    bool numFramesSet = false;
+    bool numFramesInFlightSet = false;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (nullptr == value) {
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+
+        if (0 == strcmp(arg, "--objects")) {
+            params.NumObjects = static_cast<uint32_t>(atoi(value));
+            numObjectsSet = true;
+        } else if (0 == strcmp(arg, "--width")) {
+            params.Width = static_cast<uint32_t>(atoi(value));
+        } else if (0 == strcmp(arg, "--height")) {
+            params.Height = static_cast<uint32_t>(atoi(value));
+        } else if (0 == strcmp(arg, "--frames-in-flight")) {
+            params.NumFramesInFlight = static_cast<uint32_t>(atoi(value));
+            numFramesInFlightSet = true;
+        } else if (0 == strcmp(arg, "--frames")) {
+            params.NumFrames = static_cast<uint32_t>(atoi(value));
+            numFramesSet = true;
+        } else if (0 == strcmp(arg, "--warm-up")) {
+            params.NumWarmUpFrames = static_cast<uint32_t>(atoi(value));
+        } else if (0 == strcmp(arg, "--time-step")) {
+            params.TimeStep = static_cast<float>(atof(value));
+        } else if (0 == strcmp(arg, "--device")) {
+            params.DeviceIndex = static_cast<uint32_t>(atoi(value));
+        } else if (0 == strcmp(arg, "--output")) {
+            params.OutputPath = value;
+        } else if (0 == strcmp(arg, "--mode") && (0 == strcmp(value, "render") || 0 == strcmp(value, "jobs")
+            || 0 == strcmp(value, "color") || 0 == strcmp(value, "encoder"))) 
+        {
+            params.JobsMode = (0 == strcmp(value, "jobs"));
+            params.ColorMode = (0 == strcmp(value, "color"));
+            params.EncoderMode = (0 == strcmp(value, "encoder"));
+        } else if (0 == strcmp(arg, "--threads")) {
+            params.MaxThreads = static_cast<uint32_t>(atoi(value));
+        } else if (0 == strcmp(arg, "--batch")) {
+            params.BatchSize = static_cast<uint32_t>(atoi(value));
+        } else if (0 == strcmp(arg, "--rate")) {
+            params.EncodeRate = static_cast<int32_t>(atoi(value));
+        } else if (0 == strcmp(arg, "--encode-latency")) {
+            params.EncodeLatencyMs = static_cast<float>(atof(value));
+        } else {
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+        ++i;
+    }
+
+    if (params.JobsMode) {
+        if (!numObjectsSet) {
+            params.NumObjects = JOBS_MODE_DEFAULT_NUM_OBJECTS;
+        }
+
+        JobBenchmark jobBenchmark;
+        try {
+            jobBenchmark.Run(params);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (params.ColorMode) {
+        if (!numFramesSet) {
+            params.NumFrames = COLOR_MODE_DEFAULT_NUM_FRAMES;
+        }
+
+        ColorConversionBenchmark colorBenchmark;
+        try {
+            colorBenchmark.Run(params);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (params.EncoderMode) {
+        if (!numFramesSet) {
+            params.NumFrames = ENCODER_MODE_DEFAULT_NUM_FRAMES;
+        }
+        if (!numFramesInFlightSet) {
+            params.NumFramesInFlight = ENCODER_MODE_DEFAULT_NUM_INPUTS;
+        }
+
+        EncoderBenchmark encoderBenchmark;
+        try {
+            encoderBenchmark.Run(params);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    BenchmarkApp app;
+    try {
+        app.Run(params);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        app.CleanUp();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -70,6 +70,8 @@ MultipleObjectsApp::MultipleObjectsApp()
     , m_colorDescriptorSetLayout(VK_NULL_HANDLE)
     , m_texDescriptorSetLayout(VK_NULL_HANDLE)
     , m_commandPool(VK_NULL_HANDLE), m_currentFrame(0), m_recreateSwapChainRequested(false)
+    , m_depthFormat(VK_FORMAT_UNDEFINED), m_depthImage(VK_NULL_HANDLE), m_depthImageMemory(VK_NULL_HANDLE)
+    , m_depthImageView(VK_NULL_HANDLE)
     , m_texMesh(nullptr), m_colorMesh(nullptr)
     , m_texture(nullptr)
     , m_window(nullptr) 
@@ -125,6 +127,7 @@ void MultipleObjectsApp::InitVulkan() {
     m_window->CreateVulkanSurfaceInto(m_instance, g_allocator, &m_surface);
     PickPhysicalDevice();
     CreateLogicalDevice();
+    m_depthFormat = GraphicsUtility::FindDepthFormat(m_physicalDevice);
     CreateDescriptorSetLayout();
     CreateCommandPool();
 
@@ -191,6 +194,15 @@ void MultipleObjectsApp::InitVulkan() {
     );
     #undef SHADER_PATH
 
+    //The objects are opaque and overlap: depth test, so that they are drawn front to back
+    Shin::PipelineRenderState depthTestedState;
+    depthTestedState.Blend = Shin::BLEND_MODE_OPAQUE;
+    depthTestedState.DepthTest = VK_TRUE;
+    depthTestedState.DepthWrite = VK_TRUE;
+    for (uint32_t i = 0; i < NUM_DRAW_PIPELINES; ++i) {
+        m_drawPipelines[i]->SetRenderState(depthTestedState);
+    }
+
     m_drawPipelines[0]->AddDrawObject(&m_drawObjects[0]);
     m_drawPipelines[1]->AddDrawObject(&m_drawObjects[1]);
     m_drawPipelines[0]->AddDrawObject(&m_drawObjects[2]);
@@ -213,6 +225,7 @@ void MultipleObjectsApp::RecreateSwapChain() {
     CreateSwapChain();
     CreateImageViews();
     CreateRenderPass();
+    CreateDepthResources();
 
     CreateFrameBuffers();
     CreateDescriptorPool();
@@ -420,14 +433,16 @@ void MultipleObjectsApp::CreateCommandBuffers() {
         renderPassInfo.renderArea.offset = {0, 0};
         renderPassInfo.renderArea.extent = m_swapChainExtent;
 
-        VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
-        renderPassInfo.clearValueCount = 1;
-        renderPassInfo.pClearValues = &clearColor; //to be used by VK_ATTACHMENT_LOAD_OP_CLEAR, when creating RenderPass
+        std::array<VkClearValue, 2> clearValues = {};
+        clearValues[0].color = {0.0f, 0.0f, 0.0f, 1.0f};
+        clearValues[1].depthStencil = {1.0f, 0};
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassInfo.pClearValues = clearValues.data(); //to be used by VK_ATTACHMENT_LOAD_OP_CLEAR, when creating RenderPass
         vkCmdBeginRenderPass(m_commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
         const uint32_t numPipelines = static_cast<uint32_t>(m_drawPipelines.size());
         for (uint32_t j = 0; j < numPipelines; ++j) {
-            m_drawPipelines[j]->Bind(m_commandBuffers[i]);
+            m_drawPipelines[j]->Bind(m_commandBuffers[i], m_swapChainExtent);
             m_drawPipelines[j]->DrawToCommandBuffer(m_commandBuffers[i], static_cast<uint32_t>(i));
         }
 
@@ -558,28 +573,47 @@ void MultipleObjectsApp::CreateRenderPass() {
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;  //So that after rendering, we can present
 
+    //Only used during the pass, so it isn't stored
+    VkAttachmentDescription depthAttachment = {};
+    depthAttachment.format = m_depthFormat;
+    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
     VkAttachmentReference colorAttachmentRef = {};
     colorAttachmentRef.attachment = 0; //this is referred by shaders (layout location)
     colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+    VkAttachmentReference depthAttachmentRef = {};
+    depthAttachmentRef.attachment = 1;
+    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
     VkSubpassDescription subpass = {};
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorAttachmentRef;
+    subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
 
+    //The depth buffer is shared: it can only be cleared after the depth tests of the previous frame
     VkSubpassDependency dependency = {};
     dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
     dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+        | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+    std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
     VkRenderPassCreateInfo renderPassInfo = {};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
     renderPassInfo.dependencyCount = 1;
@@ -590,6 +624,17 @@ void MultipleObjectsApp::CreateRenderPass() {
     }
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+
+void MultipleObjectsApp::CreateDepthResources() {
+    GraphicsUtility::CreateImage(m_physicalDevice, m_logicalDevice, g_allocator, 
+        m_swapChainExtent.width, m_swapChainExtent.height, VK_IMAGE_TILING_OPTIMAL, 
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_depthFormat, 
+        &m_depthImage, &m_depthImageMemory
+    );
+    m_depthImageView = GraphicsUtility::CreateImageView(m_logicalDevice, g_allocator, m_depthImage, m_depthFormat);
+}
+
 
 //---------------------------------------------------------------------------------------------------------------------
 
@@ -628,13 +673,14 @@ void MultipleObjectsApp::CreateFrameBuffers() {
 
     for (size_t i = 0; i < numImageViews; i++) {
         VkImageView attachments[] = {
-            m_swapChainImageViews[i]
+            m_swapChainImageViews[i],
+            m_depthImageView
         };
 
         VkFramebufferCreateInfo framebufferInfo = {};
         framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         framebufferInfo.renderPass = m_renderPass;
-        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.attachmentCount = 2;
         framebufferInfo.pAttachments = attachments;
         framebufferInfo.width = m_swapChainExtent.width;
         framebufferInfo.height = m_swapChainExtent.height;
@@ -1053,6 +1099,10 @@ void MultipleObjectsApp::CleanUpVulkanSwapChain() {
     }
     m_swapChainFramebuffers.clear();
 
+    SAFE_DESTROY_IMAGE_VIEW(m_logicalDevice, m_depthImageView, g_allocator);
+    SAFE_DESTROY_IMAGE(m_logicalDevice, m_depthImage, g_allocator);
+    SAFE_FREE_MEMORY(m_logicalDevice, m_depthImageMemory, g_allocator);
+
     for (VkImageView& imageView : m_swapChainImageViews) {
         vkDestroyImageView(m_logicalDevice, imageView, g_allocator);
     }
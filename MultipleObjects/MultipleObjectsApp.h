@@ -54,6 +54,7 @@ private:
     void CreateSwapChain();
     void CreateImageViews();
     void CreateRenderPass();
+    void CreateDepthResources();
     void CreateFrameBuffers();
     void CreateDescriptorPool();
     void CreateCommandBuffers();
@@ -112,6 +113,10 @@ private:
     VkFormat                    m_swapChainSurfaceFormat;
     VkExtent2D                  m_swapChainExtent;
     std::vector<VkFramebuffer>  m_swapChainFramebuffers;
+    VkFormat                    m_depthFormat;
+    VkImage                     m_depthImage; //Shared by all framebuffers
+    VkDeviceMemory              m_depthImageMemory;
+    VkImageView                 m_depthImageView;
     uint32_t                    m_currentFrame;
     std::vector<VkFence>        m_inFlightFences; //CPU-GPU synchronizations
     std::vector<VkFence>        m_imagesInFlight; //To test if the current frame is still in flight
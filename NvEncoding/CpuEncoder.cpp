@@ -0,0 +1,116 @@
+#include "CpuEncoder.h"
+#include <stdexcept> //std::runtime_error
+#include <cstring> //memcpy
+
+#include "Shin/Profiler.h"
+
+CpuEncoder::CpuEncoder() : m_jobSystem(nullptr), m_simdLevel(Shin::SIMD_LEVEL_SCALAR), m_hasFrame(false)
+    , m_maxWidth(0), m_maxHeight(0), m_width(0), m_height(0)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CpuEncoder::Init(const uint32_t maxWidth, const uint32_t maxHeight, Shin::JobSystem* jobSystem) {
+    if (0 == maxWidth || 0 == maxHeight) {
+        throw std::runtime_error("failed to init cpu encoder: invalid size!");
+    }
+
+    m_jobSystem = jobSystem;
+    m_simdLevel = Shin::ColorConversion::GetSupportedSIMDLevel();
+    m_maxWidth = m_width = maxWidth;
+    m_maxHeight = m_height = maxHeight;
+    m_hasFrame = false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CpuEncoder::CleanUp() {
+    DestroyBuffers();
+    m_jobSystem = nullptr;
+    m_frame.clear();
+    m_hasFrame = false;
+    m_maxWidth = m_maxHeight = m_width = m_height = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CpuEncoder::CreateBuffers(const uint32_t numBuffers) {
+    FrameEncoderInput input = {};
+    input.Type = FRAME_ENCODER_INPUT_TYPE_HOST_MEMORY;
+    m_inputs.assign(numBuffers, input);
+
+    m_frame.reserve(Shin::ColorConversion::GetYUVSize(m_maxWidth, m_maxHeight));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CpuEncoder::DestroyBuffers() {
+    m_inputs.clear();
+    m_hasFrame = false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CpuEncoder::RegisterInput(const uint32_t idx, const FrameEncoderInput& input) {
+    const bool hostMemory = (FRAME_ENCODER_INPUT_TYPE_HOST_MEMORY == input.Type 
+        || FRAME_ENCODER_INPUT_TYPE_HOST_MEMORY_I420 == input.Type);
+    if (idx >= m_inputs.size() || !hostMemory) {
+        throw std::runtime_error("failed to register cpu encoder input!");
+    }
+    m_inputs[idx] = input;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CpuEncoder::Reconfigure(const uint32_t width, const uint32_t height) {
+    if (0 == width || 0 == height || width > m_maxWidth || height > m_maxHeight) {
+        throw std::runtime_error("failed to reconfigure cpu encoder: invalid size!");
+    }
+    m_width = width;
+    m_height = height;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CpuEncoder::EncodeFrame(const uint32_t idx) {
+    SHIN_PROFILE_FUNCTION();
+
+    if (idx >= m_inputs.size() || nullptr == m_inputs[idx].Resource) {
+        throw std::runtime_error("failed to encode frame: the input hasn't been registered!");
+    }
+
+    const FrameEncoderInput& input = m_inputs[idx];
+    const uint8_t* src = static_cast<const uint8_t*>(input.Resource);
+
+    //An unretrieved frame is overwritten
+    m_frame.resize(Shin::ColorConversion::GetYUVSize(m_width, m_height));
+    if (FRAME_ENCODER_INPUT_TYPE_HOST_MEMORY_I420 == input.Type) {
+        memcpy(m_frame.data(), src, m_frame.size());
+        m_hasFrame = true;
+        return;
+    }
+
+    Shin::ColorConversionDesc desc = {};
+    desc.Width = m_width;
+    desc.Height = m_height;
+    desc.SrcRowPitch = (0 == input.RowPitch) ? m_width * 4 : input.RowPitch;
+    desc.Matrix = Shin::COLOR_MATRIX_BT601;
+    desc.Format = Shin::YUV_FORMAT_I420;
+    desc.SIMD = m_simdLevel;
+    Shin::ColorConversion::Convert(desc, src, m_frame.data(), m_jobSystem);
+    m_hasFrame = true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool CpuEncoder::RetrieveBitstream(std::vector<uint8_t>* bitstream) {
+    if (!m_hasFrame) {
+        return false;
+    }
+
+    //The allocations are exchanged: the next frame is encoded into the previous bitstream
+    bitstream->swap(m_frame);
+    m_hasFrame = false;
+    return true;
+}
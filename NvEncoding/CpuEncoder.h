@@ -0,0 +1,55 @@
+#pragma once
+
+#include "FrameEncoder.h"
+
+//Shared
+#include "Shin/JobSystem.h"
+#include "Shin/ColorConversion.h"
+
+//Converts RGBA frames in host memory into raw I420 (BT.601, limited range) on the CPU, so that the streaming path
+//can run on machines without NVENC. Each frame is split into bands of rows, which are converted in parallel by
+//the threads of the job system of the app, with the widest SIMD instructions of the CPU.
+//Frames which have already been converted to I420 on the GPU are only copied.
+//The bitstream of a frame is its Y plane, followed by the U and V planes at half resolution
+class CpuEncoder : public FrameEncoder {
+public:
+    CpuEncoder();
+
+    //jobSystem: shared with the rest of the app, and initialized by the thread that encodes.
+    //nullptr to convert on the thread that encodes only
+    void Init(const uint32_t maxWidth, const uint32_t maxHeight, Shin::JobSystem* jobSystem);
+    void CleanUp() override;
+
+    void CreateBuffers(const uint32_t numBuffers) override;
+    void DestroyBuffers() override;
+    void RegisterInput(const uint32_t idx, const FrameEncoderInput& input) override;
+    void EncodeFrame(const uint32_t idx) override;
+    bool RetrieveBitstream(std::vector<uint8_t>* bitstream) override;
+    void Reconfigure(const uint32_t width, const uint32_t height) override;
+
+    inline uint32_t GetWidth() const override;
+    inline uint32_t GetHeight() const override;
+    inline bool IsInitialized() const;
+    inline uint32_t GetNumThreads() const;
+    inline Shin::SIMDLevel GetSIMDLevel() const;
+
+private:
+    Shin::JobSystem*                m_jobSystem;
+    Shin::SIMDLevel                 m_simdLevel;
+    std::vector<FrameEncoderInput>  m_inputs;
+    std::vector<uint8_t>            m_frame;    //The last encoded frame
+    bool                            m_hasFrame; //m_frame hasn't been retrieved
+
+    uint32_t    m_maxWidth;
+    uint32_t    m_maxHeight;
+    uint32_t    m_width;
+    uint32_t    m_height;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t CpuEncoder::GetWidth() const { return m_width; }
+uint32_t CpuEncoder::GetHeight() const { return m_height; }
+bool CpuEncoder::IsInitialized() const { return m_maxWidth > 0; }
+uint32_t CpuEncoder::GetNumThreads() const { return (nullptr != m_jobSystem) ? m_jobSystem->GetNumThreads() : 1; }
+Shin::SIMDLevel CpuEncoder::GetSIMDLevel() const { return m_simdLevel; }
@@ -0,0 +1,35 @@
+#include "CudaApi.h"
+
+static CudaFunctionList g_cudaFunctionList = CudaApi::GetDriverFunctionList();
+
+//---------------------------------------------------------------------------------------------------------------------
+
+const CudaFunctionList& CudaApi::Get() {
+    return g_cudaFunctionList;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CudaApi::SetFunctionList(const CudaFunctionList& functionList) {
+    g_cudaFunctionList = functionList;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Some of the names are macros of cuda.h, which select the versions of the functions
+CudaFunctionList CudaApi::GetDriverFunctionList() {
+    CudaFunctionList functionList = {};
+    functionList.Init = cuInit;
+    functionList.DeviceGetCount = cuDeviceGetCount;
+    functionList.DeviceGet = cuDeviceGet;
+    functionList.DeviceGetUuid = cuDeviceGetUuid;
+    functionList.CtxCreate = cuCtxCreate;
+    functionList.CtxDestroy = cuCtxDestroy;
+    functionList.CtxSetCurrent = cuCtxSetCurrent;
+    functionList.ImportExternalMemory = cuImportExternalMemory;
+    functionList.ExternalMemoryGetMappedMipmappedArray = cuExternalMemoryGetMappedMipmappedArray;
+    functionList.MipmappedArrayGetLevel = cuMipmappedArrayGetLevel;
+    functionList.MipmappedArrayDestroy = cuMipmappedArrayDestroy;
+    functionList.DestroyExternalMemory = cuDestroyExternalMemory;
+    return functionList;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "cuda.h"
+
+//The CUDA driver functions which are called by CudaContext and CudaImage
+struct CudaFunctionList {
+    CUresult (CUDAAPI* Init)(unsigned int flags);
+    CUresult (CUDAAPI* DeviceGetCount)(int* count);
+    CUresult (CUDAAPI* DeviceGet)(CUdevice* device, int ordinal);
+    CUresult (CUDAAPI* DeviceGetUuid)(CUuuid* uuid, CUdevice device);
+    CUresult (CUDAAPI* CtxCreate)(CUcontext* context, unsigned int flags, CUdevice device);
+    CUresult (CUDAAPI* CtxDestroy)(CUcontext context);
+    CUresult (CUDAAPI* CtxSetCurrent)(CUcontext context);
+    CUresult (CUDAAPI* ImportExternalMemory)(CUexternalMemory* extMemory,
+        const CUDA_EXTERNAL_MEMORY_HANDLE_DESC* memHandleDesc);
+    CUresult (CUDAAPI* ExternalMemoryGetMappedMipmappedArray)(CUmipmappedArray* mipmap, CUexternalMemory extMemory,
+        const CUDA_EXTERNAL_MEMORY_MIPMAPPED_ARRAY_DESC* mipmapDesc);
+    CUresult (CUDAAPI* MipmappedArrayGetLevel)(CUarray* levelArray, CUmipmappedArray mipmap, unsigned int level);
+    CUresult (CUDAAPI* MipmappedArrayDestroy)(CUmipmappedArray mipmap);
+    CUresult (CUDAAPI* DestroyExternalMemory)(CUexternalMemory extMemory);
+};
+
+//The function list which the CUDA wrappers call: the driver's, unless it has been replaced, e.g. by FakeCudaApi.
+//The driver's functions are only called through it, so that an executable which never calls them can run without
+//an NVIDIA driver when nvcuda.dll is delay-loaded
+class CudaApi {
+public:
+    static const CudaFunctionList& Get();
+
+    //Before any CudaContext is initialized
+    static void SetFunctionList(const CudaFunctionList& functionList);
+    static CudaFunctionList GetDriverFunctionList();
+};
@@ -3,6 +3,7 @@
 #include <stdexcept> //std::runtime_error
 #include <array>
 #include "Shin/Utilities/GraphicsUtility.h"
+#include "CudaApi.h"
 
 CudaContext::CudaContext() : m_context(nullptr) {
 }
@@ -15,25 +16,32 @@ CudaContext::~CudaContext() {
 //---------------------------------------------------------------------------------------------------------------------
 
 void CudaContext::Init(const VkInstance instance, VkPhysicalDevice physicalDevice) {
+    std::array<uint8_t, VK_UUID_SIZE> deviceUUID;
+    GraphicsUtility::GetPhysicalDeviceUUIDInto(instance, physicalDevice, &deviceUUID);
+    InitWithDeviceUUID(deviceUUID);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CudaContext::InitWithDeviceUUID(const std::array<uint8_t, VK_UUID_SIZE>& deviceUUID) {
+    const CudaFunctionList& cuda = CudaApi::Get();
 
     CUdevice dev;
     CUresult result = CUDA_SUCCESS;
-    bool foundDevice = true;
+    bool foundDevice = false;
 
-    result = cuInit(0);
+    result = cuda.Init(0);
     if (result != CUDA_SUCCESS) {
         throw std::runtime_error("Failed to cuInit()");
     }
 
     int numDevices = 0;
-    result = cuDeviceGetCount(&numDevices);
+    result = cuda.DeviceGetCount(&numDevices);
     if (result != CUDA_SUCCESS) {
         throw std::runtime_error("Failed to get count of CUDA devices");
     }
 
     CUuuid id = {};
-    std::array<uint8_t, VK_UUID_SIZE> deviceUUID;
-    GraphicsUtility::GetPhysicalDeviceUUIDInto(instance, physicalDevice, &deviceUUID);
 
     /*
      * Loop over the available devices and identify the CUdevice
@@ -42,9 +50,9 @@ void CudaContext::Init(const VkInstance instance, VkPhysicalDevice physicalDevic
      * API boundaries.
      */
     for (int i = 0; i < numDevices; i++) {
-        cuDeviceGet(&dev, i);
+        cuda.DeviceGet(&dev, i);
 
-        cuDeviceGetUuid(&id, dev);
+        cuda.DeviceGetUuid(&id, dev);
 
         if (!std::memcmp(static_cast<const void *>(&id),
                 static_cast<const void *>(deviceUUID.data()),
@@ -59,7 +67,7 @@ void CudaContext::Init(const VkInstance instance, VkPhysicalDevice physicalDevic
  
  }
 
-    result = cuCtxCreate(&m_context, 0, dev);
+    result = cuda.CtxCreate(&m_context, 0, dev);
     if (result != CUDA_SUCCESS) {
         throw std::runtime_error("Failed to create a CUDA context");
     }
@@ -69,7 +77,15 @@ void CudaContext::Init(const VkInstance instance, VkPhysicalDevice physicalDevic
 
 void CudaContext::CleanUp() {
     if (nullptr != m_context) {
-        cuCtxDestroy(m_context);
+        CudaApi::Get().CtxDestroy(m_context);
         m_context = nullptr;
     }
 }
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CudaContext::SetCurrent() const {
+    if (CUDA_SUCCESS != CudaApi::Get().CtxSetCurrent(m_context)) {
+        throw std::runtime_error("Failed to set the current CUDA context");
+    }
+}
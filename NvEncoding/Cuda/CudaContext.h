@@ -2,6 +2,7 @@
 
 #include <vulkan/vulkan.h>
 #include <cuda.h>
+#include <array>
 
 /**
 *  @brief Wrapper class around CUcontext
@@ -17,7 +18,12 @@ public:
     ~CudaContext();
 
     void Init(const VkInstance instance, VkPhysicalDevice physicalDevice);
+    //On the CUDA device with this UUID, e.g. of FakeCudaApi
+    void InitWithDeviceUUID(const std::array<uint8_t, VK_UUID_SIZE>& deviceUUID);
     void CleanUp();
+
+    //Init() only makes the context current on the thread that called it
+    void SetCurrent() const;
     inline const CUcontext GetContext() const;
 private:
     CUcontext m_context;
@@ -3,8 +3,8 @@
 #include <stdexcept> //std::runtime_error
 #include <sstream> //ostringstream
 
-#include "Shin/Texture.h"
 #include "Shin/Utilities/GraphicsUtility.h"
+#include "CudaApi.h"
 
 //---------------------------------------------------------------------------------------------------------------------
 
@@ -20,31 +20,37 @@ CudaImage::~CudaImage()
 
 //---------------------------------------------------------------------------------------------------------------------
 
-void CudaImage::Init(const VkDevice device, const Shin::Texture* texture)
+void CudaImage::Init(const VkDevice device, const VkDeviceMemory memory, const VkDeviceSize memorySize, 
+    const VkExtent2D& extent)
 {
-    int fd = -1;
-    CUresult result = CUDA_SUCCESS;
-
-    void *p = GraphicsUtility::GetExportHandle(device, texture->GetTextureImageMemory());
+    void *p = GraphicsUtility::GetExportHandle(device, memory);
 
     if (nullptr == p) {
         throw std::runtime_error("Failed to get export handle for memory");
     }
 
+    InitWithHandle(p, memorySize, extent);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CudaImage::InitWithHandle(void* handle, const VkDeviceSize memorySize, const VkExtent2D& extent) {
+    const CudaFunctionList& cuda = CudaApi::Get();
+    CUresult result = CUDA_SUCCESS;
+
     CUDA_EXTERNAL_MEMORY_HANDLE_DESC memDesc = {};
 #ifndef _WIN32
     memDesc.type = CU_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD;
 #else
     memDesc.type = CU_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32;
 #endif
-    memDesc.handle.fd = (int)(uintptr_t)p;
-    memDesc.size = texture->GetTextureImageMemorySize();
+    memDesc.handle.fd = (int)(uintptr_t)handle;
+    memDesc.size = memorySize;
 
-    if ((result=cuImportExternalMemory(&m_extMemory, &memDesc)) != CUDA_SUCCESS) {
+    if ((result=cuda.ImportExternalMemory(&m_extMemory, &memDesc)) != CUDA_SUCCESS) {
         throw std::runtime_error("Failed to import buffer into CUDA");
     }
 
-    VkExtent2D extent = texture->GetExtent();
 
     CUDA_ARRAY3D_DESCRIPTOR arrayDesc = {};
     arrayDesc.Width = extent.width;
@@ -59,7 +65,7 @@ void CudaImage::Init(const VkDevice device, const Shin::Texture* texture)
     mipmapArrayDesc.arrayDesc = arrayDesc;
     mipmapArrayDesc.numLevels = 1;
 
-    result = cuExternalMemoryGetMappedMipmappedArray(&m_mipmapArray, m_extMemory,
+    result = cuda.ExternalMemoryGetMappedMipmappedArray(&m_mipmapArray, m_extMemory,
                  &mipmapArrayDesc);
     if (result != CUDA_SUCCESS) {
         std::ostringstream oss;
@@ -67,7 +73,7 @@ void CudaImage::Init(const VkDevice device, const Shin::Texture* texture)
         throw std::runtime_error(oss.str());
     }
 
-    result = cuMipmappedArrayGetLevel(&m_array, m_mipmapArray, 0);
+    result = cuda.MipmappedArrayGetLevel(&m_array, m_mipmapArray, 0);
     if (result != CUDA_SUCCESS) {
         std::ostringstream oss;
         oss << "Failed to get CUarray; " << result;
@@ -81,11 +87,11 @@ void CudaImage::CleanUp() {
     m_array = nullptr;
 
     if (nullptr != m_mipmapArray) {
-        cuMipmappedArrayDestroy(m_mipmapArray);
+        CudaApi::Get().MipmappedArrayDestroy(m_mipmapArray);
         m_mipmapArray = nullptr;
     }
     if (nullptr != m_extMemory) {
-        cuDestroyExternalMemory(m_extMemory);
+        CudaApi::Get().DestroyExternalMemory(m_extMemory);
         m_extMemory = nullptr;
     }
 
@@ -3,14 +3,10 @@
 #include "cuda.h"
 #include <vulkan/vulkan.h>
 
-namespace Shin {
-    class Texture;
-}
-
 /**
 *  @brief Wrapper class around CUarray
 * This class can be used for mapping a 2D CUDA array on the device memory
-* object referred to by deviceMem. deviceMem should have been created with a
+* object referred to by memory. memory should have been created with a
 * device memory object backing a 2D VkImage. This mapping makes use of Vulkan's
 * export of device memory followed by import of this external memory by CUDA.
 */
@@ -19,7 +15,10 @@ class CudaImage
 public:
     CudaImage();
     ~CudaImage();
-    void Init(const VkDevice device, const Shin::Texture* texture);
+    void Init(const VkDevice device, const VkDeviceMemory memory, const VkDeviceSize memorySize, 
+        const VkExtent2D& extent);
+    //handle: the exported handle of the memory, whose ownership is transferred to CUDA
+    void InitWithHandle(void* handle, const VkDeviceSize memorySize, const VkExtent2D& extent);
     void CleanUp();
     inline CUarray GetArray();
 
@@ -0,0 +1,286 @@
+#include "FakeCudaApi.h"
+#include <vector>
+#include <set>
+#include <mutex>
+#include <cstring> //memcpy
+
+struct FakeCudaContext {
+    CUdevice    Device;
+};
+
+struct FakeCudaExternalMemory {
+    unsigned long long  Size;
+    uint32_t            NumMappedArrays;
+};
+
+struct FakeCudaArray {
+    size_t      Width;
+    size_t      Height;
+};
+
+//The handle of each level is the address of its FakeCudaArray
+struct FakeCudaMipmappedArray {
+    FakeCudaExternalMemory*     ExternalMemory;
+    std::vector<FakeCudaArray>  Levels;
+};
+
+static std::mutex                           g_fakeCudaMutex;
+static bool                                 g_fakeCudaInitialized = false;
+static std::set<FakeCudaContext*>           g_fakeCudaContexts;
+static std::set<FakeCudaExternalMemory*>    g_fakeCudaExternalMemories;
+static std::set<FakeCudaMipmappedArray*>    g_fakeCudaMipmappedArrays;
+
+static thread_local FakeCudaContext* t_fakeCudaCurrentContext = nullptr;
+
+static const CUdevice FAKE_CUDA_DEVICE = 0;
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FakeCudaApi::FillFunctionList(CudaFunctionList* functionList) {
+    functionList->Init = Init;
+    functionList->DeviceGetCount = DeviceGetCount;
+    functionList->DeviceGet = DeviceGet;
+    functionList->DeviceGetUuid = DeviceGetUuid;
+    functionList->CtxCreate = CtxCreate;
+    functionList->CtxDestroy = CtxDestroy;
+    functionList->CtxSetCurrent = CtxSetCurrent;
+    functionList->ImportExternalMemory = ImportExternalMemory;
+    functionList->ExternalMemoryGetMappedMipmappedArray = ExternalMemoryGetMappedMipmappedArray;
+    functionList->MipmappedArrayGetLevel = MipmappedArrayGetLevel;
+    functionList->MipmappedArrayDestroy = MipmappedArrayDestroy;
+    functionList->DestroyExternalMemory = DestroyExternalMemory;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+std::array<uint8_t, VK_UUID_SIZE> FakeCudaApi::GetDeviceUUID() {
+    std::array<uint8_t, VK_UUID_SIZE> uuid;
+    for (uint32_t i = 0; i < VK_UUID_SIZE; ++i) {
+        uuid[i] = static_cast<uint8_t>(0xF0 + i);
+    }
+    return uuid;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t FakeCudaApi::GetNumLiveObjects() {
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    return static_cast<uint32_t>(g_fakeCudaContexts.size() + g_fakeCudaExternalMemories.size()
+        + g_fakeCudaMipmappedArrays.size());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+CUresult FakeCudaApi::Init(unsigned int flags) {
+    if (0 != flags) {
+        return CUDA_ERROR_INVALID_VALUE;
+    }
+
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    g_fakeCudaInitialized = true;
+    return CUDA_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+CUresult FakeCudaApi::DeviceGetCount(int* count) {
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    if (!g_fakeCudaInitialized) {
+        return CUDA_ERROR_NOT_INITIALIZED;
+    }
+    if (nullptr == count) {
+        return CUDA_ERROR_INVALID_VALUE;
+    }
+    *count = 1;
+    return CUDA_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+CUresult FakeCudaApi::DeviceGet(CUdevice* device, int ordinal) {
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    if (!g_fakeCudaInitialized) {
+        return CUDA_ERROR_NOT_INITIALIZED;
+    }
+    if (nullptr == device) {
+        return CUDA_ERROR_INVALID_VALUE;
+    }
+    if (0 != ordinal) {
+        return CUDA_ERROR_INVALID_DEVICE;
+    }
+    *device = FAKE_CUDA_DEVICE;
+    return CUDA_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+CUresult FakeCudaApi::DeviceGetUuid(CUuuid* uuid, CUdevice device) {
+    if (nullptr == uuid) {
+        return CUDA_ERROR_INVALID_VALUE;
+    }
+    if (FAKE_CUDA_DEVICE != device) {
+        return CUDA_ERROR_INVALID_DEVICE;
+    }
+
+    const std::array<uint8_t, VK_UUID_SIZE> deviceUUID = GetDeviceUUID();
+    memcpy(uuid, deviceUUID.data(), sizeof(CUuuid));
+    return CUDA_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The new context is current on the calling thread
+CUresult FakeCudaApi::CtxCreate(CUcontext* context, unsigned int flags, CUdevice device) {
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    if (!g_fakeCudaInitialized) {
+        return CUDA_ERROR_NOT_INITIALIZED;
+    }
+    if (nullptr == context) {
+        return CUDA_ERROR_INVALID_VALUE;
+    }
+    if (FAKE_CUDA_DEVICE != device) {
+        return CUDA_ERROR_INVALID_DEVICE;
+    }
+
+    FakeCudaContext* fakeContext = new FakeCudaContext();
+    fakeContext->Device = device;
+    g_fakeCudaContexts.insert(fakeContext);
+    t_fakeCudaCurrentContext = fakeContext;
+    *context = reinterpret_cast<CUcontext>(fakeContext);
+    return CUDA_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+CUresult FakeCudaApi::CtxDestroy(CUcontext context) {
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    FakeCudaContext* fakeContext = reinterpret_cast<FakeCudaContext*>(context);
+    if (0 == g_fakeCudaContexts.erase(fakeContext)) {
+        return CUDA_ERROR_INVALID_CONTEXT;
+    }
+
+    if (t_fakeCudaCurrentContext == fakeContext) {
+        t_fakeCudaCurrentContext = nullptr;
+    }
+    delete fakeContext;
+    return CUDA_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//nullptr: no context is current
+CUresult FakeCudaApi::CtxSetCurrent(CUcontext context) {
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    FakeCudaContext* fakeContext = reinterpret_cast<FakeCudaContext*>(context);
+    if (nullptr != fakeContext && 0 == g_fakeCudaContexts.count(fakeContext)) {
+        return CUDA_ERROR_INVALID_CONTEXT;
+    }
+
+    t_fakeCudaCurrentContext = fakeContext;
+    return CUDA_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+CUresult FakeCudaApi::ImportExternalMemory(CUexternalMemory* extMemory,
+    const CUDA_EXTERNAL_MEMORY_HANDLE_DESC* memHandleDesc)
+{
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    if (nullptr == extMemory || nullptr == memHandleDesc || 0 == memHandleDesc->size) {
+        return CUDA_ERROR_INVALID_VALUE;
+    }
+    if (nullptr == t_fakeCudaCurrentContext) {
+        return CUDA_ERROR_INVALID_CONTEXT;
+    }
+
+    FakeCudaExternalMemory* externalMemory = new FakeCudaExternalMemory();
+    externalMemory->Size = memHandleDesc->size;
+    externalMemory->NumMappedArrays = 0;
+    g_fakeCudaExternalMemories.insert(externalMemory);
+    *extMemory = reinterpret_cast<CUexternalMemory>(externalMemory);
+    return CUDA_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//4 bytes per channel, as CudaImage uses CU_AD_FORMAT_UNSIGNED_INT32
+CUresult FakeCudaApi::ExternalMemoryGetMappedMipmappedArray(CUmipmappedArray* mipmap, CUexternalMemory extMemory,
+    const CUDA_EXTERNAL_MEMORY_MIPMAPPED_ARRAY_DESC* mipmapDesc)
+{
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    FakeCudaExternalMemory* externalMemory = reinterpret_cast<FakeCudaExternalMemory*>(extMemory);
+    if (0 == g_fakeCudaExternalMemories.count(externalMemory)) {
+        return CUDA_ERROR_INVALID_HANDLE;
+    }
+    if (nullptr == mipmap || nullptr == mipmapDesc || 0 == mipmapDesc->numLevels) {
+        return CUDA_ERROR_INVALID_VALUE;
+    }
+
+    const CUDA_ARRAY3D_DESCRIPTOR& arrayDesc = mipmapDesc->arrayDesc;
+    const unsigned long long size = static_cast<unsigned long long>(arrayDesc.Width) * arrayDesc.Height
+        * arrayDesc.NumChannels * 4;
+    if (0 == size || mipmapDesc->offset + size > externalMemory->Size) {
+        return CUDA_ERROR_INVALID_VALUE;
+    }
+
+    FakeCudaMipmappedArray* mipmappedArray = new FakeCudaMipmappedArray();
+    mipmappedArray->ExternalMemory = externalMemory;
+    mipmappedArray->Levels.resize(mipmapDesc->numLevels);
+    for (uint32_t i = 0; i < mipmapDesc->numLevels; ++i) {
+        mipmappedArray->Levels[i].Width = ((arrayDesc.Width >> i) > 0) ? (arrayDesc.Width >> i) : 1;
+        mipmappedArray->Levels[i].Height = ((arrayDesc.Height >> i) > 0) ? (arrayDesc.Height >> i) : 1;
+    }
+
+    ++externalMemory->NumMappedArrays;
+    g_fakeCudaMipmappedArrays.insert(mipmappedArray);
+    *mipmap = reinterpret_cast<CUmipmappedArray>(mipmappedArray);
+    return CUDA_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+CUresult FakeCudaApi::MipmappedArrayGetLevel(CUarray* levelArray, CUmipmappedArray mipmap, unsigned int level) {
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    FakeCudaMipmappedArray* mipmappedArray = reinterpret_cast<FakeCudaMipmappedArray*>(mipmap);
+    if (0 == g_fakeCudaMipmappedArrays.count(mipmappedArray)) {
+        return CUDA_ERROR_INVALID_HANDLE;
+    }
+    if (nullptr == levelArray || level >= mipmappedArray->Levels.size()) {
+        return CUDA_ERROR_INVALID_VALUE;
+    }
+
+    *levelArray = reinterpret_cast<CUarray>(&mipmappedArray->Levels[level]);
+    return CUDA_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+CUresult FakeCudaApi::MipmappedArrayDestroy(CUmipmappedArray mipmap) {
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    FakeCudaMipmappedArray* mipmappedArray = reinterpret_cast<FakeCudaMipmappedArray*>(mipmap);
+    if (0 == g_fakeCudaMipmappedArrays.erase(mipmappedArray)) {
+        return CUDA_ERROR_INVALID_HANDLE;
+    }
+
+    --mipmappedArray->ExternalMemory->NumMappedArrays;
+    delete mipmappedArray;
+    return CUDA_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The arrays which are mapped on the memory have to be destroyed first
+CUresult FakeCudaApi::DestroyExternalMemory(CUexternalMemory extMemory) {
+    std::lock_guard<std::mutex> lock(g_fakeCudaMutex);
+    FakeCudaExternalMemory* externalMemory = reinterpret_cast<FakeCudaExternalMemory*>(extMemory);
+    if (0 == g_fakeCudaExternalMemories.count(externalMemory)) {
+        return CUDA_ERROR_INVALID_HANDLE;
+    }
+    if (externalMemory->NumMappedArrays > 0) {
+        return CUDA_ERROR_INVALID_VALUE;
+    }
+
+    g_fakeCudaExternalMemories.erase(externalMemory);
+    delete externalMemory;
+    return CUDA_SUCCESS;
+}
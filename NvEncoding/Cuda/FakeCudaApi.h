@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vulkan/vulkan.h> //VK_UUID_SIZE
+#include <stdint.h>
+#include <array>
+
+#include "CudaApi.h"
+
+//CUDA without a driver, to run CudaContext, CudaImage and NvEncoder (with FakeNvEncodeApi) on any machine.
+//FillFunctionList() fills the function list which is given to CudaApi::SetFunctionList().
+//There is one device, whose UUID is GetDeviceUUID(). Contexts, external memory and arrays are only handles, which
+//are checked when they are used and destroyed, like the driver does: e.g. memory can only be imported while a
+//context is current on the thread, and can't be destroyed while an array is mapped on it.
+//The imported handles aren't used, and don't need to refer to memory
+class FakeCudaApi {
+public:
+    static void FillFunctionList(CudaFunctionList* functionList);
+    static std::array<uint8_t, VK_UUID_SIZE> GetDeviceUUID();
+
+    //Contexts, external memory and mipmapped arrays which haven't been destroyed
+    static uint32_t GetNumLiveObjects();
+
+private:
+    static CUresult CUDAAPI Init(unsigned int flags);
+    static CUresult CUDAAPI DeviceGetCount(int* count);
+    static CUresult CUDAAPI DeviceGet(CUdevice* device, int ordinal);
+    static CUresult CUDAAPI DeviceGetUuid(CUuuid* uuid, CUdevice device);
+    static CUresult CUDAAPI CtxCreate(CUcontext* context, unsigned int flags, CUdevice device);
+    static CUresult CUDAAPI CtxDestroy(CUcontext context);
+    static CUresult CUDAAPI CtxSetCurrent(CUcontext context);
+    static CUresult CUDAAPI ImportExternalMemory(CUexternalMemory* extMemory,
+        const CUDA_EXTERNAL_MEMORY_HANDLE_DESC* memHandleDesc);
+    static CUresult CUDAAPI ExternalMemoryGetMappedMipmappedArray(CUmipmappedArray* mipmap,
+        CUexternalMemory extMemory, const CUDA_EXTERNAL_MEMORY_MIPMAPPED_ARRAY_DESC* mipmapDesc);
+    static CUresult CUDAAPI MipmappedArrayGetLevel(CUarray* levelArray, CUmipmappedArray mipmap, unsigned int level);
+    static CUresult CUDAAPI MipmappedArrayDestroy(CUmipmappedArray mipmap);
+    static CUresult CUDAAPI DestroyExternalMemory(CUexternalMemory extMemory);
+};
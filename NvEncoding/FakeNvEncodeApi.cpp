@@ -0,0 +1,638 @@
+#include "FakeNvEncodeApi.h"
+#include <vector>
+#include <deque>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstring> //memcpy
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+//A registered input. Its handle is also the handle of the mapped input
+struct FakeResource {
+    uint32_t    Width;
+    uint32_t    Height;
+    bool        IsMapped;
+    uint32_t    NumPendingPictures; //Encoded from this input, and not finished yet
+};
+
+struct FakeBitstreamBuffer {
+    std::vector<uint8_t>    Data;
+    NV_ENC_PIC_TYPE         PictureType;
+    uint32_t                FrameIdx;
+    uint64_t                TimeStamp;
+    bool                    IsPending;  //From nvEncEncodePicture() until nvEncUnlockBitstream()
+    bool                    IsEncoded;
+    bool                    IsLocked;
+};
+
+struct FakePicture {
+    FakeBitstreamBuffer*    Output; //nullptr: EOS
+    FakeResource*           Input;
+    void*                   CompletionEvent;
+    std::chrono::steady_clock::time_point EncodedTime;
+};
+
+struct FakeSession {
+    FakeNvEncodeParams  Params;
+    bool                IsInitialized;
+    bool                IsAsync;
+    bool                IsIDRForced;    //The next picture is an IDR frame
+    uint32_t            Width;
+    uint32_t            Height;
+    uint32_t            MaxWidth;
+    uint32_t            MaxHeight;
+    uint32_t            NumPictures;
+
+    std::set<FakeResource*>         Resources;
+    std::set<FakeBitstreamBuffer*>  BitstreamBuffers;
+    std::set<void*>                 CompletionEvents;
+
+    //The pictures are encoded by Worker in submission order
+    std::mutex                              Mutex;
+    std::condition_variable                 PictureQueued;
+    std::condition_variable                 PictureEncoded;
+    std::deque<FakePicture>                 Pictures;
+    std::chrono::steady_clock::time_point   EngineFreeTime;
+    bool                                    IsDestroyed;
+    std::thread                             Worker;
+};
+
+static std::mutex           g_fakeNvEncodeMutex;
+static FakeNvEncodeParams   g_fakeNvEncodeParams = {};
+static FakeNvEncodeCounters g_fakeNvEncodeCounters = {};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+static void CountCall(uint64_t FakeNvEncodeCounters::* counter) {
+    std::lock_guard<std::mutex> lock(g_fakeNvEncodeMutex);
+    ++(g_fakeNvEncodeCounters.*counter);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+static void SignalCompletionEvent(void* completionEvent) {
+#ifdef _WIN32
+    if (nullptr != completionEvent) {
+        SetEvent(static_cast<HANDLE>(completionEvent));
+    }
+#else
+    (void)completionEvent;
+#endif
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The start code and the header of an H.264 NAL unit, followed by a pattern of the frame index
+static void WriteBitstream(const uint32_t frameIdx, const bool isKeyFrame, const uint32_t size,
+    std::vector<uint8_t>* data)
+{
+    const uint8_t header[] = { 0, 0, 0, 1, static_cast<uint8_t>(isKeyFrame ? 0x65 : 0x41) };
+    data->resize((size > sizeof(header)) ? size : sizeof(header));
+    memcpy(data->data(), header, sizeof(header));
+
+    const size_t dataSize = data->size();
+    for (size_t i = sizeof(header); i < dataSize; ++i) {
+        (*data)[i] = static_cast<uint8_t>(frameIdx + i);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Runs until the session is destroyed. The pending pictures are then never finished
+static void EncodePictures(FakeSession* session) {
+    std::unique_lock<std::mutex> lock(session->Mutex);
+    while (!session->IsDestroyed) {
+        if (session->Pictures.empty()) {
+            session->PictureQueued.wait(lock);
+            continue;
+        }
+
+        //The encoder engine is busy until then
+        const std::chrono::steady_clock::time_point encodedTime = session->Pictures.front().EncodedTime;
+        if (std::chrono::steady_clock::now() < encodedTime) {
+            session->PictureQueued.wait_until(lock, encodedTime);
+            continue;
+        }
+
+        const FakePicture picture = session->Pictures.front();
+        session->Pictures.pop_front();
+        if (nullptr != picture.Output) {
+            picture.Output->IsEncoded = true;
+            --picture.Input->NumPendingPictures;
+        }
+        SignalCompletionEvent(picture.CompletionEvent);
+        session->PictureEncoded.notify_all();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FakeNvEncodeApi::FillFunctionList(const FakeNvEncodeParams& params, NV_ENCODE_API_FUNCTION_LIST* functionList) {
+    {
+        std::lock_guard<std::mutex> lock(g_fakeNvEncodeMutex);
+        g_fakeNvEncodeParams = params;
+    }
+
+    *functionList = { NV_ENCODE_API_FUNCTION_LIST_VER };
+    functionList->nvEncOpenEncodeSessionEx = OpenEncodeSessionEx;
+    functionList->nvEncGetEncodeCaps = GetEncodeCaps;
+    functionList->nvEncGetEncodePresetConfig = GetEncodePresetConfig;
+    functionList->nvEncInitializeEncoder = InitializeEncoder;
+    functionList->nvEncReconfigureEncoder = ReconfigureEncoder;
+    functionList->nvEncDestroyEncoder = DestroyEncoder;
+    functionList->nvEncCreateBitstreamBuffer = CreateBitstreamBuffer;
+    functionList->nvEncDestroyBitstreamBuffer = DestroyBitstreamBuffer;
+    functionList->nvEncRegisterAsyncEvent = RegisterAsyncEvent;
+    functionList->nvEncUnregisterAsyncEvent = UnregisterAsyncEvent;
+    functionList->nvEncRegisterResource = RegisterResource;
+    functionList->nvEncUnregisterResource = UnregisterResource;
+    functionList->nvEncMapInputResource = MapInputResource;
+    functionList->nvEncUnmapInputResource = UnmapInputResource;
+    functionList->nvEncEncodePicture = EncodePicture;
+    functionList->nvEncLockBitstream = LockBitstream;
+    functionList->nvEncUnlockBitstream = UnlockBitstream;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+FakeNvEncodeCounters FakeNvEncodeApi::GetCounters() {
+    std::lock_guard<std::mutex> lock(g_fakeNvEncodeMutex);
+    return g_fakeNvEncodeCounters;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FakeNvEncodeApi::ResetCounters() {
+    std::lock_guard<std::mutex> lock(g_fakeNvEncodeMutex);
+    g_fakeNvEncodeCounters = {};
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::OpenEncodeSessionEx(NV_ENC_OPEN_ENCODE_SESSION_EX_PARAMS* openSessionExParams,
+    void** encoder)
+{
+    if (nullptr == openSessionExParams || nullptr == encoder) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+    if (NV_ENC_DEVICE_TYPE_CUDA != openSessionExParams->deviceType) {
+        return NV_ENC_ERR_UNSUPPORTED_DEVICE;
+    }
+    if (NVENCAPI_VERSION != openSessionExParams->apiVersion) {
+        return NV_ENC_ERR_INVALID_VERSION;
+    }
+
+    FakeSession* session = new FakeSession();
+    {
+        std::lock_guard<std::mutex> lock(g_fakeNvEncodeMutex);
+        session->Params = g_fakeNvEncodeParams;
+    }
+#ifndef _WIN32
+    session->Params.AsyncEncodeSupported = false;
+#endif
+    session->IsInitialized = false;
+    session->IsAsync = false;
+    session->IsIDRForced = true;
+    session->Width = session->Height = session->MaxWidth = session->MaxHeight = 0;
+    session->NumPictures = 0;
+    session->EngineFreeTime = std::chrono::steady_clock::now();
+    session->IsDestroyed = false;
+    session->Worker = std::thread(EncodePictures, session);
+
+    *encoder = session;
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::GetEncodeCaps(void* encoder, GUID encodeGUID, NV_ENC_CAPS_PARAM* capsParam,
+    int* capsVal)
+{
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session || nullptr == capsParam || nullptr == capsVal) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    //Nothing else is supported
+    *capsVal = 0;
+    if (NV_ENC_CAPS_ASYNC_ENCODE_SUPPORT == capsParam->capsToQuery) {
+        *capsVal = session->Params.AsyncEncodeSupported ? 1 : 0;
+    }
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The config which is passed in is kept
+NVENCSTATUS FakeNvEncodeApi::GetEncodePresetConfig(void* encoder, GUID encodeGUID, GUID presetGUID,
+    NV_ENC_PRESET_CONFIG* presetConfig)
+{
+    if (nullptr == encoder || nullptr == presetConfig) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::InitializeEncoder(void* encoder, NV_ENC_INITIALIZE_PARAMS* createEncodeParams) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session || nullptr == createEncodeParams) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    std::lock_guard<std::mutex> lock(session->Mutex);
+    if (session->IsInitialized) {
+        return NV_ENC_ERR_INVALID_CALL;
+    }
+    if (0 == createEncodeParams->encodeWidth || 0 == createEncodeParams->encodeHeight) {
+        return NV_ENC_ERR_INVALID_PARAM;
+    }
+    if (createEncodeParams->enableEncodeAsync && !session->Params.AsyncEncodeSupported) {
+        return NV_ENC_ERR_UNSUPPORTED_PARAM;
+    }
+
+    session->IsInitialized = true;
+    session->IsAsync = (0 != createEncodeParams->enableEncodeAsync);
+    session->Width = createEncodeParams->encodeWidth;
+    session->Height = createEncodeParams->encodeHeight;
+    session->MaxWidth = (createEncodeParams->maxEncodeWidth > 0) ? createEncodeParams->maxEncodeWidth
+        : session->Width;
+    session->MaxHeight = (createEncodeParams->maxEncodeHeight > 0) ? createEncodeParams->maxEncodeHeight
+        : session->Height;
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::ReconfigureEncoder(void* encoder, NV_ENC_RECONFIGURE_PARAMS* reInitEncodeParams) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session || nullptr == reInitEncodeParams) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    std::lock_guard<std::mutex> lock(session->Mutex);
+    if (!session->IsInitialized) {
+        return NV_ENC_ERR_ENCODER_NOT_INITIALIZED;
+    }
+
+    const NV_ENC_INITIALIZE_PARAMS& params = reInitEncodeParams->reInitEncodeParams;
+    if (0 == params.encodeWidth || 0 == params.encodeHeight || params.encodeWidth > session->MaxWidth
+        || params.encodeHeight > session->MaxHeight || (0 != params.enableEncodeAsync) != session->IsAsync)
+    {
+        return NV_ENC_ERR_INVALID_PARAM;
+    }
+
+    //Like the driver, a new size starts a new H.264 sequence
+    const bool isResized = (params.encodeWidth != session->Width || params.encodeHeight != session->Height);
+    session->Width = params.encodeWidth;
+    session->Height = params.encodeHeight;
+    session->IsIDRForced = session->IsIDRForced || isResized || reInitEncodeParams->resetEncoder 
+        || reInitEncodeParams->forceIDR;
+    CountCall(&FakeNvEncodeCounters::NumReconfigurations);
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Also frees what hasn't been destroyed, like the driver
+NVENCSTATUS FakeNvEncodeApi::DestroyEncoder(void* encoder) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(session->Mutex);
+        session->IsDestroyed = true;
+    }
+    session->PictureQueued.notify_all();
+    session->Worker.join();
+
+    for (FakeResource* resource : session->Resources) {
+        delete resource;
+    }
+    for (FakeBitstreamBuffer* bitstreamBuffer : session->BitstreamBuffers) {
+        delete bitstreamBuffer;
+    }
+    delete session;
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::CreateBitstreamBuffer(void* encoder,
+    NV_ENC_CREATE_BITSTREAM_BUFFER* createBitstreamBufferParams)
+{
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session || nullptr == createBitstreamBufferParams) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    FakeBitstreamBuffer* bitstreamBuffer = new FakeBitstreamBuffer();
+    bitstreamBuffer->PictureType = NV_ENC_PIC_TYPE_P;
+    bitstreamBuffer->FrameIdx = 0;
+    bitstreamBuffer->TimeStamp = 0;
+    bitstreamBuffer->IsPending = bitstreamBuffer->IsEncoded = bitstreamBuffer->IsLocked = false;
+
+    std::lock_guard<std::mutex> lock(session->Mutex);
+    session->BitstreamBuffers.insert(bitstreamBuffer);
+    createBitstreamBufferParams->bitstreamBuffer = bitstreamBuffer;
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::DestroyBitstreamBuffer(void* encoder, NV_ENC_OUTPUT_PTR bitstreamBuffer) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    std::lock_guard<std::mutex> lock(session->Mutex);
+    FakeBitstreamBuffer* buffer = static_cast<FakeBitstreamBuffer*>(bitstreamBuffer);
+    if (0 == session->BitstreamBuffers.count(buffer)) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+    if (buffer->IsPending) {
+        return NV_ENC_ERR_INVALID_CALL;
+    }
+
+    session->BitstreamBuffers.erase(buffer);
+    delete buffer;
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::RegisterAsyncEvent(void* encoder, NV_ENC_EVENT_PARAMS* eventParams) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session || nullptr == eventParams || nullptr == eventParams->completionEvent) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    std::lock_guard<std::mutex> lock(session->Mutex);
+    if (!session->IsAsync) {
+        return NV_ENC_ERR_INVALID_CALL;
+    }
+    session->CompletionEvents.insert(eventParams->completionEvent);
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::UnregisterAsyncEvent(void* encoder, NV_ENC_EVENT_PARAMS* eventParams) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session || nullptr == eventParams) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    std::lock_guard<std::mutex> lock(session->Mutex);
+    if (0 == session->CompletionEvents.erase(eventParams->completionEvent)) {
+        return NV_ENC_ERR_EVENT_NOT_REGISTERD;
+    }
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::RegisterResource(void* encoder, NV_ENC_REGISTER_RESOURCE* registerResParams) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session || nullptr == registerResParams || nullptr == registerResParams->resourceToRegister) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+    if (NV_ENC_INPUT_RESOURCE_TYPE_CUDAARRAY != registerResParams->resourceType
+        && NV_ENC_INPUT_RESOURCE_TYPE_CUDADEVICEPTR != registerResParams->resourceType)
+    {
+        return NV_ENC_ERR_UNSUPPORTED_PARAM;
+    }
+
+    FakeResource* resource = new FakeResource();
+    resource->Width = registerResParams->width;
+    resource->Height = registerResParams->height;
+    resource->IsMapped = false;
+    resource->NumPendingPictures = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(session->Mutex);
+        session->Resources.insert(resource);
+    }
+    registerResParams->registeredResource = resource;
+    CountCall(&FakeNvEncodeCounters::NumRegisteredResources);
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::UnregisterResource(void* encoder, NV_ENC_REGISTERED_PTR registeredResource) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(session->Mutex);
+        FakeResource* resource = static_cast<FakeResource*>(registeredResource);
+        if (0 == session->Resources.count(resource)) {
+            return NV_ENC_ERR_RESOURCE_NOT_REGISTERED;
+        }
+        if (resource->IsMapped) {
+            return NV_ENC_ERR_INVALID_CALL;
+        }
+
+        session->Resources.erase(resource);
+        delete resource;
+    }
+    CountCall(&FakeNvEncodeCounters::NumUnregisteredResources);
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::MapInputResource(void* encoder, NV_ENC_MAP_INPUT_RESOURCE* mapInputResParams) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session || nullptr == mapInputResParams) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(session->Mutex);
+        FakeResource* resource = static_cast<FakeResource*>(mapInputResParams->registeredResource);
+        if (0 == session->Resources.count(resource)) {
+            return NV_ENC_ERR_RESOURCE_NOT_REGISTERED;
+        }
+        if (resource->IsMapped) {
+            return NV_ENC_ERR_INVALID_CALL;
+        }
+
+        resource->IsMapped = true;
+        mapInputResParams->mappedResource = resource;
+        mapInputResParams->mappedBufferFmt = NV_ENC_BUFFER_FORMAT_ARGB;
+    }
+    CountCall(&FakeNvEncodeCounters::NumMappedResources);
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The pictures which are encoded from the input have to be finished
+NVENCSTATUS FakeNvEncodeApi::UnmapInputResource(void* encoder, NV_ENC_INPUT_PTR mappedInputBuffer) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(session->Mutex);
+        FakeResource* resource = static_cast<FakeResource*>(mappedInputBuffer);
+        if (0 == session->Resources.count(resource)) {
+            return NV_ENC_ERR_RESOURCE_NOT_REGISTERED;
+        }
+        if (!resource->IsMapped) {
+            return NV_ENC_ERR_RESOURCE_NOT_MAPPED;
+        }
+        if (resource->NumPendingPictures > 0) {
+            return NV_ENC_ERR_INVALID_CALL;
+        }
+        resource->IsMapped = false;
+    }
+    CountCall(&FakeNvEncodeCounters::NumUnmappedResources);
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::EncodePicture(void* encoder, NV_ENC_PIC_PARAMS* encodePicParams) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session || nullptr == encodePicParams) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(session->Mutex);
+    if (!session->IsInitialized) {
+        return NV_ENC_ERR_ENCODER_NOT_INITIALIZED;
+    }
+    if (session->IsAsync && 0 == session->CompletionEvents.count(encodePicParams->completionEvent)) {
+        return NV_ENC_ERR_INVALID_EVENT;
+    }
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const std::chrono::steady_clock::time_point startTime = (now > session->EngineFreeTime) ? now
+        : session->EngineFreeTime;
+
+    FakePicture picture = {};
+    picture.CompletionEvent = encodePicParams->completionEvent;
+
+    //Finished after the queued pictures
+    if (encodePicParams->encodePicFlags & NV_ENC_PIC_FLAG_EOS) {
+        picture.EncodedTime = startTime;
+        session->Pictures.push_back(picture);
+        lock.unlock();
+        session->PictureQueued.notify_one();
+        return NV_ENC_SUCCESS;
+    }
+
+    FakeResource* input = static_cast<FakeResource*>(encodePicParams->inputBuffer);
+    FakeBitstreamBuffer* output = static_cast<FakeBitstreamBuffer*>(encodePicParams->outputBitstream);
+    if (0 == session->Resources.count(input) || 0 == session->BitstreamBuffers.count(output)) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+    if (!input->IsMapped) {
+        return NV_ENC_ERR_RESOURCE_NOT_MAPPED;
+    }
+    if (output->IsPending) {
+        return NV_ENC_ERR_INVALID_CALL;
+    }
+    if (encodePicParams->inputWidth != session->Width || encodePicParams->inputHeight != session->Height
+        || input->Width < session->Width || input->Height < session->Height)
+    {
+        return NV_ENC_ERR_INVALID_PARAM;
+    }
+
+    const bool isKeyFrame = session->IsIDRForced || (encodePicParams->encodePicFlags & NV_ENC_PIC_FLAG_FORCEIDR);
+    session->IsIDRForced = false;
+    output->PictureType = isKeyFrame ? NV_ENC_PIC_TYPE_IDR : NV_ENC_PIC_TYPE_P;
+    output->FrameIdx = session->NumPictures++;
+    output->TimeStamp = encodePicParams->inputTimeStamp;
+    output->IsPending = true;
+    output->IsEncoded = false;
+    WriteBitstream(output->FrameIdx, isKeyFrame,
+        isKeyFrame ? session->Params.KeyFrameBitstreamSize : session->Params.BitstreamSize, &output->Data);
+    ++input->NumPendingPictures;
+
+    picture.Output = output;
+    picture.Input = input;
+    picture.EncodedTime = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float, std::milli>(session->Params.EncodeLatencyMs));
+    session->EngineFreeTime = picture.EncodedTime;
+    session->Pictures.push_back(picture);
+    lock.unlock();
+    session->PictureQueued.notify_one();
+
+    CountCall(&FakeNvEncodeCounters::NumEncodedPictures);
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::LockBitstream(void* encoder, NV_ENC_LOCK_BITSTREAM* lockBitstreamBufferParams) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session || nullptr == lockBitstreamBufferParams) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(session->Mutex);
+        FakeBitstreamBuffer* buffer = static_cast<FakeBitstreamBuffer*>(lockBitstreamBufferParams->outputBitstream);
+        if (0 == session->BitstreamBuffers.count(buffer)) {
+            return NV_ENC_ERR_INVALID_PTR;
+        }
+        if (!buffer->IsPending || buffer->IsLocked) {
+            return NV_ENC_ERR_INVALID_CALL;
+        }
+
+        if (!buffer->IsEncoded) {
+            if (lockBitstreamBufferParams->doNotWait) {
+                return NV_ENC_ERR_LOCK_BUSY;
+            }
+            session->PictureEncoded.wait(lock, [buffer] { return buffer->IsEncoded; });
+        }
+
+        buffer->IsLocked = true;
+        lockBitstreamBufferParams->bitstreamBufferPtr = buffer->Data.data();
+        lockBitstreamBufferParams->bitstreamSizeInBytes = static_cast<uint32_t>(buffer->Data.size());
+        lockBitstreamBufferParams->frameIdx = buffer->FrameIdx;
+        lockBitstreamBufferParams->outputTimeStamp = buffer->TimeStamp;
+        lockBitstreamBufferParams->pictureType = buffer->PictureType;
+        lockBitstreamBufferParams->pictureStruct = NV_ENC_PIC_STRUCT_FRAME;
+    }
+    CountCall(&FakeNvEncodeCounters::NumLockedBitstreams);
+    return NV_ENC_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NVENCSTATUS FakeNvEncodeApi::UnlockBitstream(void* encoder, NV_ENC_OUTPUT_PTR bitstreamBuffer) {
+    FakeSession* session = static_cast<FakeSession*>(encoder);
+    if (nullptr == session) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+
+    std::lock_guard<std::mutex> lock(session->Mutex);
+    FakeBitstreamBuffer* buffer = static_cast<FakeBitstreamBuffer*>(bitstreamBuffer);
+    if (0 == session->BitstreamBuffers.count(buffer)) {
+        return NV_ENC_ERR_INVALID_PTR;
+    }
+    if (!buffer->IsLocked) {
+        return NV_ENC_ERR_INVALID_CALL;
+    }
+
+    buffer->IsLocked = buffer->IsPending = buffer->IsEncoded = false;
+    return NV_ENC_SUCCESS;
+}
+
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include "nvEncodeAPI.h"
+
+//The parameters of the simulated encoder
+struct FakeNvEncodeParams {
+    float       EncodeLatencyMs;        //Per picture. The pictures are encoded one after another
+    uint32_t    BitstreamSize;          //Bytes of each P frame
+    uint32_t    KeyFrameBitstreamSize;  //Bytes of each IDR frame
+    bool        AsyncEncodeSupported;   //Reported by NV_ENC_CAPS_ASYNC_ENCODE_SUPPORT. Windows only
+};
+
+//The calls which have succeeded since the last ResetCounters()
+struct FakeNvEncodeCounters {
+    uint64_t NumRegisteredResources;
+    uint64_t NumUnregisteredResources;
+    uint64_t NumMappedResources;
+    uint64_t NumUnmappedResources;
+    uint64_t NumEncodedPictures;        //Without EOS
+    uint64_t NumLockedBitstreams;
+    uint64_t NumReconfigurations;
+};
+
+//An NVENC driver without a GPU, to measure the latency and the throughput of NvEncoder, and of its callers.
+//FillFunctionList() fills the function list which is given to NvEncoder::SetApi().
+//The output bitstream of each picture is the start code of an H.264 NAL unit followed by a pattern. A worker
+//thread of each session finishes the queued pictures one after another, EncodeLatencyMs each, and signals their
+//completion events.
+//The calls are checked against the rules of the real driver, e.g. an input must stay mapped while its picture is
+//being encoded, and can't be unregistered while it is mapped: a violation fails, mostly with
+//NV_ENC_ERR_INVALID_CALL.
+//Not supported: sessions of other devices than NV_ENC_DEVICE_TYPE_CUDA, and B frames
+class FakeNvEncodeApi {
+public:
+    //params are used by the sessions which are opened afterwards
+    static void FillFunctionList(const FakeNvEncodeParams& params, NV_ENCODE_API_FUNCTION_LIST* functionList);
+
+    static FakeNvEncodeCounters GetCounters();
+    static void ResetCounters();
+
+private:
+    static NVENCSTATUS NVENCAPI OpenEncodeSessionEx(NV_ENC_OPEN_ENCODE_SESSION_EX_PARAMS* openSessionExParams,
+        void** encoder);
+    static NVENCSTATUS NVENCAPI GetEncodeCaps(void* encoder, GUID encodeGUID, NV_ENC_CAPS_PARAM* capsParam,
+        int* capsVal);
+    static NVENCSTATUS NVENCAPI GetEncodePresetConfig(void* encoder, GUID encodeGUID, GUID presetGUID,
+        NV_ENC_PRESET_CONFIG* presetConfig);
+    static NVENCSTATUS NVENCAPI InitializeEncoder(void* encoder, NV_ENC_INITIALIZE_PARAMS* createEncodeParams);
+    static NVENCSTATUS NVENCAPI ReconfigureEncoder(void* encoder, NV_ENC_RECONFIGURE_PARAMS* reInitEncodeParams);
+    static NVENCSTATUS NVENCAPI DestroyEncoder(void* encoder);
+
+    static NVENCSTATUS NVENCAPI CreateBitstreamBuffer(void* encoder,
+        NV_ENC_CREATE_BITSTREAM_BUFFER* createBitstreamBufferParams);
+    static NVENCSTATUS NVENCAPI DestroyBitstreamBuffer(void* encoder, NV_ENC_OUTPUT_PTR bitstreamBuffer);
+    static NVENCSTATUS NVENCAPI RegisterAsyncEvent(void* encoder, NV_ENC_EVENT_PARAMS* eventParams);
+    static NVENCSTATUS NVENCAPI UnregisterAsyncEvent(void* encoder, NV_ENC_EVENT_PARAMS* eventParams);
+
+    static NVENCSTATUS NVENCAPI RegisterResource(void* encoder, NV_ENC_REGISTER_RESOURCE* registerResParams);
+    static NVENCSTATUS NVENCAPI UnregisterResource(void* encoder, NV_ENC_REGISTERED_PTR registeredResource);
+    static NVENCSTATUS NVENCAPI MapInputResource(void* encoder, NV_ENC_MAP_INPUT_RESOURCE* mapInputResParams);
+    static NVENCSTATUS NVENCAPI UnmapInputResource(void* encoder, NV_ENC_INPUT_PTR mappedInputBuffer);
+
+    static NVENCSTATUS NVENCAPI EncodePicture(void* encoder, NV_ENC_PIC_PARAMS* encodePicParams);
+    static NVENCSTATUS NVENCAPI LockBitstream(void* encoder, NV_ENC_LOCK_BITSTREAM* lockBitstreamBufferParams);
+    static NVENCSTATUS NVENCAPI UnlockBitstream(void* encoder, NV_ENC_OUTPUT_PTR bitstreamBuffer);
+};
@@ -0,0 +1,511 @@
+#include "FrameConsumerApp.h"
+
+#include <stdexcept> //std::runtime_error
+#include <iostream> //cout
+#include <chrono>
+#include <array>
+#include <cstring> //memcmp
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <vulkan/vulkan_win32.h>
+#endif
+
+//Shared
+#include "Shin/Utilities/GraphicsUtility.h"
+#include "Shin/Utilities/Macros.h"
+
+extern VkAllocationCallbacks* g_allocator;
+
+//The frames are handled as soon as they are received
+const int RECEIVE_TIMEOUT_MS = 1000;
+const int CONNECT_TIMEOUT_MS = 5000;
+const uint32_t PRINT_INTERVAL_FRAMES = 60;
+
+//Vulkan owns the file descriptors which it has imported, but not the Windows handles
+#ifndef _WIN32
+const bool IMPORT_OWNS_HANDLES = true;
+#else
+const bool IMPORT_OWNS_HANDLES = false;
+#endif
+
+const std::vector<const char*> g_consumerInstanceExtensions = {
+    VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, //the device UUID
+    VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME,
+    VK_KHR_EXTERNAL_SEMAPHORE_CAPABILITIES_EXTENSION_NAME,
+};
+
+const std::vector<const char*> g_consumerDeviceExtensions = {
+    VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME,
+    VK_KHR_EXTERNAL_SEMAPHORE_EXTENSION_NAME,
+#ifndef _WIN32
+    VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME,
+    VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME,
+#else
+    VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME,
+    VK_KHR_EXTERNAL_SEMAPHORE_WIN32_EXTENSION_NAME,
+#endif
+    VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
+};
+
+
+//---------------------------------------------------------------------------------------------------------------------
+
+FrameConsumerApp::FrameConsumerApp() : m_setup({}), m_instance(VK_NULL_HANDLE), m_physicalDevice(VK_NULL_HANDLE)
+    , m_logicalDevice(VK_NULL_HANDLE), m_queueFamilyIndex(0), m_queue(VK_NULL_HANDLE)
+    , m_renderedSemaphore(VK_NULL_HANDLE), m_releasedSemaphore(VK_NULL_HANDLE)
+    , m_commandPool(VK_NULL_HANDLE), m_commandBuffer(VK_NULL_HANDLE), m_fence(VK_NULL_HANDLE)
+    , m_buffer(VK_NULL_HANDLE), m_bufferMemory(VK_NULL_HANDLE), m_mappedData(nullptr), m_numCopiedFrames(0)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameConsumerApp::Run(const std::string& socketPath, const float durationSeconds) {
+    m_socket.Connect(socketPath);
+
+    //The exporter sends the setup as soon as it has accepted the connection, on its next frame
+    std::vector<Shin::FrameSharingHandle> handles;
+    if (!m_socket.Receive(&m_setup, sizeof(m_setup), CONNECT_TIMEOUT_MS, &handles)) {
+        throw std::runtime_error("failed to receive frame sharing setup!");
+    }
+    if (Shin::FRAME_SHARING_MAGIC != m_setup.Magic || Shin::FRAME_SHARING_VERSION != m_setup.Version
+        || m_setup.NumImages > Shin::FRAME_SHARING_MAX_IMAGES || handles.size() != m_setup.NumImages + 2)
+    {
+        Shin::CloseFrameSharingHandles(handles, 0);
+        throw std::runtime_error("failed to receive frame sharing setup: unsupported version!");
+    }
+
+    uint32_t numImportedHandles = 0;
+    try {
+        InitVulkanInstance();
+        PickPhysicalDevice(m_setup.DeviceUUID);
+        CreateLogicalDevice();
+
+        ImportImages(handles, &numImportedHandles);
+        ImportSemaphore(handles[m_setup.NumImages], &m_renderedSemaphore);
+        ++numImportedHandles;
+        ImportSemaphore(handles[m_setup.NumImages + 1], &m_releasedSemaphore);
+        ++numImportedHandles;
+    } catch (...) {
+        Shin::CloseFrameSharingHandles(handles, IMPORT_OWNS_HANDLES ? numImportedHandles : 0);
+        throw;
+    }
+    if (!IMPORT_OWNS_HANDLES) {
+        Shin::CloseFrameSharingHandles(handles, 0);
+    }
+    CreateCopyResources();
+
+    std::cout << "Consumer: imported " << m_setup.NumImages << " images of " << m_setup.Width << "x"
+        << m_setup.Height << std::endl;
+
+    Loop(durationSeconds);
+    CleanUp();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameConsumerApp::InitVulkanInstance() {
+    VkApplicationInfo appInfo = {};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "Frame Consumer";
+    appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.pEngineName = "No Engine";
+    appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.apiVersion = VK_API_VERSION_1_0;
+
+    VkInstanceCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    createInfo.pApplicationInfo = &appInfo;
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(g_consumerInstanceExtensions.size());
+    createInfo.ppEnabledExtensionNames = g_consumerInstanceExtensions.data();
+
+    if (vkCreateInstance(&createInfo, g_allocator, &m_instance) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create instance!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The memory can only be imported on the device which exported it
+void FrameConsumerApp::PickPhysicalDevice(const uint8_t* deviceUUID) {
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(m_instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(m_instance, &deviceCount, devices.data());
+
+    for (const VkPhysicalDevice device : devices) {
+        std::array<uint8_t, VK_UUID_SIZE> uuid;
+        GraphicsUtility::GetPhysicalDeviceUUIDInto(m_instance, device, &uuid);
+        if (0 != memcmp(uuid.data(), deviceUUID, VK_UUID_SIZE))
+            continue;
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+
+        //Graphics and compute queues also support transfers
+        const VkQueueFlags transferFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+        for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+            if (queueFamilies[i].queueCount > 0 && 0 != (queueFamilies[i].queueFlags & transferFlags)) {
+                m_physicalDevice = device;
+                m_queueFamilyIndex = i;
+                return;
+            }
+        }
+    }
+
+    throw std::runtime_error("failed to find the GPU of the exporter!");
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameConsumerApp::CreateLogicalDevice() {
+    const float queuePriority = 1.0f;
+    VkDeviceQueueCreateInfo queueCreateInfo = {};
+    queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueCreateInfo.queueFamilyIndex = m_queueFamilyIndex;
+    queueCreateInfo.queueCount = 1;
+    queueCreateInfo.pQueuePriorities = &queuePriority;
+
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    timelineFeatures.timelineSemaphore = VK_TRUE;
+
+    VkPhysicalDeviceFeatures deviceFeatures = {};
+    VkDeviceCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = &timelineFeatures;
+    createInfo.pQueueCreateInfos = &queueCreateInfo;
+    createInfo.queueCreateInfoCount = 1;
+    createInfo.pEnabledFeatures = &deviceFeatures;
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(g_consumerDeviceExtensions.size());
+    createInfo.ppEnabledExtensionNames = g_consumerDeviceExtensions.data();
+
+    if (vkCreateDevice(m_physicalDevice, &createInfo, g_allocator, &m_logicalDevice) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create logical device!");
+    }
+    vkGetDeviceQueue(m_logicalDevice, m_queueFamilyIndex, 0, &m_queue);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The images are created with the same parameters as the exported ones, and bound at the beginning of the
+//imported memory
+void FrameConsumerApp::ImportImages(const std::vector<Shin::FrameSharingHandle>& handles,
+    uint32_t* numImportedHandles)
+{
+    const uint32_t numImages = m_setup.NumImages;
+    m_images.resize(numImages);
+    for (uint32_t i = 0; i < numImages; ++i) {
+        ImportedImage& imported = m_images[i];
+        imported = {};
+
+#ifndef _WIN32
+        VkImportMemoryFdInfoKHR importInfo = {};
+        importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR;
+        importInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT_KHR;
+        importInfo.fd = handles[i];
+#else
+        VkImportMemoryWin32HandleInfoKHR importInfo = {};
+        importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_WIN32_HANDLE_INFO_KHR;
+        importInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT_KHR;
+        importInfo.handle = handles[i];
+#endif
+
+        VkExternalMemoryImageCreateInfoKHR externalInfo = {};
+        externalInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO_KHR;
+        externalInfo.handleTypes = importInfo.handleType;
+
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.pNext = &externalInfo;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = { m_setup.Width, m_setup.Height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = static_cast<VkFormat>(m_setup.Format);
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = static_cast<VkImageUsageFlags>(m_setup.Usage);
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        if (vkCreateImage(m_logicalDevice, &imageInfo, g_allocator, &imported.Image) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create imported image!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(m_logicalDevice, imported.Image, &memRequirements);
+
+        VkMemoryAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.pNext = &importInfo;
+        allocInfo.allocationSize = m_setup.MemorySizes[i];
+        allocInfo.memoryTypeIndex = GraphicsUtility::FindMemoryType(m_physicalDevice,
+            memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (vkAllocateMemory(m_logicalDevice, &allocInfo, g_allocator, &imported.Memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to import image memory!");
+        }
+        ++(*numImportedHandles);
+        vkBindImageMemory(m_logicalDevice, imported.Image, imported.Memory, 0);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameConsumerApp::ImportSemaphore(const Shin::FrameSharingHandle handle, VkSemaphore* semaphore) {
+    *semaphore = GraphicsUtility::CreateTimelineSemaphore(m_logicalDevice, g_allocator, 0, false);
+
+#ifndef _WIN32
+    auto importSemaphore = (PFN_vkImportSemaphoreFdKHR)
+        vkGetDeviceProcAddr(m_logicalDevice, "vkImportSemaphoreFdKHR");
+
+    VkImportSemaphoreFdInfoKHR importInfo = {};
+    importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_FD_INFO_KHR;
+    importInfo.handleType = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT_KHR;
+    importInfo.fd = handle;
+#else
+    auto importSemaphore = (PFN_vkImportSemaphoreWin32HandleKHR)
+        vkGetDeviceProcAddr(m_logicalDevice, "vkImportSemaphoreWin32HandleKHR");
+
+    VkImportSemaphoreWin32HandleInfoKHR importInfo = {};
+    importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_WIN32_HANDLE_INFO_KHR;
+    importInfo.handleType = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_WIN32_BIT_KHR;
+    importInfo.handle = handle;
+#endif
+    importInfo.semaphore = *semaphore;
+    if (nullptr == importSemaphore || importSemaphore(m_logicalDevice, &importInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to import semaphore!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameConsumerApp::CreateCopyResources() {
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = m_queueFamilyIndex;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    if (vkCreateCommandPool(m_logicalDevice, &poolInfo, g_allocator, &m_commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create command pool!");
+    }
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(m_logicalDevice, &allocInfo, &m_commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate command buffers!");
+    }
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(m_logicalDevice, &fenceInfo, g_allocator, &m_fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create fence!");
+    }
+
+    const VkDeviceSize size = static_cast<VkDeviceSize>(m_setup.Width) * m_setup.Height * 4;
+    GraphicsUtility::CreateBuffer(m_physicalDevice, m_logicalDevice, g_allocator, size,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &m_buffer, &m_bufferMemory);
+
+    void* data = nullptr;
+    if (vkMapMemory(m_logicalDevice, m_bufferMemory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS) {
+        throw std::runtime_error("failed to map buffer memory!");
+    }
+    m_mappedData = static_cast<const uint8_t*>(data);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameConsumerApp::Loop(const float durationSeconds) {
+    const auto startTime = std::chrono::steady_clock::now();
+    float elapsedSeconds = 0.0f;
+    while (elapsedSeconds < durationSeconds) {
+        Shin::FrameSharingFrame frame;
+        if (ReceiveLatestFrame(&frame)) {
+            CopyFrame(frame);
+        } else if (!m_socket.IsConnected()) {
+            std::cout << "Consumer: the exporter has gone" << std::endl;
+            break;
+        }
+
+        elapsedSeconds = std::chrono::duration<float, std::chrono::seconds::period>(
+            std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    std::cout << "Consumer: copied " << m_numCopiedFrames << " frames in " << elapsedSeconds << " seconds"
+        << std::endl;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Only the latest of the queued frames is copied. Releasing it also releases the skipped ones,
+//whose values are smaller
+bool FrameConsumerApp::ReceiveLatestFrame(Shin::FrameSharingFrame* frame) {
+    std::vector<Shin::FrameSharingHandle> handles;
+    if (!m_socket.Receive(frame, sizeof(*frame), RECEIVE_TIMEOUT_MS, &handles)) {
+        return false;
+    }
+
+    Shin::FrameSharingFrame nextFrame;
+    while (m_socket.Receive(&nextFrame, sizeof(nextFrame), 0, &handles)) {
+        *frame = nextFrame;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The image is shared with the exporter: it is returned to the layout which the exporter left it in
+void FrameConsumerApp::CopyFrame(const Shin::FrameSharingFrame& frame) {
+    if (frame.ImageIndex >= m_images.size() || frame.Width > m_setup.Width || frame.Height > m_setup.Height) {
+        throw std::runtime_error("failed to copy shared frame: invalid frame!");
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(m_commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+
+    VkImageMemoryBarrier imageBarrier = {};
+    imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    imageBarrier.srcAccessMask = 0; //The semaphore wait makes the writes of the exporter available
+    imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image = m_images[frame.ImageIndex].Image;
+    imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageBarrier.subresourceRange.baseMipLevel = 0;
+    imageBarrier.subresourceRange.levelCount = 1;
+    imageBarrier.subresourceRange.baseArrayLayer = 0;
+    imageBarrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+        0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+    VkBufferImageCopy region = {};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = { frame.Width, frame.Height, 1 };
+    vkCmdCopyImageToBuffer(m_commandBuffer, imageBarrier.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_buffer,
+        1, &region);
+
+    imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    imageBarrier.dstAccessMask = 0;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkBufferMemoryBarrier bufferBarrier = {};
+    bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.buffer = m_buffer;
+    bufferBarrier.offset = 0;
+    bufferBarrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+        0, nullptr, 0, nullptr, 1, &imageBarrier);
+    vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+        0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+    if (vkEndCommandBuffer(m_commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+
+    //Wait for the exporter to render the frame, and release it when the copy has finished
+    const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+    timelineInfo.waitSemaphoreValueCount = 1;
+    timelineInfo.pWaitSemaphoreValues = &frame.Value;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &frame.Value;
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = &m_renderedSemaphore;
+    submitInfo.pWaitDstStageMask = &waitStage;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &m_commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &m_releasedSemaphore;
+    if (vkQueueSubmit(m_queue, 1, &submitInfo, m_fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit copy command buffer!");
+    }
+
+    vkWaitForFences(m_logicalDevice, 1, &m_fence, VK_TRUE, UINT64_MAX);
+    vkResetFences(m_logicalDevice, 1, &m_fence);
+    ++m_numCopiedFrames;
+
+    if (0 != (m_numCopiedFrames % PRINT_INTERVAL_FRAMES))
+        return;
+
+    //Something to show that the pixels have arrived
+    uint64_t sums[4] = {};
+    const uint32_t numPixels = frame.Width * frame.Height;
+    for (uint32_t i = 0; i < numPixels; ++i) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            sums[c] += m_mappedData[i * 4 + c];
+        }
+    }
+    std::cout << "Consumer: frame " << frame.Value << ", " << frame.Width << "x" << frame.Height
+        << ", average color (" << (sums[0] / numPixels) << ", " << (sums[1] / numPixels) << ", "
+        << (sums[2] / numPixels) << ", " << (sums[3] / numPixels) << ")" << std::endl;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameConsumerApp::CleanUp() {
+    m_socket.Close();
+    if (VK_NULL_HANDLE != m_logicalDevice) {
+        vkDeviceWaitIdle(m_logicalDevice);
+
+        if (nullptr != m_mappedData) {
+            vkUnmapMemory(m_logicalDevice, m_bufferMemory);
+            m_mappedData = nullptr;
+        }
+        SAFE_DESTROY_BUFFER(m_logicalDevice, m_buffer, g_allocator);
+        SAFE_FREE_MEMORY(m_logicalDevice, m_bufferMemory, g_allocator);
+        if (VK_NULL_HANDLE != m_fence) {
+            vkDestroyFence(m_logicalDevice, m_fence, g_allocator);
+            m_fence = VK_NULL_HANDLE;
+        }
+        SAFE_DESTROY_COMMAND_POOL(m_logicalDevice, m_commandPool, g_allocator);
+
+        VkSemaphore* semaphores[] = { &m_renderedSemaphore, &m_releasedSemaphore };
+        for (VkSemaphore* semaphore : semaphores) {
+            if (VK_NULL_HANDLE != *semaphore) {
+                vkDestroySemaphore(m_logicalDevice, *semaphore, g_allocator);
+                *semaphore = VK_NULL_HANDLE;
+            }
+        }
+
+        for (ImportedImage& imported : m_images) {
+            SAFE_DESTROY_IMAGE(m_logicalDevice, imported.Image, g_allocator);
+            SAFE_FREE_MEMORY(m_logicalDevice, imported.Memory, g_allocator);
+        }
+        m_images.clear();
+
+        vkDestroyDevice(m_logicalDevice, g_allocator);
+        m_logicalDevice = VK_NULL_HANDLE;
+    }
+
+    if (VK_NULL_HANDLE != m_instance) {
+        vkDestroyInstance(m_instance, g_allocator);
+        m_instance = VK_NULL_HANDLE;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+
+//Shared
+#include "Shin/FrameSharing.h"
+
+//A second process which imports the offscreen frames that NvEncodingApp exports with --export-frames,
+//and copies each of them to host memory on the GPU. Needs no window
+class FrameConsumerApp {
+public:
+    FrameConsumerApp();
+
+    void Run(const std::string& socketPath, const float durationSeconds);
+    void CleanUp();
+
+private:
+    struct ImportedImage {
+        VkImage         Image;
+        VkDeviceMemory  Memory;
+    };
+
+    void InitVulkanInstance();
+    void PickPhysicalDevice(const uint8_t* deviceUUID);
+    void CreateLogicalDevice();
+    void ImportImages(const std::vector<Shin::FrameSharingHandle>& handles, uint32_t* numImportedHandles);
+    void ImportSemaphore(const Shin::FrameSharingHandle handle, VkSemaphore* semaphore);
+    void CreateCopyResources();
+    void Loop(const float durationSeconds);
+
+    //Returns false if no frame has arrived in time, or if the exporter has gone
+    bool ReceiveLatestFrame(Shin::FrameSharingFrame* frame);
+    void CopyFrame(const Shin::FrameSharingFrame& frame);
+
+    Shin::FrameSharingSocket    m_socket;
+    Shin::FrameSharingSetup     m_setup;
+
+    VkInstance                  m_instance;
+    VkPhysicalDevice            m_physicalDevice;
+    VkDevice                    m_logicalDevice;
+    uint32_t                    m_queueFamilyIndex;
+    VkQueue                     m_queue;
+
+    std::vector<ImportedImage>  m_images;
+    VkSemaphore                 m_renderedSemaphore;
+    VkSemaphore                 m_releasedSemaphore;
+
+    //The copies
+    VkCommandPool               m_commandPool;
+    VkCommandBuffer             m_commandBuffer;
+    VkFence                     m_fence;
+    VkBuffer                    m_buffer;
+    VkDeviceMemory              m_bufferMemory;
+    const uint8_t*              m_mappedData;
+
+    uint64_t                    m_numCopiedFrames;
+};
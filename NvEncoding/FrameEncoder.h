@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+enum FrameEncoderType {
+    FRAME_ENCODER_TYPE_NVENC = 0,   //NvEncoder. Reads the offscreen images through Cuda
+    FRAME_ENCODER_TYPE_CPU,         //CpuEncoder. Reads the frames of the readback ring
+};
+
+enum FrameEncoderInputType {
+    FRAME_ENCODER_INPUT_TYPE_CUDA_ARRAY = 0,
+    FRAME_ENCODER_INPUT_TYPE_HOST_MEMORY,
+    FRAME_ENCODER_INPUT_TYPE_HOST_MEMORY_I420,  //Already converted, e.g. by Shin::ColorConversionPass
+};
+
+//Resource: a CUarray, or pixels in host memory.
+//RowPitch: bytes per row of RGBA host memory. 0: the rows are tightly packed at the encoded width.
+//I420 planes are always tightly packed
+struct FrameEncoderInput {
+    FrameEncoderInputType   Type;
+    void*                   Resource;
+    uint32_t                RowPitch;
+};
+
+//The encoders which NvEncodingApp streams the offscreen frames with.
+//The inputs are registered once per index, e.g. per image index, and must stay valid until DestroyBuffers().
+//EncodeFrame() encodes the top-left part of an input, with the size given to Reconfigure().
+//Init() takes the parameters of each backend
+class FrameEncoder {
+public:
+    virtual ~FrameEncoder() {}
+
+    virtual void CleanUp() = 0;
+
+    virtual void CreateBuffers(const uint32_t numBuffers) = 0;
+    virtual void DestroyBuffers() = 0;
+    virtual void RegisterInput(const uint32_t idx, const FrameEncoderInput& input) = 0;
+    virtual void EncodeFrame(const uint32_t idx) = 0;
+
+    //Moves the oldest encoded frame into bitstream. Returns false if there is none
+    virtual bool RetrieveBitstream(std::vector<uint8_t>* bitstream) = 0;
+
+    //The next frame will be a key frame. Can't be larger than the size given to Init()
+    virtual void Reconfigure(const uint32_t width, const uint32_t height) = 0;
+
+    virtual uint32_t GetWidth() const = 0;
+    virtual uint32_t GetHeight() const = 0;
+};
@@ -3,6 +3,12 @@
 #include "NvEncException.h"
 #include <assert.h>
 
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include "Shin/Profiler.h"
+
 //NVEncoder Macros
 #define NVENC_API_CALL( nvencAPI )                                                                                 \
     do                                                                                                             \
@@ -24,25 +30,47 @@
 
 //---------------------------------------------------------------------------------------------------------------------
 
-NvEncoder::NvEncoder() : m_encoder(nullptr), m_isEncoderInitialized(false),
-    m_width(0), m_height(0)
-{
+#ifdef _WIN32
+static const DWORD COMPLETION_EVENT_TIMEOUT_MS = 20000;
+#endif
+
+//---------------------------------------------------------------------------------------------------------------------
 
+NvEncoder::NvEncoder() : m_isApiSet(false), m_encoder(nullptr)
+    , m_pendingOutputs(MAX_OUTPUT_BUFFERS), m_completedOutputs(MAX_OUTPUT_BUFFERS)
+    , m_encodedBitstreams(MAX_ENCODED_BITSTREAMS), m_retrievalFailed(false), m_numDroppedFrames(0)
+    , m_numDiscardedBitstreams(0), m_numRetrievedFrames(0), m_totalLatencyUs(0), m_maxLatencyUs(0)
+    , m_isEncoderInitialized(false), m_isAsync(false), m_width(0), m_height(0)
+{
+    m_nvenc = { NV_ENCODE_API_FUNCTION_LIST_VER };
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
 NvEncoder::~NvEncoder() {
-     
+    //CleanUp() hasn't been called. The thread can't be left running
+    if (m_retrievalThread.joinable()) {
+        m_pendingOutputs.Close();
+        m_retrievalThread.join();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncoder::SetApi(const NV_ENCODE_API_FUNCTION_LIST& api) {
+    m_nvenc = api;
+    m_isApiSet = true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
 void NvEncoder::Init(const NV_ENC_DEVICE_TYPE deviceType, void *device, const uint32_t width, const uint32_t height)
 {
-    LoadNvEncApi();
+    if (!m_isApiSet) {
+        LoadNvEncApi();
+    }
 
-    if (!m_nvenc.nvEncOpenEncodeSession) {
+    if (!m_nvenc.nvEncOpenEncodeSessionEx) {
         NVENC_THROW_ERROR("EncodeAPI not found", NV_ENC_ERR_NO_ENCODE_DEVICE);
     }
 
@@ -65,9 +93,15 @@ void NvEncoder::CleanUp() {
 }
 
 //---------------------------------------------------------------------------------------------------------------------
+//One output buffer per input. The outputs aren't tied to the inputs: they are taken from m_freeOutputs
 void NvEncoder::CreateBuffers(const uint32_t numBuffers) {
+    if (numBuffers > MAX_OUTPUT_BUFFERS) {
+        NVENC_THROW_ERROR("Too many encoder buffers", NV_ENC_ERR_INVALID_PARAM);
+    }
+
     m_registeredInputResources.resize(numBuffers, nullptr);
     m_mappedInputBuffers.resize(numBuffers, nullptr);
+    m_inputsInUse.resize(numBuffers, false);
     m_bitStreamOutputBuffers.resize(numBuffers, nullptr);
 
     for (uint32_t i = 0; i < numBuffers; ++i)
@@ -75,68 +109,313 @@ void NvEncoder::CreateBuffers(const uint32_t numBuffers) {
         NV_ENC_CREATE_BITSTREAM_BUFFER createBitstreamBuffer = { NV_ENC_CREATE_BITSTREAM_BUFFER_VER };
         NVENC_API_CALL(m_nvenc.nvEncCreateBitstreamBuffer(m_encoder, &createBitstreamBuffer));
         m_bitStreamOutputBuffers[i] = createBitstreamBuffer.bitstreamBuffer;
+        m_freeOutputs.push_back(i);
     }
 
+#ifdef _WIN32
+    //The last event signals the end of the stream
+    if (m_isAsync) {
+        m_completionEvents.resize(numBuffers + 1, nullptr);
+        for (uint32_t i = 0; i <= numBuffers; ++i) {
+            m_completionEvents[i] = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+            if (nullptr == m_completionEvents[i]) {
+                NVENC_THROW_ERROR("Failed to create completion event", NV_ENC_ERR_OUT_OF_MEMORY);
+            }
+
+            NV_ENC_EVENT_PARAMS eventParams = { NV_ENC_EVENT_PARAMS_VER };
+            eventParams.completionEvent = m_completionEvents[i];
+            NVENC_API_CALL(m_nvenc.nvEncRegisterAsyncEvent(m_encoder, &eventParams));
+        }
+    }
+#endif
+
+    StartRetrievalThread();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void NvEncoder::DestroyBuffers() {
+    StopRetrievalThread();
+
+    //The pending pictures have been finished, so no input should be in use anymore. One which still is can't be
+    //unmapped while the driver may be encoding it: it is released with the encoder instead.
+    //The first error is thrown once everything has been released
+    NVENCSTATUS status = NV_ENC_SUCCESS;
     const uint32_t numBuffers = static_cast<uint32_t>(m_mappedInputBuffers.size());
     for (uint32_t i = 0; i < numBuffers; ++i)
     {
-        if (m_mappedInputBuffers[i]) {
-            m_nvenc.nvEncUnmapInputResource(m_encoder, m_mappedInputBuffers[i]);
-            m_mappedInputBuffers[i] = nullptr;
+        NVENCSTATUS inputStatus = m_inputsInUse[i] ? NV_ENC_ERR_ENCODER_BUSY : NV_ENC_SUCCESS;
+        if (NV_ENC_SUCCESS == inputStatus && m_mappedInputBuffers[i]) {
+            inputStatus = m_nvenc.nvEncUnmapInputResource(m_encoder, m_mappedInputBuffers[i]);
+        }
+
+        //The driver doesn't unregister a mapped input
+        if (NV_ENC_SUCCESS == inputStatus && m_registeredInputResources[i]) {
+            inputStatus = m_nvenc.nvEncUnregisterResource(m_encoder, m_registeredInputResources[i]);
         }
 
-        if (m_registeredInputResources[i]) {
-            m_nvenc.nvEncUnregisterResource(m_encoder, m_registeredInputResources[i]);
-            m_registeredInputResources[i] = nullptr;
+        m_mappedInputBuffers[i] = nullptr;
+        m_registeredInputResources[i] = nullptr;
+        if (NV_ENC_SUCCESS == status) {
+            status = inputStatus;
         }
     }
     m_mappedInputBuffers.clear();
+    m_inputsInUse.clear();
     m_registeredInputResources.clear();
+    m_freeOutputs.clear();
 
     DestroyBitstreamBuffer();
+
+    if (NV_ENC_SUCCESS != status) {
+        NVENC_THROW_ERROR("Failed to release the encoder inputs", status);
+    }
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void NvEncoder::RegisterInputResource(const uint32_t idx, CUarray input) {
+void NvEncoder::RegisterInput(const uint32_t idx, const FrameEncoderInput& input) {
+    if (FRAME_ENCODER_INPUT_TYPE_CUDA_ARRAY != input.Type) {
+        NVENC_THROW_ERROR("Unsupported input type", NV_ENC_ERR_INVALID_PARAM);
+    }
+    RegisterInputArray(idx, static_cast<CUarray>(input.Resource));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void NvEncoder::RegisterInputArray(const uint32_t idx, CUarray input) {
     assert(idx<m_registeredInputResources.size());
     assert(nullptr == m_registeredInputResources[idx]); //we need to unregister this if we want to suppor reassigning
 
     const NV_ENC_INPUT_RESOURCE_TYPE resourceType = NV_ENC_INPUT_RESOURCE_TYPE_CUDAARRAY;
     const NV_ENC_BUFFER_FORMAT bufferFormat = NV_ENC_BUFFER_FORMAT_ARGB;
 
-    const NV_ENC_REGISTERED_PTR registeredPtr = RegisterResource(input, resourceType, m_width, m_height, m_width,
+    //The largest size, so that Reconfigure() doesn't have to register the inputs again
+    const uint32_t width = m_initializeParams.maxEncodeWidth;
+    const uint32_t height = m_initializeParams.maxEncodeHeight;
+    const NV_ENC_REGISTERED_PTR registeredPtr = RegisterResource(input, resourceType, width, height, width,
         bufferFormat, NV_ENC_INPUT_IMAGE);
 
     m_registeredInputResources[idx] = registeredPtr;
+
+    //Mapped for as long as it is registered, instead of around each picture
+    NV_ENC_MAP_INPUT_RESOURCE mapInputResource = { NV_ENC_MAP_INPUT_RESOURCE_VER };
+    mapInputResource.registeredResource = registeredPtr;
+    NVENC_API_CALL(m_nvenc.nvEncMapInputResource(m_encoder, &mapInputResource));
+    m_mappedInputBuffers[idx] = mapInputResource.mappedResource;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncoder::Reconfigure(const uint32_t width, const uint32_t height) {
+    if (width == m_width && height == m_height) {
+        return;
+    }
+
+    if (width <= 0 || height <= 0 || width > m_initializeParams.maxEncodeWidth 
+        || height > m_initializeParams.maxEncodeHeight) 
+    {
+        NVENC_THROW_ERROR("Invalid encoder width and height", NV_ENC_ERR_INVALID_PARAM);
+    }
+
+    //The pending pictures keep the previous size. The rate control isn't reset
+    NV_ENC_RECONFIGURE_PARAMS reconfigureParams = { NV_ENC_RECONFIGURE_PARAMS_VER };
+    reconfigureParams.reInitEncodeParams = m_initializeParams;
+    reconfigureParams.reInitEncodeParams.encodeWidth = width;
+    reconfigureParams.reInitEncodeParams.encodeHeight = height;
+    reconfigureParams.reInitEncodeParams.darWidth = width;
+    reconfigureParams.reInitEncodeParams.darHeight = height;
+    reconfigureParams.resetEncoder = 0;
+    reconfigureParams.forceIDR = 0;
+    NVENC_API_CALL(m_nvenc.nvEncReconfigureEncoder(m_encoder, &reconfigureParams));
+
+    m_initializeParams = reconfigureParams.reInitEncodeParams;
+    m_width = width;
+    m_height = height;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void NvEncoder::EncodeFrame(const uint32_t imageIndex) {
+    SHIN_PROFILE_FUNCTION();
 
     if (!m_isEncoderInitialized) {
         NVENC_THROW_ERROR("Encoder device not found", NV_ENC_ERR_NO_ENCODE_DEVICE);
     }
 
-    //Map resources
-    NV_ENC_MAP_INPUT_RESOURCE mapInputResource = { NV_ENC_MAP_INPUT_RESOURCE_VER };
-    mapInputResource.registeredResource = m_registeredInputResources[imageIndex];
-    NVENC_API_CALL(m_nvenc.nvEncMapInputResource(m_encoder, &mapInputResource));
-    m_mappedInputBuffers[imageIndex] = mapInputResource.mappedResource;
+    RethrowRetrievalError();
+    ReclaimCompletedOutputs();
+
+    if (m_inputsInUse[imageIndex] || m_freeOutputs.empty()) {
+        ++m_numDroppedFrames;
+        return;
+    }
 
+    PendingOutput pending = {};
+    pending.InputIndex = imageIndex;
+    pending.SubmitTime = std::chrono::steady_clock::now();
 
-    const NVENCSTATUS nvStatus = DoEncode(m_mappedInputBuffers[imageIndex], m_bitStreamOutputBuffers[imageIndex]);
+    //Released by ReclaimCompletedOutputs(). The input is already mapped
+    m_inputsInUse[imageIndex] = true;
+    pending.OutputIndex = m_freeOutputs.back();
+    m_freeOutputs.pop_back();
+    void* completionEvent = m_isAsync ? m_completionEvents[pending.OutputIndex] : nullptr;
+
+    SHIN_PROFILE_SCOPE("DoEncode");
+    const NVENCSTATUS nvStatus = DoEncode(m_mappedInputBuffers[imageIndex], 
+        m_bitStreamOutputBuffers[pending.OutputIndex], completionEvent);
 
     if (NV_ENC_SUCCESS != nvStatus  && NV_ENC_ERR_NEED_MORE_INPUT != nvStatus) {
+        m_inputsInUse[imageIndex] = false;
+        m_freeOutputs.push_back(pending.OutputIndex);
         NVENC_THROW_ERROR("nvEncEncodePicture API failed", nvStatus);
     }
 
-    //Unmap
-    NVENC_API_CALL(m_nvenc.nvEncUnmapInputResource(m_encoder, m_mappedInputBuffers[imageIndex]));
+    //None is written while more input is needed. Then the deferred outputs are written in order
+    m_deferredOutputs.push_back(pending);
+    if (NV_ENC_SUCCESS == nvStatus) {
+        for (const PendingOutput& deferred : m_deferredOutputs) {
+            m_pendingOutputs.Push(deferred);
+        }
+        m_deferredOutputs.clear();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
 
+bool NvEncoder::RetrieveBitstream(std::vector<uint8_t>* bitstream) {
+    RethrowRetrievalError();
+    return m_encodedBitstreams.TryPop(bitstream);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+double NvEncoder::GetAverageLatencyMs() const {
+    const uint64_t numFrames = m_numRetrievedFrames.load();
+    if (0 == numFrames) {
+        return 0.0;
+    }
+    return static_cast<double>(m_totalLatencyUs.load()) / numFrames / 1000.0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+double NvEncoder::GetMaxLatencyMs() const {
+    return static_cast<double>(m_maxLatencyUs.load()) / 1000.0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncoder::StartRetrievalThread() {
+    m_pendingOutputs.Reset();
+    m_retrievalError = nullptr;
+    m_retrievalFailed.store(false);
+    m_retrievalThread = std::thread(&NvEncoder::RetrieveOutputs, this);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncoder::StopRetrievalThread() {
+    if (!m_retrievalThread.joinable()) {
+        return;
+    }
+
+    //Without more input, the deferred outputs are only written at the end of the stream
+    if (!m_deferredOutputs.empty()) {
+        const bool isFlushed = (NV_ENC_SUCCESS == SendEOS());
+        for (const PendingOutput& deferred : m_deferredOutputs) {
+            if (isFlushed) {
+                m_pendingOutputs.Push(deferred);
+                continue;
+            }
+            m_inputsInUse[deferred.InputIndex] = false;
+            m_freeOutputs.push_back(deferred.OutputIndex);
+        }
+        m_deferredOutputs.clear();
+    }
+
+    m_pendingOutputs.Close();
+    m_retrievalThread.join();
+    ReclaimCompletedOutputs();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Runs on the retrieval thread until m_pendingOutputs is closed
+void NvEncoder::RetrieveOutputs() {
+    std::vector<uint8_t> bitstream;
+    PendingOutput pending;
+    while (m_pendingOutputs.Pop(&pending)) {
+        //After an error, the outputs are only returned, so that they and their inputs can be reused
+        if (!m_retrievalFailed.load()) {
+            try {
+                RetrieveOutput(pending, &bitstream);
+            } catch (...) {
+                m_retrievalError = std::current_exception();
+                m_retrievalFailed.store(true);
+            }
+        }
+
+        //Never full: it can hold every output buffer
+        CompletedOutput completed = { pending.OutputIndex, pending.InputIndex };
+        m_completedOutputs.TryPush(&completed);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncoder::RetrieveOutput(const PendingOutput& pending, std::vector<uint8_t>* bitstream) {
+    SHIN_PROFILE_FUNCTION();
+
+#ifdef _WIN32
+    if (m_isAsync) {
+        const HANDLE completionEvent = static_cast<HANDLE>(m_completionEvents[pending.OutputIndex]);
+        if (WAIT_OBJECT_0 != WaitForSingleObject(completionEvent, COMPLETION_EVENT_TIMEOUT_MS)) {
+            NVENC_THROW_ERROR("Failed to wait for the completion event", NV_ENC_ERR_GENERIC);
+        }
+    }
+#endif
+
+    //Synchronous mode: waits until the output has been written
+    NV_ENC_LOCK_BITSTREAM lockBitstream = { NV_ENC_LOCK_BITSTREAM_VER };
+    lockBitstream.outputBitstream = m_bitStreamOutputBuffers[pending.OutputIndex];
+    lockBitstream.doNotWait = 0;
+    NVENC_API_CALL(m_nvenc.nvEncLockBitstream(m_encoder, &lockBitstream));
+
+    const uint8_t* data = static_cast<const uint8_t*>(lockBitstream.bitstreamBufferPtr);
+    bitstream->assign(data, data + lockBitstream.bitstreamSizeInBytes);
+
+    NVENC_API_CALL(m_nvenc.nvEncUnlockBitstream(m_encoder, lockBitstream.outputBitstream));
+
+    const uint64_t latencyUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - pending.SubmitTime).count());
+
+    //The allocation of the oldest retrieved bitstream comes back
+    if (!m_encodedBitstreams.TryPush(bitstream)) {
+        ++m_numDiscardedBitstreams;
+        return;
+    }
+
+    //Only written by this thread
+    m_totalLatencyUs.fetch_add(latencyUs);
+    if (latencyUs > m_maxLatencyUs.load()) {
+        m_maxLatencyUs.store(latencyUs);
+    }
+    ++m_numRetrievedFrames;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncoder::ReclaimCompletedOutputs() {
+    CompletedOutput completed;
+    while (m_completedOutputs.TryPop(&completed)) {
+        m_inputsInUse[completed.InputIndex] = false;
+        m_freeOutputs.push_back(completed.OutputIndex);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncoder::RethrowRetrievalError() {
+    if (m_retrievalFailed.load()) {
+        std::rethrow_exception(m_retrievalError);
+    }
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -167,8 +446,19 @@ void NvEncoder::InitEncoder(const uint32_t width, const uint32_t height) {
     m_width = width;
     m_height = height;
 
-    //use default initialize params
-    NV_ENC_INITIALIZE_PARAMS initializeParams = { NV_ENC_INITIALIZE_PARAMS_VER };
+    //Completion events are only supported on Windows
+    m_isAsync = false;
+#ifdef _WIN32
+    NV_ENC_CAPS_PARAM capsParam = { NV_ENC_CAPS_PARAM_VER };
+    capsParam.capsToQuery = NV_ENC_CAPS_ASYNC_ENCODE_SUPPORT;
+    int asyncEncodeSupport = 0;
+    m_nvenc.nvEncGetEncodeCaps(m_encoder, NV_ENC_CODEC_H264_GUID, &capsParam, &asyncEncodeSupport);
+    m_isAsync = (0 != asyncEncodeSupport);
+#endif
+
+    //use default initialize params. Kept for Reconfigure()
+    m_initializeParams = { NV_ENC_INITIALIZE_PARAMS_VER };
+    NV_ENC_INITIALIZE_PARAMS& initializeParams = m_initializeParams;
 
     initializeParams.version = NV_ENC_INITIALIZE_PARAMS_VER;
     initializeParams.encodeWidth = width;
@@ -184,7 +474,7 @@ void NvEncoder::InitEncoder(const uint32_t width, const uint32_t height) {
     initializeParams.enableSubFrameWrite = 0;
     initializeParams.maxEncodeWidth = width;
     initializeParams.maxEncodeHeight = height;
-    initializeParams.enableEncodeAsync = 0; // Output to GPU
+    initializeParams.enableEncodeAsync = m_isAsync ? 1 : 0;
 //    initializeParams.enableOutputInVidmem = true;
 
     //Always use preset config
@@ -225,6 +515,19 @@ void NvEncoder::DestroyBitstreamBuffer() {
     }
 
     m_bitStreamOutputBuffers.clear();
+
+#ifdef _WIN32
+    for (void* completionEvent : m_completionEvents) {
+        if (nullptr == completionEvent) {
+            continue;
+        }
+        NV_ENC_EVENT_PARAMS eventParams = { NV_ENC_EVENT_PARAMS_VER };
+        eventParams.completionEvent = completionEvent;
+        m_nvenc.nvEncUnregisterAsyncEvent(m_encoder, &eventParams);
+        CloseHandle(static_cast<HANDLE>(completionEvent));
+    }
+#endif
+    m_completionEvents.clear();
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -248,7 +551,8 @@ NV_ENC_REGISTERED_PTR NvEncoder::RegisterResource(void *pBuffer, const NV_ENC_IN
 
 //---------------------------------------------------------------------------------------------------------------------
 
-NVENCSTATUS NvEncoder::DoEncode(NV_ENC_INPUT_PTR inputBuffer, NV_ENC_OUTPUT_PTR outputBuffer) 
+NVENCSTATUS NvEncoder::DoEncode(NV_ENC_INPUT_PTR inputBuffer, NV_ENC_OUTPUT_PTR outputBuffer,
+    void* completionEvent)
 {
     NV_ENC_PIC_PARAMS picParams = {};
     picParams.version = NV_ENC_PIC_PARAMS_VER;
@@ -258,6 +562,7 @@ NVENCSTATUS NvEncoder::DoEncode(NV_ENC_INPUT_PTR inputBuffer, NV_ENC_OUTPUT_PTR
     picParams.inputWidth = m_width;
     picParams.inputHeight = m_height;
     picParams.outputBitstream = outputBuffer;
+    picParams.completionEvent = completionEvent;
     const NVENCSTATUS nvStatus = m_nvenc.nvEncEncodePicture(m_encoder, &picParams);
 
     return nvStatus; 
@@ -265,3 +570,20 @@ NVENCSTATUS NvEncoder::DoEncode(NV_ENC_INPUT_PTR inputBuffer, NV_ENC_OUTPUT_PTR
 }
 
 //---------------------------------------------------------------------------------------------------------------------
+
+//Makes the encoder write every output which it still holds
+NVENCSTATUS NvEncoder::SendEOS() {
+    NV_ENC_PIC_PARAMS picParams = { NV_ENC_PIC_PARAMS_VER };
+    picParams.encodePicFlags = NV_ENC_PIC_FLAG_EOS;
+    picParams.completionEvent = m_isAsync ? m_completionEvents.back() : nullptr;
+    const NVENCSTATUS nvStatus = m_nvenc.nvEncEncodePicture(m_encoder, &picParams);
+
+#ifdef _WIN32
+    if (NV_ENC_SUCCESS == nvStatus && m_isAsync) {
+        WaitForSingleObject(static_cast<HANDLE>(picParams.completionEvent), COMPLETION_EVENT_TIMEOUT_MS);
+    }
+#endif
+    return nvStatus;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
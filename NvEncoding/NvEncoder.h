@@ -1,23 +1,82 @@
 ﻿#pragma once
 #include "nvEncodeAPI.h"
 #include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include "cuda.h"
 
+#include "FrameEncoder.h"
 
-class NvEncoder {
+//Shared
+#include "Shin/StageQueue.h"
+#include "Shin/SpscQueue.h"
+
+//H.264 on NVENC. The inputs are CUarrays: FRAME_ENCODER_INPUT_TYPE_CUDA_ARRAY
+//
+//EncodeFrame() only maps the input and queues the picture with an output buffer of a pool. A retrieval thread
+//waits for each output in submission order, locks its bitstream and hands it over to RetrieveBitstream() through
+//a lock-free queue. It waits on the completion event of the output if the encoder supports asynchronous mode
+//(Windows), and in nvEncLockBitstream() otherwise.
+//Each input is registered with the size given to Init() and mapped once, when it is registered. It is only unmapped
+//by DestroyBuffers(), after the pending pictures have been finished: the driver can't unmap an input which is being
+//encoded.
+//An input is in use until its output has been locked: until then, the frame which is encoded from it is dropped,
+//as are the frames which find no free output buffer.
+//EncodeFrame() and RetrieveBitstream() have to be called on the same thread
+class NvEncoder : public FrameEncoder {
 public:
     NvEncoder();
     ~NvEncoder();
 
+    //Replaces the driver's function list, e.g. with FakeNvEncodeApi. Has to be called before Init()
+    void SetApi(const NV_ENCODE_API_FUNCTION_LIST& api);
+
     void Init(const NV_ENC_DEVICE_TYPE deviceType, void *device, const uint32_t width, const uint32_t height);
-    void CleanUp();
+    void CleanUp() override;
+
+    void CreateBuffers(const uint32_t numBuffers) override;
+    void DestroyBuffers() override;
+    void RegisterInput(const uint32_t idx, const FrameEncoderInput& input) override;
+    void EncodeFrame(const uint32_t imageIndex) override;
+    bool RetrieveBitstream(std::vector<uint8_t>* bitstream) override;
+
+    //Encodes the top-left part of the inputs from the next frame. Can't be larger than the size given to Init().
+    //Neither waits for the pending outputs nor registers the inputs again, but H.264 can't change its size without
+    //a new sequence: the driver starts it with an IDR frame. Callers which change their size often should scale
+    //their inputs instead, like NvEncodingApp
+    void Reconfigure(const uint32_t width, const uint32_t height) override;
 
-    void CreateBuffers(const uint32_t numBuffers);
-    void DestroyBuffers();
-    void RegisterInputResource(const uint32_t idx, CUarray input); 
-    void EncodeFrame(const uint32_t imageIndex);
+    inline uint32_t GetWidth() const override;
+    inline uint32_t GetHeight() const override;
+    inline bool IsAsync() const;
+
+    //Frames which weren't encoded, because their input or every output buffer was still in use
+    inline uint64_t GetNumDroppedFrames() const;
+    //Encoded frames which were thrown away, because RetrieveBitstream() wasn't called often enough
+    inline uint64_t GetNumDiscardedBitstreams() const;
+    inline uint64_t GetNumRetrievedFrames() const;
+
+    //From EncodeFrame() until the bitstream is ready to be retrieved
+    double GetAverageLatencyMs() const;
+    double GetMaxLatencyMs() const;
 
 private:
+    //An output buffer which has been given to nvEncEncodePicture()
+    struct PendingOutput {
+        uint32_t    OutputIndex;
+        uint32_t    InputIndex;
+        std::chrono::steady_clock::time_point SubmitTime;
+    };
+
+    //Returned by the retrieval thread once the bitstream has been unlocked
+    struct CompletedOutput {
+        uint32_t    OutputIndex;
+        uint32_t    InputIndex;
+    };
+
+    void RegisterInputArray(const uint32_t idx, CUarray input); //And maps it
 
     void LoadNvEncApi();
     void InitEncoder(const uint32_t width, const uint32_t height);
@@ -25,25 +84,67 @@ private:
     void DestroyBitstreamBuffer();
 
     NV_ENC_REGISTERED_PTR RegisterResource(void *pBuffer, const NV_ENC_INPUT_RESOURCE_TYPE eResourceType,
-        const uint32_t width, const uint32_t height, const uint32_t pitch, 
-        const NV_ENC_BUFFER_FORMAT bufferFormat, 
+        const uint32_t width, const uint32_t height, const uint32_t pitch,
+        const NV_ENC_BUFFER_FORMAT bufferFormat,
         const NV_ENC_BUFFER_USAGE bufferUsage);
 
-    NVENCSTATUS DoEncode(NV_ENC_INPUT_PTR inputBuffer, NV_ENC_OUTPUT_PTR outputBuffer);
+    NVENCSTATUS DoEncode(NV_ENC_INPUT_PTR inputBuffer, NV_ENC_OUTPUT_PTR outputBuffer, void* completionEvent);
+    NVENCSTATUS SendEOS();
+
+    //Retrieval thread
+    void StartRetrievalThread();
+    void StopRetrievalThread(); //Waits for the pending outputs
+    void RetrieveOutputs();
+    void RetrieveOutput(const PendingOutput& pending, std::vector<uint8_t>* bitstream);
+
+    //Render thread
+    void ReclaimCompletedOutputs();
+    void RethrowRetrievalError();
 
 private:
 
     NV_ENCODE_API_FUNCTION_LIST m_nvenc;
+    bool m_isApiSet; //by SetApi()
     void *m_encoder;
 
     std::vector<NV_ENC_OUTPUT_PTR>      m_bitStreamOutputBuffers;
+    std::vector<void*>                  m_completionEvents; //Asynchronous mode: one per output buffer, and EOS
+    std::vector<uint32_t>               m_freeOutputs;      //Indices of m_bitStreamOutputBuffers
+    std::vector<PendingOutput>          m_deferredOutputs;  //Encoded with NV_ENC_ERR_NEED_MORE_INPUT
     std::vector<NV_ENC_REGISTERED_PTR>  m_registeredInputResources;
-    std::vector<NV_ENC_INPUT_PTR>       m_mappedInputBuffers;
+    std::vector<NV_ENC_INPUT_PTR>       m_mappedInputBuffers; //While the input is registered
+    std::vector<bool>                   m_inputsInUse;        //Until the output of the input has been locked
+
+    std::thread                             m_retrievalThread;
+    Shin::StageQueue<PendingOutput>         m_pendingOutputs;
+    Shin::SpscQueue<CompletedOutput>        m_completedOutputs;
+    Shin::SpscQueue<std::vector<uint8_t>>   m_encodedBitstreams;
+    std::exception_ptr                      m_retrievalError;
+    std::atomic<bool>                       m_retrievalFailed;
+
+    uint64_t                m_numDroppedFrames;
+    std::atomic<uint64_t>   m_numDiscardedBitstreams;
+    std::atomic<uint64_t>   m_numRetrievedFrames;
+    std::atomic<uint64_t>   m_totalLatencyUs;
+    std::atomic<uint64_t>   m_maxLatencyUs;
 
     NV_ENC_CONFIG   m_encodeConfig;
+    NV_ENC_INITIALIZE_PARAMS m_initializeParams;
     bool            m_isEncoderInitialized;
+    bool            m_isAsync;
     uint32_t        m_width;
     uint32_t        m_height;
 
+    static const uint32_t MAX_OUTPUT_BUFFERS = 16;      //Capacity of m_completedOutputs
+    static const uint32_t MAX_ENCODED_BITSTREAMS = 16;  //Capacity of m_encodedBitstreams
 };
 
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t NvEncoder::GetWidth() const { return m_width; }
+uint32_t NvEncoder::GetHeight() const { return m_height; }
+bool NvEncoder::IsAsync() const { return m_isAsync; }
+uint64_t NvEncoder::GetNumDroppedFrames() const { return m_numDroppedFrames; }
+uint64_t NvEncoder::GetNumDiscardedBitstreams() const { return m_numDiscardedBitstreams.load(); }
+uint64_t NvEncoder::GetNumRetrievedFrames() const { return m_numRetrievedFrames.load(); }
+
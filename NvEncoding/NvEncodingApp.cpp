@@ -8,6 +8,7 @@
 #include <set> 
 #include <array> 
 #include <chrono>
+#include <algorithm> //std::find
 
 
 //Shared
@@ -19,6 +20,10 @@
 #include "Shin/Mesh.h"
 #include "Shin/Texture.h"
 #include "Shin/DrawPipeline.h"
+#include "Shin/Profiler.h"
+#include "Shin/RenderGraph.h"
+#include "Shin/UploadBatch.h"
+#include "Shin/ResolutionScaler.h"
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -38,11 +43,15 @@ const std::vector<const char*> g_requiredInstanceExtensions = {
 #endif
     VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, //vkGetPhysicalDeviceProperties2KHR()
     VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME,     //for VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME
-//    VK_KHR_EXTERNAL_SEMAPHORE_CAPABILITIES_EXTENSION_NAME
+    VK_KHR_EXTERNAL_SEMAPHORE_CAPABILITIES_EXTENSION_NAME,  //for the optional frame export
 };
 
-const std::vector<const char*> g_requiredDeviceExtensions = {
+const std::vector<const char*> g_swapChainDeviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+};
+
+//Required for sharing the offscreen textures with Cuda. Optional in headless mode
+const std::vector<const char*> g_encodingDeviceExtensions = {
     VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME, //for the memory extension below
 
 #ifndef _WIN32
@@ -83,6 +92,19 @@ const std::vector<uint16_t> g_indices = {
 const uint32_t OFFSCREEN_TEXTURE_WIDTH =  800;
 const uint32_t OFFSCREEN_TEXTURE_HEIGHT = 600;
 
+//The offscreen pass may use half of a frame of the encoder, which runs at 45 fps
+const float OFFSCREEN_GPU_BUDGET_MS = 1000.0f / 45.0f * 0.5f;
+const float OFFSCREEN_MIN_RESOLUTION_SCALE = 0.5f;
+
+//Frames which are being copied or waiting for a consumer
+const uint32_t READBACK_RING_SIZE = 4;
+
+//Frames which the other processes can read while the next one is published, if they are copied into the ring.
+//If the readback ring imports the shared frame ring, both have READBACK_RING_SIZE slots
+const uint32_t SHARED_FRAME_RING_SIZE = 3;
+
+const float PROFILER_CAPTURE_SECONDS = 10.0f;
+
 
 //---------------------------------------------------------------------------------------------------------------------
 static void WindowResizedCallback(void* userData) {
@@ -92,15 +114,34 @@ static void WindowResizedCallback(void* userData) {
 
 //---------------------------------------------------------------------------------------------------------------------
 
+//Used when leaving because of another error: the jobs may still be using local variables
+static void WaitForJobsIgnoringExceptions(Shin::JobSystem* jobSystem, Shin::JobCounter* counter) {
+    try {
+        jobSystem->Wait(counter);
+    } catch (...) {
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
 NvEncodingApp::NvEncodingApp() 
-    : m_instance(VK_NULL_HANDLE), m_surface(VK_NULL_HANDLE)
+    : m_headless(false), m_headlessDurationSeconds(0.0f), m_encodingEnabled(true), m_numImages(0)
+    , m_instance(VK_NULL_HANDLE), m_surface(VK_NULL_HANDLE)
     , m_physicalDevice(VK_NULL_HANDLE), m_logicalDevice(VK_NULL_HANDLE)
     , m_graphicsQueue(VK_NULL_HANDLE)
-    , m_swapChain(VK_NULL_HANDLE), m_renderPass(VK_NULL_HANDLE)
+    , m_swapChain(VK_NULL_HANDLE), m_renderPass(VK_NULL_HANDLE), m_useDynamicRendering(false)
     , m_descriptorPool(VK_NULL_HANDLE)
     , m_colorDescriptorSetLayout(VK_NULL_HANDLE)
     , m_texDescriptorSetLayout(VK_NULL_HANDLE)
     , m_commandPool(VK_NULL_HANDLE), m_currentFrame(0), m_recreateSwapChainRequested(false)
+    , m_swapChainGeneration(0)
+    , m_timestampQueryPool(VK_NULL_HANDLE), m_numTimestampImages(0), m_timestampsSupported(false)
+    , m_timestampPeriodNs(1.0), m_timestampMask(0)
+    , m_readbackEnabled(false), m_numSubmittedFrames(0), m_numReadbackFrames(0), m_gpuColorConversion(false)
+    , m_externalMemorySupported(false)
+    , m_encoderType(FRAME_ENCODER_TYPE_NVENC), m_frameEncoder(nullptr), m_numEncodedFrames(0), m_numEncodedBytes(0)
+    , m_freeSceneStates(NUM_SCENE_STATES), m_simulatedSceneStates(NUM_SCENE_STATES)
+    , m_recordedFrames(NUM_RECORDED_FRAMES), m_frameLoopRunning(false)
     , m_quadDrawPipeline(nullptr)
     , m_texMesh(nullptr), m_colorMesh(nullptr)
     , m_texture(nullptr)
@@ -110,9 +151,25 @@ NvEncodingApp::NvEncodingApp()
 
 //---------------------------------------------------------------------------------------------------------------------
 
-void NvEncodingApp::Run() {    
-    m_window = new Window();
-    m_window->Init(WIDTH,HEIGHT, WindowResizedCallback, this);
+void NvEncodingApp::Run(const bool headless, const float headlessDurationSeconds, const bool readback, 
+    const std::string& sharedFramesName, const std::string& frameExportPath, const FrameEncoderType encoderType,
+    const bool gpuColorConversion) 
+{    
+    m_headless = headless;
+    m_headlessDurationSeconds = headlessDurationSeconds;
+    m_encoderType = encoderType;
+    m_readbackEnabled = readback || (FRAME_ENCODER_TYPE_CPU == encoderType);
+    m_gpuColorConversion = gpuColorConversion && (FRAME_ENCODER_TYPE_CPU == encoderType) 
+        && sharedFramesName.empty();
+    m_sharedFramesName = sharedFramesName;
+    m_frameExportPath = frameExportPath;
+    m_startupTimeline.Start();
+    if (!m_headless) {
+        const uint32_t windowPhase = m_startupTimeline.BeginPhase("Window");
+        m_window = new Window();
+        m_window->Init(WIDTH,HEIGHT, WindowResizedCallback, this);
+        m_startupTimeline.EndPhase(windowPhase);
+    }
 
     PrintSupportedExtensions();
     Init();
@@ -131,6 +188,11 @@ void NvEncodingApp::Run() {
 //---------------------------------------------------------------------------------------------------------------------
 void NvEncodingApp::Init() {
 
+    //Work which doesn't need the device queue runs on the job system
+    m_jobSystem.Init(0);
+
+    const uint32_t devicePhase = m_startupTimeline.BeginPhase("Vulkan instance and device");
+
     VkApplicationInfo appInfo = {};
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     appInfo.pApplicationName = "Hello Triangle";
@@ -141,7 +203,7 @@ void NvEncodingApp::Init() {
 
     //Get required extension to create Vulkan with GLFW
     std::vector<const char*> extensions;
-    GetRequiredExtensionsInto(&extensions);
+    GetRequiredExtensionsInto(m_headless, &extensions);
 
     std::cout << "Extensions used for initializing: " << std::endl;
     for (const char* extension : extensions) {
@@ -154,43 +216,151 @@ void NvEncodingApp::Init() {
     InitVulkanInstance(appInfo, extensions);
 #endif
 
-    m_window->CreateVulkanSurfaceInto(m_instance, g_allocator, &m_surface);
+    if (!m_headless) {
+        m_window->CreateVulkanSurfaceInto(m_instance, g_allocator, &m_surface);
+    }
     PickPhysicalDevice();
     CreateLogicalDevice();
     CreateDescriptorSetLayout();
     CreateCommandPool();
+    const bool usePipelineLibraries = m_deviceCapabilities.IsGraphicsPipelineLibrarySupported() 
+        && m_deviceCapabilities.IsFastLinkingSupported();
+    std::cout << "Graphics pipeline libraries: " << (usePipelineLibraries ? "enabled" : "disabled") << std::endl;
+    m_useDynamicRendering = m_deviceCapabilities.IsDynamicRenderingSupported();
+    std::cout << "Dynamic rendering: " << (m_useDynamicRendering ? "enabled" : "disabled") << std::endl;
+    m_pipelineCompiler.Init(m_logicalDevice, g_allocator, nullptr, usePipelineLibraries);
+    m_pipelineStateCache.Init(m_logicalDevice, g_allocator, &m_pipelineCompiler);
 
-    //Init texture
-    m_texture = new Shin::Texture();
-    m_texture->Init(m_physicalDevice, m_logicalDevice, g_allocator, m_commandPool,m_graphicsQueue, 
-        "../Resources/Textures/statue.jpg"
-    );
+    m_startupTimeline.EndPhase(devicePhase);
 
-    //Model
-    const uint32_t numIndices = static_cast<uint32_t>(g_indices.size());
+    const uint32_t NUM_DRAW_OBJECTS = 5;
+    const uint32_t NUM_DRAW_PIPELINES    = 2;
+
+    m_texture = new Shin::Texture();
     m_texMesh = new Shin::Mesh();
-    m_texMesh->Init(m_physicalDevice, m_logicalDevice, g_allocator, m_commandPool,m_graphicsQueue, 
-        reinterpret_cast<const char*>(g_texVertices.data()), static_cast<uint32_t>(sizeof(g_texVertices[0]) * g_texVertices.size()),
-        reinterpret_cast<const char*>(g_indices.data()), static_cast<uint32_t>(sizeof(g_indices[0]) * numIndices),
-        numIndices
-    );
     m_colorMesh = new Shin::Mesh();
-    m_colorMesh->Init(m_physicalDevice, m_logicalDevice, g_allocator, m_commandPool,m_graphicsQueue, 
-        reinterpret_cast<const char*>(g_colorVertices.data()), static_cast<uint32_t>(sizeof(g_colorVertices[0]) * g_colorVertices.size()),
-        reinterpret_cast<const char*>(g_indices.data()), static_cast<uint32_t>(sizeof(g_indices[0]) * numIndices),
-        numIndices
-    );
     m_quadMesh = new Shin::Mesh();
-    m_quadMesh->Init(m_physicalDevice, m_logicalDevice, g_allocator, m_commandPool,m_graphicsQueue, 
-        reinterpret_cast<const char*>(g_quadVertices.data()), static_cast<uint32_t>(sizeof(g_quadVertices[0]) * g_quadVertices.size()),
-        reinterpret_cast<const char*>(g_indices.data()), static_cast<uint32_t>(sizeof(g_indices[0]) * numIndices),
-        numIndices
-    );
+    m_drawPipelines.resize(NUM_DRAW_PIPELINES);
+    for (uint32_t i = 0; i < NUM_DRAW_PIPELINES; ++i) {
+        m_drawPipelines[i] = new Shin::DrawPipeline();
+    }
+    m_quadDrawPipeline = new Shin::DrawPipeline();
 
-    CreateSyncObjects();
+    //All objects are opaque. The offscreen objects overlap: they are depth tested and drawn front to back.
+    //The quads are composited in order on the screen, which has no depth buffer
+    Shin::PipelineRenderState opaqueState;
+    opaqueState.Blend = Shin::BLEND_MODE_OPAQUE;
+    Shin::PipelineRenderState depthTestedState = opaqueState;
+    depthTestedState.DepthTest = VK_TRUE;
+    depthTestedState.DepthWrite = VK_TRUE;
+    for (uint32_t i = 0; i < NUM_DRAW_PIPELINES; ++i) {
+        m_drawPipelines[i]->SetRenderState(depthTestedState);
+    }
+    m_quadDrawPipeline->SetRenderState(opaqueState);
+
+    //Jobs: decode the texture, read the shaders and initialize Cuda.
+    //Meanwhile, the main thread records all the GPU uploads into one batch, which is submitted once
+    Shin::JobCounter textureJob;
+    Shin::JobCounter initJobs;
+    std::vector<uint8_t> texturePixels;
+    uint32_t textureWidth = 0, textureHeight = 0;
+    Shin::UploadBatch uploadBatch;
+
+    try {
+        m_jobSystem.Run([this, &texturePixels, &textureWidth, &textureHeight]() {
+            Shin::StartupTimelineScope phase(&m_startupTimeline, "Decode texture");
+            Shin::Texture::LoadPixelsInto("../Resources/Textures/statue.jpg", 
+                &texturePixels, &textureWidth, &textureHeight);
+        }, &textureJob);
+
+        m_jobSystem.Run([this]() {
+            Shin::StartupTimelineScope phase(&m_startupTimeline, "Cuda and NvEncoder");
+            InitCudaAndNvCodec();
+        }, &initJobs);
+
+        #define SHADER_PATH "../Shared/Shaders/"
+
+        m_jobSystem.Run([this]() {
+            Shin::StartupTimelineScope phase(&m_startupTimeline, "Texture shaders");
+            m_drawPipelines[0]->Init(m_logicalDevice, g_allocator,
+                SHADER_PATH "Texture.vert.spv",
+                SHADER_PATH "Texture.frag.spv", 
+                TextureVertex::GetBindingDescription(),
+                TextureVertex::GetAttributeDescriptions(),
+                m_texDescriptorSetLayout
+            );
+        }, &initJobs);
+        m_jobSystem.Run([this]() {
+            Shin::StartupTimelineScope phase(&m_startupTimeline, "Color shaders");
+            m_drawPipelines[1]->Init(m_logicalDevice, g_allocator,
+                SHADER_PATH "Color.vert.spv",
+                SHADER_PATH "Color.frag.spv", 
+                ColorVertex::GetBindingDescription(),
+                ColorVertex::GetAttributeDescriptions(),
+                m_colorDescriptorSetLayout
+            );
+        }, &initJobs);
+        m_jobSystem.Run([this]() {
+            Shin::StartupTimelineScope phase(&m_startupTimeline, "Quad shaders");
+            m_quadDrawPipeline->Init( m_logicalDevice, g_allocator,
+                SHADER_PATH "Quad.vert.spv",
+                SHADER_PATH "Texture.frag.spv", 
+                TextureVertex::GetBindingDescription(),
+                TextureVertex::GetAttributeDescriptions(),
+                m_texDescriptorSetLayout
+            );
+        }, &initJobs);
+        #undef SHADER_PATH
+
+        const uint32_t meshPhase = m_startupTimeline.BeginPhase("Record mesh uploads");
+        uploadBatch.Begin(m_logicalDevice, m_commandPool);
+
+        //Model
+        const uint32_t numIndices = static_cast<uint32_t>(g_indices.size());
+        m_texMesh->Init(m_physicalDevice, m_logicalDevice, g_allocator, 
+            reinterpret_cast<const char*>(g_texVertices.data()), static_cast<uint32_t>(sizeof(g_texVertices[0]) * g_texVertices.size()),
+            reinterpret_cast<const char*>(g_indices.data()), static_cast<uint32_t>(sizeof(g_indices[0]) * numIndices),
+            numIndices, &uploadBatch
+        );
+        m_colorMesh->Init(m_physicalDevice, m_logicalDevice, g_allocator, 
+            reinterpret_cast<const char*>(g_colorVertices.data()), static_cast<uint32_t>(sizeof(g_colorVertices[0]) * g_colorVertices.size()),
+            reinterpret_cast<const char*>(g_indices.data()), static_cast<uint32_t>(sizeof(g_indices[0]) * numIndices),
+            numIndices, &uploadBatch
+        );
+        m_quadMesh->Init(m_physicalDevice, m_logicalDevice, g_allocator, 
+            reinterpret_cast<const char*>(g_quadVertices.data()), static_cast<uint32_t>(sizeof(g_quadVertices[0]) * g_quadVertices.size()),
+            reinterpret_cast<const char*>(g_indices.data()), static_cast<uint32_t>(sizeof(g_indices[0]) * numIndices),
+            numIndices, &uploadBatch
+        );
+        m_startupTimeline.EndPhase(meshPhase);
 
-    const uint32_t NUM_DRAW_OBJECTS = 5;
-    const uint32_t NUM_DRAW_PIPELINES    = 2;
+        CreateSyncObjects();
+
+        //Init texture
+        m_jobSystem.Wait(&textureJob);
+        const uint32_t texturePhase = m_startupTimeline.BeginPhase("Record texture upload");
+        m_texture->Init(m_physicalDevice, m_logicalDevice, g_allocator, texturePixels, textureWidth, textureHeight, 
+            &uploadBatch
+        );
+        texturePixels.clear();
+        texturePixels.shrink_to_fit();
+        m_startupTimeline.EndPhase(texturePhase);
+
+        uploadBatch.Submit(m_logicalDevice, g_allocator, m_graphicsQueue);
+
+        const uint32_t waitPhase = m_startupTimeline.BeginPhase("Wait for jobs");
+        m_jobSystem.Wait(&initJobs);
+        m_startupTimeline.EndPhase(waitPhase);
+
+        const uint32_t uploadPhase = m_startupTimeline.BeginPhase("Wait for GPU uploads");
+        uploadBatch.Wait(m_logicalDevice, g_allocator);
+        m_startupTimeline.EndPhase(uploadPhase);
+    } catch (...) {
+        WaitForJobsIgnoringExceptions(&m_jobSystem, &textureJob);
+        WaitForJobsIgnoringExceptions(&m_jobSystem, &initJobs);
+        uploadBatch.Wait(m_logicalDevice, g_allocator);
+        throw;
+    }
 
     //Init drawObjects
     m_drawObjects.resize(NUM_DRAW_OBJECTS);
@@ -209,38 +379,6 @@ void NvEncodingApp::Init() {
     m_smallerQuadDrawObject.SetPos(0.75f,0.75f,0.f);
     m_smallerQuadDrawObject.SetScale(0.25f);
 
-    //Init pipelines
-    m_drawPipelines.resize(NUM_DRAW_PIPELINES);
-    for (uint32_t i = 0; i < NUM_DRAW_PIPELINES; ++i) {
-        m_drawPipelines[i] = new Shin::DrawPipeline();
-    }
-    m_quadDrawPipeline = new Shin::DrawPipeline();
-
-    #define SHADER_PATH "../Shared/Shaders/"
-
-    m_drawPipelines[0]->Init(m_logicalDevice, g_allocator,
-        SHADER_PATH "Texture.vert.spv",
-        SHADER_PATH "Texture.frag.spv", 
-        TextureVertex::GetBindingDescription(),
-        TextureVertex::GetAttributeDescriptions(),
-        m_texDescriptorSetLayout
-    );
-    m_drawPipelines[1]->Init(m_logicalDevice, g_allocator,
-        SHADER_PATH "Color.vert.spv",
-        SHADER_PATH "Color.frag.spv", 
-        ColorVertex::GetBindingDescription(),
-        ColorVertex::GetAttributeDescriptions(),
-        m_colorDescriptorSetLayout
-    );
-    m_quadDrawPipeline->Init( m_logicalDevice, g_allocator,
-        SHADER_PATH "Quad.vert.spv",
-        SHADER_PATH "Texture.frag.spv", 
-        TextureVertex::GetBindingDescription(),
-        TextureVertex::GetAttributeDescriptions(),
-        m_texDescriptorSetLayout
-    );
-    #undef SHADER_PATH
-
     m_drawPipelines[0]->AddDrawObject(&m_drawObjects[0]);
     m_drawPipelines[1]->AddDrawObject(&m_drawObjects[1]);
     m_drawPipelines[0]->AddDrawObject(&m_drawObjects[2]);
@@ -250,53 +388,154 @@ void NvEncodingApp::Init() {
     m_quadDrawPipeline->AddDrawObject(&m_quadDrawObject);
     m_quadDrawPipeline->AddDrawObject(&m_smallerQuadDrawObject);
 
-    m_offScreenPass.Init(OFFSCREEN_TEXTURE_WIDTH, OFFSCREEN_TEXTURE_HEIGHT);
+    //The context was created on a job thread. Frames are encoded on this thread
+    if (m_encodingEnabled) {
+        m_cudaContext.SetCurrent();
+    }
+
+    if (!m_frameExportPath.empty()) {
+        InitFrameExporter();
+    }
 
-    InitCudaAndNvCodec();
+    //The exported textures are allocated separately.
+    //NVENC always encodes the full extent: the render extent is scaled into its inputs, so that a change of the 
+    //resolution scale doesn't reconfigure the encoder, which would start a new IDR frame
+    m_offScreenPass.Init(OFFSCREEN_TEXTURE_WIDTH, OFFSCREEN_TEXTURE_HEIGHT, m_frameExporter.IsInitialized(), 
+        m_useDynamicRendering, GraphicsUtility::FindDepthFormat(m_physicalDevice));
+    if (m_encodingEnabled) {
+        m_encoderInputPass.Init(OFFSCREEN_TEXTURE_WIDTH, OFFSCREEN_TEXTURE_HEIGHT, true, true, VK_FORMAT_UNDEFINED);
+    }
+    InitResolutionScaler();
+    if (m_readbackEnabled) {
+        InitReadbackRing();
+    }
+    if (FRAME_ENCODER_TYPE_CPU == m_encoderType) {
+        InitCpuEncoder();
+    }
 
     //Swap
+    const uint32_t swapChainPhase = m_startupTimeline.BeginPhase("Swap chain and pipelines");
     RecreateSwapChain();
+    m_startupTimeline.EndPhase(swapChainPhase);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
 void NvEncodingApp::RecreateSwapChain() {
+    SHIN_PROFILE_FUNCTION();
 
-    m_window->WaitInMinimizedState(); //Handle window minimization
+    if (!m_headless) {
+        m_window->WaitInMinimizedState(); //Handle window minimization
+    }
+
+    //Frames which were recorded for the previous swap chain will be discarded
+    ++m_swapChainGeneration;
+
+    VkSwapchainKHR newSwapChain = VK_NULL_HANDLE;
+    if (VK_NULL_HANDLE != m_swapChain) {
+        //Hand the current swap chain over to the new one. Frames in flight keep using the retired objects, 
+        //which are destroyed in SubmitFrame() after their fences are signaled
+        const uint32_t prevNumImages = m_numImages;
+        const VkFormat prevFormat = m_swapChainSurfaceFormat;
+        RetireSwapChain();
+        CreateSwapChain(m_retiredSwapChains.back().SwapChain);
+
+        uint32_t numImages = 0;
+        vkGetSwapchainImagesKHR(m_logicalDevice, m_swapChain, &numImages, nullptr);
+        if (numImages == prevNumImages && m_swapChainSurfaceFormat == prevFormat) {
+            //Only the objects that depend on the extent. Pipelines, uniform buffers, descriptor sets, 
+            //cuda images and encoder resources are per image index and can be kept
+            CreateImageViews();
+            m_quadDrawPipeline->SetExtent(m_swapChainExtent);
+            CreateCommandBuffers();
+            m_recreateSwapChainRequested = false;
+            return;
+        }
+
+        //The number of images or the render pass has changed: recreate everything, but keep the new swap chain
+        newSwapChain = m_swapChain;
+        m_swapChain = VK_NULL_HANDLE;
+    }
 
     vkDeviceWaitIdle(m_logicalDevice);
 
+    DestroyRetiredSwapChains(true);
     CleanUpSwapChain();
-    CreateSwapChain();
-    CreateImageViews();
-    CreateRenderPass();
 
-    CreateFrameBuffers();
+    if (m_headless) {
+        //No swap chain. The offscreen pass is the final output
+        m_numImages = HEADLESS_NUM_IMAGES;
+        m_swapChainExtent = m_offScreenPass.GetExtent();
+    } else {
+        m_swapChain = newSwapChain;
+        if (VK_NULL_HANDLE == m_swapChain) {
+            CreateSwapChain(VK_NULL_HANDLE);
+        }
+        CreateImageViews();
+        if (!m_useDynamicRendering) {
+            CreateRenderPass();
+        }
+        m_numImages = static_cast<uint32_t>(m_swapChainImages.size());
+    }
+
     CreateDescriptorPool();
 
-    const uint32_t numImages = static_cast<uint32_t>(m_swapChainImages.size());
+    const uint32_t numImages = m_numImages;
 
     //Offscreen Pass
     m_offScreenPass.RecreateSwapChainObjects(m_physicalDevice,m_logicalDevice,g_allocator,numImages);
+    if (m_encodingEnabled) {
+        m_encoderInputPass.RecreateSwapChainObjects(m_physicalDevice, m_logicalDevice, g_allocator, numImages);
+    }
+    if (m_frameExporter.IsInitialized()) {
+        SetFrameExporterImages(numImages);
+    }
 
-    //Recreate pipeline
+    //Recreate pipeline. The pipelines are compiled on the job threads while the draw objects are recreated here.
+    //At startup, CreateCommandBuffers() waits for them. While streaming, the draws are skipped until the pipelines 
+    //are ready, instead of stalling the frames, and UpdateCommandBuffer() records the command buffers again
+    //With dynamic rendering, the keys only depend on the attachment formats: the pipelines are found in the cache
+    const bool optionalPipelines = m_frameLoopRunning;
     const uint32_t numPipelines = static_cast<uint32_t>(m_drawPipelines.size());
     for (uint32_t i = 0; i < numPipelines; ++i) {
-        m_drawPipelines[i]->RecreateSwapChainObjects(m_physicalDevice, m_logicalDevice, g_allocator, 
-            m_descriptorPool, numImages, m_offScreenPass.GetRenderPass(), m_swapChainExtent            
+        m_drawPipelines[i]->SetOptional(optionalPipelines);
+        if (m_useDynamicRendering) {
+            m_drawPipelines[i]->RequestPipeline(&m_pipelineStateCache, m_offScreenPass.GetColorFormat(), 
+                m_offScreenPass.GetDepthFormat());
+        } else {
+            m_drawPipelines[i]->RequestPipeline(&m_pipelineStateCache, m_offScreenPass.GetRenderPass());
+        }
+    }
+    if (!m_headless) {
+        m_quadDrawPipeline->SetOptional(optionalPipelines);
+        if (m_useDynamicRendering) {
+            m_quadDrawPipeline->RequestPipeline(&m_pipelineStateCache, m_swapChainSurfaceFormat, VK_FORMAT_UNDEFINED);
+        } else {
+            m_quadDrawPipeline->RequestPipeline(&m_pipelineStateCache, m_renderPass);
+        }
+    }
+    m_pipelineCompiler.Compile(&m_jobSystem);
+
+    for (uint32_t i = 0; i < numPipelines; ++i) {
+        m_drawPipelines[i]->RecreateDrawObjects(m_physicalDevice, m_logicalDevice, g_allocator, 
+            m_descriptorPool, numImages, m_offScreenPass.GetExtent()
+        );
+    }
+    if (!m_headless) {
+        m_quadDrawPipeline->RecreateDrawObjects(m_physicalDevice, m_logicalDevice, g_allocator, 
+            m_descriptorPool, numImages, m_swapChainExtent   
         );
     }
-    m_quadDrawPipeline->RecreateSwapChainObjects(m_physicalDevice, m_logicalDevice, g_allocator, 
-        m_descriptorPool, numImages, m_renderPass, m_swapChainExtent   
-    );
 
     CreateCommandBuffers();
 
     m_imagesInFlight.resize(numImages, VK_NULL_HANDLE);
 
     //Cuda
-    CreateCudaImages();
-    SetupNvEncoderResources();
+    if (m_encodingEnabled) {
+        CreateCudaImages();
+        SetupNvEncoderResources();
+    }
 
     m_recreateSwapChainRequested = false;
 
@@ -317,7 +556,10 @@ void NvEncodingApp::PickPhysicalDevice()  {
 
     for (const VkPhysicalDevice& device : devices) {
         //Check extension
-        if (!CheckDeviceExtensionSupport(device, &g_requiredDeviceExtensions))
+        std::vector<const char*> deviceExtensions;
+        bool encodingSupported = false;
+        GetDeviceExtensionsInto(device, &deviceExtensions, &encodingSupported);
+        if (!CheckDeviceExtensionSupport(device, &deviceExtensions))
             continue;
 
         //Check features
@@ -327,15 +569,20 @@ void NvEncodingApp::PickPhysicalDevice()  {
             continue;
 
         //Check swap chain support
-        PhysicalDeviceSurfaceInfo deviceSurfaceInfo = QueryVulkanPhysicalDeviceSurfaceInfo(device, m_surface);
-        if (!deviceSurfaceInfo.IsSwapChainSupported())
-            continue;
+        if (!m_headless) {
+            PhysicalDeviceSurfaceInfo deviceSurfaceInfo = QueryVulkanPhysicalDeviceSurfaceInfo(device, m_surface);
+            if (!deviceSurfaceInfo.IsSwapChainSupported())
+                continue;
+        }
 
         //Check required queue family
         QueueFamilyIndices curIndices = QueryVulkanQueueFamilyIndices(device, m_surface);
         if (curIndices.IsComplete()) {
             m_physicalDevice = device;
             m_queueFamilyIndices = curIndices;
+            m_deviceExtensions = deviceExtensions;
+            m_encodingEnabled = encodingSupported && (FRAME_ENCODER_TYPE_NVENC == m_encoderType);
+            m_externalMemorySupported = encodingSupported;
             break;
         }
 
@@ -345,6 +592,9 @@ void NvEncodingApp::PickPhysicalDevice()  {
         throw std::runtime_error("failed to find a suitable GPU!");
     }
 
+    m_deviceCapabilities.Query(m_instance, m_physicalDevice);
+    m_deviceCapabilities.GetExtensionsInto(&m_deviceExtensions);
+
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -374,11 +624,12 @@ void NvEncodingApp::CreateLogicalDevice()  {
     //Creating logical device
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = m_deviceCapabilities.GetFeatures();
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(g_requiredDeviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = g_requiredDeviceExtensions.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(m_deviceExtensions.size());
+    createInfo.ppEnabledExtensionNames = m_deviceExtensions.data();
     createInfo.enabledLayerCount =  0;
 
 #ifdef ENABLE_VULKAN_DEBUG
@@ -447,7 +698,7 @@ void NvEncodingApp::CreateCommandPool() {
     VkCommandPoolCreateInfo poolInfo = {};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     poolInfo.queueFamilyIndex = m_queueFamilyIndices.GetGraphicsIndex();
-    poolInfo.flags = 0; // Optional
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; //UpdateCommandBuffer() records them again
 
     if (vkCreateCommandPool(m_logicalDevice, &poolInfo, g_allocator, &m_commandPool) != VK_SUCCESS) {
         throw std::runtime_error("failed to create command pool!");
@@ -457,7 +708,7 @@ void NvEncodingApp::CreateCommandPool() {
 
 //---------------------------------------------------------------------------------------------------------------------
 void NvEncodingApp::CreateCommandBuffers() {
-    const uint32_t numFrameBuffers = static_cast<uint32_t>(m_swapChainFramebuffers.size());
+    const uint32_t numFrameBuffers = m_numImages;
     m_commandBuffers.resize(numFrameBuffers);
 
     VkCommandBufferAllocateInfo allocInfo = {};
@@ -470,80 +721,201 @@ void NvEncodingApp::CreateCommandBuffers() {
         throw std::runtime_error("failed to allocate command buffers!");
     }
 
-    //Starting command buffer recording
+    m_renderGraphs.resize(numFrameBuffers);
+    m_outdatedCommandBuffers.assign(numFrameBuffers, false);
+
+    CreateTimestampQueryPool(numFrameBuffers);
+    m_timestampsWritten.assign(numFrameBuffers, false);
+
     for (uint32_t i = 0; i < numFrameBuffers; ++i) {
-        VkCommandBufferBeginInfo beginInfo = {};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = 0; // Optional
-        beginInfo.pInheritanceInfo = nullptr; // Optional
+        RecordCommandBuffer(i);
+    }
+}
 
-        if (vkBeginCommandBuffer(m_commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-            throw std::runtime_error("failed to begin recording command buffer!");
-        }
+//---------------------------------------------------------------------------------------------------------------------
 
-        const VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
+void NvEncodingApp::RecordCommandBuffer(const uint32_t imageIndex) {
+    SHIN_PROFILE_FUNCTION();
 
-        //First render pass: Offscreen rendering
-        {
-            VkRenderPassBeginInfo renderPassInfo = {};
-            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassInfo.renderPass = m_offScreenPass.GetRenderPass();
-            renderPassInfo.framebuffer = m_offScreenPass.GetFrameBuffer(i);
-            renderPassInfo.renderArea.offset = {0, 0};
-            renderPassInfo.renderArea.extent = m_offScreenPass.GetExtent();
-            renderPassInfo.clearValueCount = 1;
-            renderPassInfo.pClearValues = &clearColor; //to be used by VK_ATTACHMENT_LOAD_OP_CLEAR, when creating RenderPass
-            vkCmdBeginRenderPass(m_commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-            const uint32_t numPipelines = static_cast<uint32_t>(m_drawPipelines.size());
-            for (uint32_t j = 0; j < numPipelines; ++j) {
-
-                m_drawPipelines[j]->Bind(m_commandBuffers[i]);
-                m_drawPipelines[j]->DrawToCommandBuffer(m_commandBuffers[i], static_cast<uint32_t>(i));
-            }
-            vkCmdEndRenderPass(m_commandBuffers[i]);
-        }
+    //Starting command buffer recording. Resets the command buffer if it has been recorded before
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = 0; // Optional
+    beginInfo.pInheritanceInfo = nullptr; // Optional
+
+    if (vkBeginCommandBuffer(m_commandBuffers[imageIndex], &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+
+    //Written in the offscreen pass. Can't be reset inside a render pass
+    if (VK_NULL_HANDLE != m_timestampQueryPool) {
+        vkCmdResetQueryPool(m_commandBuffers[imageIndex], m_timestampQueryPool, imageIndex * 2, 2);
+    }
 
+    BuildRenderGraph(imageIndex, &m_renderGraphs[imageIndex]);
+    m_renderGraphs[imageIndex].Compile(m_physicalDevice, m_logicalDevice, g_allocator);
+    m_renderGraphs[imageIndex].Record(m_commandBuffers[imageIndex]);
+
+    if (vkEndCommandBuffer(m_commandBuffers[imageIndex]) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+}
 
-		{
-            //Second pass, render to screen
-			VkRenderPassBeginInfo renderPassInfo= {};
-            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = m_renderPass;
-			renderPassInfo.framebuffer = m_swapChainFramebuffers[i];
-            renderPassInfo.renderArea.offset = {0, 0};
-            renderPassInfo.renderArea.extent = m_swapChainExtent;
-			renderPassInfo.clearValueCount = 1;
-			renderPassInfo.pClearValues = &clearColor;
-
-            vkCmdBeginRenderPass(m_commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-            m_quadDrawPipeline->Bind(m_commandBuffers[i]);
-            m_quadDrawPipeline->DrawToCommandBuffer(m_commandBuffers[i], static_cast<uint32_t>(i));
-            vkCmdEndRenderPass(m_commandBuffers[i]);
+//---------------------------------------------------------------------------------------------------------------------
+
+//Runs on the main thread before the submit. The command buffer isn't in use anymore: 
+//RecordFrame() has waited for the previous frame of this image
+void NvEncodingApp::UpdateCommandBuffer(const uint32_t imageIndex) {
+    bool pipelineReady = m_quadDrawPipeline->UpdatePipeline();
+    const uint32_t numPipelines = static_cast<uint32_t>(m_drawPipelines.size());
+    for (uint32_t i = 0; i < numPipelines; ++i) {
+        pipelineReady = m_drawPipelines[i]->UpdatePipeline() || pipelineReady;
+    }
+
+    //The draws are recorded front to back. The view and the positions don't move yet, but the order is checked 
+    //every frame, so that the command buffers follow them when they do
+    bool drawOrderChanged = false;
+    for (uint32_t i = 0; i < numPipelines; ++i) {
+        drawOrderChanged = m_drawPipelines[i]->SortDrawObjects() || drawOrderChanged;
+    }
+
+    //All the images were recorded without the pipeline, or with another order
+    if (pipelineReady || drawOrderChanged) {
+        m_outdatedCommandBuffers.assign(m_outdatedCommandBuffers.size(), true);
+    }
+
+    if (!m_outdatedCommandBuffers[imageIndex]) {
+        return;
+    }
+
+    RecordCommandBuffer(imageIndex);
+    m_outdatedCommandBuffers[imageIndex] = false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The barriers between the passes, and the layout transitions of the images, are decided by the render graph.
+//The render passes created by the graph are compatible with m_renderPass and the render pass of m_offScreenPass,
+//which are used to create the pipelines. With dynamic rendering, the graph renders directly on the image views.
+void NvEncodingApp::BuildRenderGraph(const uint32_t imageIndex, Shin::RenderGraph* graph) {
+    graph->CleanUp(m_logicalDevice, g_allocator);
+    if (m_useDynamicRendering) {
+        graph->EnableDynamicRendering(m_logicalDevice);
+    }
+
+    const VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
+    VkClearValue clearDepth = {};
+    clearDepth.depthStencil = {1.0f, 0};
+
+    //First pass: Offscreen rendering. 
+    //The texture is also read back, or exported, after the command buffer has been executed
+    const Shin::RenderGraphResource offScreenColor = graph->ImportImage("OffScreenColor", 
+        m_offScreenPass.GetImage(imageIndex), m_offScreenPass.GetLayer(imageIndex), 
+        m_offScreenPass.GetImageView(imageIndex), m_offScreenPass.GetColorFormat(), m_offScreenPass.GetExtent(),
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0
+    );
+
+    //Shared by all images: waits for the depth tests of the previous frame. Its contents are discarded
+    const VkPipelineStageFlags depthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT 
+        | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    const Shin::RenderGraphResource offScreenDepth = graph->ImportImage("OffScreenDepth", 
+        m_offScreenPass.GetDepthImage(), 0, m_offScreenPass.GetDepthImageView(), m_offScreenPass.GetDepthFormat(), 
+        m_offScreenPass.GetExtent(),
+        VK_IMAGE_LAYOUT_UNDEFINED, depthStages, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, depthStages, 0
+    );
+
+    //Only the top-left part of renderExtent is rendered. The rest is cleared
+    const VkExtent2D renderExtent = m_resolutionScaler.GetExtent();
+    const uint32_t offScreenPass = graph->AddPass("OffScreen", [this, imageIndex, renderExtent](const VkCommandBuffer commandBuffer) {
+        if (VK_NULL_HANDLE != m_timestampQueryPool) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampQueryPool, imageIndex * 2);
         }
 
-        if (vkEndCommandBuffer(m_commandBuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to record command buffer!");
+        const uint32_t numPipelines = static_cast<uint32_t>(m_drawPipelines.size());
+        for (uint32_t j = 0; j < numPipelines; ++j) {
+            if (m_drawPipelines[j]->Bind(commandBuffer, renderExtent)) {
+                m_drawPipelines[j]->DrawToCommandBuffer(commandBuffer, imageIndex);
+            }
         }
 
+        if (VK_NULL_HANDLE != m_timestampQueryPool) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampQueryPool, 
+                imageIndex * 2 + 1);
+        }
+    });
+    graph->AddColorAttachment(offScreenPass, offScreenColor, &clearColor);
+    graph->SetDepthAttachment(offScreenPass, offScreenDepth, &clearDepth);
+
+    //Scales the render extent to the full extent of the encoder input, which is read by NVENC after the command 
+    //buffer has been executed
+    if (m_encodingEnabled) {
+        const Shin::RenderGraphResource encoderInput = graph->ImportImage("EncoderInput", 
+            m_encoderInputPass.GetImage(imageIndex), 0, m_encoderInputPass.GetImageView(imageIndex), 
+            m_encoderInputPass.GetColorFormat(), m_encoderInputPass.GetExtent(),
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0
+        );
+
+        const uint32_t scalePass = graph->AddPass("EncoderScale", 
+            [this, imageIndex, renderExtent](const VkCommandBuffer commandBuffer) 
+        {
+            const VkExtent2D dstExtent = m_encoderInputPass.GetExtent();
+            VkImageBlit region = {};
+            region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, m_offScreenPass.GetLayer(imageIndex), 1 };
+            region.srcOffsets[1] = { static_cast<int32_t>(renderExtent.width), 
+                static_cast<int32_t>(renderExtent.height), 1 };
+            region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            region.dstOffsets[1] = { static_cast<int32_t>(dstExtent.width), 
+                static_cast<int32_t>(dstExtent.height), 1 };
+            vkCmdBlitImage(commandBuffer, m_offScreenPass.GetImage(imageIndex), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                m_encoderInputPass.GetImage(imageIndex), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, 
+                VK_FILTER_LINEAR);
+        });
+        graph->AddRead(scalePass, offScreenColor, Shin::RENDER_GRAPH_ACCESS_TRANSFER_READ);
+        graph->AddWrite(scalePass, encoderInput, Shin::RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
     }
+
+    if (m_headless)
+        return;
+
+    //Second pass, render to screen
+    const Shin::RenderGraphResource swapChainColor = graph->ImportImage("SwapChainColor", 
+        m_swapChainImages[imageIndex], 0, m_swapChainImageViews[imageIndex], 
+        m_swapChainSurfaceFormat, m_swapChainExtent,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, //Wait for the acquire semaphore
+        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0
+    );
+
+    const uint32_t screenPass = graph->AddPass("Screen", [this, imageIndex](const VkCommandBuffer commandBuffer) {
+        if (m_quadDrawPipeline->Bind(commandBuffer, m_swapChainExtent)) {
+            m_quadDrawPipeline->DrawToCommandBuffer(commandBuffer, imageIndex);
+        }
+    });
+    graph->AddRead(screenPass, offScreenColor, Shin::RENDER_GRAPH_ACCESS_FRAGMENT_SHADER_READ);
+    graph->AddColorAttachment(screenPass, swapChainColor, &clearColor);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void NvEncodingApp::CreateCudaImages() {
-    const uint32_t numImages = static_cast<uint32_t>(m_swapChainImages.size());
+    const uint32_t numImages = m_numImages;
     m_cudaImages.resize(numImages);
     for (uint32_t i = 0; i < numImages; ++i) {
-        m_cudaImages[i].Init(m_logicalDevice, m_offScreenPass.GetTexture(i));
+        m_cudaImages[i].Init(m_logicalDevice, m_encoderInputPass.GetImageMemory(i), 
+            m_encoderInputPass.GetImageMemorySize(i), m_encoderInputPass.GetExtent());
     }
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void NvEncodingApp::SetupNvEncoderResources() {
-    const uint32_t numImages = static_cast<uint32_t>(m_swapChainImages.size());
+    const uint32_t numImages = m_numImages;
     m_nvEncoder.CreateBuffers(numImages);
     for (uint32_t i = 0; i < numImages; ++i) {
-        m_nvEncoder.RegisterInputResource(i, m_cudaImages[i].GetArray());
+        FrameEncoderInput input = {};
+        input.Type = FRAME_ENCODER_INPUT_TYPE_CUDA_ARRAY;
+        input.Resource = m_cudaImages[i].GetArray();
+        m_nvEncoder.RegisterInput(i, input);
     }
 
 }
@@ -576,7 +948,7 @@ void NvEncodingApp::CreateSyncObjects() {
 
 //---------------------------------------------------------------------------------------------------------------------
 
-void NvEncodingApp::CreateSwapChain() {
+void NvEncodingApp::CreateSwapChain(const VkSwapchainKHR oldSwapChain) {
     //Decide parameters
     PhysicalDeviceSurfaceInfo surfaceInfo = QueryVulkanPhysicalDeviceSurfaceInfo(m_physicalDevice, m_surface);
     VkSurfaceCapabilitiesKHR& capabilities = surfaceInfo.Capabilities;
@@ -586,7 +958,9 @@ void NvEncodingApp::CreateSwapChain() {
 
     m_swapChainExtent = m_window->SelectVulkanSwapExtent(capabilities);
     
-    uint32_t imageCount = capabilities.minImageCount + 1; //add +1 to prevent waiting for internal ops
+    //add +1 to prevent waiting for internal ops, and +1 for the image held by the record thread while the main thread
+    //presents the previous one
+    uint32_t imageCount = capabilities.minImageCount + 2; 
     if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount) {
         imageCount = capabilities.maxImageCount;
     }
@@ -622,7 +996,7 @@ void NvEncodingApp::CreateSwapChain() {
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    createInfo.oldSwapchain = oldSwapChain; //Allows the presentation engine to reuse resources
 
     if (vkCreateSwapchainKHR(m_logicalDevice, &createInfo, g_allocator, &m_swapChain) != VK_SUCCESS) {
         throw std::runtime_error("failed to create swap chain!");
@@ -683,7 +1057,7 @@ void NvEncodingApp::CreateRenderPass() {
     //- srcAccessMask can be 0
     //  1. We don't need to preserve previous results. Our rendering pipeline doesn't use the image 
     //     before the transition (no reads or writes)
-    //  2. Works in conjunction with m_imageAvailableSemaphores in DrawFrame()
+    //  2. Works in conjunction with m_imageAvailableSemaphores in SubmitFrame()
     //     The acquisition semaphore already guarantees that any external accesses are made visible when the semaphore 
     //     is signaled. This already ensures any memory accesses from the presentation engine are visible after the 
     //     barrier.
@@ -716,7 +1090,7 @@ void NvEncodingApp::CreateRenderPass() {
 void NvEncodingApp::CreateDescriptorPool() {
     const uint32_t NUM_QUADS = 2;
 
-    const uint32_t numImages = static_cast<uint32_t>(m_swapChainImages.size());
+    const uint32_t numImages = m_numImages;
     const uint32_t maxDescriptorCount = (static_cast<uint32_t>(m_drawObjects.size()) + NUM_QUADS) * numImages;
 
     std::array<VkDescriptorPoolSize, 2> poolSizes = {};
@@ -737,37 +1111,6 @@ void NvEncodingApp::CreateDescriptorPool() {
 }
 
 
-//---------------------------------------------------------------------------------------------------------------------
-
-//VkFrameBuffer is what maps the actual attachments (swap chain images) to a RenderPass. 
-//The attachment definition was defined when creating the RenderPass
-void NvEncodingApp::CreateFrameBuffers() {
-    const uint32_t numImageViews = static_cast<uint32_t>(m_swapChainImageViews.size());
-    m_swapChainFramebuffers.resize(numImageViews);
-    
-
-    for (size_t i = 0; i < numImageViews; i++) {
-        VkImageView attachments[] = {
-            m_swapChainImageViews[i]
-        };
-
-        VkFramebufferCreateInfo framebufferInfo = {};
-        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = m_renderPass;
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = attachments;
-        framebufferInfo.width = m_swapChainExtent.width;
-        framebufferInfo.height = m_swapChainExtent.height;
-        framebufferInfo.layers = 1;
-
-        if (vkCreateFramebuffer(m_logicalDevice, &framebufferInfo, g_allocator, &m_swapChainFramebuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create framebuffer!");
-        }
-    }
-}
-
-
-
 #ifdef ENABLE_VULKAN_DEBUG
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -845,74 +1188,369 @@ void NvEncodingApp::InitVulkanInstance(const VkApplicationInfo& appInfo, const s
 //---------------------------------------------------------------------------------------------------------------------
 
 void NvEncodingApp::Loop() {
-    while (m_window->Loop()) {
-        DrawFrame();
+    SHIN_PROFILE_THREAD_NAME("Main");
+    SHIN_PROFILE_BEGIN_TIMED_CAPTURE(PROFILER_CAPTURE_SECONDS, "NvEncodingTrace.json");
+
+    StartFramePipeline();
+
+    try {
+        FrameTicket ticket;
+        if (m_headless) {
+            const auto startTime = std::chrono::steady_clock::now();
+            uint64_t numFrames = 0;
+            float elapsedSeconds = 0.0f;
+            while (elapsedSeconds < m_headlessDurationSeconds && m_recordedFrames.Pop(&ticket)) {
+                SubmitFrame(ticket);
+                SHIN_PROFILE_UPDATE_CAPTURE();
+                ++numFrames;
+                elapsedSeconds = std::chrono::duration<float, std::chrono::seconds::period>(
+                    std::chrono::steady_clock::now() - startTime).count();
+            }
+            std::cout << "Headless: rendered " << numFrames << " frames in " << elapsedSeconds << " seconds ("
+                << (static_cast<float>(numFrames) / elapsedSeconds) << " fps)" << std::endl;
+        } else {
+            while (m_window->Loop() && m_recordedFrames.Pop(&ticket)) {
+                SubmitFrame(ticket);
+                SHIN_PROFILE_UPDATE_CAPTURE();
+            }
+        }
+    } catch (...) {
+        StopFramePipeline();
+        throw;
     }
 
+    StopFramePipeline();
+
     //Wait until all vulkan operations are finished
     vkDeviceWaitIdle(m_logicalDevice);
+
+    if (m_readbackRing.IsInitialized()) {
+        ConsumeReadbackFrames();
+        std::cout << "Readback" << (m_readbackRing.PublishesSharedFrames() ? " (into the shared frames)" : "") 
+            << ": " << m_numReadbackFrames << " frames, " << m_readbackRing.GetNumDroppedFrames() << " dropped" 
+            << std::endl;
+    }
+    if (m_frameExporter.IsInitialized()) {
+        std::cout << "Frame export: " << m_frameExporter.GetNumSentFrames() << " frames sent" << std::endl;
+    }
+    if (nullptr != m_frameEncoder) {
+        std::cout << "Encoding (" << ((&m_cpuEncoder == m_frameEncoder) ? "CPU I420" : "NVENC H.264") << "): " 
+            << m_numEncodedFrames << " frames, " << m_numEncodedBytes << " bytes" << std::endl;
+    }
+    if (&m_nvEncoder == m_frameEncoder) {
+        std::cout << "NVENC (" << (m_nvEncoder.IsAsync() ? "async" : "sync") << "): latency " 
+            << m_nvEncoder.GetAverageLatencyMs() << " ms average, " << m_nvEncoder.GetMaxLatencyMs() << " ms max, "
+            << m_nvEncoder.GetNumDroppedFrames() << " dropped" << std::endl;
+    }
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
-void NvEncodingApp::DrawFrame() {
-    //The fence will sync CPU - GPU. Make sure that we are not processing the same frame in flight
-    vkWaitForFences(m_logicalDevice, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+void NvEncodingApp::StartFramePipeline() {
+    const uint32_t numObjects = static_cast<uint32_t>(m_drawObjects.size());
 
-    //1. Acquire an image from the swap chain
-    VkSemaphore curImageAvailableSemaphore = m_imageAvailableSemaphores[m_currentFrame];
-    uint32_t imageIndex;
-    {
-        const VkResult result = vkAcquireNextImageKHR(m_logicalDevice, m_swapChain, UINT64_MAX, 
-                                                      curImageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
-        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-            RecreateSwapChain();
-            return;
-        } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-            throw std::runtime_error("failed to acquire swap chain image!");
+    m_freeSceneStates.Reset();
+    m_simulatedSceneStates.Reset();
+    m_recordedFrames.Reset();
+
+    m_sceneStates.resize(NUM_SCENE_STATES);
+    for (uint32_t i = 0; i < NUM_SCENE_STATES; ++i) {
+        m_sceneStates[i].Time = 0.0f;
+        m_sceneStates[i].ModelMats.resize(numObjects, glm::mat4(1.0f));
+        m_freeSceneStates.Push(i);
+    }
+
+    m_frameThreadException = nullptr;
+    m_frameLoopRunning = true;
+    m_simulationThread = std::thread(&NvEncodingApp::SimulationThreadLoop, this);
+    m_recordThread = std::thread(&NvEncodingApp::RecordThreadLoop, this);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncodingApp::StopFramePipeline() {
+    m_frameLoopRunning = false;
+    m_freeSceneStates.Close();
+    m_simulatedSceneStates.Close();
+
+    //The record thread may be blocked until the main thread takes its frame. 
+    //m_recordedFrames is closed when the record thread exits
+    FrameTicket ticket;
+    while (m_recordedFrames.Pop(&ticket)) {
+        DiscardFrame(ticket);
+    }
+
+    if (m_simulationThread.joinable()) {
+        m_simulationThread.join();
+    }
+    if (m_recordThread.joinable()) {
+        m_recordThread.join();
+    }
+
+    if (nullptr != m_frameThreadException) {
+        std::exception_ptr e = m_frameThreadException;
+        m_frameThreadException = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncodingApp::SimulationThreadLoop() {
+    SHIN_PROFILE_THREAD_NAME("Simulation");
+
+    try {
+        uint32_t stateIndex = 0;
+        while (m_frameLoopRunning && m_freeSceneStates.Pop(&stateIndex)) {
+            SimulateScene(&m_sceneStates[stateIndex]);
+            if (!m_simulatedSceneStates.Push(stateIndex)) {
+                break;
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        if (nullptr == m_frameThreadException) {
+            m_frameThreadException = std::current_exception();
+        }
+    }
+
+    //Lets the record thread finish the remaining states and exit
+    m_simulatedSceneStates.Close();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncodingApp::RecordThreadLoop() {
+    SHIN_PROFILE_THREAD_NAME("Record");
+
+    try {
+        uint32_t stateIndex = 0;
+        while (m_simulatedSceneStates.Pop(&stateIndex)) {
+            FrameTicket ticket;
+            const bool recorded = RecordFrame(m_sceneStates[stateIndex], &ticket);
+
+            //The scene state has been written into the uniform buffers and can be simulated again
+            m_freeSceneStates.Push(stateIndex);
+            if (!recorded || !m_recordedFrames.Push(ticket)) {
+                break;
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        if (nullptr == m_frameThreadException) {
+            m_frameThreadException = std::current_exception();
+        }
+    }
+
+    //Lets the main thread exit its loop
+    m_recordedFrames.Close();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncodingApp::SimulateScene(SceneState* state) const {
+    SHIN_PROFILE_FUNCTION();
+
+    static const auto START_TIME = std::chrono::high_resolution_clock::now();
+    const auto currentTime = std::chrono::high_resolution_clock::now();
+    state->Time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - START_TIME).count();
+
+    //Only the rotation changes. The positions and scales of the draw objects are set before the pipeline starts
+    const uint32_t numObjects = static_cast<uint32_t>(state->ModelMats.size());
+    for (uint32_t i = 0; i < numObjects; ++i) {
+        state->ModelMats[i] = m_drawObjects[i].CalculateModelMat(state->Time * glm::radians(90.0f), 
+            glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Runs on the record thread. The lock is released while waiting for an image, so that the main thread can present
+//the image it holds, or recreate the swap chain
+bool NvEncodingApp::RecordFrame(const SceneState& state, FrameTicket* ticket) {
+    SHIN_PROFILE_FUNCTION();
+
+    while (m_frameLoopRunning) {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+
+        //The fence will sync CPU - GPU. Make sure that we are not processing the same frame in flight
+        const uint32_t frameSlot = m_currentFrame;
+        {
+            SHIN_PROFILE_SCOPE("WaitForInFlightFence");
+            vkWaitForFences(m_logicalDevice, 1, &m_inFlightFences[frameSlot], VK_TRUE, UINT64_MAX);
         }
+
+        ticket->FrameSlot = frameSlot;
+        ticket->ImageIndex = frameSlot; //Headless: the offscreen images are simply used in turn
+        ticket->SwapChainGeneration = m_swapChainGeneration;
+        ticket->RecreateSwapChain = false;
+        if (!m_headless) {
+            if (!AcquireNextImage(ticket)) {
+                continue;
+            }
+            if (ticket->RecreateSwapChain) {
+                return true;
+            }
+        }
+
+        //Check if we are about to draw to an image from the swap chain that is still in flight.
+        //This can happen for example if MAX_FRAMES_IN_FLIGHT >= the number of images in the swap chain.
+        const uint32_t imageIndex = ticket->ImageIndex;
+        if (m_imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
+            SHIN_PROFILE_SCOPE("WaitForImageInFlightFence");
+            vkWaitForFences(m_logicalDevice, 1, &m_imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+        }
+        m_imagesInFlight[imageIndex] = m_inFlightFences[frameSlot];
+
+        UpdateVulkanUniformBuffers(imageIndex, state);
+
+        m_currentFrame = (m_currentFrame + 1) % (m_headless ? m_numImages : MAX_FRAMES_IN_FLIGHT);
+        return true;
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Uses a short timeout since the main thread can't present while m_swapChainMutex is held
+bool NvEncodingApp::AcquireNextImage(FrameTicket* ticket) {
+    SHIN_PROFILE_FUNCTION();
+
+    const uint64_t ACQUIRE_TIMEOUT_NS = 1000000;
+
+    VkResult result;
+    {
+        std::lock_guard<std::mutex> lock(m_swapChainMutex);
+        result = vkAcquireNextImageKHR(m_logicalDevice, m_swapChain, ACQUIRE_TIMEOUT_NS, 
+            m_imageAvailableSemaphores[ticket->FrameSlot], VK_NULL_HANDLE, &ticket->ImageIndex);
     }
 
-    //Check if we are about to draw to an image from the swap chain that is still in flight.
-    //This can happen for example if MAX_FRAMES_IN_FLIGHT >= the number of images in the swap chain.
-    if (m_imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-        vkWaitForFences(m_logicalDevice, 1, &m_imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+    if (result == VK_TIMEOUT || result == VK_NOT_READY) {
+        return false;
+    } else if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        ticket->RecreateSwapChain = true;
+    } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+        throw std::runtime_error("failed to acquire swap chain image!");
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncodingApp::SubmitFrame(const FrameTicket& ticket) {
+    SHIN_PROFILE_FUNCTION();
+
+    if (!m_retiredSwapChains.empty()) {
+        DestroyRetiredSwapChains(false);
+    }
+
+    //The swap chain has been recreated after the frame was recorded
+    if (ticket.SwapChainGeneration != m_swapChainGeneration) {
+        DiscardFrame(ticket);
+        return;
+    }
+
+    if (ticket.RecreateSwapChain) {
+        RecreateSwapChainWhileRunning();
+        return;
+    }
+
+    const uint32_t frameSlot = ticket.FrameSlot;
+    const uint32_t imageIndex = ticket.ImageIndex;
+
+    UpdateRenderExtent(imageIndex);
+    UpdateCommandBuffer(imageIndex);
+    if (!m_headless) {
+        UpdateQuadUniformBuffers(imageIndex);
     }
-    m_imagesInFlight[imageIndex] = m_inFlightFences[m_currentFrame];
 
     //Semaphores: GPU-GPU synchronization. No need to reset
-    VkSemaphore waitSemaphores[] = {curImageAvailableSemaphore};
-    VkSemaphore signalSemaphores[] = {m_renderFinishedSemaphores[m_currentFrame]};
+    VkSemaphore waitSemaphores[2];
+    uint64_t waitValues[2] = {}; //Ignored for binary semaphores
+    uint32_t numWaitSemaphores = 0;
+    VkSemaphore signalSemaphores[] = {m_renderFinishedSemaphores[frameSlot]};
+    if (!m_headless) {
+        waitSemaphores[numWaitSemaphores++] = m_imageAvailableSemaphores[frameSlot]; //The acquire process
+    }
+
+    //The frame consumer may still be reading the offscreen image
+    VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+    const bool waitForRelease = m_frameExporter.IsInitialized() && m_frameExporter.GetReleasedWait(imageIndex, 
+        &waitSemaphores[numWaitSemaphores], &waitValues[numWaitSemaphores]);
+    if (waitForRelease) {
+        ++numWaitSemaphores;
+        timelineInfo.waitSemaphoreValueCount = numWaitSemaphores;
+        timelineInfo.pWaitSemaphoreValues = waitValues;
+    }
 
-    //2. Execute the command buffer with that image as attachment in the framebuffer
+    //Execute the command buffer with that image as attachment in the framebuffer
     //[Note-sin: 2019-11-14] Waits for the stage that writes to the color attachment. 
     //So theoretically the driver implementation can already start executing our vertex shader and such 
     //while the image is not yet available. 
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-
-    UpdateVulkanUniformBuffers(imageIndex);
+    VkPipelineStageFlags waitStages[] = {
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+    };
 
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores; //Wait for the acquire process to finish
-    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.pNext = waitForRelease ? &timelineInfo : nullptr;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &m_commandBuffers[imageIndex];
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+    submitInfo.waitSemaphoreCount = numWaitSemaphores;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
+    if (!m_headless) {
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = signalSemaphores;
+    }
 
     //Reset fence for syncing sync CPU - GPU
-    vkResetFences(m_logicalDevice, 1, &m_inFlightFences[m_currentFrame]);
+    vkResetFences(m_logicalDevice, 1, &m_inFlightFences[frameSlot]);
 
-    if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
+    {
+        SHIN_PROFILE_SCOPE("QueueSubmit");
+        if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[frameSlot]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
+    }
+    if (VK_NULL_HANDLE != m_timestampQueryPool) {
+        m_timestampsWritten[imageIndex] = true;
+    }
+    ++m_numSubmittedFrames;
+
+    //Copied after the frame on the same queue. Doesn't wait for the copies of the previous frames
+    if (m_colorConversionPass.IsInitialized()) {
+        m_readbackRing.SubmitConversion(m_graphicsQueue, m_colorConversionPass, 
+            m_offScreenPass.GetImageView(imageIndex), m_offScreenPass.GetSampler(), m_resolutionScaler.GetExtent(), 
+            m_numSubmittedFrames);
+        ConsumeReadbackFrames();
+    } else if (m_readbackRing.IsInitialized()) {
+        m_readbackRing.Submit(m_graphicsQueue, m_offScreenPass.GetImage(imageIndex), 
+            m_offScreenPass.GetLayer(imageIndex), m_resolutionScaler.GetExtent(), m_numSubmittedFrames);
+        ConsumeReadbackFrames();
     }
 
-    //Perform encoding here
-    m_nvEncoder.EncodeFrame(imageIndex);
+    if (m_frameExporter.IsInitialized()) {
+        m_frameExporter.Publish(m_graphicsQueue, imageIndex, m_resolutionScaler.GetExtent());
+    }
 
-    //3. Return the image to the swap chain for presentation. Wait for rendering to be finished
+    //Perform encoding here. The render extent has been scaled to the full extent of the inputs
+    if (m_encodingEnabled) {
+        EncodeFrame(imageIndex, m_encoderInputPass.GetExtent());
+    }
+
+    if (!m_startupTimeline.IsFirstFrameMarked()) {
+        m_startupTimeline.MarkFirstFrame();
+        m_startupTimeline.Print(std::cout);
+    }
+
+    if (m_headless) {
+        return;
+    }
+
+    //Return the image to the swap chain for presentation. Wait for rendering to be finished
     VkPresentInfoKHR presentInfo = {};
     VkSwapchainKHR swapChains[] = {m_swapChain};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -922,37 +1560,226 @@ void NvEncodingApp::DrawFrame() {
     presentInfo.pSwapchains = swapChains;
     presentInfo.pImageIndices = &imageIndex;
     presentInfo.pResults = nullptr; // Optional
+
+    VkResult result;
     {
-        const VkResult result = vkQueuePresentKHR(m_presentationQueue, &presentInfo);
-        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_recreateSwapChainRequested) {
-            //The RecreateSwapChainRequested check is put here to make sure that the semaphores are in consistent state
-            RecreateSwapChain();
-        } else if (result != VK_SUCCESS) {
-            throw std::runtime_error("failed to present swap chain image!");
-        }
+        SHIN_PROFILE_SCOPE("QueuePresent");
+        std::lock_guard<std::mutex> lock(m_swapChainMutex);
+        result = vkQueuePresentKHR(m_presentationQueue, &presentInfo);
+    }
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_recreateSwapChainRequested) {
+        //The RecreateSwapChainRequested check is put here to make sure that the semaphores are in consistent state
+        RecreateSwapChainWhileRunning();
+    } else if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to present swap chain image!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The image of the frame was acquired, but won't be presented. 
+//Submit a wait on its semaphore so that the semaphore and the fence can be reused
+void NvEncodingApp::DiscardFrame(const FrameTicket& ticket) {
+    if (m_headless || ticket.RecreateSwapChain) {
+        return;
     }
 
-    m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
 
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = &m_imageAvailableSemaphores[ticket.FrameSlot];
+    submitInfo.pWaitDstStageMask = waitStages;
+
+    vkResetFences(m_logicalDevice, 1, &m_inFlightFences[ticket.FrameSlot]);
+    if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_inFlightFences[ticket.FrameSlot]) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit discarded frame!");
+    }
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void NvEncodingApp::UpdateVulkanUniformBuffers(uint32_t imageIndex) {
 
-    static const auto START_TIME = std::chrono::high_resolution_clock::now();
-    const auto currentTime = std::chrono::high_resolution_clock::now();
-    const float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - START_TIME).count();
+void NvEncodingApp::RecreateSwapChainWhileRunning() {
+    //The record thread uses the swap chain and the per-image objects while holding m_frameMutex
+    std::lock_guard<std::mutex> lock(m_frameMutex);
+    RecreateSwapChain();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+//The draw objects aren't modified, since the main thread reads them when it records the command buffers
+void NvEncodingApp::UpdateVulkanUniformBuffers(const uint32_t imageIndex, const SceneState& state) {
+    SHIN_PROFILE_FUNCTION();
 
     const uint32_t numObjects = static_cast<uint32_t>(m_drawObjects.size());
     for (uint32_t i = 0; i < numObjects; ++i) {
-        m_drawObjects[i].Rotate(time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        m_drawObjects[i].UpdateUniformBuffers(m_logicalDevice, imageIndex);
+        m_drawObjects[i].UpdateUniformBuffers(m_logicalDevice, imageIndex, state.ModelMats[i]);
     }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The quads sample the part of the offscreen texture which has been rendered.
+//The uniform buffers of the image aren't in use: RecordFrame() has waited for the previous frame of this image
+void NvEncodingApp::UpdateQuadUniformBuffers(const uint32_t imageIndex) {
+    const VkExtent2D renderExtent = m_resolutionScaler.GetExtent();
+    const VkExtent2D maxExtent = m_resolutionScaler.GetMaxExtent();
+    const float u = static_cast<float>(renderExtent.width) / static_cast<float>(maxExtent.width);
+    const float v = static_cast<float>(renderExtent.height) / static_cast<float>(maxExtent.height);
 
+    m_quadDrawObject.SetTexCoordScale(u, v);
     m_quadDrawObject.UpdateUniformBuffers(m_logicalDevice, imageIndex);
+    m_smallerQuadDrawObject.SetTexCoordScale(u, v);
     m_smallerQuadDrawObject.UpdateUniformBuffers(m_logicalDevice, imageIndex);
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+
+//With shared frames, the GPU writes directly into the slots of the shared frame ring if they can be imported, and
+//the frames are published in place. Otherwise they are copied into the ring once they have been read back
+void NvEncodingApp::InitReadbackRing() {
+    const uint32_t graphicsIndex = m_queueFamilyIndices.GetGraphicsIndex();
+    const VkExtent2D extent = m_offScreenPass.GetExtent();
+    VkFormat format = m_offScreenPass.GetColorFormat();
+    const bool importSharedFrames = !m_sharedFramesName.empty() 
+        && m_deviceCapabilities.IsExternalMemoryHostSupported();
+    if (!m_sharedFramesName.empty()) {
+        m_sharedFrameRing.Create(m_sharedFramesName, extent, format, 
+            importSharedFrames ? READBACK_RING_SIZE : SHARED_FRAME_RING_SIZE);
+    }
+
+    //The same conversion as the cpu encoder. Each slot of the ring has its own descriptor set
+    if (m_gpuColorConversion) {
+        m_colorConversionPass.Init(m_logicalDevice, g_allocator, "../Shared/Shaders/RGBAToYUV.comp.spv", 
+            Shin::COLOR_MATRIX_BT601, Shin::YUV_FORMAT_I420, READBACK_RING_SIZE);
+        format = m_colorConversionPass.GetOutputFormat();
+    }
+
+    if (importSharedFrames) {
+        try {
+            m_readbackRing.InitWithSharedFrameRing(m_physicalDevice, m_logicalDevice, g_allocator, graphicsIndex,
+                &m_sharedFrameRing, m_deviceCapabilities.GetMinImportedHostPointerAlignment());
+            return;
+        } catch (const std::exception& e) {
+            //Some drivers can only import private allocations. Keep sharing with copies
+            std::cout << "Shared frames are copied: " << e.what() << std::endl;
+            m_readbackRing.CleanUp(m_logicalDevice, g_allocator);
+        }
+    }
+
+    m_readbackRing.Init(m_physicalDevice, m_logicalDevice, g_allocator, graphicsIndex, extent, format, 
+        READBACK_RING_SIZE);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The frames are read in place, and released as soon as they have been consumed so that the ring doesn't drop them.
+//Other processes get a copy in the shared frame ring, unless the readback ring has already published them there
+void NvEncodingApp::ConsumeReadbackFrames() {
+    SHIN_PROFILE_FUNCTION();
+
+    Shin::ReadbackFrame frame;
+    while (m_readbackRing.Acquire(&frame)) {
+        ++m_numReadbackFrames;
+        if (m_sharedFrameRing.IsOpen() && !m_readbackRing.PublishesSharedFrames()) {
+            m_sharedFrameRing.Publish(frame.Data, frame.RowPitch, frame.Extent, frame.FrameIndex);
+        }
+        if (m_cpuEncoder.IsInitialized()) {
+            EncodeFrame(frame.Slot, frame.Extent); //The inputs are the slots
+        }
+        m_readbackRing.Release(frame);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncodingApp::InitFrameExporter() {
+    if (!m_externalMemorySupported || !m_deviceCapabilities.IsExternalTimelineSemaphoreSupported()) {
+        std::cout << "Frame export is disabled: the device does not support external memory and external timeline "
+            << "semaphores" << std::endl;
+        return;
+    }
+
+    m_frameExporter.Init(m_instance, m_physicalDevice, m_logicalDevice, g_allocator, m_frameExportPath);
+    std::cout << "Frame export: listening on " << m_frameExportPath << std::endl;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//A consumer stays connected if the offscreen images have been kept
+void NvEncodingApp::SetFrameExporterImages(const uint32_t numImages) {
+    std::vector<VkDeviceMemory> memories(numImages);
+    std::vector<VkDeviceSize> memorySizes(numImages);
+    for (uint32_t i = 0; i < numImages; ++i) {
+        memories[i] = m_offScreenPass.GetImageMemory(i);
+        memorySizes[i] = m_offScreenPass.GetImageMemorySize(i);
+    }
+    m_frameExporter.SetImages(memories, memorySizes, m_offScreenPass.GetExtent(), m_offScreenPass.GetColorFormat(),
+        m_offScreenPass.GetColorUsage());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncodingApp::InitResolutionScaler() {
+    m_resolutionScaler.Init(m_offScreenPass.GetExtent(), OFFSCREEN_GPU_BUDGET_MS, OFFSCREEN_MIN_RESOLUTION_SCALE);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+    m_timestampPeriodNs = static_cast<double>(properties.limits.timestampPeriod);
+
+    //Without timestamps, the offscreen pass is always rendered at its full extent
+    std::vector<VkQueueFamilyProperties> queueFamilies;
+    GetVulkanQueueFamilyPropertiesInto(m_physicalDevice, &queueFamilies);
+    const uint32_t validBits = queueFamilies[m_queueFamilyIndices.GetGraphicsIndex()].timestampValidBits;
+    m_timestampsSupported = (validBits > 0);
+    m_timestampMask = (validBits >= 64) ? UINT64_MAX : ((static_cast<uint64_t>(1) << validBits) - 1);
+    std::cout << "Dynamic resolution: " << (m_timestampsSupported ? "enabled" : "disabled") << std::endl;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Only grows. The number of images only changes after RecreateSwapChain() has waited for the device
+void NvEncodingApp::CreateTimestampQueryPool(const uint32_t numImages) {
+    if (!m_timestampsSupported || m_numTimestampImages >= numImages) {
+        return;
+    }
+
+    SAFE_DESTROY_QUERY_POOL(m_logicalDevice, m_timestampQueryPool, g_allocator);
+
+    VkQueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = numImages * 2;
+
+    if (vkCreateQueryPool(m_logicalDevice, &queryPoolInfo, g_allocator, &m_timestampQueryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create query pool!");
+    }
+    m_numTimestampImages = numImages;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Reads the GPU time of the previous frame of the image, which RecordFrame() has waited for.
+//When the render extent changes, all the command buffers are recorded again before they are submitted
+void NvEncodingApp::UpdateRenderExtent(const uint32_t imageIndex) {
+    if (VK_NULL_HANDLE == m_timestampQueryPool || !m_timestampsWritten[imageIndex]) {
+        return;
+    }
+
+    std::array<uint64_t, 2> timestamps = {};
+    const VkResult result = vkGetQueryPoolResults(m_logicalDevice, m_timestampQueryPool, imageIndex * 2, 2,
+        sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (VK_SUCCESS != result) {
+        return;
+    }
+
+    const uint64_t elapsedTicks = ((timestamps[1] & m_timestampMask) - (timestamps[0] & m_timestampMask)) & m_timestampMask;
+    const double gpuTimeMs = static_cast<double>(elapsedTicks) * m_timestampPeriodNs * 1.0e-6;
+    if (m_resolutionScaler.AddGPUTime(static_cast<float>(gpuTimeMs))) {
+        m_outdatedCommandBuffers.assign(m_outdatedCommandBuffers.size(), true);
+    }
+}
 
 //---------------------------------------------------------------------------------------------------------------------
 void NvEncodingApp::PrintSupportedExtensions() {
@@ -968,16 +1795,38 @@ void NvEncodingApp::PrintSupportedExtensions() {
 }
 //---------------------------------------------------------------------------------------------------------------------
 
-void NvEncodingApp::GetRequiredExtensionsInto(std::vector<const char*>* extensions) {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+void NvEncodingApp::GetRequiredExtensionsInto(const bool headless, std::vector<const char*>* extensions) {
+    //Surface extensions are only needed when there is a window
+    if (!headless) {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-    extensions->insert(extensions->end(), &glfwExtensions[0], &glfwExtensions[glfwExtensionCount]);   
+        extensions->insert(extensions->end(), &glfwExtensions[0], &glfwExtensions[glfwExtensionCount]);   
+    }
     extensions->insert(extensions->end(), g_requiredInstanceExtensions.begin(),g_requiredInstanceExtensions.end());
 
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncodingApp::GetDeviceExtensionsInto(const VkPhysicalDevice& device, std::vector<const char*>* extensions, 
+    bool* encodingSupported) const
+{
+    if (!m_headless) {
+        extensions->insert(extensions->end(), g_swapChainDeviceExtensions.begin(), g_swapChainDeviceExtensions.end());
+        extensions->insert(extensions->end(), g_encodingDeviceExtensions.begin(), g_encodingDeviceExtensions.end());
+        *encodingSupported = true;
+        return;
+    }
+
+    //Headless: devices without external memory support (software rasterizers) can still render, but not encode
+    *encodingSupported = CheckDeviceExtensionSupport(device, &g_encodingDeviceExtensions);
+    if (*encodingSupported) {
+        extensions->insert(extensions->end(), g_encodingDeviceExtensions.begin(), g_encodingDeviceExtensions.end());
+    }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void NvEncodingApp::GetVulkanQueueFamilyPropertiesInto(const VkPhysicalDevice& device, 
                                                      std::vector<VkQueueFamilyProperties>* queueFamilies) 
@@ -1006,6 +1855,11 @@ QueueFamilyIndices NvEncodingApp::QueryVulkanQueueFamilyIndices(const VkPhysical
             indices.SetGraphicsIndex(i);
         }
 
+        //Headless: nothing is presented, so the graphics queue is used for both
+        if (VK_NULL_HANDLE == surface && indices.IsGraphicsIndexSet()) {
+            indices.SetPresentIndex(indices.GetGraphicsIndex());
+        }
+
         if (!indices.IsPresentIndexSet()) {
             VkBool32 presentSupport = false;
             vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
@@ -1096,6 +1950,10 @@ VkPresentModeKHR NvEncodingApp::PickSwapPresentMode(const std::vector<VkPresentM
 
 void NvEncodingApp::CleanUp() {
 
+    //The pipelines are destroyed below, before the pipeline libraries which they were linked from
+    m_pipelineCompiler.CancelRequests();
+    m_jobSystem.CleanUp();
+
     //Semaphores
     const uint32_t numSyncObjects = static_cast<uint32_t>(m_imageAvailableSemaphores.size());
     for (size_t i = 0; i < numSyncObjects; i++) {
@@ -1107,12 +1965,21 @@ void NvEncodingApp::CleanUp() {
     m_renderFinishedSemaphores.clear();
     m_inFlightFences.clear();
 
+    DestroyRetiredSwapChains(true);
     CleanUpSwapChain();
 
     SAFE_DESTROY_DESCRIPTOR_SET_LAYOUT(m_logicalDevice,m_texDescriptorSetLayout,g_allocator);
     SAFE_DESTROY_DESCRIPTOR_SET_LAYOUT(m_logicalDevice,m_colorDescriptorSetLayout,g_allocator);
 
+    //The inputs of the cpu encoder are in the readback ring.
+    //The host memory is freed after the device memory which imports it
+    m_cpuEncoder.CleanUp();
+    m_readbackRing.CleanUp(m_logicalDevice, g_allocator);
+    m_colorConversionPass.CleanUp(m_logicalDevice, g_allocator);
+    m_sharedFrameRing.Close();
+    m_frameExporter.CleanUp(m_logicalDevice, g_allocator);
     m_offScreenPass.CleanUp(m_logicalDevice, g_allocator);
+    m_encoderInputPass.CleanUp(m_logicalDevice, g_allocator);
 
     //Draw Objects
     const uint32_t numDrawObjects = static_cast<uint32_t>(m_drawObjects.size());
@@ -1131,7 +1998,8 @@ void NvEncodingApp::CleanUp() {
     }
     m_drawPipelines.clear();
     SAFE_CLEANUP_PTR(m_logicalDevice, g_allocator, m_quadDrawPipeline);
-    
+    m_pipelineStateCache.CleanUp();
+    m_pipelineCompiler.CleanUp();
 
     //Textures
     SAFE_CLEANUP_PTR(m_logicalDevice, g_allocator, m_texture);
@@ -1143,6 +2011,7 @@ void NvEncodingApp::CleanUp() {
 
 
     SAFE_DESTROY_COMMAND_POOL(m_logicalDevice, m_commandPool, g_allocator);
+    SAFE_DESTROY_QUERY_POOL(m_logicalDevice, m_timestampQueryPool, g_allocator);
 
     m_graphicsQueue = VK_NULL_HANDLE;
     m_presentationQueue = VK_NULL_HANDLE;
@@ -1175,8 +2044,11 @@ void NvEncodingApp::CleanUp() {
 void NvEncodingApp::CleanUpSwapChain() {
 
 
-    const uint32_t numImages = static_cast<uint32_t>(m_swapChainImages.size());
-    vkFreeCommandBuffers(m_logicalDevice, m_commandPool, static_cast<uint32_t>(m_commandBuffers.size()), m_commandBuffers.data());
+    if (!m_commandBuffers.empty()) {
+        vkFreeCommandBuffers(m_logicalDevice, m_commandPool, static_cast<uint32_t>(m_commandBuffers.size()), 
+            m_commandBuffers.data());
+        m_commandBuffers.clear();
+    }
 
     m_nvEncoder.DestroyBuffers();
     CleanUpCudaImages();
@@ -1186,25 +2058,90 @@ void NvEncodingApp::CleanUpSwapChain() {
     for (uint32_t i = 0; i < numDrawPipelines; ++i) {
         m_drawPipelines[i]->CleanUpSwapChainObjects(m_logicalDevice, g_allocator);
     }
+    if (!m_useDynamicRendering) {
+        m_pipelineStateCache.ClearPipelines(); //The keys refer to the render passes
+        m_pipelineCompiler.ClearRenderPassLibraries();
+    }
 
     SAFE_DESTROY_DESCRIPTOR_POOL(m_logicalDevice, m_descriptorPool, g_allocator);
-    for (VkFramebuffer& framebuffer : m_swapChainFramebuffers) {
-        vkDestroyFramebuffer(m_logicalDevice, framebuffer, g_allocator);
+    for (Shin::RenderGraph& renderGraph : m_renderGraphs) {
+        renderGraph.CleanUp(m_logicalDevice, g_allocator);
     }
-    m_swapChainFramebuffers.clear();
+    m_renderGraphs.clear();
 
     for (VkImageView& imageView : m_swapChainImageViews) {
         vkDestroyImageView(m_logicalDevice, imageView, g_allocator);
     }
+    m_swapChainImageViews.clear();
     m_swapChainImages.clear();
 
     SAFE_DESTROY_RENDER_PASS(m_logicalDevice, m_renderPass, g_allocator);
     SAFE_DESTROY_SWAP_CHAIN(m_logicalDevice, m_swapChain, g_allocator);
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+
+//Moves the swap chain and the objects that refer to its images to m_retiredSwapChains.
+//m_imagesInFlight is kept since the other per-image objects (uniform buffers, offscreen textures, etc) are still used
+void NvEncodingApp::RetireSwapChain() {
+    RetiredSwapChain retired;
+    retired.SwapChain = m_swapChain;
+    retired.ImageViews.swap(m_swapChainImageViews);
+    retired.RenderGraphs.swap(m_renderGraphs);
+    retired.CommandBuffers.swap(m_commandBuffers);
+
+    for (const VkFence fence : m_imagesInFlight) {
+        if (VK_NULL_HANDLE != fence 
+            && std::find(retired.Fences.begin(), retired.Fences.end(), fence) == retired.Fences.end()) 
+        {
+            retired.Fences.push_back(fence);
+        }
+    }
+
+    m_swapChainImages.clear();
+    m_swapChain = VK_NULL_HANDLE;
+    m_retiredSwapChains.push_back(retired);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//A fence may have been reused by a later frame after the swap chain was retired. Waiting for it to be signaled 
+//again is conservative, but still correct since the queue executes the frames in order
+void NvEncodingApp::DestroyRetiredSwapChains(const bool forceDestroy) {
+
+    uint32_t i = 0;
+    while (i < m_retiredSwapChains.size()) {
+        RetiredSwapChain& retired = m_retiredSwapChains[i];
+
+        bool signaled = true;
+        const uint32_t numFences = static_cast<uint32_t>(retired.Fences.size());
+        for (uint32_t j = 0; !forceDestroy && signaled && j < numFences; ++j) {
+            signaled = (VK_SUCCESS == vkGetFenceStatus(m_logicalDevice, retired.Fences[j]));
+        }
+        if (!signaled) {
+            ++i;
+            continue;
+        }
+
+        if (!retired.CommandBuffers.empty()) {
+            vkFreeCommandBuffers(m_logicalDevice, m_commandPool, static_cast<uint32_t>(retired.CommandBuffers.size()), 
+                retired.CommandBuffers.data());
+        }
+        for (Shin::RenderGraph& renderGraph : retired.RenderGraphs) {
+            renderGraph.CleanUp(m_logicalDevice, g_allocator);
+        }
+        for (VkImageView& imageView : retired.ImageViews) {
+            vkDestroyImageView(m_logicalDevice, imageView, g_allocator);
+        }
+        SAFE_DESTROY_SWAP_CHAIN(m_logicalDevice, retired.SwapChain, g_allocator);
+
+        m_retiredSwapChains.erase(m_retiredSwapChains.begin() + i);
+    }
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 void NvEncodingApp::CleanUpCudaImages() {
-    const uint32_t numImages = static_cast<uint32_t>(m_swapChainImages.size());
+    const uint32_t numImages = static_cast<uint32_t>(m_cudaImages.size());
     for (uint32_t i = 0; i < numImages; ++i) {
         m_cudaImages[i].CleanUp();
     }
@@ -1215,9 +2152,67 @@ void NvEncodingApp::CleanUpCudaImages() {
 //---------------------------------------------------------------------------------------------------------------------
 
 void NvEncodingApp::InitCudaAndNvCodec() {
-    m_cudaContext.Init(m_instance, m_physicalDevice);
-    m_nvEncoder.Init(NV_ENC_DEVICE_TYPE_CUDA, m_cudaContext.GetContext(), 
-        OFFSCREEN_TEXTURE_WIDTH, OFFSCREEN_TEXTURE_HEIGHT);
+    if (FRAME_ENCODER_TYPE_NVENC != m_encoderType) {
+        return;
+    }
+
+    if (!m_encodingEnabled) {
+        std::cout << "Encoding is disabled: the device does not support external memory" << std::endl;
+        return;
+    }
+
+    try {
+        m_cudaContext.Init(m_instance, m_physicalDevice);
+        m_nvEncoder.Init(NV_ENC_DEVICE_TYPE_CUDA, m_cudaContext.GetContext(), 
+            OFFSCREEN_TEXTURE_WIDTH, OFFSCREEN_TEXTURE_HEIGHT);
+        m_frameEncoder = &m_nvEncoder;
+    } catch (const std::exception& e) {
+        //Headless mode is also used on machines without NVIDIA GPUs. Keep rendering without encoding
+        if (!m_headless)
+            throw;
+
+        std::cout << "Encoding is disabled: " << e.what() << std::endl;
+        m_nvEncoder.CleanUp();
+        m_cudaContext.CleanUp();
+        m_encodingEnabled = false;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The frames are encoded on the main thread, when they are acquired from the readback ring. They are converted by
+//the workers which also load the assets, so that the cores are not oversubscribed.
+//The ring isn't recreated with the swap chain: neither are the inputs
+void NvEncodingApp::InitCpuEncoder() {
+    m_cpuEncoder.Init(OFFSCREEN_TEXTURE_WIDTH, OFFSCREEN_TEXTURE_HEIGHT, &m_jobSystem);
+    const uint32_t numSlots = m_readbackRing.GetNumSlots();
+    m_cpuEncoder.CreateBuffers(numSlots);
+    const bool converted = m_colorConversionPass.IsInitialized();
+    for (uint32_t i = 0; i < numSlots; ++i) {
+        FrameEncoderInput input = {};
+        input.Type = converted ? FRAME_ENCODER_INPUT_TYPE_HOST_MEMORY_I420 : FRAME_ENCODER_INPUT_TYPE_HOST_MEMORY;
+        input.Resource = const_cast<uint8_t*>(m_readbackRing.GetSlotData(i));
+        input.RowPitch = 0; //Tightly packed
+        m_cpuEncoder.RegisterInput(i, input);
+    }
+    m_frameEncoder = &m_cpuEncoder;
+    if (converted) {
+        std::cout << "Encoding: CPU I420, converted on the GPU" << std::endl;
+        return;
+    }
+    std::cout << "Encoding: CPU I420 on " << m_cpuEncoder.GetNumThreads() << " threads ("
+        << Shin::ColorConversion::GetSIMDLevelName(m_cpuEncoder.GetSIMDLevel()) << ")" << std::endl;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncodingApp::EncodeFrame(const uint32_t inputIndex, const VkExtent2D& extent) {
+    m_frameEncoder->Reconfigure(extent.width, extent.height);
+    m_frameEncoder->EncodeFrame(inputIndex);
+    while (m_frameEncoder->RetrieveBitstream(&m_bitstream)) {
+        ++m_numEncodedFrames;
+        m_numEncodedBytes += m_bitstream.size();
+    }
 }
 
 //---------------------------------------------------------------------------------------------------------------------
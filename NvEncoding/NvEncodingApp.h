@@ -4,6 +4,11 @@
 #include <glm/vec4.hpp>
 #include <vector>
 #include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <string>
 
 //Shared
 #include "Shin/SharedConfig.h"
@@ -11,11 +16,24 @@
 #include "Shin/PhysicalDeviceSurfaceInfo.h"
 #include "Shin/DrawObject.h"
 #include "Shin/OffScreenPass.h"
+#include "Shin/RenderGraph.h"
+#include "Shin/StageQueue.h"
+#include "Shin/DeviceCapabilities.h"
+#include "Shin/JobSystem.h"
+#include "Shin/StartupTimeline.h"
+#include "Shin/PipelineCompiler.h"
+#include "Shin/PipelineStateCache.h"
+#include "Shin/ResolutionScaler.h"
+#include "Shin/ReadbackRing.h"
+#include "Shin/SharedFrameRing.h"
+#include "Shin/FrameExporter.h"
+#include "Shin/ColorConversionPass.h"
 
 //Cuda and NvEncoder
 #include "Cuda/CudaContext.h"
 #include "Cuda/CudaImage.h"
 #include "NvEncoder.h"
+#include "CpuEncoder.h"
 
 #include "QueueFamilyIndices.h"
 
@@ -31,13 +49,24 @@ namespace Shin {
 class NvEncodingApp {
 public:
     NvEncodingApp();
-    void Run();
+
+    //headless: no window and no swap chain. Only the offscreen pass is rendered for headlessDurationSeconds
+    //readback: copy the offscreen frames to host memory, for consumers other than the encoder
+    //sharedFramesName: publish the copied frames in a SharedFrameRing. Empty for none
+    //frameExportPath: the socket which a FrameConsumerApp connects to, to share the offscreen images. Empty for none
+    //encoderType: FRAME_ENCODER_TYPE_CPU encodes the frames of the readback ring, and implies readback
+    //gpuColorConversion: FRAME_ENCODER_TYPE_CPU only. The frames are converted to I420 before they are read back.
+    //Ignored with sharedFramesName, whose consumers expect RGBA
+    void Run(const bool headless, const float headlessDurationSeconds, const bool readback, 
+        const std::string& sharedFramesName, const std::string& frameExportPath, const FrameEncoderType encoderType,
+        const bool gpuColorConversion);
     void CleanUp();
     inline void RequestToRecreateSwapChain();
 
 private:
     void Init();
     void InitCudaAndNvCodec();
+    void InitCpuEncoder(); //After InitReadbackRing()
     void RecreateSwapChain();
 
 #ifdef ENABLE_VULKAN_DEBUG
@@ -57,25 +86,69 @@ private:
     void CreateSyncObjects();
     
     //Swap chain related
-    void CreateSwapChain();
+    void CreateSwapChain(const VkSwapchainKHR oldSwapChain);
     void CreateImageViews();
     void CreateRenderPass();
-    void CreateFrameBuffers();
     void CreateDescriptorPool();
     void CreateCommandBuffers();
+    void RecordCommandBuffer(const uint32_t imageIndex);
+    void UpdateCommandBuffer(const uint32_t imageIndex); //Records it again if a pipeline has become ready
+    void BuildRenderGraph(const uint32_t imageIndex, Shin::RenderGraph* graph);
     void CreateCudaImages();
     void SetupNvEncoderResources();
 
+    //Dynamic resolution: the offscreen pass renders into a part of its textures, chosen from its GPU time
+    void InitResolutionScaler();
+    void InitReadbackRing();
+    void ConsumeReadbackFrames();
+    void InitFrameExporter();
+    void SetFrameExporterImages(const uint32_t numImages);
+    void EncodeFrame(const uint32_t inputIndex, const VkExtent2D& extent); //Retrieves the bitstream
+    void CreateTimestampQueryPool(const uint32_t numImages);
+    void UpdateRenderExtent(const uint32_t imageIndex); //Main thread, before UpdateCommandBuffer()
+    void UpdateQuadUniformBuffers(const uint32_t imageIndex); //Main thread: depends on the render extent
+
     //Swap Chain cleaning up related
     void CleanUpSwapChain();
     void CleanUpCudaImages();
+    void RetireSwapChain();
+    void DestroyRetiredSwapChains(const bool forceDestroy); //forceDestroy: don't check the fences
+
+    //Frame pipeline. Frame N+2 is simulated, frame N+1 is recorded and frame N is submitted at the same time:
+    //1. Simulation thread: computes the transforms of the scene into one of the scene states
+    //2. Record thread: waits for the frame resources, acquires an image and writes the scene state into the 
+    //   uniform buffers of the image. The command buffers are prerecorded per image by the render graphs.
+    //   Neither thread modifies the draw objects, which the main thread reads to record the command buffers
+    //3. Main thread: submits, encodes and presents, and recreates the swap chain
+    struct SceneState {
+        float               Time;
+        std::vector<glm::mat4> ModelMats; //One per draw object
+    };
+
+    struct FrameTicket {
+        uint32_t    FrameSlot;           //Index of the semaphores and the in flight fence
+        uint32_t    ImageIndex;          
+        uint64_t    SwapChainGeneration; //The swap chain which the image was acquired from
+        bool        RecreateSwapChain;   //The swap chain was out of date. No image was acquired
+    };
 
     void Loop(); 
-    void DrawFrame();
-    void UpdateVulkanUniformBuffers(uint32_t imageIndex);
+    void StartFramePipeline();
+    void StopFramePipeline();
+    void SimulationThreadLoop();
+    void RecordThreadLoop();
+    void SimulateScene(SceneState* state) const;
+    bool RecordFrame(const SceneState& state, FrameTicket* ticket);   //false if the pipeline is stopping
+    bool AcquireNextImage(FrameTicket* ticket); //false if no image is available yet
+    void SubmitFrame(const FrameTicket& ticket);
+    void DiscardFrame(const FrameTicket& ticket);
+    void RecreateSwapChainWhileRunning();
+    void UpdateVulkanUniformBuffers(const uint32_t imageIndex, const SceneState& state);
 
     static void PrintSupportedExtensions();
-    static void GetRequiredExtensionsInto(std::vector<const char*>* extensions);
+    static void GetRequiredExtensionsInto(const bool headless, std::vector<const char*>* extensions);
+    void GetDeviceExtensionsInto(const VkPhysicalDevice& device, std::vector<const char*>* extensions, 
+        bool* encodingSupported) const;
 
     static void GetVulkanQueueFamilyPropertiesInto(const VkPhysicalDevice& device, std::vector<VkQueueFamilyProperties>* );
     static QueueFamilyIndices QueryVulkanQueueFamilyIndices(const VkPhysicalDevice& device, const VkSurfaceKHR& surface);
@@ -93,12 +166,21 @@ private:
     Window*                         m_window;
     Shin::OffScreenPass             m_offScreenPass;
 
+    //Headless
+    bool                            m_headless;
+    float                           m_headlessDurationSeconds;
+    bool                            m_encodingEnabled;
+    uint32_t                        m_numImages; //The number of swap chain images, or HEADLESS_NUM_IMAGES
+
     VkInstance                      m_instance;
     VkSurfaceKHR                    m_surface;
     VkPhysicalDevice                m_physicalDevice;
+    std::vector<const char*>        m_deviceExtensions;
+    Shin::DeviceCapabilities        m_deviceCapabilities; //Optional features which are used when available
     VkDevice                        m_logicalDevice;
     VkSwapchainKHR                  m_swapChain;
     VkRenderPass                    m_renderPass;
+    bool                            m_useDynamicRendering; //No render passes and framebuffers. Kept on resize
     VkDescriptorSetLayout           m_texDescriptorSetLayout;
     VkDescriptorSetLayout           m_colorDescriptorSetLayout;
     VkDescriptorPool                m_descriptorPool; //A pool to create descriptor set to bind uniform buffers 
@@ -118,6 +200,7 @@ private:
     Shin::DrawPipeline*             m_quadDrawPipeline;
 
     std::vector<VkCommandBuffer> m_commandBuffers;
+    std::vector<bool>            m_outdatedCommandBuffers; //Recorded while a pipeline was compiling
     
     std::vector<VkSemaphore> m_imageAvailableSemaphores;
     std::vector<VkSemaphore> m_renderFinishedSemaphores;
@@ -127,11 +210,64 @@ private:
     std::vector<VkImageView>    m_swapChainImageViews;
     VkFormat                    m_swapChainSurfaceFormat;
     VkExtent2D                  m_swapChainExtent;
-    std::vector<VkFramebuffer>  m_swapChainFramebuffers;
+    std::vector<Shin::RenderGraph> m_renderGraphs; //One per image. Owns the framebuffers
     uint32_t                    m_currentFrame;
     std::vector<VkFence>        m_inFlightFences; //CPU-GPU synchronizations
     std::vector<VkFence>        m_imagesInFlight; //To test if the current frame is still in flight
     bool                        m_recreateSwapChainRequested;
+    uint64_t                    m_swapChainGeneration; //Incremented every time the swap chain is recreated
+
+    //Swap chains which have been replaced, but may still be used by frames in flight
+    struct RetiredSwapChain {
+        VkSwapchainKHR                  SwapChain;
+        std::vector<VkImageView>        ImageViews;
+        std::vector<Shin::RenderGraph>  RenderGraphs;
+        std::vector<VkCommandBuffer>    CommandBuffers;
+        std::vector<VkFence>            Fences; //Can be destroyed after all of these are signaled
+    };
+    std::vector<RetiredSwapChain>   m_retiredSwapChains;
+
+    //Frame pipeline
+    std::vector<SceneState>         m_sceneStates;
+    Shin::StageQueue<uint32_t>      m_freeSceneStates;      //Indices of m_sceneStates
+    Shin::StageQueue<uint32_t>      m_simulatedSceneStates;
+    Shin::StageQueue<FrameTicket>   m_recordedFrames;
+    std::thread                     m_simulationThread;
+    std::thread                     m_recordThread;
+    std::atomic<bool>               m_frameLoopRunning;
+    std::exception_ptr              m_frameThreadException; //Rethrown on the main thread
+    std::mutex                      m_frameMutex;     //Held while a frame is recorded, and while recreating swap chain
+    std::mutex                      m_swapChainMutex; //Acquire and present need external synchronization
+
+    //Startup
+    Shin::JobSystem                 m_jobSystem;       //Loads assets, creates pipelines and converts CPU frames
+    Shin::StartupTimeline           m_startupTimeline; //Printed after the first frame
+    Shin::PipelineCompiler          m_pipelineCompiler; //Compiles the pipelines of RecreateSwapChain() in parallel
+    Shin::PipelineStateCache        m_pipelineStateCache; //Shares identical pipelines between the DrawPipelines
+
+    //Dynamic resolution. Only used on the main thread
+    Shin::ResolutionScaler          m_resolutionScaler;
+    VkQueryPool                     m_timestampQueryPool; //Two per image. VK_NULL_HANDLE if unsupported
+    uint32_t                        m_numTimestampImages;
+    std::vector<bool>               m_timestampsWritten;  //The image has been submitted since it was recorded
+    bool                            m_timestampsSupported;
+    double                          m_timestampPeriodNs;
+    uint64_t                        m_timestampMask;
+
+    //Offscreen frames in host memory. Only initialized for --readback
+    bool                            m_readbackEnabled;
+    Shin::ReadbackRing              m_readbackRing;
+    uint64_t                        m_numSubmittedFrames;
+    uint64_t                        m_numReadbackFrames; //Consumed
+    std::string                     m_sharedFramesName;
+    Shin::SharedFrameRing           m_sharedFrameRing;   //For other processes
+    bool                            m_gpuColorConversion;
+    Shin::ColorConversionPass       m_colorConversionPass; //Fills the readback ring if m_gpuColorConversion
+
+    //Offscreen images shared with a consumer process, without copies. Only initialized for --export-frames
+    bool                            m_externalMemorySupported;
+    std::string                     m_frameExportPath;
+    Shin::FrameExporter             m_frameExporter;
 
     //Queues
     QueueFamilyIndices  m_queueFamilyIndices;
@@ -140,11 +276,23 @@ private:
 
     //Cuda and NvEncoder
     CudaContext             m_cudaContext;
+    Shin::OffScreenPass     m_encoderInputPass; //m_offScreenPass scaled to the full extent. Only its images are used
     std::vector<CudaImage>  m_cudaImages;
     NvEncoder               m_nvEncoder;
 
+    //Encoding
+    FrameEncoderType        m_encoderType;
+    CpuEncoder              m_cpuEncoder;
+    FrameEncoder*           m_frameEncoder; //m_nvEncoder or m_cpuEncoder. nullptr if encoding is disabled
+    std::vector<uint8_t>    m_bitstream;
+    uint64_t                m_numEncodedFrames;
+    uint64_t                m_numEncodedBytes;
+
     static const uint32_t WIDTH = 800;
     static const uint32_t HEIGHT = 600;
+    static const uint32_t HEADLESS_NUM_IMAGES = 3;
+    static const uint32_t NUM_SCENE_STATES = 2;    //Double-buffered between the simulation and the record thread
+    static const uint32_t NUM_RECORDED_FRAMES = 1; //Frames which have been recorded, but not submitted
 
     const uint32_t MAX_FRAMES_IN_FLIGHT = 100;
 };
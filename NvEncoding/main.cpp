@@ -1,10 +1,70 @@
 #include <iostream> //std::exception, EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>  //strcmp
+#include <cstdlib>  //atof
+#include <string>
 #include "NvEncodingApp.h"
+#include "FrameConsumerApp.h"
+
+//Usage: NvEncoding [--headless] [--seconds <duration of the headless run>] [--readback] 
+//                  [--shared-frames <shared memory name>] [--export-frames <socket path>] [--encoder <nvenc|cpu>]
+//                  [--gpu-color-conversion]
+//       NvEncoding --consume-frames <socket path> [--seconds <duration>]
+//--readback: copy the offscreen frames to host memory
+//--shared-frames: also publish them to other processes, e.g. "/NvEncodingFrames". Implies --readback
+//--export-frames: share the offscreen images with a consumer process on the same GPU, e.g. "/tmp/NvEncoding.sock",
+//                 or a pipe name on Windows, e.g. "\\.\pipe\NvEncoding"
+//--consume-frames: run as the consumer of another NvEncoding process which uses --export-frames
+//--encoder: nvenc (default) encodes H.264 on the GPU. cpu converts the readback frames to raw I420 on all cores, 
+//           for machines without NVENC. Implies --readback
+//--gpu-color-conversion: with --encoder cpu, convert the frames to I420 in a compute shader before they are read 
+//                        back, which halves the bytes copied to host memory. Ignored with --shared-frames
+int main(int argc, char** argv) {
+    bool headless = false;
+    float headlessDurationSeconds = 10.0f;
+    bool readback = false;
+    std::string sharedFramesName;
+    std::string frameExportPath;
+    std::string frameConsumePath;
+    FrameEncoderType encoderType = FRAME_ENCODER_TYPE_NVENC;
+    bool gpuColorConversion = false;
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp(argv[i], "--headless")) {
+            headless = true;
+        } else if (0 == strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            headlessDurationSeconds = static_cast<float>(atof(argv[++i]));
+        } else if (0 == strcmp(argv[i], "--readback")) {
+            readback = true;
+        } else if (0 == strcmp(argv[i], "--shared-frames") && i + 1 < argc) {
+            readback = true;
+            sharedFramesName = argv[++i];
+        } else if (0 == strcmp(argv[i], "--export-frames") && i + 1 < argc) {
+            frameExportPath = argv[++i];
+        } else if (0 == strcmp(argv[i], "--consume-frames") && i + 1 < argc) {
+            frameConsumePath = argv[++i];
+        } else if (0 == strcmp(argv[i], "--encoder") && i + 1 < argc) {
+            ++i;
+            encoderType = (0 == strcmp(argv[i], "cpu")) ? FRAME_ENCODER_TYPE_CPU : FRAME_ENCODER_TYPE_NVENC;
+        } else if (0 == strcmp(argv[i], "--gpu-color-conversion")) {
+            gpuColorConversion = true;
+        }
+    }
+
+    if (!frameConsumePath.empty()) {
+        FrameConsumerApp consumer;
+        try {
+            consumer.Run(frameConsumePath, headlessDurationSeconds);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            consumer.CleanUp();
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
 
-int main() {
     NvEncodingApp app;
     try {
-        app.Run();
+        app.Run(headless, headlessDurationSeconds, readback, sharedFramesName, frameExportPath, encoderType, 
+            gpuColorConversion);
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
         app.CleanUp();
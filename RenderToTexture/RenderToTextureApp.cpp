@@ -229,7 +229,7 @@ void RenderToTextureApp::InitVulkan() {
     const uint32_t OFFSCREEN_WIDTH =  800;
     const uint32_t OFFSCREEN_HEIGHT = 600;
 
-    m_offScreenPass.Init(OFFSCREEN_WIDTH, OFFSCREEN_HEIGHT);
+    m_offScreenPass.Init(OFFSCREEN_WIDTH, OFFSCREEN_HEIGHT, false, false, VK_FORMAT_UNDEFINED);
 
     //Swap
     RecreateSwapChain();
@@ -470,7 +470,7 @@ void RenderToTextureApp::CreateCommandBuffers() {
             const uint32_t numPipelines = static_cast<uint32_t>(m_drawPipelines.size());
             for (uint32_t j = 0; j < numPipelines; ++j) {
 
-                m_drawPipelines[j]->Bind(m_commandBuffers[i]);
+                m_drawPipelines[j]->Bind(m_commandBuffers[i], m_offScreenPass.GetExtent());
                 m_drawPipelines[j]->DrawToCommandBuffer(m_commandBuffers[i], static_cast<uint32_t>(i));
             }
             vkCmdEndRenderPass(m_commandBuffers[i]);
@@ -489,7 +489,7 @@ void RenderToTextureApp::CreateCommandBuffers() {
 			renderPassInfo.pClearValues = &clearColor;
 
             vkCmdBeginRenderPass(m_commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-            m_quadDrawPipeline->Bind(m_commandBuffers[i]);
+            m_quadDrawPipeline->Bind(m_commandBuffers[i], m_swapChainExtent);
             m_quadDrawPipeline->DrawToCommandBuffer(m_commandBuffers[i], static_cast<uint32_t>(i));
             vkCmdEndRenderPass(m_commandBuffers[i]);
         }
@@ -6,6 +6,7 @@ layout(binding = 0) uniform UniformBufferObject {
     mat4 model;
     mat4 view;
     mat4 proj;
+    vec4 texCoordScale; //xy. The part of the texture which has been rendered
 } uMVP;
 
 //in: From vkCmdBindVertexBuffers
@@ -22,5 +23,5 @@ layout(location = 1) out vec2 fragTexCoord;
 void main() {
     gl_Position = uMVP.model * vec4(inPosition, 0.0, 1.0);
     fragColor = inColor;
-    fragTexCoord = inTexCoord;
+    fragTexCoord = inTexCoord * uMVP.texCoordScale.xy;
 }
\ No newline at end of file
@@ -0,0 +1,362 @@
+#include "ColorConversion.h"
+#include <algorithm> //std::min
+#include <cstring> //memcpy
+
+#include "Shin/JobSystem.h"
+#include "Shin/Profiler.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define SHIN_COLOR_CONVERSION_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h> //__cpuid
+        #define SHIN_TARGET_SSE41
+        #define SHIN_TARGET_AVX2
+    #else
+        //The kernels are compiled for their instruction sets, and selected at runtime
+        #define SHIN_TARGET_SSE41 __attribute__((target("sse4.1")))
+        #define SHIN_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace Shin {
+
+//8 bits of fraction. The chroma coefficients of each row sum up to 0
+struct ColorCoefficients {
+    int16_t Y[3];
+    int16_t U[3];
+    int16_t V[3];
+};
+
+static const ColorCoefficients COLOR_COEFFICIENTS[] = {
+    { {  66, 129,  25 }, { -38, -74, 112 }, { 112, -94, -18 } }, //COLOR_MATRIX_BT601
+    { {  47, 157,  16 }, { -26, -86, 112 }, { 112, -102, -10 } }, //COLOR_MATRIX_BT709
+};
+
+//The rows which are converted together: two rows of the source and of the Y plane, and one row of each chroma plane.
+//NV12: U is the row of interleaved chroma, and V is unused
+struct RowPair {
+    const uint8_t*  Src0;
+    const uint8_t*  Src1;
+    uint8_t*        Y0;
+    uint8_t*        Y1;
+    uint8_t*        U;
+    uint8_t*        V;
+};
+
+static inline uint8_t ToY(const int16_t* k, const int r, const int g, const int b) {
+    return static_cast<uint8_t>(((k[0] * r + k[1] * g + k[2] * b + 128) >> 8) + 16);
+}
+
+static inline uint8_t ToChroma(const int16_t* k, const int r, const int g, const int b) {
+    return static_cast<uint8_t>(((k[0] * r + k[1] * g + k[2] * b + 128) >> 8) + 128);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The chroma sample cx, and the four luma samples of its block
+static inline void ConvertBlockScalar(const ColorCoefficients& c, const RowPair& rows, const uint32_t width,
+    const bool nv12, const uint32_t cx)
+{
+    const uint32_t x0 = cx * 2;
+    const uint32_t x1 = std::min(x0 + 1, width - 1);
+    const uint8_t* p00 = rows.Src0 + x0 * 4;
+    const uint8_t* p01 = rows.Src0 + x1 * 4;
+    const uint8_t* p10 = rows.Src1 + x0 * 4;
+    const uint8_t* p11 = rows.Src1 + x1 * 4;
+
+    rows.Y0[x0] = ToY(c.Y, p00[0], p00[1], p00[2]);
+    rows.Y0[x1] = ToY(c.Y, p01[0], p01[1], p01[2]);
+    rows.Y1[x0] = ToY(c.Y, p10[0], p10[1], p10[2]);
+    rows.Y1[x1] = ToY(c.Y, p11[0], p11[1], p11[2]);
+
+    const int r = (p00[0] + p01[0] + p10[0] + p11[0] + 2) >> 2;
+    const int g = (p00[1] + p01[1] + p10[1] + p11[1] + 2) >> 2;
+    const int b = (p00[2] + p01[2] + p10[2] + p11[2] + 2) >> 2;
+    const uint8_t u = ToChroma(c.U, r, g, b);
+    const uint8_t v = ToChroma(c.V, r, g, b);
+    if (nv12) {
+        rows.U[cx * 2] = u;
+        rows.U[cx * 2 + 1] = v;
+    } else {
+        rows.U[cx] = u;
+        rows.V[cx] = v;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+#ifdef SHIN_COLOR_CONVERSION_X86
+
+//The coefficients of two pixels, to be multiplied with RGBA widened to 16 bits. Alpha is ignored
+SHIN_TARGET_SSE41 static inline __m128i LoadCoefficientsSSE41(const int16_t* k) {
+    return _mm_setr_epi16(k[0], k[1], k[2], 0, k[0], k[1], k[2], 0);
+}
+
+//(sum + 128) >> 8, + offset for 4 pixels, whose RGBA has been multiplied by madd
+SHIN_TARGET_SSE41 static inline __m128i DotSSE41(const __m128i madd01, const __m128i madd23, const int offset) {
+    const __m128i sum = _mm_hadd_epi32(madd01, madd23);
+    const __m128i shifted = _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+    return _mm_add_epi32(shifted, _mm_set1_epi32(offset));
+}
+
+//Y of 4 RGBA pixels
+SHIN_TARGET_SSE41 static inline __m128i ToYSSE41(const __m128i rgba, const __m128i k) {
+    const __m128i p01 = _mm_cvtepu8_epi16(rgba);
+    const __m128i p23 = _mm_cvtepu8_epi16(_mm_srli_si128(rgba, 8));
+    return DotSSE41(_mm_madd_epi16(p01, k), _mm_madd_epi16(p23, k), 16);
+}
+
+//The rounded averages of the two 2x2 blocks of 4 pixels of two rows, as 16 bits RGBA
+SHIN_TARGET_SSE41 static inline __m128i Average2x2SSE41(const __m128i rgba0, const __m128i rgba1) {
+    const __m128i p01 = _mm_add_epi16(_mm_cvtepu8_epi16(rgba0), _mm_cvtepu8_epi16(rgba1));
+    const __m128i p23 = _mm_add_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(rgba0, 8)),
+        _mm_cvtepu8_epi16(_mm_srli_si128(rgba1, 8)));
+    const __m128i block0 = _mm_add_epi16(p01, _mm_srli_si128(p01, 8));
+    const __m128i block1 = _mm_add_epi16(p23, _mm_srli_si128(p23, 8));
+    const __m128i sums = _mm_unpacklo_epi64(block0, block1);
+    return _mm_srli_epi16(_mm_add_epi16(sums, _mm_set1_epi16(2)), 2);
+}
+
+//8 pixels per iteration. Returns the first column which hasn't been converted
+SHIN_TARGET_SSE41 static uint32_t ConvertRowPairSSE41(const ColorCoefficients& c, const RowPair& rows,
+    const uint32_t width, const bool nv12, uint32_t x)
+{
+    const __m128i kY = LoadCoefficientsSSE41(c.Y);
+    const __m128i kU = LoadCoefficientsSSE41(c.U);
+    const __m128i kV = LoadCoefficientsSSE41(c.V);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; x + 8 <= width; x += 8) {
+        const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.Src0 + x * 4));
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.Src0 + x * 4 + 16));
+        const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.Src1 + x * 4));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.Src1 + x * 4 + 16));
+
+        const __m128i y0 = _mm_packs_epi32(ToYSSE41(a0, kY), ToYSSE41(b0, kY));
+        const __m128i y1 = _mm_packs_epi32(ToYSSE41(a1, kY), ToYSSE41(b1, kY));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.Y0 + x), _mm_packus_epi16(y0, zero));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.Y1 + x), _mm_packus_epi16(y1, zero));
+
+        const __m128i avg01 = Average2x2SSE41(a0, a1);
+        const __m128i avg23 = Average2x2SSE41(b0, b1);
+        const __m128i u = DotSSE41(_mm_madd_epi16(avg01, kU), _mm_madd_epi16(avg23, kU), 128);
+        const __m128i v = DotSSE41(_mm_madd_epi16(avg01, kV), _mm_madd_epi16(avg23, kV), 128);
+        const __m128i uv = _mm_packus_epi16(_mm_packs_epi32(u, v), zero); //U0..U3 V0..V3
+
+        if (nv12) {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.U + x), _mm_unpacklo_epi8(uv, _mm_srli_si128(uv, 4)));
+        } else {
+            const int32_t u4 = _mm_cvtsi128_si32(uv);
+            const int32_t v4 = _mm_cvtsi128_si32(_mm_srli_si128(uv, 4));
+            memcpy(rows.U + x / 2, &u4, sizeof(u4));
+            memcpy(rows.V + x / 2, &v4, sizeof(v4));
+        }
+    }
+    return x;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+SHIN_TARGET_AVX2 static inline __m256i LoadCoefficientsAVX2(const int16_t* k) {
+    return _mm256_setr_epi16(k[0], k[1], k[2], 0, k[0], k[1], k[2], 0, k[0], k[1], k[2], 0, k[0], k[1], k[2], 0);
+}
+
+//(sum + 128) >> 8, + offset for 8 values. hadd works within each 128-bit lane: the order is restored by permuting
+SHIN_TARGET_AVX2 static inline __m256i DotAVX2(const __m256i maddA, const __m256i maddB, const __m256i order,
+    const int offset)
+{
+    const __m256i sum = _mm256_permutevar8x32_epi32(_mm256_hadd_epi32(maddA, maddB), order);
+    const __m256i shifted = _mm256_srai_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(128)), 8);
+    return _mm256_add_epi32(shifted, _mm256_set1_epi32(offset));
+}
+
+//Y of 8 RGBA pixels
+SHIN_TARGET_AVX2 static inline __m256i ToYAVX2(const __m256i rgba, const __m256i k) {
+    const __m256i p0123 = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(rgba));
+    const __m256i p4567 = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(rgba, 1));
+    return DotAVX2(_mm256_madd_epi16(p0123, k), _mm256_madd_epi16(p4567, k),
+        _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7), 16);
+}
+
+//The sums of the two 2x2 blocks of 4 pixels of two rows: the first block in the low 64 bits of the low lane,
+//and the second one in the low 64 bits of the high lane
+SHIN_TARGET_AVX2 static inline __m256i Sum2x2AVX2(const __m128i rgba0, const __m128i rgba1) {
+    const __m256i sum = _mm256_add_epi16(_mm256_cvtepu8_epi16(rgba0), _mm256_cvtepu8_epi16(rgba1));
+    return _mm256_add_epi16(sum, _mm256_srli_si256(sum, 8));
+}
+
+//The rounded averages of the four 2x2 blocks of 8 pixels of two rows, as 16 bits RGBA.
+//The low lane has the blocks 0 and 2, and the high lane the blocks 1 and 3
+SHIN_TARGET_AVX2 static inline __m256i Average2x2AVX2(const uint8_t* src0, const uint8_t* src1) {
+    const __m256i sums01 = Sum2x2AVX2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src0)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1)));
+    const __m256i sums23 = Sum2x2AVX2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + 16)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + 16)));
+    const __m256i sums = _mm256_unpacklo_epi64(sums01, sums23);
+    return _mm256_srli_epi16(_mm256_add_epi16(sums, _mm256_set1_epi16(2)), 2);
+}
+
+//Packs two vectors of 8 values into 16 ordered bytes
+SHIN_TARGET_AVX2 static inline __m128i PackAVX2(const __m256i a, const __m256i b) {
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+    return _mm_packus_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+}
+
+//16 pixels per iteration. Returns the first column which hasn't been converted
+SHIN_TARGET_AVX2 static uint32_t ConvertRowPairAVX2(const ColorCoefficients& c, const RowPair& rows,
+    const uint32_t width, const bool nv12, uint32_t x)
+{
+    const __m256i kY = LoadCoefficientsAVX2(c.Y);
+    const __m256i kU = LoadCoefficientsAVX2(c.U);
+    const __m256i kV = LoadCoefficientsAVX2(c.V);
+    const __m256i chromaOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* src0 = rows.Src0 + x * 4;
+        const uint8_t* src1 = rows.Src1 + x * 4;
+        const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src0));
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src0 + 32));
+        const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1 + 32));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rows.Y0 + x), PackAVX2(ToYAVX2(a0, kY), ToYAVX2(b0, kY)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rows.Y1 + x), PackAVX2(ToYAVX2(a1, kY), ToYAVX2(b1, kY)));
+
+        const __m256i avgA = Average2x2AVX2(src0, src1);
+        const __m256i avgB = Average2x2AVX2(src0 + 32, src1 + 32);
+        const __m256i u = DotAVX2(_mm256_madd_epi16(avgA, kU), _mm256_madd_epi16(avgB, kU), chromaOrder, 128);
+        const __m256i v = DotAVX2(_mm256_madd_epi16(avgA, kV), _mm256_madd_epi16(avgB, kV), chromaOrder, 128);
+        const __m128i uv = PackAVX2(u, v); //U0..U7 V0..V7
+
+        if (nv12) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rows.U + x), _mm_unpacklo_epi8(uv, _mm_srli_si128(uv, 8)));
+        } else {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.U + x / 2), uv);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.V + x / 2), _mm_srli_si128(uv, 8));
+        }
+    }
+    return x;
+}
+
+#endif //SHIN_COLOR_CONVERSION_X86
+
+//---------------------------------------------------------------------------------------------------------------------
+
+SIMDLevel ColorConversion::GetSupportedSIMDLevel() {
+#ifdef SHIN_COLOR_CONVERSION_X86
+    #ifdef _MSC_VER
+        int info[4] = {};
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool sse41 = 0 != (info[2] & (1 << 19));
+        const bool osxsave = 0 != (info[2] & (1 << 27));
+        const bool avx = 0 != (info[2] & (1 << 28));
+
+        //AVX2 also needs the OS to save the YMM registers
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx && 6 == (_xgetbv(0) & 6)) {
+            __cpuidex(info, 7, 0);
+            avx2 = 0 != (info[1] & (1 << 5));
+        }
+    #else
+        __builtin_cpu_init();
+        const bool sse41 = __builtin_cpu_supports("sse4.1");
+        const bool avx2 = __builtin_cpu_supports("avx2");
+    #endif
+
+    if (avx2)
+        return SIMD_LEVEL_AVX2;
+    if (sse41)
+        return SIMD_LEVEL_SSE41;
+#endif
+    return SIMD_LEVEL_SCALAR;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+const char* ColorConversion::GetSIMDLevelName(const SIMDLevel level) {
+    switch (level) {
+        case SIMD_LEVEL_SSE41: return "SSE4.1";
+        case SIMD_LEVEL_AVX2: return "AVX2";
+        default: return "Scalar";
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+size_t ColorConversion::GetYUVSize(const uint32_t width, const uint32_t height) {
+    const size_t chromaSize = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+    return static_cast<size_t>(width) * height + 2 * chromaSize;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ColorConversion::Convert(const ColorConversionDesc& desc, const uint8_t* src, uint8_t* dst,
+    JobSystem* jobSystem)
+{
+    SHIN_PROFILE_FUNCTION();
+
+    const uint32_t numRowPairs = (desc.Height + 1) / 2;
+    if (nullptr == jobSystem) {
+        ConvertRowPairs(desc, src, 0, numRowPairs, dst);
+        return;
+    }
+
+    jobSystem->ParallelFor(numRowPairs, ROW_PAIRS_PER_BAND,
+        [&desc, src, dst](const uint32_t begin, const uint32_t end) {
+            ConvertRowPairs(desc, src, begin, end, dst);
+        }
+    );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The SIMD kernels convert the columns which fill their registers, and the rest is converted one block at a time
+void ColorConversion::ConvertRowPairs(const ColorConversionDesc& desc, const uint8_t* src,
+    const uint32_t beginRowPair, const uint32_t endRowPair, uint8_t* dst)
+{
+    const ColorCoefficients& c = COLOR_COEFFICIENTS[desc.Matrix];
+    const bool nv12 = (YUV_FORMAT_NV12 == desc.Format);
+    const uint32_t width = desc.Width;
+    const uint32_t height = desc.Height;
+    const uint32_t chromaWidth = (width + 1) / 2;
+    const size_t chromaSize = static_cast<size_t>(chromaWidth) * ((height + 1) / 2);
+    uint8_t* yPlane = dst;
+    uint8_t* uPlane = dst + static_cast<size_t>(width) * height;
+    uint8_t* vPlane = uPlane + chromaSize;
+
+    for (uint32_t pair = beginRowPair; pair < endRowPair; ++pair) {
+        const uint32_t y0 = pair * 2;
+        const uint32_t y1 = std::min(y0 + 1, height - 1);
+
+        RowPair rows;
+        rows.Src0 = src + static_cast<size_t>(y0) * desc.SrcRowPitch;
+        rows.Src1 = src + static_cast<size_t>(y1) * desc.SrcRowPitch;
+        rows.Y0 = yPlane + static_cast<size_t>(y0) * width;
+        rows.Y1 = yPlane + static_cast<size_t>(y1) * width;
+        if (nv12) {
+            rows.U = uPlane + static_cast<size_t>(pair) * chromaWidth * 2;
+            rows.V = nullptr;
+        } else {
+            rows.U = uPlane + static_cast<size_t>(pair) * chromaWidth;
+            rows.V = vPlane + static_cast<size_t>(pair) * chromaWidth;
+        }
+
+        uint32_t x = 0;
+#ifdef SHIN_COLOR_CONVERSION_X86
+        if (desc.SIMD >= SIMD_LEVEL_AVX2) {
+            x = ConvertRowPairAVX2(c, rows, width, nv12, x);
+        }
+        if (desc.SIMD >= SIMD_LEVEL_SSE41) {
+            x = ConvertRowPairSSE41(c, rows, width, nv12, x);
+        }
+#endif
+        for (uint32_t cx = x / 2; cx < chromaWidth; ++cx) {
+            ConvertBlockScalar(c, rows, width, nv12, cx);
+        }
+    }
+}
+
+} //end namespace
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h> //size_t
+
+namespace Shin {
+
+class JobSystem;
+
+enum ColorMatrix {
+    COLOR_MATRIX_BT601 = 0,
+    COLOR_MATRIX_BT709,
+};
+
+enum YUVFormat {
+    YUV_FORMAT_I420 = 0,    //The Y plane, followed by the U and V planes at half resolution
+    YUV_FORMAT_NV12,        //The Y plane, followed by one plane of interleaved U and V at half resolution
+};
+
+enum SIMDLevel {
+    SIMD_LEVEL_SCALAR = 0,
+    SIMD_LEVEL_SSE41,
+    SIMD_LEVEL_AVX2,
+};
+
+struct ColorConversionDesc {
+    uint32_t    Width;
+    uint32_t    Height;
+    uint32_t    SrcRowPitch;    //Bytes per row of the RGBA source. The planes are tightly packed
+    ColorMatrix Matrix;
+    YUVFormat   Format;
+    SIMDLevel   SIMD;           //Can't be higher than GetSupportedSIMDLevel()
+};
+
+//Converts RGBA8 frames into 8-bit YUV 4:2:0, limited range.
+//Every SIMD level uses the same integer math as the scalar code (and as RGBAToYUV.comp), so they all produce
+//exactly the same bytes. Each chroma sample is the rounded average of a 2x2 block. The last row and column are
+//repeated for odd sizes
+class ColorConversion {
+public:
+    static SIMDLevel GetSupportedSIMDLevel();
+    static const char* GetSIMDLevelName(const SIMDLevel level);
+    static size_t GetYUVSize(const uint32_t width, const uint32_t height);
+
+    //Converts the whole frame. The rows are split into bands which are converted in parallel on jobSystem.
+    //jobSystem: nullptr to convert on the calling thread
+    static void Convert(const ColorConversionDesc& desc, const uint8_t* src, uint8_t* dst, JobSystem* jobSystem);
+
+    //Rows [2 * beginRowPair, 2 * endRowPair) of the Y plane, and rows [beginRowPair, endRowPair) of the chroma
+    static void ConvertRowPairs(const ColorConversionDesc& desc, const uint8_t* src, const uint32_t beginRowPair,
+        const uint32_t endRowPair, uint8_t* dst);
+
+    static const uint32_t ROW_PAIRS_PER_BAND = 8;
+};
+
+} //end namespace
@@ -0,0 +1,212 @@
+#include "ColorConversionPass.h"
+#include <stdexcept> //std::runtime_error
+#include <array>
+
+#include "Utilities/GraphicsUtility.h"
+#include "Utilities/FileUtility.h"
+#include "Utilities/Macros.h"
+
+namespace Shin {
+
+ColorConversionPass::ColorConversionPass() : m_descriptorSetLayout(VK_NULL_HANDLE)
+    , m_descriptorPool(VK_NULL_HANDLE), m_pipelineLayout(VK_NULL_HANDLE), m_pipeline(VK_NULL_HANDLE)
+    , m_matrix(COLOR_MATRIX_BT601), m_format(YUV_FORMAT_I420)
+{
+
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ColorConversionPass::Init(const VkDevice device, const VkAllocationCallbacks* allocator,
+    const char* shaderPath, const ColorMatrix matrix, const YUVFormat format, const uint32_t numSets)
+{
+    m_matrix = matrix;
+    m_format = format;
+    CreateDescriptorSets(device, allocator, numSets);
+    CreatePipeline(device, allocator, shaderPath);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ColorConversionPass::CleanUp(const VkDevice device, const VkAllocationCallbacks* allocator) {
+    SAFE_DESTROY_PIPELINE(device, m_pipeline, allocator);
+    SAFE_DESTROY_PIPELINE_LAYOUT(device, m_pipelineLayout, allocator);
+
+    //Frees the sets
+    if (VK_NULL_HANDLE != m_descriptorPool) {
+        vkDestroyDescriptorPool(device, m_descriptorPool, allocator);
+        m_descriptorPool = VK_NULL_HANDLE;
+    }
+    m_descriptorSets.clear();
+    SAFE_DESTROY_DESCRIPTOR_SET_LAYOUT(device, m_descriptorSetLayout, allocator);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkDeviceSize ColorConversionPass::GetOutputSize(const VkExtent2D& extent) {
+    return static_cast<VkDeviceSize>(ColorConversion::GetYUVSize(extent.width, extent.height));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ColorConversionPass::CreateDescriptorSets(const VkDevice device, const VkAllocationCallbacks* allocator,
+    const uint32_t numSets)
+{
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, allocator, &m_descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create color conversion descriptor set layout!");
+    }
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = numSets;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = numSets;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = numSets;
+    if (vkCreateDescriptorPool(device, &poolInfo, allocator, &m_descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create color conversion descriptor pool!");
+    }
+
+    std::vector<VkDescriptorSetLayout> layouts(numSets, m_descriptorSetLayout);
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_descriptorPool;
+    allocInfo.descriptorSetCount = numSets;
+    allocInfo.pSetLayouts = layouts.data();
+
+    m_descriptorSets.resize(numSets);
+    if (vkAllocateDescriptorSets(device, &allocInfo, m_descriptorSets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate color conversion descriptor sets!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The matrix and the format are specialization constants, so that the shader doesn't branch on them
+void ColorConversionPass::CreatePipeline(const VkDevice device, const VkAllocationCallbacks* allocator,
+    const char* shaderPath)
+{
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, allocator, &m_pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create color conversion pipeline layout!");
+    }
+
+    std::vector<char> shaderCode;
+    FileUtility::ReadFileInto(shaderPath, &shaderCode);
+    VkShaderModule shaderModule = GraphicsUtility::CreateShaderModule(device, allocator, shaderCode);
+
+    const uint32_t specializationData[] = { static_cast<uint32_t>(m_matrix), static_cast<uint32_t>(m_format) };
+    std::array<VkSpecializationMapEntry, 2> specializationEntries = {};
+    for (uint32_t i = 0; i < specializationEntries.size(); ++i) {
+        specializationEntries[i].constantID = i;
+        specializationEntries[i].offset = i * sizeof(uint32_t);
+        specializationEntries[i].size = sizeof(uint32_t);
+    }
+
+    VkSpecializationInfo specializationInfo = {};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+    specializationInfo.pMapEntries = specializationEntries.data();
+    specializationInfo.dataSize = sizeof(specializationData);
+    specializationInfo.pData = specializationData;
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.stage.pSpecializationInfo = &specializationInfo;
+    pipelineInfo.layout = m_pipelineLayout;
+
+    const VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, allocator,
+        &m_pipeline);
+
+    //Not needed once the pipeline has been created
+    SAFE_DESTROY_SHADER_MODULE(device, shaderModule, allocator);
+    if (VK_SUCCESS != result) {
+        throw std::runtime_error("failed to create color conversion pipeline!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ColorConversionPass::Record(const VkDevice device, const VkCommandBuffer commandBuffer, const uint32_t set,
+    const VkImageView src, const VkSampler sampler, const VkBuffer dst, const VkExtent2D& extent) const
+{
+    if (0 != extent.width % BLOCK_WIDTH || 0 != extent.height % BLOCK_HEIGHT) {
+        throw std::runtime_error("failed to record color conversion: unsupported extent!");
+    }
+
+    const VkDescriptorSet descriptorSet = m_descriptorSets[set];
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.sampler = sampler;
+    imageInfo.imageView = src;
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkDescriptorBufferInfo bufferInfo = {};
+    bufferInfo.buffer = dst;
+    bufferInfo.offset = 0;
+    bufferInfo.range = GetOutputSize(extent);
+
+    std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
+    descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[0].dstSet = descriptorSet;
+    descriptorWrites[0].dstBinding = 0;
+    descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrites[0].descriptorCount = 1;
+    descriptorWrites[0].pImageInfo = &imageInfo;
+    descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[1].dstSet = descriptorSet;
+    descriptorWrites[1].dstBinding = 1;
+    descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorWrites[1].descriptorCount = 1;
+    descriptorWrites[1].pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(),
+        0, nullptr);
+
+    PushConstants pushConstants = {};
+    pushConstants.Width = extent.width;
+    pushConstants.Height = extent.height;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &descriptorSet,
+        0, nullptr);
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants),
+        &pushConstants);
+
+    const uint32_t numBlocksX = extent.width / BLOCK_WIDTH;
+    const uint32_t numBlocksY = extent.height / BLOCK_HEIGHT;
+    vkCmdDispatch(commandBuffer, (numBlocksX + GROUP_SIZE - 1) / GROUP_SIZE, (numBlocksY + GROUP_SIZE - 1) / GROUP_SIZE,
+        1);
+}
+
+} //end namespace
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+
+#include "ColorConversion.h"
+
+namespace Shin {
+
+//Converts RGBA images into YUV 4:2:0 with the RGBAToYUV compute shader, before they are read back, so that only
+//half of the bytes of each frame leave the GPU. The output is exactly the one of ColorConversion on the CPU.
+//Each converted frame has its own descriptor set, which is updated when the conversion is recorded: a set can be
+//recorded again once the command buffer of its previous conversion has finished
+class ColorConversionPass {
+public:
+    ColorConversionPass();
+
+    //shaderPath: the SPIR-V of RGBAToYUV.comp. numSets: the conversions which may be pending at the same time
+    void Init(const VkDevice device, const VkAllocationCallbacks* allocator, const char* shaderPath,
+        const ColorMatrix matrix, const YUVFormat format, const uint32_t numSets);
+    void CleanUp(const VkDevice device, const VkAllocationCallbacks* allocator);
+
+    //Converts the top-left extent of src, which is in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, into the tightly
+    //packed planes at the start of dst, which needs VK_BUFFER_USAGE_STORAGE_BUFFER_BIT.
+    //The width of extent must be a multiple of 8, and the height a multiple of 2.
+    //Doesn't record any barrier: the caller synchronizes the image and the buffer
+    void Record(const VkDevice device, const VkCommandBuffer commandBuffer, const uint32_t set,
+        const VkImageView src, const VkSampler sampler, const VkBuffer dst, const VkExtent2D& extent) const;
+
+    inline bool IsInitialized() const;
+    inline YUVFormat GetFormat() const;
+    inline VkFormat GetOutputFormat() const; //The multi-planar format of the same layout
+    inline uint32_t GetNumSets() const;
+
+    static VkDeviceSize GetOutputSize(const VkExtent2D& extent);
+
+private:
+    struct PushConstants {
+        uint32_t Width;
+        uint32_t Height;
+    };
+
+    void CreateDescriptorSets(const VkDevice device, const VkAllocationCallbacks* allocator,
+        const uint32_t numSets);
+    void CreatePipeline(const VkDevice device, const VkAllocationCallbacks* allocator, const char* shaderPath);
+
+    VkDescriptorSetLayout           m_descriptorSetLayout;
+    VkDescriptorPool                m_descriptorPool;
+    std::vector<VkDescriptorSet>    m_descriptorSets;
+    VkPipelineLayout                m_pipelineLayout;
+    VkPipeline                      m_pipeline;
+    ColorMatrix                     m_matrix;
+    YUVFormat                       m_format;
+
+    static const uint32_t BLOCK_WIDTH = 8;  //Pixels converted by each invocation
+    static const uint32_t BLOCK_HEIGHT = 2;
+    static const uint32_t GROUP_SIZE = 8;   //local_size_x and local_size_y
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool ColorConversionPass::IsInitialized() const { return VK_NULL_HANDLE != m_pipeline; }
+YUVFormat ColorConversionPass::GetFormat() const { return m_format; }
+VkFormat ColorConversionPass::GetOutputFormat() const { 
+    return (YUV_FORMAT_NV12 == m_format) ? VK_FORMAT_G8_B8R8_2PLANE_420_UNORM_KHR 
+        : VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM_KHR;
+}
+uint32_t ColorConversionPass::GetNumSets() const { return static_cast<uint32_t>(m_descriptorSets.size()); }
+
+} //end namespace
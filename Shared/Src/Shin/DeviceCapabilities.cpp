@@ -0,0 +1,189 @@
+#include "DeviceCapabilities.h"
+#include <cstring> //strcmp
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <vulkan/vulkan_win32.h>
+#endif
+
+namespace Shin {
+
+const std::vector<const char*> g_graphicsPipelineLibraryExtensions = {
+    VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+    VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
+};
+
+//Core in Vulkan 1.3. The others are its dependencies on Vulkan 1.0
+const std::vector<const char*> g_dynamicRenderingExtensions = {
+    VK_KHR_MULTIVIEW_EXTENSION_NAME,
+    VK_KHR_MAINTENANCE2_EXTENSION_NAME,
+    VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+    VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+    VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+};
+
+//Importing host allocations as device memory. No features to enable
+const std::vector<const char*> g_externalMemoryHostExtensions = {
+    VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME,
+    VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME,
+};
+
+//Sharing frames with other processes. The instance needs VK_KHR_external_semaphore_capabilities
+const std::vector<const char*> g_externalTimelineSemaphoreExtensions = {
+    VK_KHR_EXTERNAL_SEMAPHORE_EXTENSION_NAME,
+#ifndef _WIN32
+    VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME,
+#else
+    VK_KHR_EXTERNAL_SEMAPHORE_WIN32_EXTENSION_NAME,
+#endif
+    VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+DeviceCapabilities::DeviceCapabilities() : m_graphicsPipelineLibraryFeatures({}), m_dynamicRenderingFeatures({})
+    , m_timelineSemaphoreFeatures({})
+    , m_graphicsPipelineLibrary(false), m_fastLinking(false), m_dynamicRendering(false)
+    , m_externalMemoryHost(false), m_minImportedHostPointerAlignment(0), m_externalTimelineSemaphore(false)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void DeviceCapabilities::Query(const VkInstance instance, const VkPhysicalDevice physicalDevice) {
+    m_graphicsPipelineLibraryFeatures = {};
+    m_graphicsPipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    m_dynamicRenderingFeatures = {};
+    m_dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    m_timelineSemaphoreFeatures = {};
+    m_timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    m_graphicsPipelineLibrary = false;
+    m_fastLinking = false;
+    m_dynamicRendering = false;
+    m_externalMemoryHost = false;
+    m_minImportedHostPointerAlignment = 0;
+    m_externalTimelineSemaphore = false;
+
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    std::set<std::string> extensionNames;
+    for (const VkExtensionProperties& extension : availableExtensions) {
+        extensionNames.insert(extension.extensionName);
+    }
+
+    const bool hasPipelineLibrary = HasExtensions(extensionNames, g_graphicsPipelineLibraryExtensions);
+    const bool hasDynamicRendering = HasExtensions(extensionNames, g_dynamicRenderingExtensions);
+    const bool hasExternalMemoryHost = HasExtensions(extensionNames, g_externalMemoryHostExtensions);
+    const bool hasExternalTimelineSemaphore = HasExtensions(extensionNames, g_externalTimelineSemaphoreExtensions);
+    if (!hasPipelineLibrary && !hasDynamicRendering && !hasExternalMemoryHost && !hasExternalTimelineSemaphore) {
+        return;
+    }
+
+    //The extension may be listed without the feature being supported
+    auto getFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2KHR) 
+        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR");
+    auto getProperties2 = (PFN_vkGetPhysicalDeviceProperties2KHR) 
+        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR");
+    if (nullptr == getFeatures2 || nullptr == getProperties2) {
+        return;
+    }
+
+    VkPhysicalDeviceFeatures2KHR features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    features.pNext = &m_graphicsPipelineLibraryFeatures;
+    m_graphicsPipelineLibraryFeatures.pNext = &m_dynamicRenderingFeatures;
+    m_dynamicRenderingFeatures.pNext = &m_timelineSemaphoreFeatures;
+    getFeatures2(physicalDevice, &features);
+    m_graphicsPipelineLibrary = hasPipelineLibrary 
+        && (VK_TRUE == m_graphicsPipelineLibraryFeatures.graphicsPipelineLibrary);
+    m_dynamicRendering = hasDynamicRendering && (VK_TRUE == m_dynamicRenderingFeatures.dynamicRendering);
+    m_externalTimelineSemaphore = hasExternalTimelineSemaphore 
+        && (VK_TRUE == m_timelineSemaphoreFeatures.timelineSemaphore);
+
+    VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT libraryProperties = {};
+    libraryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+
+    VkPhysicalDeviceExternalMemoryHostPropertiesEXT hostProperties = {};
+    hostProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+    libraryProperties.pNext = hasExternalMemoryHost ? &hostProperties : nullptr;
+
+    VkPhysicalDeviceProperties2KHR properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+    properties.pNext = &libraryProperties;
+    getProperties2(physicalDevice, &properties);
+    m_fastLinking = m_graphicsPipelineLibrary 
+        && (VK_TRUE == libraryProperties.graphicsPipelineLibraryFastLinking);
+    m_externalMemoryHost = hasExternalMemoryHost && (hostProperties.minImportedHostPointerAlignment > 0);
+    m_minImportedHostPointerAlignment = hostProperties.minImportedHostPointerAlignment;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void DeviceCapabilities::GetExtensionsInto(std::vector<const char*>* extensions) const {
+    if (m_graphicsPipelineLibrary) {
+        AddExtensionsInto(g_graphicsPipelineLibraryExtensions, extensions);
+    }
+    if (m_dynamicRendering) {
+        AddExtensionsInto(g_dynamicRenderingExtensions, extensions);
+    }
+    if (m_externalMemoryHost) {
+        AddExtensionsInto(g_externalMemoryHostExtensions, extensions);
+    }
+    if (m_externalTimelineSemaphore) {
+        AddExtensionsInto(g_externalTimelineSemaphoreExtensions, extensions);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void* DeviceCapabilities::GetFeatures() {
+    void* features = nullptr;
+    if (m_externalTimelineSemaphore) {
+        m_timelineSemaphoreFeatures.pNext = features;
+        features = &m_timelineSemaphoreFeatures;
+    }
+    if (m_dynamicRendering) {
+        m_dynamicRenderingFeatures.pNext = features;
+        features = &m_dynamicRenderingFeatures;
+    }
+    if (m_graphicsPipelineLibrary) {
+        m_graphicsPipelineLibraryFeatures.pNext = features;
+        features = &m_graphicsPipelineLibraryFeatures;
+    }
+    return features;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool DeviceCapabilities::HasExtensions(const std::set<std::string>& availableExtensions, 
+    const std::vector<const char*>& extensions)
+{
+    for (const char* extension : extensions) {
+        if (availableExtensions.count(extension) <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Skips the extensions which are already in dest, e.g. VK_KHR_external_memory when encoding
+void DeviceCapabilities::AddExtensionsInto(const std::vector<const char*>& extensions, 
+    std::vector<const char*>* dest) 
+{
+    for (const char* extension : extensions) {
+        bool found = false;
+        for (const char* existing : *dest) {
+            found = found || (0 == strcmp(existing, extension));
+        }
+        if (!found) {
+            dest->push_back(extension);
+        }
+    }
+}
+
+} //end namespace
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Shin {
+
+//The optional device features which are used when the physical device supports them.
+//Usage: Query() -> add GetExtensionsInto() and GetFeatures() to VkDeviceCreateInfo -> the Is*Supported() getters
+class DeviceCapabilities {
+public:
+    DeviceCapabilities();
+
+    //The instance needs VK_KHR_get_physical_device_properties2
+    void Query(const VkInstance instance, const VkPhysicalDevice physicalDevice);
+
+    //The device extensions required by the supported capabilities
+    void GetExtensionsInto(std::vector<const char*>* extensions) const;
+
+    //The feature structs to chain into VkDeviceCreateInfo::pNext. nullptr if nothing is supported
+    void* GetFeatures();
+
+    inline bool IsGraphicsPipelineLibrarySupported() const;
+    inline bool IsFastLinkingSupported() const; //Linking pipeline libraries without link time optimization is fast
+    inline bool IsDynamicRenderingSupported() const;
+    inline bool IsExternalMemoryHostSupported() const;
+    inline VkDeviceSize GetMinImportedHostPointerAlignment() const; //Of the address and the size of imported memory
+    inline bool IsExternalTimelineSemaphoreSupported() const; //Timeline semaphores which can be exported as FDs
+
+private:
+    static bool HasExtensions(const std::set<std::string>& availableExtensions, 
+        const std::vector<const char*>& extensions);
+    static void AddExtensionsInto(const std::vector<const char*>& extensions, std::vector<const char*>* dest);
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT  m_graphicsPipelineLibraryFeatures;
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR         m_dynamicRenderingFeatures;
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR        m_timelineSemaphoreFeatures;
+    bool                                                m_graphicsPipelineLibrary;
+    bool                                                m_fastLinking;
+    bool                                                m_dynamicRendering;
+    bool                                                m_externalMemoryHost;
+    VkDeviceSize                                        m_minImportedHostPointerAlignment;
+    bool                                                m_externalTimelineSemaphore;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool DeviceCapabilities::IsGraphicsPipelineLibrarySupported() const { return m_graphicsPipelineLibrary; }
+bool DeviceCapabilities::IsFastLinkingSupported() const { return m_fastLinking; }
+bool DeviceCapabilities::IsDynamicRenderingSupported() const { return m_dynamicRendering; }
+bool DeviceCapabilities::IsExternalMemoryHostSupported() const { return m_externalMemoryHost; }
+bool DeviceCapabilities::IsExternalTimelineSemaphoreSupported() const { return m_externalTimelineSemaphore; }
+VkDeviceSize DeviceCapabilities::GetMinImportedHostPointerAlignment() const { 
+    return m_minImportedHostPointerAlignment; 
+}
+
+} //end namespace
@@ -18,6 +18,7 @@ DrawObject::DrawObject() : m_texture(nullptr), m_offScreenPass(nullptr), m_mesh(
 {
     m_mvpMat.ViewMat  = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     m_mvpMat.ModelMat = glm::mat4(1.0f);
+    m_mvpMat.TexCoordScale = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
 
 }
 
@@ -79,23 +80,54 @@ void DrawObject::SetScale(const float scale) {
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-void DrawObject::Rotate(const float degree, const glm::vec3& axis) {
+void DrawObject::Rotate(const float radians, const glm::vec3& axis) {
 
-    m_rotateMat = glm::rotate(glm::mat4(1.0f), degree, axis);
+    m_rotateMat = glm::rotate(glm::mat4(1.0f), radians, axis);
 
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
-void DrawObject::UpdateUniformBuffers(const VkDevice device, const uint32_t imageIndex) {
-
+void DrawObject::UpdateModelMat() {
     glm::mat4 translationMat = glm::translate(glm::mat4(1.0f), m_pos);
     m_mvpMat.ModelMat = translationMat * m_scaleMat *   m_rotateMat;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+glm::mat4 DrawObject::CalculateModelMat(const float radians, const glm::vec3& axis) const {
+    const glm::mat4 translationMat = glm::translate(glm::mat4(1.0f), m_pos);
+    return translationMat * m_scaleMat * glm::rotate(glm::mat4(1.0f), radians, axis);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The camera looks down -Z in view space
+float DrawObject::GetViewDepth() const {
+    const glm::vec4 viewPos = m_mvpMat.ViewMat * glm::vec4(m_pos, 1.0f);
+    return -viewPos.z;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void DrawObject::UpdateUniformBuffers(const VkDevice device, const uint32_t imageIndex) {
+
+    UpdateModelMat();
 
     GraphicsUtility::CopyCPUDataToBuffer(device, &m_mvpMat, m_uniformBuffersMemory[imageIndex],sizeof(m_mvpMat));
 
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+
+void DrawObject::UpdateUniformBuffers(const VkDevice device, const uint32_t imageIndex, 
+        const glm::mat4& modelMat) const 
+{
+    MVPUniform mvpMat = m_mvpMat;
+    mvpMat.ModelMat = modelMat;
+    GraphicsUtility::CopyCPUDataToBuffer(device, &mvpMat, m_uniformBuffersMemory[imageIndex], sizeof(mvpMat));
+}
+
 
 //---------------------------------------------------------------------------------------------------------------------
 void DrawObject::CreateUniformBuffers(const VkPhysicalDevice physicalDevice, VkDevice device,VkAllocationCallbacks* allocator, 
@@ -182,9 +214,8 @@ void DrawObject::CreateDescriptorSets(const VkDevice device, const VkDescriptorP
 
             VkDescriptorImageInfo imageInfo = {};
             imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            imageInfo.imageView = m_offScreenPass->GetTexture(i)->GetImageView();
-            //[TODO-sin:2019-11-14] We only need one sampler actually
-            imageInfo.sampler   = m_offScreenPass->GetTexture(i)->GetSampler();
+            imageInfo.imageView = m_offScreenPass->GetImageView(i);
+            imageInfo.sampler   = m_offScreenPass->GetSampler();
 
             std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
 
@@ -33,11 +33,21 @@ public:
     inline void SetPos(const float x, const float y, const float z);
     void SetProj(const float perspective);
     void SetScale(const float scale);
+    inline void SetTexCoordScale(const float u, const float v); //To sample a part of the texture
 
-    void Rotate(const float degree, const glm::vec3& axis);
+    void Rotate(const float radians, const glm::vec3& axis);
 
+    void UpdateModelMat(); //CPU only. Also called by UpdateUniformBuffers()
     void UpdateUniformBuffers(const VkDevice device, const uint32_t imageIndex);
 
+    //The model matrix with the given rotation instead of the one set by Rotate(), and writes the uniform buffers
+    //with it. Both leave the object unchanged, so that other threads can keep reading it
+    glm::mat4 CalculateModelMat(const float radians, const glm::vec3& axis) const;
+    void UpdateUniformBuffers(const VkDevice device, const uint32_t imageIndex, const glm::mat4& modelMat) const;
+
+    inline const MVPUniform& GetMVP() const;
+    float GetViewDepth() const; //The distance of the position from the camera, along the view direction
+
     inline const VkDescriptorSet GetDescriptorSet(const uint32_t idx) const;
     inline const Mesh* GetMesh() const;
 
@@ -68,7 +78,9 @@ private:
 
 void DrawObject::SetPos(const float x, const float y, const float z) { m_pos = glm::vec3(x,y,z); }
 void DrawObject::SetPos(const glm::vec3& pos) { m_pos = pos; }
+void DrawObject::SetTexCoordScale(const float u, const float v) { m_mvpMat.TexCoordScale = glm::vec4(u, v, 0.0f, 0.0f); }
 const VkDescriptorSet DrawObject::GetDescriptorSet(const uint32_t idx) const { return m_descriptorSets[idx]; }
 const Mesh* DrawObject::GetMesh() const { return m_mesh; }
+const MVPUniform& DrawObject::GetMVP() const { return m_mvpMat; }
 
 };
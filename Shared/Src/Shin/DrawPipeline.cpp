@@ -1,4 +1,6 @@
 #include "DrawPipeline.h"
+#include <chrono> //std::chrono::seconds
+#include <algorithm> //std::stable_sort
 
 #include "Utilities/GraphicsUtility.h"
 #include "Utilities/FileUtility.h"
@@ -6,10 +8,12 @@
 
 #include "Shin/Mesh.h"
 #include "DrawObject.h"
+#include "PipelineCompiler.h"
 
 namespace Shin {
 
-DrawPipeline::DrawPipeline() : m_pipeline(VK_NULL_HANDLE), m_pipelineLayout(VK_NULL_HANDLE), 
+DrawPipeline::DrawPipeline() : m_pipeline(VK_NULL_HANDLE), m_pipelineLayout(VK_NULL_HANDLE), m_ownsPipeline(true),
+    m_optional(false), m_boundWithoutPipeline(false),
     m_bindingDescriptions(nullptr), m_attributeDescriptions(nullptr),
     m_descriptorSetLayout(nullptr)
 {
@@ -45,6 +49,15 @@ void DrawPipeline::CleanUpSwapChainObjects(const VkDevice device, VkAllocationCa
         m_drawObjects[i]->CleanUpSwapChainObjects(device, allocator);
     }
 
+    if (!m_ownsPipeline) {
+        //Destroyed by the cache
+        m_requestedPipeline = std::shared_future<VkPipeline>();
+        m_pipeline = VK_NULL_HANDLE;
+        m_pipelineLayout = VK_NULL_HANDLE;
+        m_boundWithoutPipeline = false;
+        return;
+    }
+
     SAFE_DESTROY_PIPELINE(device, m_pipeline, allocator);
     SAFE_DESTROY_PIPELINE_LAYOUT(device, m_pipelineLayout, allocator);
 }
@@ -53,6 +66,7 @@ void DrawPipeline::CleanUpSwapChainObjects(const VkDevice device, VkAllocationCa
 
 void DrawPipeline::CleanUp(const VkDevice device, VkAllocationCallbacks* allocator) {
     m_drawObjects.clear();
+    m_drawOrder.clear();
 
     SAFE_DESTROY_SHADER_MODULE(device, m_fragShaderModule, allocator);
     SAFE_DESTROY_SHADER_MODULE(device, m_vertShaderModule, allocator);
@@ -67,114 +81,54 @@ void DrawPipeline::RecreateSwapChainObjects( const VkPhysicalDevice physicalDevi
         const VkExtent2D& extent
     )
 {
-    //Vertex
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = m_vertShaderModule;
-    vertShaderStageInfo.pName = "main";
-    vertShaderStageInfo.pSpecializationInfo = nullptr;//To specify shader constants
-
-    //Frag
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
-    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = m_fragShaderModule;
-    fragShaderStageInfo.pName = "main";
-
-    VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
-
-    //Vertex Input
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(m_attributeDescriptions->size());
-    vertexInputInfo.pVertexBindingDescriptions = m_bindingDescriptions; 
-    vertexInputInfo.pVertexAttributeDescriptions = m_attributeDescriptions->data(); 
-
-    //Input Assembly
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    //Viewport and Scissor 
-    VkViewport viewport = {};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(extent.width);
-    viewport.height = static_cast<float>(extent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
+    CreatePipeline(device, allocator, renderPass);
+    RecreateDrawObjects(physicalDevice, device, allocator, descriptorPool, numImages, extent);
+}
 
-    VkRect2D scissor = {};
-    scissor.offset = {0, 0};
-    scissor.extent = extent;
+//---------------------------------------------------------------------------------------------------------------------
+
+void DrawPipeline::CreatePipeline(const VkDevice device, VkAllocationCallbacks* allocator, 
+    const VkRenderPass renderPass) 
+{
+    CreatePipelineLayout(device, allocator);
+    m_ownsPipeline = true;
+
+    const PipelineStateKey key = GetPipelineStateKey(renderPass, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED);
+    if (PipelineCompiler::CreateGraphicsPipelines(device, allocator, VK_NULL_HANDLE, 1, &key, &m_pipeline) 
+        != VK_SUCCESS) 
+    {
+        throw std::runtime_error("failed to create graphics pipeline!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
 
-    VkPipelineViewportStateCreateInfo viewportState = {};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
-
-    //Rasterizer
-    VkPipelineRasterizationStateCreateInfo rasterizer = {};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-    rasterizer.depthBiasConstantFactor = 0.0f; // Optional
-    rasterizer.depthBiasClamp = 0.0f; // Optional
-    rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
-
-    //Multisampling
-    VkPipelineMultisampleStateCreateInfo multisampling = {};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisampling.minSampleShading = 1.0f; // Optional
-    multisampling.pSampleMask = nullptr; // Optional
-    multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-    multisampling.alphaToOneEnable = VK_FALSE; // Optional
-
-    //Color blending
-    VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable = VK_TRUE;
-    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending = {};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-    colorBlending.blendConstants[0] = 0.0f; // Optional
-    colorBlending.blendConstants[1] = 0.0f; // Optional
-    colorBlending.blendConstants[2] = 0.0f; // Optional
-    colorBlending.blendConstants[3] = 0.0f; // Optional
-
-    //Dynamic states
-    VkDynamicState dynamicStates[] = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_LINE_WIDTH
-    };
-
-    VkPipelineDynamicStateCreateInfo dynamicState = {};
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount = 2;
-    dynamicState.pDynamicStates = dynamicStates;
+void DrawPipeline::RequestPipeline(PipelineStateCache* cache, const VkRenderPass renderPass) {
+    RequestPipeline(cache, renderPass, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED);
+}
 
+//---------------------------------------------------------------------------------------------------------------------
+
+void DrawPipeline::RequestPipeline(PipelineStateCache* cache, const VkFormat colorFormat, 
+    const VkFormat depthFormat) 
+{
+    RequestPipeline(cache, VK_NULL_HANDLE, colorFormat, depthFormat);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void DrawPipeline::RequestPipeline(PipelineStateCache* cache, const VkRenderPass renderPass, 
+    const VkFormat colorFormat, const VkFormat depthFormat) 
+{
+    m_pipelineLayout = cache->GetOrCreatePipelineLayout(m_descriptorSetLayout);
+    m_ownsPipeline = false;
+    m_pipeline = VK_NULL_HANDLE;
+    m_requestedPipeline = cache->GetOrRequestPipeline(GetPipelineStateKey(renderPass, colorFormat, depthFormat));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void DrawPipeline::CreatePipelineLayout(const VkDevice device, VkAllocationCallbacks* allocator) {
     //Pipeline layout: to pass uniform values to shaders
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -186,55 +140,129 @@ void DrawPipeline::RecreateSwapChainObjects( const VkPhysicalDevice physicalDevi
     if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, allocator, &m_pipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("failed to create pipeline layout!");
     }
+}
 
-    //Graphics pipeline
-    VkGraphicsPipelineCreateInfo pipelineInfo = {};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = shaderStages;
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = nullptr; // Optional
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = nullptr; 
-    pipelineInfo.layout = m_pipelineLayout;
-    pipelineInfo.renderPass = renderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-    pipelineInfo.basePipelineIndex = -1; // Optional
-
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, allocator, &m_pipeline) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create graphics pipeline!");
+//---------------------------------------------------------------------------------------------------------------------
+
+PipelineStateKey DrawPipeline::GetPipelineStateKey(const VkRenderPass renderPass, const VkFormat colorFormat,
+    const VkFormat depthFormat) const 
+{
+    PipelineStateKey key;
+    key.VertShaderModule = m_vertShaderModule;
+    key.FragShaderModule = m_fragShaderModule;
+    key.BindingDescription = m_bindingDescriptions;
+    key.AttributeDescriptions = m_attributeDescriptions;
+    key.RenderState = m_renderState;
+    key.Layout = m_pipelineLayout;
+    key.RenderPass = renderPass;
+    key.ColorFormat = colorFormat;
+    key.DepthFormat = depthFormat;
+    return key;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Blended draws must keep their order, and there is nothing to reject without depth writes
+bool DrawPipeline::IsSortedFrontToBack() const {
+    return BLEND_MODE_OPAQUE == m_renderState.Blend && m_renderState.DepthTest && m_renderState.DepthWrite;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkPipeline DrawPipeline::GetPipeline() {
+    if (m_requestedPipeline.valid()) {
+        const std::shared_future<VkPipeline> requestedPipeline = m_requestedPipeline;
+        m_requestedPipeline = std::shared_future<VkPipeline>();
+        m_pipeline = requestedPipeline.get();
+    }
+    return m_pipeline;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool DrawPipeline::IsPipelineReady() {
+    if (m_requestedPipeline.valid() 
+        && std::future_status::ready != m_requestedPipeline.wait_for(std::chrono::seconds(0))) 
+    {
+        return false;
     }
+    return (VK_NULL_HANDLE != GetPipeline());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
 
+bool DrawPipeline::UpdatePipeline() {
+    if (!m_boundWithoutPipeline || !IsPipelineReady()) {
+        return false;
+    }
+
+    m_boundWithoutPipeline = false;
+    return true;
+}
 
+//---------------------------------------------------------------------------------------------------------------------
+
+void DrawPipeline::RecreateDrawObjects(const VkPhysicalDevice physicalDevice, const VkDevice device, 
+    VkAllocationCallbacks* allocator, VkDescriptorPool descriptorPool, const uint32_t numImages,
+    const VkExtent2D& extent) 
+{
     //Registered draw objects
     const uint32_t numDrawObjects = static_cast<uint32_t>(m_drawObjects.size());
     for (uint32_t i=0;i<numDrawObjects;++i) {
         m_drawObjects[i]->RecreateSwapChainObjects(physicalDevice, device, allocator, 
             descriptorPool, numImages, m_descriptorSetLayout);
-        m_drawObjects[i]->SetProj(extent.width / static_cast<float> (extent.height));
     }
+    SetExtent(extent);
+    SortDrawObjects();
+}
 
+//---------------------------------------------------------------------------------------------------------------------
+
+void DrawPipeline::SetExtent(const VkExtent2D& extent) {
+    const uint32_t numDrawObjects = static_cast<uint32_t>(m_drawObjects.size());
+    for (uint32_t i=0;i<numDrawObjects;++i) {
+        m_drawObjects[i]->SetProj(extent.width / static_cast<float> (extent.height));
+    }
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
-void DrawPipeline::Bind(const VkCommandBuffer commandBuffer) {
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+bool DrawPipeline::Bind(const VkCommandBuffer commandBuffer, const VkExtent2D& extent) {
+    if (m_optional && !IsPipelineReady()) {
+        m_boundWithoutPipeline = true;
+        return false;
+    }
+
+    const VkPipeline pipeline = GetPipeline();
+    if (VK_NULL_HANDLE == pipeline) {
+        throw std::runtime_error("failed to bind a pipeline which has not been created or requested!");
+    }
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+    VkViewport viewport = {};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor = {};
+    scissor.offset = {0, 0};
+    scissor.extent = extent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    return true;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
-void DrawPipeline::DrawToCommandBuffer(const VkCommandBuffer commandBuffer, const uint32_t imageIndex) {
+void DrawPipeline::DrawToCommandBuffer(const VkCommandBuffer commandBuffer, const uint32_t imageIndex) const {
 
     //Draw multiple objects
-    const uint32_t numObjects = static_cast<uint32_t>(m_drawObjects.size());
+    const uint32_t numObjects = static_cast<uint32_t>(m_drawOrder.size());
     for (uint32_t k = 0; k < numObjects; ++k) {
-        const DrawObject* curDrawObject = m_drawObjects[k];
+        const DrawObject* curDrawObject = m_drawOrder[k];
         const Mesh* curMesh = curDrawObject->GetMesh();
 
         //Bind vertex and index buffers
@@ -259,4 +287,23 @@ void DrawPipeline::AddDrawObject(DrawObject* obj) {
     m_drawObjects.push_back(obj);
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+
+//Stable, so that objects at the same depth don't swap places and make the command buffers be recorded again
+bool DrawPipeline::SortDrawObjects() {
+    std::vector<const DrawObject*> drawOrder(m_drawObjects.begin(), m_drawObjects.end());
+    if (IsSortedFrontToBack()) {
+        std::stable_sort(drawOrder.begin(), drawOrder.end(), [](const DrawObject* a, const DrawObject* b) {
+            return a->GetViewDepth() < b->GetViewDepth();
+        });
+    }
+
+    if (drawOrder == m_drawOrder) {
+        return false;
+    }
+
+    m_drawOrder.swap(drawOrder);
+    return true;
+}
+
 } //end namespace
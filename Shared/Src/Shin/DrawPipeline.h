@@ -2,9 +2,11 @@
 
 #include <vulkan/vulkan.h> 
 #include <stdint.h>
+#include <future>
 #include <vector>
 
 #include "DrawObject.h"
+#include "PipelineStateCache.h"
 
 namespace Shin {
 
@@ -26,18 +28,73 @@ public:
         const VkExtent2D& extent
     );
 
+    //The two steps of RecreateSwapChainObjects().
+    //CreatePipeline() only touches this pipeline, so different pipelines can be created on different threads.
+    //RecreateDrawObjects() allocates from descriptorPool, which needs external synchronization
+    void CreatePipeline(const VkDevice device, VkAllocationCallbacks* allocator, const VkRenderPass renderPass);
+
+    //Instead of CreatePipeline(): the pipeline and its layout are shared through the cache, which owns them.
+    //A new pipeline is compiled by PipelineCompiler::Compile(), and Bind() waits for it if it hasn't finished yet. 
+    //Compile() must be called before Bind()
+    void RequestPipeline(PipelineStateCache* cache, const VkRenderPass renderPass);
+
+    //For dynamic rendering: the pipeline is created for a color attachment of colorFormat, without render pass.
+    //depthFormat: VK_FORMAT_UNDEFINED if there is no depth attachment
+    void RequestPipeline(PipelineStateCache* cache, const VkFormat colorFormat, const VkFormat depthFormat);
+
+    //Blending, depth, culling and topology. Used by the next CreatePipeline()/RequestPipeline().
+    //Opaque draws with depth writes are drawn front to back, so that the hidden fragments are rejected early
+    inline void SetRenderState(const PipelineRenderState& renderState);
+
+    //While the requested pipeline is compiling, Bind() skips the draws if optional, or waits for the pipeline
+    inline void SetOptional(const bool optional);
+
+    //Doesn't wait. Returns true if the requested pipeline has become ready after a Bind() which couldn't use it:
+    //the command buffers recorded since then should be recorded again
+    bool UpdatePipeline();
+
+    void RecreateDrawObjects(const VkPhysicalDevice physicalDevice, const VkDevice device, 
+        VkAllocationCallbacks* allocator, VkDescriptorPool descriptorPool, const uint32_t numImages,
+        const VkExtent2D& extent);
+
     void CleanUpSwapChainObjects(const VkDevice device, VkAllocationCallbacks* allocator);
     void CleanUp(const VkDevice device, VkAllocationCallbacks* allocator);
 
-    void Bind(const VkCommandBuffer commandBuffer);
+    //Updates the objects that depend on the extent of the render target. 
+    //The pipeline itself doesn't need to be recreated, since viewport and scissor are dynamic states
+    void SetExtent(const VkExtent2D& extent);
+
+    //Binds the pipeline and sets the viewport and scissor to cover extent. Throws if there is no pipeline.
+    //Returns false if the draws have to be skipped because the pipeline is still compiling
+    bool Bind(const VkCommandBuffer commandBuffer, const VkExtent2D& extent);
 
-    void DrawToCommandBuffer(const VkCommandBuffer commandBuffer, const uint32_t imageIndex);
+    //Draws in the order of the last SortDrawObjects(). May be called on several threads
+    void DrawToCommandBuffer(const VkCommandBuffer commandBuffer, const uint32_t imageIndex) const;
     void AddDrawObject(DrawObject* obj);
+
+    //Sorts the draw objects front to back with their current view depths, if the render state needs it.
+    //Called by RecreateDrawObjects(), and again whenever the view or the positions may have changed.
+    //Returns true if the order has changed: the command buffers which draw them have to be recorded again
+    bool SortDrawObjects();
 private:
+    void CreatePipelineLayout(const VkDevice device, VkAllocationCallbacks* allocator);
+    void RequestPipeline(PipelineStateCache* cache, const VkRenderPass renderPass, const VkFormat colorFormat,
+        const VkFormat depthFormat);
+    PipelineStateKey GetPipelineStateKey(const VkRenderPass renderPass, const VkFormat colorFormat, 
+        const VkFormat depthFormat) const;
+    bool IsSortedFrontToBack() const;
+    VkPipeline GetPipeline(); //Waits for the requested pipeline
+    bool IsPipelineReady();   //Doesn't wait
 
     std::vector<DrawObject*>     m_drawObjects; // multiple objects
+    std::vector<const DrawObject*> m_drawOrder; //m_drawObjects, as sorted by SortDrawObjects()
 
     VkPipeline                  m_pipeline;
+    std::shared_future<VkPipeline> m_requestedPipeline; //Valid until the compiled pipeline is moved to m_pipeline
+    bool                        m_ownsPipeline;   //false if m_pipeline and m_pipelineLayout belong to a cache
+    PipelineRenderState         m_renderState;
+    bool                        m_optional;
+    bool                        m_boundWithoutPipeline; //Bind() was called while the pipeline was compiling
     VkPipelineLayout            m_pipelineLayout; //to pass uniform values to shaders
 
     //[TODO-sin: 2019-11-13] Can these five be grouped as something ?
@@ -51,4 +108,9 @@ private:
 
 };
 
+//---------------------------------------------------------------------------------------------------------------------
+
+void DrawPipeline::SetRenderState(const PipelineRenderState& renderState) { m_renderState = renderState; }
+void DrawPipeline::SetOptional(const bool optional) { m_optional = optional; }
+
 };
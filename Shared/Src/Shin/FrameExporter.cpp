@@ -0,0 +1,225 @@
+#include "FrameExporter.h"
+#include <stdexcept> //std::runtime_error
+#include <array>
+#include <algorithm> //std::max_element
+#include <cstring>   //memcpy
+
+#include "Shin/Utilities/GraphicsUtility.h"
+
+namespace Shin {
+
+static FrameSharingHandle ToFrameSharingHandle(void* handle) {
+#ifndef _WIN32
+    return static_cast<int>(reinterpret_cast<uintptr_t>(handle));
+#else
+    return handle;
+#endif
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+FrameExporter::FrameExporter() : m_device(VK_NULL_HANDLE), m_setup({}), m_renderedSemaphore(VK_NULL_HANDLE)
+    , m_releasedSemaphore(VK_NULL_HANDLE), m_lastValue(0), m_numSentFrames(0)
+    , m_signalSemaphore(nullptr), m_getSemaphoreCounterValue(nullptr)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameExporter::Init(const VkInstance instance, const VkPhysicalDevice physicalDevice, const VkDevice device,
+    const VkAllocationCallbacks* allocator, const std::string& socketPath)
+{
+    m_device = device;
+    m_signalSemaphore = (PFN_vkSignalSemaphoreKHR) vkGetDeviceProcAddr(device, "vkSignalSemaphoreKHR");
+    m_getSemaphoreCounterValue = (PFN_vkGetSemaphoreCounterValueKHR)
+        vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR");
+    if (nullptr == m_signalSemaphore || nullptr == m_getSemaphoreCounterValue) {
+        throw std::runtime_error("failed to init frame exporter: timeline semaphores are not enabled!");
+    }
+
+    m_setup = {};
+    m_setup.Magic = FRAME_SHARING_MAGIC;
+    m_setup.Version = FRAME_SHARING_VERSION;
+    std::array<uint8_t, VK_UUID_SIZE> deviceUUID;
+    GraphicsUtility::GetPhysicalDeviceUUIDInto(instance, physicalDevice, &deviceUUID);
+    memcpy(m_setup.DeviceUUID, deviceUUID.data(), VK_UUID_SIZE);
+
+    m_renderedSemaphore = GraphicsUtility::CreateTimelineSemaphore(device, allocator, 0, true);
+    m_releasedSemaphore = GraphicsUtility::CreateTimelineSemaphore(device, allocator, 0, true);
+    m_lastValue = 0;
+    m_numSentFrames = 0;
+
+    m_socket.Listen(socketPath);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The device must be idle
+void FrameExporter::CleanUp(const VkDevice device, const VkAllocationCallbacks* allocator) {
+    m_socket.Close();
+    m_memories.clear();
+    m_lastSentValues.clear();
+
+    if (VK_NULL_HANDLE != m_renderedSemaphore) {
+        vkDestroySemaphore(device, m_renderedSemaphore, allocator);
+        m_renderedSemaphore = VK_NULL_HANDLE;
+    }
+    if (VK_NULL_HANDLE != m_releasedSemaphore) {
+        vkDestroySemaphore(device, m_releasedSemaphore, allocator);
+        m_releasedSemaphore = VK_NULL_HANDLE;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameExporter::SetImages(const std::vector<VkDeviceMemory>& memories,
+    const std::vector<VkDeviceSize>& memorySizes, const VkExtent2D& extent, const VkFormat format,
+    const VkImageUsageFlags usage)
+{
+    const uint32_t numImages = static_cast<uint32_t>(memories.size());
+    if (numImages > FRAME_SHARING_MAX_IMAGES) {
+        throw std::runtime_error("failed to export frames: too many images!");
+    }
+
+    //The consumer has imported the same images
+    const bool unchanged = (memories == m_memories) && (extent.width == m_setup.Width)
+        && (extent.height == m_setup.Height) && (static_cast<uint32_t>(format) == m_setup.Format)
+        && (static_cast<uint32_t>(usage) == m_setup.Usage);
+    if (unchanged) {
+        return;
+    }
+
+    DisconnectConsumer();
+    m_memories = memories;
+    m_lastSentValues.assign(numImages, 0);
+
+    m_setup.Width = extent.width;
+    m_setup.Height = extent.height;
+    m_setup.Format = static_cast<uint32_t>(format);
+    m_setup.Usage = static_cast<uint32_t>(usage);
+    m_setup.NumImages = numImages;
+    for (uint32_t i = 0; i < numImages; ++i) {
+        m_setup.MemorySizes[i] = static_cast<uint64_t>(memorySizes[i]);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool FrameExporter::GetReleasedWait(const uint32_t imageIndex, VkSemaphore* semaphore, uint64_t* value) const {
+    if (imageIndex >= m_lastSentValues.size() || 0 == m_lastSentValues[imageIndex]) {
+        return false;
+    }
+
+    //Already released
+    const uint64_t sentValue = m_lastSentValues[imageIndex];
+    if (GetReleasedValue() >= sentValue) {
+        return false;
+    }
+
+    *semaphore = m_releasedSemaphore;
+    *value = sentValue;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameExporter::Publish(const VkQueue queue, const uint32_t imageIndex, const VkExtent2D& renderExtent) {
+    AcceptConsumer();
+    if (!m_socket.IsConnected() || imageIndex >= m_memories.size()) {
+        return;
+    }
+
+    //The signal waits for all the commands which were submitted before
+    const uint64_t value = m_lastValue + 1;
+    VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &value;
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &m_renderedSemaphore;
+    if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit frame exporter signal!");
+    }
+    m_lastValue = value;
+
+    FrameSharingFrame frame = {};
+    frame.Value = value;
+    frame.ImageIndex = imageIndex;
+    frame.Width = renderExtent.width;
+    frame.Height = renderExtent.height;
+    if (m_socket.Send(&frame, sizeof(frame), std::vector<FrameSharingHandle>())) {
+        m_lastSentValues[imageIndex] = value;
+        ++m_numSentFrames;
+    } else if (!m_socket.IsConnected()) {
+        DisconnectConsumer();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The handles are exported again for each consumer: the consumer owns the ones it has imported.
+//They have been duplicated into the consumer when they are closed here
+void FrameExporter::AcceptConsumer() {
+    if (m_socket.IsConnected() || m_memories.empty() || !m_socket.Accept()) {
+        return;
+    }
+
+    std::vector<void*> handles;
+    for (const VkDeviceMemory memory : m_memories) {
+        handles.push_back(GraphicsUtility::GetExportHandle(m_device, memory));
+    }
+    handles.push_back(GraphicsUtility::GetSemaphoreExportHandle(m_device, m_renderedSemaphore));
+    handles.push_back(GraphicsUtility::GetSemaphoreExportHandle(m_device, m_releasedSemaphore));
+
+    std::vector<FrameSharingHandle> sharedHandles;
+    for (void* handle : handles) {
+        if (nullptr != handle) {
+            sharedHandles.push_back(ToFrameSharingHandle(handle));
+        }
+    }
+
+    const bool exported = (sharedHandles.size() == handles.size());
+    const bool sent = exported && m_socket.Send(&m_setup, sizeof(m_setup), sharedHandles);
+    CloseFrameSharingHandles(sharedHandles, 0);
+    if (!exported) {
+        m_socket.Disconnect();
+        throw std::runtime_error("failed to export frame sharing handles!");
+    }
+    if (!sent) {
+        m_socket.Disconnect();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The frames which the GPU is waiting for will never be released by the consumer: release them here
+void FrameExporter::DisconnectConsumer() {
+    m_socket.Disconnect();
+    if (m_lastSentValues.empty()) {
+        return;
+    }
+
+    const uint64_t maxSentValue = *std::max_element(m_lastSentValues.begin(), m_lastSentValues.end());
+    if (maxSentValue > GetReleasedValue()) {
+        VkSemaphoreSignalInfoKHR signalInfo = {};
+        signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO_KHR;
+        signalInfo.semaphore = m_releasedSemaphore;
+        signalInfo.value = maxSentValue;
+        m_signalSemaphore(m_device, &signalInfo);
+    }
+    m_lastSentValues.assign(m_lastSentValues.size(), 0);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint64_t FrameExporter::GetReleasedValue() const {
+    uint64_t value = 0;
+    m_getSemaphoreCounterValue(m_device, m_releasedSemaphore, &value);
+    return value;
+}
+
+} //end namespace
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "FrameSharing.h"
+
+namespace Shin {
+
+//Shares render targets with a consumer process on the same GPU, without copies.
+//The memory of the images and two timeline semaphores are exported as file descriptors, or NT handles on Windows,
+//and sent over a FrameSharingSocket when a consumer connects. Publish() signals the rendered semaphore after each
+//frame, and tells the consumer which image to use. Before the image is rendered into again, the frame waits on the
+//GPU for the consumer to signal the released semaphore.
+//Nothing waits on the CPU: frames are not sent to a consumer which doesn't read its messages.
+//
+//Needs VK_KHR_external_memory_fd and VK_KHR_external_semaphore_fd, or their win32 versions,
+//and VK_KHR_timeline_semaphore
+class FrameExporter {
+public:
+    FrameExporter();
+
+    void Init(const VkInstance instance, const VkPhysicalDevice physicalDevice, const VkDevice device,
+        const VkAllocationCallbacks* allocator, const std::string& socketPath);
+    void CleanUp(const VkDevice device, const VkAllocationCallbacks* allocator);
+
+    //Swap chain. The images must have been created with exportHandle, each in its own memory.
+    //If they have changed, a connected consumer is disconnected: it must import the new images
+    void SetImages(const std::vector<VkDeviceMemory>& memories, const std::vector<VkDeviceSize>& memorySizes,
+        const VkExtent2D& extent, const VkFormat format, const VkImageUsageFlags usage);
+
+    //The semaphore and the value which the commands that render into the image must wait for.
+    //Returns false if there is nothing to wait for
+    bool GetReleasedWait(const uint32_t imageIndex, VkSemaphore* semaphore, uint64_t* value) const;
+
+    //After the commands which render into the image have been submitted to queue
+    void Publish(const VkQueue queue, const uint32_t imageIndex, const VkExtent2D& renderExtent);
+
+    inline bool IsInitialized() const;
+    inline uint64_t GetNumSentFrames() const;
+
+private:
+    void AcceptConsumer();
+    void DisconnectConsumer();
+    uint64_t GetReleasedValue() const;
+
+    VkDevice                    m_device;
+    FrameSharingSocket          m_socket;
+    FrameSharingSetup           m_setup;
+    std::vector<VkDeviceMemory> m_memories;
+
+    VkSemaphore                 m_renderedSemaphore;
+    VkSemaphore                 m_releasedSemaphore;
+    uint64_t                    m_lastValue;        //Of the rendered semaphore
+    std::vector<uint64_t>       m_lastSentValues;   //Per image. 0: not held by the consumer
+    uint64_t                    m_numSentFrames;
+
+    PFN_vkSignalSemaphoreKHR            m_signalSemaphore;
+    PFN_vkGetSemaphoreCounterValueKHR   m_getSemaphoreCounterValue;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool FrameExporter::IsInitialized() const { return VK_NULL_HANDLE != m_renderedSemaphore; }
+uint64_t FrameExporter::GetNumSentFrames() const { return m_numSentFrames; }
+
+} //end namespace
@@ -0,0 +1,452 @@
+#include "FrameSharing.h"
+#include <stdexcept> //std::runtime_error
+#include <cstring>   //memcpy
+#include <algorithm> //std::replace
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>      //fcntl
+#include <poll.h>       //poll
+#include <sys/socket.h> //sendmsg, recvmsg
+#include <sys/un.h>     //sockaddr_un
+#include <unistd.h>     //close, unlink
+#else
+#include <Windows.h>
+#endif
+
+namespace Shin {
+
+#ifndef _WIN32
+
+FrameSharingSocket::FrameSharingSocket() : m_listenFd(-1), m_fd(-1) {
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CloseFrameSharingHandles(const std::vector<FrameSharingHandle>& handles, const size_t begin) {
+    for (size_t i = begin; i < handles.size(); ++i) {
+        close(handles[i]);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+static sockaddr_un GetSocketAddress(const std::string& path) {
+    sockaddr_un address = {};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("failed to create frame sharing socket: path is too long!");
+    }
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameSharingSocket::Listen(const std::string& path) {
+    const sockaddr_un address = GetSocketAddress(path);
+
+    //Left behind by an exporter which crashed
+    unlink(path.c_str());
+
+    m_listenFd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (m_listenFd < 0
+        || 0 != bind(m_listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address))
+        || 0 != listen(m_listenFd, 1)
+        || 0 != fcntl(m_listenFd, F_SETFL, O_NONBLOCK))
+    {
+        Close();
+        throw std::runtime_error("failed to listen on frame sharing socket!");
+    }
+    m_path = path;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool FrameSharingSocket::Accept() {
+    if (m_listenFd < 0 || m_fd >= 0) {
+        return false;
+    }
+
+    m_fd = accept(m_listenFd, nullptr, nullptr);
+    return (m_fd >= 0);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameSharingSocket::Connect(const std::string& path) {
+    const sockaddr_un address = GetSocketAddress(path);
+    m_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (m_fd < 0 || 0 != connect(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address))) {
+        Disconnect();
+        throw std::runtime_error("failed to connect to frame sharing socket!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameSharingSocket::Disconnect() {
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameSharingSocket::Close() {
+    Disconnect();
+    if (m_listenFd >= 0) {
+        close(m_listenFd);
+        m_listenFd = -1;
+        unlink(m_path.c_str());
+    }
+    m_path.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool FrameSharingSocket::Send(const void* data, const uint32_t size, const std::vector<FrameSharingHandle>& fds) {
+    if (m_fd < 0) {
+        return false;
+    }
+
+    iovec iov = {};
+    iov.iov_base = const_cast<void*>(data);
+    iov.iov_len = size;
+
+    msghdr message = {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+
+    std::vector<uint8_t> control(CMSG_SPACE(sizeof(int) * fds.size()));
+    if (!fds.empty()) {
+        message.msg_control = control.data();
+        message.msg_controllen = control.size();
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        memcpy(CMSG_DATA(header), fds.data(), sizeof(int) * fds.size());
+    }
+
+    //MSG_NOSIGNAL: a consumer which has gone must not kill this process with SIGPIPE
+    if (sendmsg(m_fd, &message, MSG_DONTWAIT | MSG_NOSIGNAL) == static_cast<ssize_t>(size)) {
+        return true;
+    }
+
+    if (EAGAIN != errno && EWOULDBLOCK != errno) {
+        Disconnect();
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool FrameSharingSocket::Receive(void* data, const uint32_t size, const int timeoutMs,
+    std::vector<FrameSharingHandle>* fds)
+{
+    fds->clear();
+    if (m_fd < 0) {
+        return false;
+    }
+
+    pollfd pollInfo = {};
+    pollInfo.fd = m_fd;
+    pollInfo.events = POLLIN;
+    if (poll(&pollInfo, 1, timeoutMs) <= 0) {
+        return false;
+    }
+
+    iovec iov = {};
+    iov.iov_base = data;
+    iov.iov_len = size;
+
+    std::vector<uint8_t> control(CMSG_SPACE(sizeof(int) * (FRAME_SHARING_MAX_IMAGES + 2)));
+    msghdr message = {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+
+    const ssize_t received = recvmsg(m_fd, &message, MSG_CMSG_CLOEXEC);
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); nullptr != header; header = CMSG_NXTHDR(&message, header)) {
+        if (SOL_SOCKET != header->cmsg_level || SCM_RIGHTS != header->cmsg_type)
+            continue;
+
+        const size_t numFds = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const size_t prevSize = fds->size();
+        fds->resize(prevSize + numFds);
+        memcpy(fds->data() + prevSize, CMSG_DATA(header), sizeof(int) * numFds);
+    }
+
+    //0: the peer has closed the connection. A shorter message isn't one of ours
+    if (received != static_cast<ssize_t>(size) || 0 != (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+        CloseFrameSharingHandles(*fds, 0);
+        fds->clear();
+        Disconnect();
+        return false;
+    }
+    return true;
+}
+
+#else
+
+//Before each message: the values of the handles, which have been duplicated into the receiving process
+struct PipeMessageHeader {
+    uint32_t    NumHandles;
+    uint32_t    Padding;
+    uint64_t    Handles[FRAME_SHARING_MAX_IMAGES + 2];
+};
+
+//Many frames. The messages which don't fit are not sent
+const DWORD PIPE_BUFFER_SIZE = 4096;
+
+//---------------------------------------------------------------------------------------------------------------------
+
+FrameSharingSocket::FrameSharingSocket() : m_pipe(nullptr), m_event(nullptr), m_isServer(false), m_connected(false)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void CloseFrameSharingHandles(const std::vector<FrameSharingHandle>& handles, const size_t begin) {
+    for (size_t i = begin; i < handles.size(); ++i) {
+        CloseHandle(handles[i]);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+static std::string GetPipeName(const std::string& path) {
+    const std::string prefix = "\\\\.\\pipe\\";
+    if (0 == path.compare(0, prefix.size(), prefix)) {
+        return path;
+    }
+
+    //A backslash is the only character which pipe names can't contain
+    std::string name = path;
+    std::replace(name.begin(), name.end(), '\\', '/');
+    return prefix + name;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Waits for an operation which has been started with overlapped, and cancels it if it hasn't finished in time.
+//Returns false if it has failed: GetLastError() is ERROR_OPERATION_ABORTED if it has been cancelled
+static bool FinishOverlapped(const HANDLE pipe, OVERLAPPED* overlapped, const BOOL finished, const DWORD timeoutMs,
+    DWORD* numBytes)
+{
+    if (!finished && ERROR_IO_PENDING != GetLastError()) {
+        return false;
+    }
+    if (!finished && WAIT_OBJECT_0 != WaitForSingleObject(overlapped->hEvent, timeoutMs)) {
+        CancelIoEx(pipe, overlapped);
+    }
+    return FALSE != GetOverlappedResult(pipe, overlapped, numBytes, TRUE);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameSharingSocket::Listen(const std::string& path) {
+    const std::string name = GetPipeName(path);
+    m_isServer = true;
+    m_pipe = CreateNamedPipeA(name.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, 1,
+        PIPE_BUFFER_SIZE, PIPE_BUFFER_SIZE, 0, nullptr);
+    if (INVALID_HANDLE_VALUE == m_pipe) {
+        m_pipe = nullptr;
+    }
+    m_event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (nullptr == m_pipe || nullptr == m_event) {
+        Close();
+        throw std::runtime_error("failed to listen on frame sharing socket!");
+    }
+    m_path = path;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//A consumer which has opened the pipe before this is called makes ConnectNamedPipe() fail with ERROR_PIPE_CONNECTED
+bool FrameSharingSocket::Accept() {
+    if (nullptr == m_pipe || !m_isServer || m_connected) {
+        return false;
+    }
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = m_event;
+    const BOOL finished = ConnectNamedPipe(m_pipe, &overlapped);
+    const DWORD error = GetLastError();
+    DWORD numBytes = 0;
+    if (!finished && ERROR_PIPE_CONNECTED == error) {
+        m_connected = true;
+    } else if (!finished && ERROR_NO_DATA == error) {
+        //The consumer has already gone
+        DisconnectNamedPipe(m_pipe);
+    } else {
+        m_connected = FinishOverlapped(m_pipe, &overlapped, finished, 0, &numBytes);
+    }
+    return m_connected;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameSharingSocket::Connect(const std::string& path) {
+    const std::string name = GetPipeName(path);
+    m_isServer = false;
+    m_pipe = CreateFileA(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED,
+        nullptr);
+    if (INVALID_HANDLE_VALUE == m_pipe) {
+        m_pipe = nullptr;
+    }
+    m_event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+
+    DWORD mode = PIPE_READMODE_MESSAGE;
+    if (nullptr == m_pipe || nullptr == m_event || !SetNamedPipeHandleState(m_pipe, &mode, nullptr, nullptr)) {
+        Close();
+        throw std::runtime_error("failed to connect to frame sharing socket!");
+    }
+    m_path = path;
+    m_connected = true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The exporter keeps its pipe for the next consumer
+void FrameSharingSocket::Disconnect() {
+    if (!m_connected) {
+        return;
+    }
+
+    m_connected = false;
+    if (m_isServer) {
+        DisconnectNamedPipe(m_pipe);
+    } else {
+        CloseHandle(m_pipe);
+        m_pipe = nullptr;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void FrameSharingSocket::Close() {
+    Disconnect();
+    if (nullptr != m_pipe) {
+        CloseHandle(m_pipe);
+        m_pipe = nullptr;
+    }
+    if (nullptr != m_event) {
+        CloseHandle(m_event);
+        m_event = nullptr;
+    }
+    m_path.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The handles which have been duplicated into the peer are closed there if the message hasn't been sent
+bool FrameSharingSocket::Send(const void* data, const uint32_t size,
+    const std::vector<FrameSharingHandle>& handles)
+{
+    if (!m_connected || handles.size() > FRAME_SHARING_MAX_IMAGES + 2) {
+        return false;
+    }
+
+    HANDLE peerProcess = nullptr;
+    if (!handles.empty()) {
+        ULONG peerId = 0;
+        const BOOL hasPeerId = m_isServer ? GetNamedPipeClientProcessId(m_pipe, &peerId)
+            : GetNamedPipeServerProcessId(m_pipe, &peerId);
+        peerProcess = hasPeerId ? OpenProcess(PROCESS_DUP_HANDLE, FALSE, peerId) : nullptr;
+        if (nullptr == peerProcess) {
+            Disconnect();
+            return false;
+        }
+    }
+
+    PipeMessageHeader header = {};
+    for (const FrameSharingHandle handle : handles) {
+        HANDLE peerHandle = nullptr;
+        if (!DuplicateHandle(GetCurrentProcess(), handle, peerProcess, &peerHandle, 0, FALSE, DUPLICATE_SAME_ACCESS))
+            break;
+
+        header.Handles[header.NumHandles++] = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(peerHandle));
+    }
+
+    std::vector<uint8_t> message(sizeof(header) + size);
+    memcpy(message.data(), &header, sizeof(header));
+    memcpy(message.data() + sizeof(header), data, size);
+
+    //Aborted: the peer isn't reading the messages
+    bool sent = false;
+    bool failed = (header.NumHandles != handles.size());
+    if (!failed) {
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = m_event;
+        DWORD numBytes = 0;
+        const BOOL finished = WriteFile(m_pipe, message.data(), static_cast<DWORD>(message.size()), nullptr,
+            &overlapped);
+        sent = FinishOverlapped(m_pipe, &overlapped, finished, 0, &numBytes);
+        failed = !sent && ERROR_OPERATION_ABORTED != GetLastError();
+    }
+
+    if (!sent) {
+        for (uint32_t i = 0; i < header.NumHandles; ++i) {
+            const HANDLE peerHandle = reinterpret_cast<HANDLE>(static_cast<uintptr_t>(header.Handles[i]));
+            DuplicateHandle(peerProcess, peerHandle, nullptr, nullptr, 0, FALSE, DUPLICATE_CLOSE_SOURCE);
+        }
+    }
+    if (nullptr != peerProcess) {
+        CloseHandle(peerProcess);
+    }
+    if (failed) {
+        Disconnect();
+    }
+    return sent;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool FrameSharingSocket::Receive(void* data, const uint32_t size, const int timeoutMs,
+    std::vector<FrameSharingHandle>* handles)
+{
+    handles->clear();
+    if (!m_connected) {
+        return false;
+    }
+
+    //A negative timeout waits forever, as with poll()
+    std::vector<uint8_t> message(sizeof(PipeMessageHeader) + size);
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = m_event;
+    DWORD numBytes = 0;
+    const BOOL finished = ReadFile(m_pipe, message.data(), static_cast<DWORD>(message.size()), nullptr, &overlapped);
+    const bool received = FinishOverlapped(m_pipe, &overlapped, finished, static_cast<DWORD>(timeoutMs), &numBytes);
+    if (!received && ERROR_OPERATION_ABORTED == GetLastError()) {
+        return false;
+    }
+
+    //The handles of a message which isn't one of ours are closed too
+    PipeMessageHeader header = {};
+    if (numBytes >= sizeof(header)) {
+        memcpy(&header, message.data(), sizeof(header));
+        const uint32_t numHandles = (header.NumHandles <= FRAME_SHARING_MAX_IMAGES + 2) ? header.NumHandles : 0;
+        for (uint32_t i = 0; i < numHandles; ++i) {
+            handles->push_back(reinterpret_cast<HANDLE>(static_cast<uintptr_t>(header.Handles[i])));
+        }
+    }
+
+    //Broken pipe: the peer has gone. More data: a longer message
+    if (!received || numBytes != message.size()) {
+        CloseFrameSharingHandles(*handles, 0);
+        handles->clear();
+        Disconnect();
+        return false;
+    }
+    memcpy(data, message.data() + sizeof(header), size);
+    return true;
+}
+
+#endif //_WIN32
+
+} //end namespace
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Shin {
+
+//The messages between a process which exports its render targets and a consumer process on the same GPU.
+//Only fixed size types, so that processes built separately agree on them
+const uint32_t FRAME_SHARING_MAGIC      = 0x46534852; //"FSHR"
+const uint32_t FRAME_SHARING_VERSION    = 1;
+const uint32_t FRAME_SHARING_MAX_IMAGES = 8;
+
+//A file descriptor, or an NT handle on Windows
+#ifndef _WIN32
+typedef int FrameSharingHandle;
+#else
+typedef void* FrameSharingHandle;
+#endif
+
+//Those from begin
+void CloseFrameSharingHandles(const std::vector<FrameSharingHandle>& handles, const size_t begin);
+
+//Sent by the exporter after a consumer connects, with the handles of the memory of each image,
+//then of the rendered and the released timeline semaphores.
+//The images are 2D, one layer, optimal tiling, and bound at the beginning of their memory
+struct FrameSharingSetup {
+    uint32_t    Magic;
+    uint32_t    Version;
+    uint8_t     DeviceUUID[VK_UUID_SIZE];   //The consumer must import on the same device
+    uint32_t    Width;
+    uint32_t    Height;
+    uint32_t    Format;                     //VkFormat
+    uint32_t    Usage;                      //VkImageUsageFlags
+    uint32_t    NumImages;
+    uint32_t    Padding;
+    uint64_t    MemorySizes[FRAME_SHARING_MAX_IMAGES];
+};
+
+//Sent for each frame. The image is in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL when the rendered semaphore
+//reaches Value. The consumer must signal the released semaphore with at least Value when it has finished
+//using the image, even if it skips the frame: the exporter waits for it before rendering into the image again
+struct FrameSharingFrame {
+    uint64_t    Value;
+    uint32_t    ImageIndex;
+    uint32_t    Width;                      //The rendered top-left part of the image
+    uint32_t    Height;
+    uint32_t    Padding;
+};
+
+//A Unix domain socket which keeps the message boundaries, and passes file descriptors with SCM_RIGHTS.
+//On Windows, a named pipe in message mode, e.g. "\\.\pipe\NvEncoding": other paths are turned into pipe names.
+//The sender duplicates the handles into the receiving process, and sends their values before the message.
+//One consumer at a time
+class FrameSharingSocket {
+public:
+    FrameSharingSocket();
+
+    //Exporter. Doesn't wait for a consumer
+    void Listen(const std::string& path);
+
+    //Exporter. Returns true if a consumer has connected. Doesn't wait
+    bool Accept();
+
+    //Consumer
+    void Connect(const std::string& path);
+
+    void Disconnect();
+    void Close(); //Also stops listening
+
+    //Returns false if the message has not been sent: the peer has gone if IsConnected() is false,
+    //or the peer isn't reading the messages. Doesn't wait. The handles stay owned by the caller
+    bool Send(const void* data, const uint32_t size, const std::vector<FrameSharingHandle>& handles);
+
+    //Waits for timeoutMs at most. Returns false on timeout, or if the peer has gone: see IsConnected().
+    //The received handles are owned by the caller
+    bool Receive(void* data, const uint32_t size, const int timeoutMs, std::vector<FrameSharingHandle>* handles);
+
+    inline bool IsConnected() const;
+
+private:
+    std::string m_path;
+#ifndef _WIN32
+    int         m_listenFd;
+    int         m_fd;
+#else
+    void*       m_pipe;         //HANDLE. The exporter keeps it between consumers
+    void*       m_event;        //HANDLE. For the overlapped operations, which all finish before returning
+    bool        m_isServer;
+    bool        m_connected;
+#endif
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+#ifndef _WIN32
+bool FrameSharingSocket::IsConnected() const { return m_fd >= 0; }
+#else
+bool FrameSharingSocket::IsConnected() const { return m_connected; }
+#endif
+
+} //end namespace
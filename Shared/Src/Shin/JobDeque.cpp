@@ -0,0 +1,73 @@
+#include "JobDeque.h"
+
+namespace Shin {
+
+JobDeque::JobDeque(const uint32_t capacity) : m_jobs(capacity), m_mask(capacity - 1), m_top(0), m_bottom(0) {
+    for (std::atomic<Job*>& job : m_jobs) {
+        job.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool JobDeque::Push(Job* job) {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_acquire);
+    if (bottom - top > m_mask) {
+        return false;
+    }
+
+    m_jobs[bottom & m_mask].store(job, std::memory_order_relaxed);
+
+    //The job has to be visible before the thieves see the new bottom
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+Job* JobDeque::Pop() {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+
+    //Reserve the bottom job before reading top, so that the thieves and the owner can't both take it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        //Empty
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = m_jobs[bottom & m_mask].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        //The last job. Race against the thieves
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+Job* JobDeque::Steal() {
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom) {
+        return nullptr;
+    }
+
+    Job* job = m_jobs[top & m_mask].load(std::memory_order_relaxed);
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+} //end namespace
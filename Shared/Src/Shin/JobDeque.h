@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+namespace Shin {
+
+struct Job;
+
+//Chase-Lev work-stealing deque with a fixed capacity.
+//The owner thread pushes and pops at the bottom (LIFO, cache friendly),
+//while the other threads steal from the top (FIFO, the oldest and usually the biggest jobs).
+//Based on "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al., 2013), without the resizing.
+class JobDeque {
+public:
+    JobDeque(const uint32_t capacity); //Has to be a power of two
+
+    bool Push(Job* job);    //Owner only. false if the deque is full
+    Job* Pop();             //Owner only. nullptr if empty
+    Job* Steal();           //Any thread. nullptr if empty, or if another thread took the job first
+
+    inline bool IsEmpty() const; //Approximate when called by other threads
+
+private:
+    JobDeque(const JobDeque&) = delete;
+    JobDeque& operator=(const JobDeque&) = delete;
+
+    std::vector<std::atomic<Job*>>  m_jobs;
+    int64_t                         m_mask;
+
+    //Keep top and bottom in different cache lines. Top is written by the thieves, bottom by the owner
+    char                            m_padding0[64];
+    std::atomic<int64_t>            m_top;
+    char                            m_padding1[64];
+    std::atomic<int64_t>            m_bottom;
+    char                            m_padding2[64];
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool JobDeque::IsEmpty() const {
+    return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+}
+
+} //end namespace
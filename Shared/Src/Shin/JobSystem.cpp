@@ -0,0 +1,277 @@
+#include "JobSystem.h"
+#include <algorithm> //std::min, std::max
+
+#include "JobDeque.h"
+#include "Profiler.h"
+
+namespace Shin {
+
+//The system and the index of the current worker thread. Only set on the worker threads, which belong to one system.
+//Thread 0 is identified by its id instead, since the same thread can initialize several systems
+static thread_local const JobSystem* t_jobSystem = nullptr;
+static thread_local uint32_t t_threadIndex = 0;
+
+//---------------------------------------------------------------------------------------------------------------------
+
+JobCounter::JobCounter() : m_count(0) {
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+JobSystem::JobSystem() : m_numQueuedJobs(0), m_numSleepingThreads(0), m_running(false) {
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::Init(const uint32_t numThreads) {
+    uint32_t n = numThreads;
+    if (0 == n) {
+        n = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_deques.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        m_deques[i] = new JobDeque(JOB_DEQUE_CAPACITY);
+    }
+
+    m_initThreadId = std::this_thread::get_id();
+
+    m_running = true;
+    for (uint32_t i = 1; i < n; ++i) {
+        m_threads.push_back(std::thread(&JobSystem::WorkerThreadLoop, this, i));
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::CleanUp() {
+    m_running = false;
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wakeUpCondition.notify_all();
+
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+
+    for (JobDeque* deque : m_deques) {
+        while (Job* job = deque->Pop()) {
+            delete job;
+        }
+        delete deque;
+    }
+    m_deques.clear();
+
+    for (Job* job : m_sharedJobs) {
+        delete job;
+    }
+    m_sharedJobs.clear();
+    m_numQueuedJobs = 0;
+    m_initThreadId = std::thread::id();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::Run(const JobFunc& func, JobCounter* counter) {
+    if (nullptr != counter) {
+        counter->m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Schedule(new Job{ func, counter });
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::RunAfter(JobCounter* dependency, const JobFunc& func, JobCounter* counter) {
+    if (nullptr != counter) {
+        counter->m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Job* job = new Job{ func, counter };
+    {
+        std::lock_guard<std::mutex> lock(dependency->m_mutex);
+        if (!dependency->IsDone()) {
+            dependency->m_continuations.push_back(job);
+            return;
+        }
+    }
+
+    Schedule(job);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::Wait(JobCounter* counter) {
+    SHIN_PROFILE_FUNCTION();
+
+    const uint32_t threadIndex = GetCurrentThreadIndex();
+    while (!counter->IsDone()) {
+        Job* job = GetJob(threadIndex);
+        if (nullptr != job) {
+            Execute(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    //The thread that finished the last job may still be releasing the counter
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        exception = counter->m_exception;
+        counter->m_exception = nullptr;
+    }
+
+    if (nullptr != exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::ParallelFor(const uint32_t count, const uint32_t batchSize, const ParallelForFunc& func) {
+    if (0 == count) {
+        return;
+    }
+
+    const uint32_t batch = std::max(1u, batchSize);
+    JobCounter counter;
+    for (uint32_t begin = 0; begin < count; begin += batch) {
+        const uint32_t end = std::min(count, begin + batch);
+        Run([&func, begin, end]() { func(begin, end); }, &counter);
+    }
+    Wait(&counter);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::WorkerThreadLoop(const uint32_t threadIndex) {
+    SHIN_PROFILE_THREAD_NAME("JobWorker");
+    t_jobSystem = this;
+    t_threadIndex = threadIndex;
+
+    while (m_running) {
+        Job* job = GetJob(threadIndex);
+        if (nullptr != job) {
+            Execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_numSleepingThreads.fetch_add(1);
+        m_wakeUpCondition.wait(lock, [this] { return !m_running || m_numQueuedJobs.load() > 0; });
+        m_numSleepingThreads.fetch_sub(1);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::Schedule(Job* job) {
+    //Count the job first, so that the workers don't go to sleep while it is being pushed
+    m_numQueuedJobs.fetch_add(1);
+
+    const uint32_t threadIndex = GetCurrentThreadIndex();
+    if (INVALID_THREAD_INDEX == threadIndex || !m_deques[threadIndex]->Push(job)) {
+        std::lock_guard<std::mutex> lock(m_sharedJobsMutex);
+        m_sharedJobs.push_back(job);
+    }
+
+    //Lock to make sure that a thread which is about to sleep has started waiting before it is notified
+    if (m_numSleepingThreads.load() > 0) {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_wakeUpCondition.notify_one();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Own deque first, then the shared queue, then steal from the other threads
+Job* JobSystem::GetJob(const uint32_t threadIndex) {
+    Job* job = nullptr;
+    if (INVALID_THREAD_INDEX != threadIndex) {
+        job = m_deques[threadIndex]->Pop();
+    }
+
+    if (nullptr == job) {
+        std::lock_guard<std::mutex> lock(m_sharedJobsMutex);
+        if (!m_sharedJobs.empty()) {
+            job = m_sharedJobs.front();
+            m_sharedJobs.pop_front();
+        }
+    }
+
+    const uint32_t numThreads = GetNumThreads();
+    const uint32_t startIndex = (INVALID_THREAD_INDEX != threadIndex) ? threadIndex + 1 : 0;
+    for (uint32_t i = 0; nullptr == job && i < numThreads; ++i) {
+        const uint32_t victim = (startIndex + i) % numThreads;
+        if (victim != threadIndex && !m_deques[victim]->IsEmpty()) {
+            job = m_deques[victim]->Steal();
+        }
+    }
+
+    if (nullptr != job) {
+        m_numQueuedJobs.fetch_sub(1);
+    }
+    return job;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Exceptions are passed to the counter. Jobs without a counter must not throw
+void JobSystem::Execute(Job* job) {
+    JobCounter* counter = job->Counter;
+    try {
+        SHIN_PROFILE_SCOPE("Job");
+        job->Func();
+    } catch (...) {
+        if (nullptr == counter) {
+            throw;
+        }
+
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        if (nullptr == counter->m_exception) {
+            counter->m_exception = std::current_exception();
+        }
+    }
+
+    delete job;
+    if (nullptr == counter) {
+        return;
+    }
+
+    //Lock-free unless this may be the last job. The counter may be destroyed as soon as it reaches zero,
+    //so it only reaches zero while the lock is held (see Wait())
+    uint32_t count = counter->m_count.load(std::memory_order_relaxed);
+    while (count > 1) {
+        if (counter->m_count.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel)) {
+            return;
+        }
+    }
+
+    std::vector<Job*> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        if (1 == counter->m_count.fetch_sub(1, std::memory_order_acq_rel)) {
+            continuations.swap(counter->m_continuations);
+        }
+    }
+
+    for (Job* continuation : continuations) {
+        Schedule(continuation);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t JobSystem::GetCurrentThreadIndex() const {
+    if (this == t_jobSystem) {
+        return t_threadIndex;
+    }
+    return (std::this_thread::get_id() == m_initThreadId) ? 0 : INVALID_THREAD_INDEX;
+}
+
+} //end namespace
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Shin {
+
+class JobDeque;
+class JobCounter;
+
+typedef std::function<void()> JobFunc;
+typedef std::function<void(const uint32_t begin, const uint32_t end)> ParallelForFunc;
+
+struct Job {
+    JobFunc     Func;
+    JobCounter* Counter; //Decremented after Func has been executed. Can be nullptr
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Counts the unfinished jobs that were added with it.
+//Other jobs can be added to run after the counter reaches zero (JobSystem::RunAfter()).
+//Use JobSystem::Wait() before destroying a counter which still has jobs.
+//The first exception thrown by its jobs is rethrown by JobSystem::Wait().
+class JobCounter {
+public:
+    JobCounter();
+    inline bool IsDone() const;
+
+private:
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    friend class JobSystem;
+
+    std::atomic<uint32_t>   m_count;
+    std::mutex              m_mutex;         //Protects m_continuations, and the counter while it is reaching zero
+    std::vector<Job*>       m_continuations; //Scheduled when m_count reaches zero
+    std::exception_ptr      m_exception;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Work-stealing job scheduler.
+//Each thread of the system has its own JobDeque. Jobs added by a thread go to its own deque, and idle threads steal
+//from the others. Jobs added by threads outside of the system (the render thread, etc) go to a shared queue.
+//The thread that calls Init() is thread 0. It doesn't execute jobs except while it is inside Wait()/ParallelFor().
+//A thread can be thread 0 of several systems, but prefer sharing one system: each system has its own workers.
+class JobSystem {
+public:
+    JobSystem();
+
+    void Init(const uint32_t numThreads); //Including the calling thread. 0: one per hardware thread
+    void CleanUp();                       //Jobs that haven't started are discarded
+
+    //counter is incremented now, and decremented after the job has been executed. Can be nullptr
+    void Run(const JobFunc& func, JobCounter* counter);
+
+    //Runs the job after the dependency reaches zero
+    void RunAfter(JobCounter* dependency, const JobFunc& func, JobCounter* counter);
+
+    //Executes other jobs until the counter reaches zero. Rethrows the first exception thrown by the jobs
+    void Wait(JobCounter* counter);
+
+    //Splits [0, count) into batches of batchSize, executes func on each batch in parallel, and waits for them
+    void ParallelFor(const uint32_t count, const uint32_t batchSize, const ParallelForFunc& func);
+
+    inline uint32_t GetNumThreads() const;
+
+private:
+    void WorkerThreadLoop(const uint32_t threadIndex);
+    void Schedule(Job* job);
+    Job* GetJob(const uint32_t threadIndex);
+    void Execute(Job* job);
+    uint32_t GetCurrentThreadIndex() const; //INVALID_THREAD_INDEX for threads outside of the system
+
+    std::vector<JobDeque*>      m_deques; //One per thread
+    std::vector<std::thread>    m_threads;
+    std::thread::id             m_initThreadId; //Thread 0
+
+    std::mutex                  m_sharedJobsMutex;
+    std::deque<Job*>            m_sharedJobs;
+
+    //Idle threads sleep until a job is scheduled
+    std::atomic<uint32_t>       m_numQueuedJobs;
+    std::atomic<uint32_t>       m_numSleepingThreads;
+    std::mutex                  m_sleepMutex;
+    std::condition_variable     m_wakeUpCondition;
+    std::atomic<bool>           m_running;
+
+    static const uint32_t JOB_DEQUE_CAPACITY = 4096;
+    static const uint32_t INVALID_THREAD_INDEX = UINT32_MAX;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool JobCounter::IsDone() const { return 0 == m_count.load(std::memory_order_acquire); }
+uint32_t JobSystem::GetNumThreads() const { return static_cast<uint32_t>(m_deques.size()); }
+
+} //end namespace
@@ -6,4 +6,5 @@ struct MVPUniform{
     glm::mat4 ModelMat;
     glm::mat4 ViewMat;
     glm::mat4 ProjMat;
+    glm::vec4 TexCoordScale; //xy: multiplied to the texture coordinates in Quad.vert
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 
 #include "Mesh.h"
+#include "UploadBatch.h"
 #include "Utilities/GraphicsUtility.h"
 #include "Utilities/Macros.h"
 
@@ -19,10 +20,24 @@ void Mesh::Init(const VkPhysicalDevice physicalDevice, const VkDevice device,
     const char* vertexData, const uint32_t vertexDataSize, const char* indexData, const uint32_t indicesDataSize, 
     const uint32_t numIndices) 
 {
-    m_numIndices = numIndices;
-    CreateVertexBuffer(physicalDevice, device, allocator, commandPool, queue, vertexData, vertexDataSize);
-    CreateIndexBuffer(physicalDevice, device, allocator, commandPool, queue, indexData, indicesDataSize);
+    UploadBatch uploadBatch;
+    uploadBatch.Begin(device, commandPool);
+    Init(physicalDevice, device, allocator, vertexData, vertexDataSize, indexData, indicesDataSize, numIndices, 
+        &uploadBatch);
+    uploadBatch.Submit(device, allocator, queue);
+    uploadBatch.Wait(device, allocator);
+}
 
+//---------------------------------------------------------------------------------------------------------------------
+
+void Mesh::Init(const VkPhysicalDevice physicalDevice, const VkDevice device, 
+    VkAllocationCallbacks* allocator, 
+    const char* vertexData, const uint32_t vertexDataSize, const char* indexData, const uint32_t indicesDataSize, 
+    const uint32_t numIndices, UploadBatch* uploadBatch) 
+{
+    m_numIndices = numIndices;
+    CreateVertexBuffer(physicalDevice, device, allocator, vertexData, vertexDataSize, uploadBatch);
+    CreateIndexBuffer(physicalDevice, device, allocator, indexData, indicesDataSize, uploadBatch);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -38,68 +53,30 @@ void Mesh::CleanUp(const VkDevice device, VkAllocationCallbacks* allocator)
 //---------------------------------------------------------------------------------------------------------------------
 
 void Mesh::CreateVertexBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device, 
-        VkAllocationCallbacks* allocator,  const VkCommandPool commandPool, VkQueue queue, 
-        const char* vertexData, const uint32_t vertexDataSize) 
+        VkAllocationCallbacks* allocator, const char* vertexData, const uint32_t vertexDataSize, 
+        UploadBatch* uploadBatch) 
 {
-
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-
-    //VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT: to write from the CPU.
-    //VK_MEMORY_PROPERTY_HOST_COHERENT_BIT: ensure that the driver is aware of our copying. Alternative: use flush
-    GraphicsUtility::CreateBuffer(physicalDevice, device, allocator, vertexDataSize, 
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-        &stagingBuffer, &stagingBufferMemory);
-
-    //Filling Vertex Buffer
-    GraphicsUtility::CopyCPUDataToBuffer(device,vertexData,stagingBufferMemory,vertexDataSize);
-
     //VK_BUFFER_USAGE_TRANSFER_DST_BIT: destination in a memory transfer
     GraphicsUtility::CreateBuffer(physicalDevice, device, allocator, vertexDataSize, 
                  VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
                  &m_vb, &m_vbMemory);
 
-    //Copy buffer
-    GraphicsUtility::CopyBuffer(device, commandPool, queue,
-        stagingBuffer, m_vb,vertexDataSize
-    );
-
-    vkDestroyBuffer(device, stagingBuffer, allocator);
-    vkFreeMemory(device, stagingBufferMemory, allocator);
-
+    //Filling Vertex Buffer through a staging buffer
+    uploadBatch->UploadToBuffer(physicalDevice, device, allocator, vertexData, vertexDataSize, m_vb);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
 void Mesh::CreateIndexBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device, 
-        VkAllocationCallbacks* allocator,  const VkCommandPool commandPool, VkQueue queue, 
-        const char* indicesData, const uint32_t indicesDataSize) 
+        VkAllocationCallbacks* allocator, const char* indicesData, const uint32_t indicesDataSize, 
+        UploadBatch* uploadBatch) 
 {
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    GraphicsUtility::CreateBuffer(physicalDevice, device, allocator, indicesDataSize, 
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-        &stagingBuffer, &stagingBufferMemory
-    );
-
-    GraphicsUtility::CopyCPUDataToBuffer(device, indicesData,stagingBufferMemory,indicesDataSize);
-
     GraphicsUtility::CreateBuffer(physicalDevice, device,allocator, indicesDataSize, 
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_ib, &m_ibMemory);
 
-    //Copy buffer
-    GraphicsUtility::CopyBuffer(device, commandPool, queue,
-        stagingBuffer, m_ib,indicesDataSize
-    );
-
-    vkDestroyBuffer(device, stagingBuffer, allocator);
-    vkFreeMemory(device, stagingBufferMemory, allocator);
+    uploadBatch->UploadToBuffer(physicalDevice, device, allocator, indicesData, indicesDataSize, m_ib);
 }
 
 } //end namespace
@@ -4,6 +4,8 @@
 
 namespace Shin {
 
+class UploadBatch;
+
 class Mesh {
 
 public:
@@ -13,6 +15,12 @@ public:
         const char* vertexData, const uint32_t vertexDataSize, const char* indexData, const uint32_t indexDataSize,
         const uint32_t numIndices);
 
+    //Records the uploads into uploadBatch. The data can be released after this call
+    void Init(const VkPhysicalDevice physicalDevice, const VkDevice device, 
+        VkAllocationCallbacks* allocator, 
+        const char* vertexData, const uint32_t vertexDataSize, const char* indexData, const uint32_t indexDataSize,
+        const uint32_t numIndices, UploadBatch* uploadBatch);
+
     void CleanUp(const VkDevice device, VkAllocationCallbacks* allocator);
 
     inline VkBuffer GetVertexBuffer() const;
@@ -21,12 +29,12 @@ public:
     inline uint32_t GetNumIndices() const;
 private:
     void CreateVertexBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device, 
-        VkAllocationCallbacks* allocator,  const VkCommandPool commandPool, VkQueue queue, 
-        const char* vertexData, const uint32_t vertexDataSize);
+        VkAllocationCallbacks* allocator, const char* vertexData, const uint32_t vertexDataSize, 
+        UploadBatch* uploadBatch);
 
     void CreateIndexBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device, 
-        VkAllocationCallbacks* allocator,  const VkCommandPool commandPool, VkQueue queue, 
-        const char* indicesData, const uint32_t indicesDataSize);
+        VkAllocationCallbacks* allocator, const char* indicesData, const uint32_t indicesDataSize, 
+        UploadBatch* uploadBatch);
 
     VkBuffer            m_vb;
     VkDeviceMemory      m_vbMemory;
@@ -6,16 +6,23 @@
 
 namespace Shin {
 
-OffScreenPass::OffScreenPass() : m_renderPass(VK_NULL_HANDLE)
+OffScreenPass::OffScreenPass() : m_exportTextures(false), m_dynamicRendering(false)
+    , m_depthFormat(VK_FORMAT_UNDEFINED), m_depthImage(VK_NULL_HANDLE), m_depthImageMemory(VK_NULL_HANDLE)
+    , m_depthImageView(VK_NULL_HANDLE), m_sampler(VK_NULL_HANDLE), m_renderPass(VK_NULL_HANDLE)
 {
 
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
-void OffScreenPass::Init(const uint32_t width, const uint32_t height) {
+void OffScreenPass::Init(const uint32_t width, const uint32_t height, const bool exportTextures, 
+    const bool dynamicRendering, const VkFormat depthFormat) 
+{
     m_extent.width  = width;
     m_extent.height = height;
+    m_exportTextures = exportTextures;
+    m_dynamicRendering = dynamicRendering;
+    m_depthFormat = depthFormat;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -23,92 +30,98 @@ void OffScreenPass::Init(const uint32_t width, const uint32_t height) {
 void OffScreenPass::CleanUp(const VkDevice device, const VkAllocationCallbacks* allocator) {
 
 	SAFE_DESTROY_RENDER_PASS(device, m_renderPass, allocator);
+    SAFE_DESTROY_SAMPLER(device, m_sampler, allocator);
 
-    const uint32_t numImages = static_cast<uint32_t>(m_colors.size());
-    for (uint32_t i=0;i<numImages;++i) {
-        CleanUpSwapChainObject(device, allocator, i);
-    }
-    m_colors.clear();
-	m_frameBuffers.clear();		
+    CleanUpSwapChainObjects(device, allocator);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
+//The layers of an image can't be added or removed: everything is recreated when the number of images changes
 void OffScreenPass::RecreateSwapChainObjects(const VkPhysicalDevice physicalDevice, const VkDevice device, 
         const VkAllocationCallbacks* allocator, const uint32_t numImages) 
 {
     //Check RenderPass
-    if (VK_NULL_HANDLE == m_renderPass) {
+    if (!m_dynamicRendering && VK_NULL_HANDLE == m_renderPass) {
         CreateRenderPass(device, allocator);
     }
 
-    const uint32_t prevNumImages = static_cast<uint32_t>(m_colors.size());
-    if (prevNumImages == numImages) {
-        return;
+    if (VK_NULL_HANDLE == m_sampler) {
+        m_sampler = GraphicsUtility::CreateSampler(device, allocator);
     }
 
-    //if we currently have too many
-    if (prevNumImages > numImages) {
-        for (uint32_t i = numImages; i < prevNumImages; ++i) {
-            CleanUpSwapChainObject(device, allocator, i);
-        }
-        m_colors.resize(numImages);
-	    m_frameBuffers.resize(numImages);		
+    if (GetNumImages() == numImages) {
         return;
     }
 
-    //we need more 
-    m_colors.resize(numImages);
-	m_frameBuffers.resize(numImages);		
-    for (uint32_t i = prevNumImages; i < numImages; ++i) {
-        CreateSwapChainObject(physicalDevice, device, allocator, i);
-    }
-    
-
+    CleanUpSwapChainObjects(device, allocator);
+    CreateSwapChainObjects(physicalDevice, device, allocator, numImages);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
-void OffScreenPass::CreateSwapChainObject(const VkPhysicalDevice physicalDevice, const VkDevice device,
-    const VkAllocationCallbacks* allocator, const uint32_t imageIndex) 
+void OffScreenPass::CreateSwapChainObjects(const VkPhysicalDevice physicalDevice, const VkDevice device,
+    const VkAllocationCallbacks* allocator, const uint32_t numImages) 
 {
-    Texture* curColor               = &m_colors[imageIndex];
-    VkFramebuffer* curFrameBuffer   = &m_frameBuffers[imageIndex];
-
-	// Create image and image view
-    curColor->InitAsRenderTexture(physicalDevice, device, allocator, m_extent.width, m_extent.height);
-
-    //Create Frame Buffer
-	VkImageView attachments[1];
-	attachments[0] = curColor->GetImageView();
-
-	VkFramebufferCreateInfo framebufferInfo = {};
-    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-	framebufferInfo.renderPass = m_renderPass;
-	framebufferInfo.attachmentCount = 1;
-	framebufferInfo.pAttachments = attachments;
-	framebufferInfo.width = m_extent.width;
-	framebufferInfo.height = m_extent.height;
-	framebufferInfo.layers = 1;
-
-    if (vkCreateFramebuffer(device, &framebufferInfo, allocator, curFrameBuffer) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create Offscreen framebuffer!");
+    // Create the images: one with a layer per image index, or one per image index if exported
+    const uint32_t numColors = m_exportTextures ? numImages : 1;
+    const uint32_t numLayers = m_exportTextures ? 1 : numImages;
+    m_colors.resize(numColors);
+    for (ColorImage& color : m_colors) {
+        color.MemorySize = GraphicsUtility::CreateImageArray(physicalDevice, device, allocator, 
+            m_extent.width, m_extent.height, numLayers, VK_IMAGE_TILING_OPTIMAL,
+            GetColorUsage(), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GetColorFormat(), &color.Image, &color.Memory,
+            m_exportTextures
+        );
     }
 
-	// Fill a descriptor for later use in a descriptor set 
-	m_descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	m_descriptor.imageView = curColor->GetImageView();
-	m_descriptor.sampler = curColor->GetSampler();
+    const bool hasDepth = (VK_FORMAT_UNDEFINED != m_depthFormat);
+    if (hasDepth) {
+        GraphicsUtility::CreateImage(physicalDevice, device, allocator, m_extent.width, m_extent.height, 
+            VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_depthFormat, &m_depthImage, &m_depthImageMemory
+        );
+        m_depthImageView = GraphicsUtility::CreateImageView(device, allocator, m_depthImage, m_depthFormat);
+    }
+
+    m_imageViews.resize(numImages);
+    m_frameBuffers.assign(numImages, VK_NULL_HANDLE);
+    for (uint32_t i = 0; i < numImages; ++i) {
+        m_imageViews[i] = GraphicsUtility::CreateImageView(device, allocator, GetImage(i), GetColorFormat(), 
+            GetLayer(i));
+
+        if (m_dynamicRendering)
+            continue;
+
+        //Create Frame Buffer
+	    VkImageView attachments[2];
+	    attachments[0] = m_imageViews[i];
+        attachments[1] = m_depthImageView;
+
+	    VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	    framebufferInfo.renderPass = m_renderPass;
+	    framebufferInfo.attachmentCount = hasDepth ? 2 : 1;
+	    framebufferInfo.pAttachments = attachments;
+	    framebufferInfo.width = m_extent.width;
+	    framebufferInfo.height = m_extent.height;
+	    framebufferInfo.layers = 1;
+
+        if (vkCreateFramebuffer(device, &framebufferInfo, allocator, &m_frameBuffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create Offscreen framebuffer!");
+        }
+    }
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 void OffScreenPass::CreateRenderPass(const VkDevice device, const VkAllocationCallbacks* allocator) 
 {
 	// Create a separate render pass for the offscreen rendering 
-	std::array<VkAttachmentDescription, 1> colorAttachment = {};
+	std::array<VkAttachmentDescription, 2> colorAttachment = {};
+    const bool hasDepth = (VK_FORMAT_UNDEFINED != m_depthFormat);
 
 	// Color attachment
-	colorAttachment[0].format = VK_FORMAT_R8G8B8A8_UNORM;
+	colorAttachment[0].format = GetColorFormat();
 	colorAttachment[0].samples = VK_SAMPLE_COUNT_1_BIT;
 	colorAttachment[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 	colorAttachment[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -117,12 +130,24 @@ void OffScreenPass::CreateRenderPass(const VkDevice device, const VkAllocationCa
 	colorAttachment[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	colorAttachment[0].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
+    // Depth attachment. Not needed after the pass
+	colorAttachment[1].format = m_depthFormat;
+	colorAttachment[1].samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
 	VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
 
 	VkSubpassDescription subpassDescription = {};
 	subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 	subpassDescription.colorAttachmentCount = 1;
 	subpassDescription.pColorAttachments = &colorReference;
+	subpassDescription.pDepthStencilAttachment = hasDepth ? &depthReference : nullptr;
 
 	// Use subpass dependencies for layout transitions
 	std::array<VkSubpassDependency, 2> dependencies;
@@ -136,6 +161,14 @@ void OffScreenPass::CreateRenderPass(const VkDevice device, const VkAllocationCa
 	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 	dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
+    //The shared depth buffer must not be cleared while the previous pass is still testing against it
+    if (hasDepth) {
+	    dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	    dependencies[0].srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	    dependencies[0].dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	    dependencies[0].dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    }
+
     //[Note-sin: 2019-11-14] All writes must be finished before we start reading in fragment shader
 	dependencies[1].srcSubpass = 0;
 	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
@@ -148,7 +181,7 @@ void OffScreenPass::CreateRenderPass(const VkDevice device, const VkAllocationCa
 	// Create the actual renderpass
 	VkRenderPassCreateInfo renderPassInfo = {};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	renderPassInfo.attachmentCount = static_cast<uint32_t>(colorAttachment.size());
+	renderPassInfo.attachmentCount = hasDepth ? 2 : 1;
 	renderPassInfo.pAttachments = colorAttachment.data();
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpassDescription;
@@ -163,11 +196,24 @@ void OffScreenPass::CreateRenderPass(const VkDevice device, const VkAllocationCa
 
 //---------------------------------------------------------------------------------------------------------------------
 
-void OffScreenPass::CleanUpSwapChainObject(const VkDevice device, const VkAllocationCallbacks* allocator, 
-                                           const uint32_t imageIndex)     
-{
-    m_colors[imageIndex].CleanUp(device, allocator);
-	vkDestroyFramebuffer(device, m_frameBuffers[imageIndex], allocator);
+void OffScreenPass::CleanUpSwapChainObjects(const VkDevice device, const VkAllocationCallbacks* allocator) {
+    const uint32_t numImages = GetNumImages();
+    for (uint32_t i = 0; i < numImages; ++i) {
+	    vkDestroyFramebuffer(device, m_frameBuffers[i], allocator);
+        vkDestroyImageView(device, m_imageViews[i], allocator);
+    }
+    m_frameBuffers.clear();
+    m_imageViews.clear();
+
+    SAFE_DESTROY_IMAGE_VIEW(device, m_depthImageView, allocator);
+    SAFE_DESTROY_IMAGE(device, m_depthImage, allocator);
+    SAFE_FREE_MEMORY(device, m_depthImageMemory, allocator);
+
+    for (ColorImage& color : m_colors) {
+        SAFE_DESTROY_IMAGE(device, color.Image, allocator);
+        SAFE_FREE_MEMORY(device, color.Memory, allocator);
+    }
+    m_colors.clear();
 }
 
 
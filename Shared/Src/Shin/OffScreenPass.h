@@ -1,54 +1,106 @@
 #pragma once
 
 #include <stdint.h>
-#include <vulkan/vulkan.h> 
+#include <vulkan/vulkan.h>
 #include <vector>
-#include "Shin/Texture.h"
 
 
 namespace Shin {
 
+//The color targets are the layers of one 2D array image, one layer per image index, in one allocation.
+//They share one sampler, and each layer has its own view and framebuffer.
+//The optional depth buffer is shared by all of them, since its contents aren't kept after the pass.
+//Exported targets are separate images instead, since CUDA and the encoder can only use 2D arrays which start
+//at the beginning of an allocation
 class OffScreenPass {
 
 public:
     OffScreenPass();
-    void Init(const uint32_t width, const uint32_t height);
+    //exportTextures: allocate the color textures as exportable memory, e.g. to be imported by CUDA
+    //dynamicRendering: the textures are rendered with vkCmdBeginRenderingKHR. No render pass and framebuffers
+    //depthFormat: VK_FORMAT_UNDEFINED for no depth buffer
+    void Init(const uint32_t width, const uint32_t height, const bool exportTextures, const bool dynamicRendering,
+        const VkFormat depthFormat);
     void CleanUp(const VkDevice device, const VkAllocationCallbacks* allocator);
 
-    //Swap chain
-    void RecreateSwapChainObjects(const VkPhysicalDevice physicalDevice, const VkDevice device, 
+    //Swap chain. numImages: the number of image indices which the command buffers are recorded for
+    void RecreateSwapChainObjects(const VkPhysicalDevice physicalDevice, const VkDevice device,
         const VkAllocationCallbacks* allocator, const uint32_t numImages);
 
-    inline const Texture* GetTexture(const uint32_t idx) const;
-	inline VkFramebuffer GetFrameBuffer(const uint32_t idx) const;		
+    inline uint32_t GetNumImages() const;
+    inline VkImage GetImage(const uint32_t idx) const;
+    inline uint32_t GetLayer(const uint32_t idx) const; //The array layer of GetImage() for idx
+    inline VkImageView GetImageView(const uint32_t idx) const;
+    inline VkDeviceMemory GetImageMemory(const uint32_t idx) const;
+    inline VkDeviceSize GetImageMemorySize(const uint32_t idx) const;
+    inline VkSampler GetSampler() const;
+	inline VkFramebuffer GetFrameBuffer(const uint32_t idx) const;
     inline VkRenderPass GetRenderPass() const;
     inline VkExtent2D GetExtent() const;
+    inline VkFormat GetColorFormat() const;
+    inline VkImageUsageFlags GetColorUsage() const; //Importers must create the images with the same usage
+    inline VkFormat GetDepthFormat() const;
+    inline VkImage GetDepthImage() const;
+    inline VkImageView GetDepthImageView() const;
 
 private:
 
-    void CreateSwapChainObject(const VkPhysicalDevice physicalDevice, const VkDevice device, 
-        const VkAllocationCallbacks* allocator, const uint32_t imageIndex);
-    void CleanUpSwapChainObject(const VkDevice device, const VkAllocationCallbacks* allocator, const uint32_t imageIndex);
+    struct ColorImage {
+        VkImage         Image;
+        VkDeviceMemory  Memory;
+        VkDeviceSize    MemorySize;
+    };
+
+    void CreateSwapChainObjects(const VkPhysicalDevice physicalDevice, const VkDevice device,
+        const VkAllocationCallbacks* allocator, const uint32_t numImages);
+    void CleanUpSwapChainObjects(const VkDevice device, const VkAllocationCallbacks* allocator);
 
     void CreateRenderPass(const VkDevice device, const VkAllocationCallbacks* allocator);
 
+    inline const ColorImage& GetColorImage(const uint32_t idx) const;
+
     VkExtent2D m_extent;
+    bool       m_exportTextures;
+    bool       m_dynamicRendering;
+    VkFormat   m_depthFormat;
+
+    //One array image, or one image per image index if exported
+    std::vector<ColorImage> m_colors;
+    VkImage         m_depthImage;
+    VkDeviceMemory  m_depthImageMemory;
+    VkImageView     m_depthImageView;
 
     //What should be allocated as many as swap chain images
-    std::vector<Texture> m_colors;
-	std::vector<VkFramebuffer> m_frameBuffers;		
+    std::vector<VkImageView> m_imageViews;
+	std::vector<VkFramebuffer> m_frameBuffers;
+    VkSampler     m_sampler;
 	VkRenderPass  m_renderPass;
 
-	VkDescriptorImageInfo m_descriptor;
-
-
 } ;
 
 //---------------------------------------------------------------------------------------------------------------------
 
-const Texture* OffScreenPass::GetTexture(const uint32_t idx) const { return &m_colors[idx];}
-VkFramebuffer OffScreenPass::GetFrameBuffer(const uint32_t idx) const { return m_frameBuffers[idx]; }		
+uint32_t OffScreenPass::GetNumImages() const { return static_cast<uint32_t>(m_imageViews.size()); }
+VkImage OffScreenPass::GetImage(const uint32_t idx) const { return GetColorImage(idx).Image; }
+uint32_t OffScreenPass::GetLayer(const uint32_t idx) const { return m_exportTextures ? 0 : idx; }
+VkImageView OffScreenPass::GetImageView(const uint32_t idx) const { return m_imageViews[idx]; }
+VkDeviceMemory OffScreenPass::GetImageMemory(const uint32_t idx) const { return GetColorImage(idx).Memory; }
+VkDeviceSize OffScreenPass::GetImageMemorySize(const uint32_t idx) const { return GetColorImage(idx).MemorySize; }
+VkSampler OffScreenPass::GetSampler() const { return m_sampler; }
+VkFramebuffer OffScreenPass::GetFrameBuffer(const uint32_t idx) const { return m_frameBuffers[idx]; }
 VkRenderPass OffScreenPass::GetRenderPass() const { return m_renderPass; }
 VkExtent2D OffScreenPass::GetExtent() const { return m_extent; }
+VkFormat OffScreenPass::GetColorFormat() const { return VK_FORMAT_R8G8B8A8_UNORM; }
+VkImageUsageFlags OffScreenPass::GetColorUsage() const { 
+    return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+        | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+}
+VkFormat OffScreenPass::GetDepthFormat() const { return m_depthFormat; }
+VkImage OffScreenPass::GetDepthImage() const { return m_depthImage; }
+VkImageView OffScreenPass::GetDepthImageView() const { return m_depthImageView; }
+
+const OffScreenPass::ColorImage& OffScreenPass::GetColorImage(const uint32_t idx) const {
+    return m_exportTextures ? m_colors[idx] : m_colors[0];
+}
 
 } //end namespace
@@ -0,0 +1,198 @@
+#include "PipelineCompiler.h"
+#include <stdexcept> //std::runtime_error
+#include <algorithm> //std::min
+#include <exception> //std::exception_ptr
+
+#include "Utilities/Macros.h"
+#include "Profiler.h"
+
+namespace Shin {
+
+PipelineCompiler::PipelineCompiler() : m_device(VK_NULL_HANDLE), m_allocator(nullptr), m_cache(VK_NULL_HANDLE)
+    , m_usePipelineLibraries(false), m_jobSystem(nullptr)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineCompiler::Init(const VkDevice device, const VkAllocationCallbacks* allocator,
+    const std::vector<char>* initialCacheData, const bool usePipelineLibraries)
+{
+    m_device = device;
+    m_allocator = allocator;
+    m_usePipelineLibraries = usePipelineLibraries;
+
+    //Pipeline caches are internally synchronized: all the threads can compile with the same cache
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    if (nullptr != initialCacheData && !initialCacheData->empty()) {
+        cacheInfo.initialDataSize = initialCacheData->size();
+        cacheInfo.pInitialData = initialCacheData->data();
+    }
+
+    if (VK_SUCCESS != vkCreatePipelineCache(device, &cacheInfo, allocator, &m_cache)) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+
+    m_libraryLinker.Init(device, allocator, m_cache);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineCompiler::CleanUp() {
+    CancelRequests();
+
+    m_libraryLinker.CleanUp();
+    if (VK_NULL_HANDLE != m_cache) {
+        vkDestroyPipelineCache(m_device, m_cache, m_allocator);
+        m_cache = VK_NULL_HANDLE;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineCompiler::CancelRequests() {
+    if (nullptr != m_jobSystem) {
+        m_jobSystem->Wait(&m_compileJobs);
+        m_jobSystem = nullptr;
+    }
+
+    //Requests which were never compiled
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        for (PendingPipeline& pending : m_pendingPipelines) {
+            pending.Promise.set_exception(std::make_exception_ptr(
+                std::runtime_error("pipeline request was cancelled before compiling!")));
+        }
+        m_pendingPipelines.clear();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+std::shared_future<VkPipeline> PipelineCompiler::Request(const PipelineStateKey& key) {
+    PendingPipeline pending;
+    pending.Key = key;
+    std::shared_future<VkPipeline> future = pending.Promise.get_future().share();
+
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    m_pendingPipelines.push_back(std::move(pending));
+    return future;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineCompiler::Compile(JobSystem* jobSystem) {
+    SHIN_PROFILE_FUNCTION();
+
+    //Shared by the jobs
+    std::shared_ptr<PendingPipelines> pipelines = std::make_shared<PendingPipelines>();
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        pipelines->swap(m_pendingPipelines);
+    }
+
+    const uint32_t numPipelines = static_cast<uint32_t>(pipelines->size());
+    if (0 == numPipelines) {
+        return;
+    }
+
+    if (nullptr == jobSystem || jobSystem->GetNumThreads() <= 1) {
+        CompileBatch(pipelines.get(), 0, numPipelines);
+        return;
+    }
+
+    //One batch per thread. Each batch is still one vkCreateGraphicsPipelines call
+    m_jobSystem = jobSystem;
+    const uint32_t numThreads = jobSystem->GetNumThreads();
+    const uint32_t batchSize = (numPipelines + numThreads - 1) / numThreads;
+    for (uint32_t begin = 0; begin < numPipelines; begin += batchSize) {
+        const uint32_t end = std::min(numPipelines, begin + batchSize);
+        jobSystem->Run([this, pipelines, begin, end]() {
+            CompileBatch(pipelines.get(), begin, end);
+        }, &m_compileJobs);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineCompiler::GetCacheDataInto(std::vector<char>* data) const {
+    size_t dataSize = 0;
+    if (VK_SUCCESS != vkGetPipelineCacheData(m_device, m_cache, &dataSize, nullptr)) {
+        throw std::runtime_error("failed to get pipeline cache data!");
+    }
+
+    data->resize(dataSize);
+    if (dataSize > 0 && VK_SUCCESS != vkGetPipelineCacheData(m_device, m_cache, &dataSize, data->data())) {
+        throw std::runtime_error("failed to get pipeline cache data!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineCompiler::ClearRenderPassLibraries() {
+    m_libraryLinker.ClearRenderPassLibraries();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The pipelines and the errors are passed to the promises. The error of a pipeline which couldn't be created without
+//throwing is generic
+void PipelineCompiler::CompileBatch(PendingPipelines* pipelines, const uint32_t begin, const uint32_t end) {
+    SHIN_PROFILE_SCOPE("CompilePipelines");
+
+    const uint32_t count = end - begin;
+    std::vector<PipelineStateKey> keys(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        keys[i] = (*pipelines)[begin + i].Key;
+    }
+
+    std::vector<VkPipeline> createdPipelines(count, VK_NULL_HANDLE);
+    std::vector<std::exception_ptr> errors(count);
+    if (m_usePipelineLibraries) {
+        //One link per pipeline. The parts which have already been compiled are reused
+        for (uint32_t i = 0; i < count; ++i) {
+            try {
+                m_libraryLinker.CreateGraphicsPipeline(keys[i], &createdPipelines[i]);
+            } catch (const std::exception&) {
+                errors[i] = std::current_exception();
+            }
+        }
+    } else {
+        try {
+            CreateGraphicsPipelines(m_device, m_allocator, m_cache, count, keys.data(), createdPipelines.data());
+        } catch (const std::exception&) {
+            errors.assign(count, std::current_exception());
+        }
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        std::promise<VkPipeline>& promise = (*pipelines)[begin + i].Promise;
+        if (VK_NULL_HANDLE != createdPipelines[i]) {
+            promise.set_value(createdPipelines[i]);
+        } else if (nullptr != errors[i]) {
+            promise.set_exception(errors[i]);
+        } else {
+            promise.set_exception(std::make_exception_ptr(std::runtime_error("failed to create graphics pipeline!")));
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkResult PipelineCompiler::CreateGraphicsPipelines(const VkDevice device, const VkAllocationCallbacks* allocator,
+    const VkPipelineCache cache, const uint32_t count, const PipelineStateKey* keys, VkPipeline* pipelines)
+{
+    //The create infos point into their states, which can't be moved
+    std::unique_ptr<GraphicsPipelineStates[]> states(new GraphicsPipelineStates[count]);
+    std::vector<VkGraphicsPipelineCreateInfo> pipelineInfos(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        states[i].Fill(keys[i]);
+        pipelineInfos[i] = states[i].PipelineInfo;
+        pipelines[i] = VK_NULL_HANDLE;
+    }
+
+    return vkCreateGraphicsPipelines(device, cache, count, pipelineInfos.data(), allocator, pipelines);
+}
+
+} //end namespace
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "JobSystem.h"
+#include "PipelineLibraryLinker.h"
+#include "PipelineStateKey.h"
+
+namespace Shin {
+
+//Collects pipeline requests, and compiles them together using a VkPipelineCache which is shared by all the threads.
+//The caller gets a future for each request, which is resolved when the pipeline has been compiled.
+//Usage: Init() -> Request() for each pipeline -> Compile() -> the futures are resolved -> CleanUp()
+class PipelineCompiler {
+public:
+    PipelineCompiler();
+
+    //initialCacheData: the data of a previous GetCacheDataInto(). Can be nullptr.
+    //usePipelineLibraries: link the pipelines from VK_EXT_graphics_pipeline_library parts, which must be enabled
+    void Init(const VkDevice device, const VkAllocationCallbacks* allocator,
+        const std::vector<char>* initialCacheData, const bool usePipelineLibraries);
+
+    //Waits for the compilations in progress. The pipelines are owned by the requesters
+    void CleanUp();
+
+    //Waits for the compilations in progress, and fails the requests which haven't been compiled, 
+    //so that nothing waits for them anymore. Called by CleanUp()
+    void CancelRequests();
+
+    //Can be called from any thread. The future throws if the pipeline couldn't be created
+    std::shared_future<VkPipeline> Request(const PipelineStateKey& key);
+
+    //Compiles all the pending requests.
+    //jobSystem == nullptr: with one vkCreateGraphicsPipelines call on this thread, before returning.
+    //Otherwise the requests are split into one batch per job thread, and this function returns immediately.
+    void Compile(JobSystem* jobSystem);
+
+    void GetCacheDataInto(std::vector<char>* data) const;
+
+    //The pipeline library parts refer to the render passes: call this after they have been recreated, 
+    //and the pipelines linked from them have been destroyed
+    void ClearRenderPassLibraries();
+
+    //Creates the pipelines of keys with one vkCreateGraphicsPipelines call. cache can be VK_NULL_HANDLE.
+    //Returns the result of vkCreateGraphicsPipelines. pipelines which couldn't be created are VK_NULL_HANDLE
+    static VkResult CreateGraphicsPipelines(const VkDevice device, const VkAllocationCallbacks* allocator,
+        const VkPipelineCache cache, const uint32_t count, const PipelineStateKey* keys, VkPipeline* pipelines);
+
+    inline VkPipelineCache GetCache() const;
+    inline bool IsUsingPipelineLibraries() const;
+
+private:
+    struct PendingPipeline {
+        PipelineStateKey            Key;
+        std::promise<VkPipeline>    Promise;
+    };
+    typedef std::vector<PendingPipeline> PendingPipelines;
+
+    void CompileBatch(PendingPipelines* pipelines, const uint32_t begin, const uint32_t end);
+
+    VkDevice                            m_device;
+    const VkAllocationCallbacks*        m_allocator;
+    VkPipelineCache                     m_cache;
+    bool                                m_usePipelineLibraries;
+    PipelineLibraryLinker               m_libraryLinker;
+
+    std::mutex                          m_pendingMutex;
+    PendingPipelines                    m_pendingPipelines;
+
+    JobSystem*                          m_jobSystem; //The system used by the last Compile()
+    JobCounter                          m_compileJobs;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkPipelineCache PipelineCompiler::GetCache() const { return m_cache; }
+bool PipelineCompiler::IsUsingPipelineLibraries() const { return m_usePipelineLibraries; }
+
+} //end namespace
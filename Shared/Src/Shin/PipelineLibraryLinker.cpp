@@ -0,0 +1,226 @@
+#include "PipelineLibraryLinker.h"
+
+#include "Utilities/Macros.h"
+
+namespace Shin {
+
+PipelineLibraryLinker::PipelineLibraryLinker() : m_device(VK_NULL_HANDLE), m_allocator(nullptr)
+    , m_cache(VK_NULL_HANDLE)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineLibraryLinker::Init(const VkDevice device, const VkAllocationCallbacks* allocator, 
+    const VkPipelineCache cache) 
+{
+    m_device = device;
+    m_allocator = allocator;
+    m_cache = cache;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineLibraryLinker::CleanUp() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (uint32_t i = 0; i < NUM_LIBRARY_PARTS; ++i) {
+        for (auto& it : m_libraries[i]) {
+            vkDestroyPipeline(m_device, it.second, m_allocator);
+        }
+        m_libraries[i].clear();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkResult PipelineLibraryLinker::CreateGraphicsPipeline(const PipelineStateKey& key, VkPipeline* pipeline) {
+    *pipeline = VK_NULL_HANDLE;
+
+    VkPipeline libraries[NUM_LIBRARY_PARTS];
+    for (uint32_t i = 0; i < NUM_LIBRARY_PARTS; ++i) {
+        const VkResult result = GetOrCreateLibrary(static_cast<LibraryPart>(i), key, &libraries[i]);
+        if (VK_SUCCESS != result) {
+            return result;
+        }
+    }
+
+    //Link without VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT: the fast path
+    VkPipelineLibraryCreateInfoKHR libraryInfo = {};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+    libraryInfo.libraryCount = NUM_LIBRARY_PARTS;
+    libraryInfo.pLibraries = libraries;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = &libraryInfo;
+    pipelineInfo.layout = key.Layout;
+    pipelineInfo.basePipelineIndex = -1;
+
+    return vkCreateGraphicsPipelines(m_device, m_cache, 1, &pipelineInfo, m_allocator, pipeline);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineLibraryLinker::ClearRenderPassLibraries() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (uint32_t i = 0; i < NUM_LIBRARY_PARTS; ++i) {
+        LibraryMap& libraries = m_libraries[i];
+        for (auto it = libraries.begin(); libraries.end() != it;) {
+            if (VK_NULL_HANDLE == it->first.RenderPass) {
+                ++it;
+                continue;
+            }
+            vkDestroyPipeline(m_device, it->second, m_allocator);
+            it = libraries.erase(it);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t PipelineLibraryLinker::GetNumLibraries() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t numLibraries = 0;
+    for (uint32_t i = 0; i < NUM_LIBRARY_PARTS; ++i) {
+        numLibraries += m_libraries[i].size();
+    }
+    return static_cast<uint32_t>(numLibraries);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The part is compiled outside of the lock. If another thread has compiled the same part in the meantime, 
+//its library is used and ours is destroyed
+VkResult PipelineLibraryLinker::GetOrCreateLibrary(const LibraryPart part, const PipelineStateKey& key, 
+    VkPipeline* library) 
+{
+    const PipelineStateKey partKey = GetPartKey(part, key);
+    LibraryMap& libraries = m_libraries[part];
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = libraries.find(partKey);
+        if (libraries.end() != it) {
+            *library = it->second;
+            return VK_SUCCESS;
+        }
+    }
+
+    VkPipeline newLibrary = VK_NULL_HANDLE;
+    const VkResult result = CreateLibrary(part, partKey, &newLibrary);
+    if (VK_SUCCESS != result) {
+        *library = VK_NULL_HANDLE;
+        return result;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto inserted = libraries.insert(std::make_pair(partKey, newLibrary));
+    if (!inserted.second) {
+        vkDestroyPipeline(m_device, newLibrary, m_allocator);
+    }
+    *library = inserted.first->second;
+    return VK_SUCCESS;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkResult PipelineLibraryLinker::CreateLibrary(const LibraryPart part, const PipelineStateKey& partKey, 
+    VkPipeline* library) const 
+{
+    //Only the states of the part are used. The others are ignored by Vulkan, but are cleared anyway
+    GraphicsPipelineStates states;
+    states.Fill(partKey);
+
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo = {};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+    libraryInfo.pNext = states.PipelineInfo.pNext; //Dynamic rendering
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = &libraryInfo;
+    pipelineInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+    pipelineInfo.basePipelineIndex = -1;
+
+    switch (part) {
+        case LIBRARY_PART_VERTEX_INPUT: {
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+            pipelineInfo.pVertexInputState = &states.VertexInput;
+            pipelineInfo.pInputAssemblyState = &states.InputAssembly;
+            break;
+        }
+        case LIBRARY_PART_PRE_RASTERIZATION: {
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+            pipelineInfo.stageCount = 1;
+            pipelineInfo.pStages = &states.ShaderStages[0];
+            pipelineInfo.pViewportState = &states.Viewport;
+            pipelineInfo.pRasterizationState = &states.Rasterizer;
+            pipelineInfo.pDynamicState = &states.DynamicState;
+            pipelineInfo.layout = partKey.Layout;
+            pipelineInfo.renderPass = partKey.RenderPass;
+            break;
+        }
+        case LIBRARY_PART_FRAGMENT_SHADER: {
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+            pipelineInfo.stageCount = 1;
+            pipelineInfo.pStages = &states.ShaderStages[1];
+            pipelineInfo.pMultisampleState = &states.Multisampling;
+            pipelineInfo.pDepthStencilState = &states.DepthStencil;
+            pipelineInfo.layout = partKey.Layout;
+            pipelineInfo.renderPass = partKey.RenderPass;
+            break;
+        }
+        default: {
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+            pipelineInfo.pMultisampleState = &states.Multisampling;
+            pipelineInfo.pColorBlendState = &states.ColorBlending;
+            pipelineInfo.renderPass = partKey.RenderPass;
+            break;
+        }
+    }
+
+    return vkCreateGraphicsPipelines(m_device, m_cache, 1, &pipelineInfo, m_allocator, library);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Keeps only the members which are used by the part, so that pipelines which only differ in the other parts 
+//share the library
+PipelineStateKey PipelineLibraryLinker::GetPartKey(const LibraryPart part, const PipelineStateKey& key) {
+    PipelineStateKey partKey;
+
+    const PipelineRenderState& renderState = key.RenderState;
+    switch (part) {
+        case LIBRARY_PART_VERTEX_INPUT: {
+            partKey.BindingDescription = key.BindingDescription;
+            partKey.AttributeDescriptions = key.AttributeDescriptions;
+            partKey.RenderState.Topology = renderState.Topology;
+            break;
+        }
+        case LIBRARY_PART_PRE_RASTERIZATION: {
+            partKey.VertShaderModule = key.VertShaderModule;
+            partKey.RenderState.CullMode = renderState.CullMode;
+            partKey.Layout = key.Layout;
+            partKey.RenderPass = key.RenderPass;
+            break;
+        }
+        case LIBRARY_PART_FRAGMENT_SHADER: {
+            partKey.FragShaderModule = key.FragShaderModule;
+            partKey.RenderState.DepthTest = renderState.DepthTest;
+            partKey.RenderState.DepthWrite = renderState.DepthWrite;
+            partKey.RenderState.DepthCompareOp = renderState.DepthCompareOp;
+            partKey.Layout = key.Layout;
+            partKey.RenderPass = key.RenderPass;
+            partKey.DepthFormat = key.DepthFormat; //The depth test depends on it with dynamic rendering
+            break;
+        }
+        default: {
+            partKey.RenderState.Blend = renderState.Blend;
+            partKey.RenderPass = key.RenderPass;
+            partKey.ColorFormat = key.ColorFormat; //Only the output depends on the color format of dynamic rendering
+            partKey.DepthFormat = key.DepthFormat;
+            break;
+        }
+    }
+    return partKey;
+}
+
+} //end namespace
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <mutex>
+#include <unordered_map>
+
+#include "PipelineStateKey.h"
+
+namespace Shin {
+
+//Creates graphics pipelines by linking VK_EXT_graphics_pipeline_library parts: vertex input, pre-rasterization 
+//shaders, fragment shader and fragment output. Each part is compiled once per distinct state, and reused by all the 
+//pipelines which only differ in the other parts. Linking without link time optimization is fast when the device 
+//supports graphicsPipelineLibraryFastLinking.
+//The libraries are kept until the pipelines linked from them have been destroyed.
+class PipelineLibraryLinker {
+public:
+    PipelineLibraryLinker();
+
+    //cache can be VK_NULL_HANDLE
+    void Init(const VkDevice device, const VkAllocationCallbacks* allocator, const VkPipelineCache cache);
+    void CleanUp();
+
+    //Can be called from any thread. Returns the result of the failed step, or of the link
+    VkResult CreateGraphicsPipeline(const PipelineStateKey& key, VkPipeline* pipeline);
+
+    //Destroys the parts which refer to a render pass, after the render passes have been recreated. 
+    //The vertex input parts, and the parts created for dynamic rendering, are kept
+    void ClearRenderPassLibraries();
+
+    uint32_t GetNumLibraries() const;
+
+private:
+    enum LibraryPart {
+        LIBRARY_PART_VERTEX_INPUT = 0,
+        LIBRARY_PART_PRE_RASTERIZATION,
+        LIBRARY_PART_FRAGMENT_SHADER,
+        LIBRARY_PART_FRAGMENT_OUTPUT,
+        NUM_LIBRARY_PARTS,
+    };
+
+    typedef std::unordered_map<PipelineStateKey, VkPipeline, PipelineStateKeyHash> LibraryMap;
+
+    VkResult GetOrCreateLibrary(const LibraryPart part, const PipelineStateKey& key, VkPipeline* library);
+    VkResult CreateLibrary(const LibraryPart part, const PipelineStateKey& partKey, VkPipeline* library) const;
+    static PipelineStateKey GetPartKey(const LibraryPart part, const PipelineStateKey& key);
+
+    VkDevice                        m_device;
+    const VkAllocationCallbacks*    m_allocator;
+    VkPipelineCache                 m_cache;
+
+    mutable std::mutex              m_mutex;
+    LibraryMap                      m_libraries[NUM_LIBRARY_PARTS];
+};
+
+} //end namespace
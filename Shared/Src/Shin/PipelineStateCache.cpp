@@ -0,0 +1,139 @@
+#include "PipelineStateCache.h"
+#include <stdexcept> //std::runtime_error
+#include <chrono> //std::chrono::seconds
+
+#include "PipelineCompiler.h"
+#include "Utilities/Macros.h"
+
+namespace Shin {
+
+PipelineStateCache::PipelineStateCache() : m_device(VK_NULL_HANDLE), m_allocator(nullptr), m_compiler(nullptr)
+    , m_numSharedRequests(0)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineStateCache::Init(const VkDevice device, const VkAllocationCallbacks* allocator,
+    PipelineCompiler* compiler)
+{
+    m_device = device;
+    m_allocator = allocator;
+    m_compiler = compiler;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineStateCache::CleanUp() {
+    ClearPipelines();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& it : m_pipelineLayouts) {
+        vkDestroyPipelineLayout(m_device, it.second, m_allocator);
+    }
+    m_pipelineLayouts.clear();
+    m_numSharedRequests = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+std::shared_future<VkPipeline> PipelineStateCache::GetOrRequestPipeline(const PipelineStateKey& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_pipelines.find(key);
+    if (m_pipelines.end() != it) {
+        if (!IsFailed(it->second)) {
+            ++m_numSharedRequests;
+            return it->second;
+        }
+        m_pipelines.erase(it); //Request it again
+    }
+
+    std::shared_future<VkPipeline> pipeline = m_compiler->Request(key);
+    m_pipelines.insert(std::make_pair(key, pipeline));
+    return pipeline;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkPipelineLayout PipelineStateCache::GetOrCreatePipelineLayout(const VkDescriptorSetLayout descriptorSetLayout) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_pipelineLayouts.find(descriptorSetLayout);
+    if (m_pipelineLayouts.end() != it) {
+        return it->second;
+    }
+
+    //Pipeline layout: to pass uniform values to shaders
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 0;
+    pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, m_allocator, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+
+    m_pipelineLayouts.insert(std::make_pair(descriptorSetLayout, pipelineLayout));
+    return pipelineLayout;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void PipelineStateCache::ClearPipelines() {
+    //The requests which haven't been compiled would never be resolved
+    if (nullptr != m_compiler) {
+        m_compiler->CancelRequests();
+    }
+
+    //Every future is resolved now, but is not waited for while holding the lock
+    std::unordered_map<PipelineStateKey, std::shared_future<VkPipeline>, PipelineStateKeyHash> pipelines;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pipelines.swap(m_pipelines);
+    }
+
+    for (auto& it : pipelines) {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        try {
+            pipeline = it.second.get();
+        } catch (const std::exception&) {
+            //Failed to compile: nothing to destroy
+        }
+        SAFE_DESTROY_PIPELINE(m_device, pipeline, m_allocator);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool PipelineStateCache::IsFailed(const std::shared_future<VkPipeline>& pipeline) {
+    if (std::future_status::ready != pipeline.wait_for(std::chrono::seconds(0))) {
+        return false;
+    }
+
+    try {
+        pipeline.get();
+    } catch (const std::exception&) {
+        return true;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t PipelineStateCache::GetNumPipelines() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<uint32_t>(m_pipelines.size());
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t PipelineStateCache::GetNumSharedRequests() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numSharedRequests;
+}
+
+} //end namespace
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+#include "PipelineStateKey.h"
+
+namespace Shin {
+
+class PipelineCompiler;
+
+//Shares pipelines between DrawPipelines: requests with equal keys get the same VkPipeline.
+//Missing pipelines are requested from a PipelineCompiler, and are owned by the cache.
+//Pipeline layouts are shared in the same way, per descriptor set layout.
+class PipelineStateCache {
+public:
+    PipelineStateCache();
+
+    void Init(const VkDevice device, const VkAllocationCallbacks* allocator, PipelineCompiler* compiler);
+    void CleanUp();
+
+    //Can be called from any thread. A new pipeline is resolved after the next PipelineCompiler::Compile().
+    //A pipeline which failed to compile, or whose request was cancelled, is requested again
+    std::shared_future<VkPipeline> GetOrRequestPipeline(const PipelineStateKey& key);
+    VkPipelineLayout GetOrCreatePipelineLayout(const VkDescriptorSetLayout descriptorSetLayout);
+
+    //Destroys the pipelines, which must not be in use anymore. The keys contain render passes, so this has to be
+    //called when the render passes are recreated. The pipeline layouts are kept.
+    //The requests which haven't been compiled yet are cancelled through the compiler
+    void ClearPipelines();
+
+    uint32_t GetNumPipelines() const;
+    uint32_t GetNumSharedRequests() const; //The requests which have been served by an existing pipeline
+
+private:
+    static bool IsFailed(const std::shared_future<VkPipeline>& pipeline); //Doesn't wait
+
+    VkDevice                        m_device;
+    const VkAllocationCallbacks*    m_allocator;
+    PipelineCompiler*               m_compiler;
+
+    mutable std::mutex              m_mutex;
+    std::unordered_map<PipelineStateKey, std::shared_future<VkPipeline>, PipelineStateKeyHash> m_pipelines;
+    std::unordered_map<VkDescriptorSetLayout, VkPipelineLayout>  m_pipelineLayouts;
+    uint32_t                        m_numSharedRequests;
+};
+
+} //end namespace
@@ -0,0 +1,267 @@
+#include "PipelineStateKey.h"
+#include <functional> //std::hash
+
+namespace Shin {
+
+//---------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+static void HashCombine(size_t* seed, const T& value) {
+    *seed ^= std::hash<T>()(value) + 0x9e3779b9 + (*seed << 6) + (*seed >> 2);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+static bool IsEqualVertexLayout(const PipelineStateKey& lhs, const PipelineStateKey& rhs) {
+    if (lhs.BindingDescription != rhs.BindingDescription) {
+        if (nullptr == lhs.BindingDescription || nullptr == rhs.BindingDescription) {
+            return false;
+        }
+
+        const VkVertexInputBindingDescription& l = *lhs.BindingDescription;
+        const VkVertexInputBindingDescription& r = *rhs.BindingDescription;
+        if (l.binding != r.binding || l.stride != r.stride || l.inputRate != r.inputRate) {
+            return false;
+        }
+    }
+
+    if (lhs.AttributeDescriptions != rhs.AttributeDescriptions) {
+        if (nullptr == lhs.AttributeDescriptions || nullptr == rhs.AttributeDescriptions) {
+            return false;
+        }
+
+        const std::vector<VkVertexInputAttributeDescription>& l = *lhs.AttributeDescriptions;
+        const std::vector<VkVertexInputAttributeDescription>& r = *rhs.AttributeDescriptions;
+        if (l.size() != r.size()) {
+            return false;
+        }
+
+        const size_t numAttributes = l.size();
+        for (size_t i = 0; i < numAttributes; ++i) {
+            if (l[i].location != r[i].location || l[i].binding != r[i].binding
+                || l[i].format != r[i].format || l[i].offset != r[i].offset)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+PipelineRenderState::PipelineRenderState() : Blend(BLEND_MODE_ALPHA), DepthTest(VK_FALSE), DepthWrite(VK_FALSE)
+    , DepthCompareOp(VK_COMPARE_OP_LESS), CullMode(VK_CULL_MODE_BACK_BIT)
+    , Topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool operator==(const PipelineRenderState& lhs, const PipelineRenderState& rhs) {
+    return lhs.Blend == rhs.Blend
+        && lhs.DepthTest == rhs.DepthTest
+        && lhs.DepthWrite == rhs.DepthWrite
+        && lhs.DepthCompareOp == rhs.DepthCompareOp
+        && lhs.CullMode == rhs.CullMode
+        && lhs.Topology == rhs.Topology;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+PipelineStateKey::PipelineStateKey() : VertShaderModule(VK_NULL_HANDLE), FragShaderModule(VK_NULL_HANDLE)
+    , BindingDescription(nullptr), AttributeDescriptions(nullptr)
+    , Layout(VK_NULL_HANDLE), RenderPass(VK_NULL_HANDLE), ColorFormat(VK_FORMAT_UNDEFINED)
+    , DepthFormat(VK_FORMAT_UNDEFINED)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool operator==(const PipelineStateKey& lhs, const PipelineStateKey& rhs) {
+    return lhs.VertShaderModule == rhs.VertShaderModule
+        && lhs.FragShaderModule == rhs.FragShaderModule
+        && lhs.RenderState == rhs.RenderState
+        && lhs.Layout == rhs.Layout
+        && lhs.RenderPass == rhs.RenderPass
+        && lhs.ColorFormat == rhs.ColorFormat
+        && lhs.DepthFormat == rhs.DepthFormat
+        && IsEqualVertexLayout(lhs, rhs);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+size_t PipelineStateKeyHash::operator()(const PipelineStateKey& key) const {
+    size_t seed = 0;
+    HashCombine(&seed, key.VertShaderModule);
+    HashCombine(&seed, key.FragShaderModule);
+
+    if (nullptr != key.BindingDescription) {
+        HashCombine(&seed, key.BindingDescription->stride);
+        HashCombine(&seed, static_cast<uint32_t>(key.BindingDescription->inputRate));
+    }
+    if (nullptr != key.AttributeDescriptions) {
+        for (const VkVertexInputAttributeDescription& attribute : *key.AttributeDescriptions) {
+            HashCombine(&seed, attribute.location);
+            HashCombine(&seed, static_cast<uint32_t>(attribute.format));
+            HashCombine(&seed, attribute.offset);
+        }
+    }
+
+    const PipelineRenderState& renderState = key.RenderState;
+    HashCombine(&seed, static_cast<uint32_t>(renderState.Blend));
+    HashCombine(&seed, renderState.DepthTest);
+    HashCombine(&seed, renderState.DepthWrite);
+    HashCombine(&seed, static_cast<uint32_t>(renderState.DepthCompareOp));
+    HashCombine(&seed, renderState.CullMode);
+    HashCombine(&seed, static_cast<uint32_t>(renderState.Topology));
+
+    HashCombine(&seed, key.Layout);
+    HashCombine(&seed, key.RenderPass);
+    HashCombine(&seed, static_cast<uint32_t>(key.ColorFormat));
+    HashCombine(&seed, static_cast<uint32_t>(key.DepthFormat));
+    return seed;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void GraphicsPipelineStates::Fill(const PipelineStateKey& key) {
+    const PipelineRenderState& renderState = key.RenderState;
+
+    //Vertex
+    VkPipelineShaderStageCreateInfo& vertShaderStageInfo = ShaderStages[0];
+    vertShaderStageInfo = {};
+    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vertShaderStageInfo.module = key.VertShaderModule;
+    vertShaderStageInfo.pName = "main";
+    vertShaderStageInfo.pSpecializationInfo = nullptr;//To specify shader constants
+
+    //Frag
+    VkPipelineShaderStageCreateInfo& fragShaderStageInfo = ShaderStages[1];
+    fragShaderStageInfo = {};
+    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragShaderStageInfo.module = key.FragShaderModule;
+    fragShaderStageInfo.pName = "main";
+
+    //Vertex Input
+    VertexInput = {};
+    VertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    //The vertex layout can be null when only some states are used, as in PipelineLibraryLinker
+    VertexInput.vertexBindingDescriptionCount = (nullptr != key.BindingDescription) ? 1 : 0;
+    VertexInput.pVertexBindingDescriptions = key.BindingDescription;
+    if (nullptr != key.AttributeDescriptions) {
+        VertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(key.AttributeDescriptions->size());
+        VertexInput.pVertexAttributeDescriptions = key.AttributeDescriptions->data();
+    }
+
+    //Input Assembly
+    InputAssembly = {};
+    InputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    InputAssembly.topology = renderState.Topology;
+    InputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    //Viewport and Scissor. Dynamic: set in DrawPipeline::Bind(), so that the pipeline doesn't depend on the extent
+    Viewport = {};
+    Viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    Viewport.viewportCount = 1;
+    Viewport.pViewports = nullptr;
+    Viewport.scissorCount = 1;
+    Viewport.pScissors = nullptr;
+
+    //Rasterizer
+    Rasterizer = {};
+    Rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    Rasterizer.depthClampEnable = VK_FALSE;
+    Rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    Rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    Rasterizer.lineWidth = 1.0f;
+    Rasterizer.cullMode = renderState.CullMode;
+    Rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    Rasterizer.depthBiasEnable = VK_FALSE;
+    Rasterizer.depthBiasConstantFactor = 0.0f; // Optional
+    Rasterizer.depthBiasClamp = 0.0f; // Optional
+    Rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
+
+    //Multisampling
+    Multisampling = {};
+    Multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    Multisampling.sampleShadingEnable = VK_FALSE;
+    Multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    Multisampling.minSampleShading = 1.0f; // Optional
+    Multisampling.pSampleMask = nullptr; // Optional
+    Multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
+    Multisampling.alphaToOneEnable = VK_FALSE; // Optional
+
+    //Depth. Ignored if the render pass doesn't have a depth attachment
+    DepthStencil = {};
+    DepthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    DepthStencil.depthTestEnable = renderState.DepthTest;
+    DepthStencil.depthWriteEnable = renderState.DepthWrite;
+    DepthStencil.depthCompareOp = renderState.DepthCompareOp;
+    DepthStencil.depthBoundsTestEnable = VK_FALSE;
+    DepthStencil.stencilTestEnable = VK_FALSE;
+    DepthStencil.minDepthBounds = 0.0f;
+    DepthStencil.maxDepthBounds = 1.0f;
+
+    //Color blending
+    ColorBlendAttachment = {};
+    ColorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    ColorBlendAttachment.blendEnable = (BLEND_MODE_ALPHA == renderState.Blend) ? VK_TRUE : VK_FALSE;
+    ColorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    ColorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    ColorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    ColorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    ColorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    ColorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    ColorBlending = {};
+    ColorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    ColorBlending.logicOpEnable = VK_FALSE;
+    ColorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
+    ColorBlending.attachmentCount = 1;
+    ColorBlending.pAttachments = &ColorBlendAttachment;
+
+    //Dynamic states
+    DynamicStates[0] = VK_DYNAMIC_STATE_VIEWPORT;
+    DynamicStates[1] = VK_DYNAMIC_STATE_SCISSOR;
+
+    DynamicState = {};
+    DynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    DynamicState.dynamicStateCount = 2;
+    DynamicState.pDynamicStates = DynamicStates;
+
+    //Dynamic rendering: the attachment formats replace the render pass. 
+    //Without a color format, e.g. for pipeline library parts which don't output colors, there is no attachment
+    ColorFormat = key.ColorFormat;
+    Rendering = {};
+    Rendering.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    Rendering.colorAttachmentCount = (VK_FORMAT_UNDEFINED != ColorFormat) ? 1 : 0;
+    Rendering.pColorAttachmentFormats = &ColorFormat;
+    Rendering.depthAttachmentFormat = key.DepthFormat;
+    Rendering.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+
+    //Graphics pipeline
+    PipelineInfo = {};
+    PipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    PipelineInfo.pNext = (VK_NULL_HANDLE == key.RenderPass) ? &Rendering : nullptr;
+    PipelineInfo.stageCount = 2;
+    PipelineInfo.pStages = ShaderStages;
+    PipelineInfo.pVertexInputState = &VertexInput;
+    PipelineInfo.pInputAssemblyState = &InputAssembly;
+    PipelineInfo.pViewportState = &Viewport;
+    PipelineInfo.pRasterizationState = &Rasterizer;
+    PipelineInfo.pMultisampleState = &Multisampling;
+    PipelineInfo.pDepthStencilState = &DepthStencil;
+    PipelineInfo.pColorBlendState = &ColorBlending;
+    PipelineInfo.pDynamicState = &DynamicState;
+    PipelineInfo.layout = key.Layout;
+    PipelineInfo.renderPass = key.RenderPass;
+    PipelineInfo.subpass = 0;
+    PipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+    PipelineInfo.basePipelineIndex = -1; // Optional
+}
+
+} //end namespace
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stddef.h>
+#include <vector>
+
+namespace Shin {
+
+enum BlendMode {
+    BLEND_MODE_OPAQUE = 0, //No blending
+    BLEND_MODE_ALPHA,      //src * srcAlpha + dst * (1 - srcAlpha)
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The fixed-function states which can be chosen per pipeline. The default is the state that every DrawPipeline used
+//to have: alpha blending, back-face culling, no depth and triangle lists.
+//Depth testing requires a render pass with a depth attachment, or a DepthFormat with dynamic rendering
+struct PipelineRenderState {
+    PipelineRenderState();
+
+    BlendMode           Blend;
+    VkBool32            DepthTest;
+    VkBool32            DepthWrite;
+    VkCompareOp         DepthCompareOp;
+    VkCullModeFlags     CullMode;
+    VkPrimitiveTopology Topology;
+};
+
+bool operator==(const PipelineRenderState& lhs, const PipelineRenderState& rhs);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Everything that is needed to create a graphics pipeline.
+//Two keys are equal if they would create the same pipeline: the vertex layouts are compared by value.
+//Without RenderPass, the pipeline is used with dynamic rendering into an attachment of ColorFormat, 
+//and a depth attachment of DepthFormat unless it is VK_FORMAT_UNDEFINED
+struct PipelineStateKey {
+    PipelineStateKey();
+
+    VkShaderModule                                          VertShaderModule;
+    VkShaderModule                                          FragShaderModule;
+    const VkVertexInputBindingDescription*                  BindingDescription;
+    const std::vector<VkVertexInputAttributeDescription>*   AttributeDescriptions;
+    PipelineRenderState                                     RenderState;
+    VkPipelineLayout                                        Layout;
+    VkRenderPass                                            RenderPass;
+    VkFormat                                                ColorFormat;
+    VkFormat                                                DepthFormat;
+};
+
+bool operator==(const PipelineStateKey& lhs, const PipelineStateKey& rhs);
+
+struct PipelineStateKeyHash {
+    size_t operator()(const PipelineStateKey& key) const;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The create infos of the graphics pipeline of a key. PipelineInfo points to the other members, so this can't be
+//copied. Viewport and scissor are dynamic states, set in DrawPipeline::Bind()
+struct GraphicsPipelineStates {
+    GraphicsPipelineStates() {}
+    void Fill(const PipelineStateKey& key);
+
+    VkPipelineShaderStageCreateInfo         ShaderStages[2]; //Vertex, fragment
+    VkPipelineVertexInputStateCreateInfo    VertexInput;
+    VkPipelineInputAssemblyStateCreateInfo  InputAssembly;
+    VkPipelineViewportStateCreateInfo       Viewport;
+    VkPipelineRasterizationStateCreateInfo  Rasterizer;
+    VkPipelineMultisampleStateCreateInfo    Multisampling;
+    VkPipelineDepthStencilStateCreateInfo   DepthStencil;
+    VkPipelineColorBlendAttachmentState     ColorBlendAttachment;
+    VkPipelineColorBlendStateCreateInfo     ColorBlending;
+    VkDynamicState                          DynamicStates[2];
+    VkPipelineDynamicStateCreateInfo        DynamicState;
+    VkFormat                                ColorFormat;
+    VkPipelineRenderingCreateInfoKHR        Rendering;      //Chained to PipelineInfo for dynamic rendering
+    VkGraphicsPipelineCreateInfo            PipelineInfo;
+
+private:
+    GraphicsPipelineStates(const GraphicsPipelineStates&);
+    GraphicsPipelineStates& operator=(const GraphicsPipelineStates&);
+};
+
+} //end namespace
@@ -0,0 +1,218 @@
+#include "Profiler.h"
+
+#ifdef ENABLE_SHIN_PROFILER
+
+#include <chrono>
+#include <fstream>
+#include <memory>   //unique_ptr
+#include <mutex>
+#include <algorithm> //min
+#include <iomanip>   //setprecision
+
+namespace Shin {
+
+//The registry is only locked when a thread records its first zone, when a thread is named, and when exporting.
+static std::mutex g_profilerRegistryMutex;
+static std::vector<std::unique_ptr<ProfilerThreadBuffer>> g_profilerThreadBuffers;
+static thread_local ProfilerThreadBuffer* t_profilerThreadBuffer = nullptr;
+
+static const std::chrono::steady_clock::time_point g_profilerEpoch = std::chrono::steady_clock::now();
+
+static std::mutex   g_profilerCaptureMutex;
+static uint64_t     g_profilerCaptureStartNs = 0;
+static uint64_t     g_profilerCaptureEndNs = 0;
+static uint64_t     g_profilerTimedCaptureEndNs = 0;
+static std::string  g_profilerTimedCapturePath;
+
+std::atomic<bool> Profiler::s_capturing(false);
+
+//---------------------------------------------------------------------------------------------------------------------
+
+ProfilerThreadBuffer::ProfilerThreadBuffer(const uint32_t threadID)
+    : m_events(SHIN_PROFILER_EVENTS_PER_THREAD), m_writeCount(0), m_threadID(threadID)
+{
+    m_name = "Thread " + std::to_string(threadID);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ProfilerThreadBuffer::CopyEventsInto(std::vector<ProfilerEvent>* events) const {
+
+    const uint64_t endCount = m_writeCount.load(std::memory_order_acquire);
+    const uint64_t startCount = (endCount > SHIN_PROFILER_EVENTS_PER_THREAD)
+        ? endCount - SHIN_PROFILER_EVENTS_PER_THREAD : 0;
+
+    const size_t prevSize = events->size();
+    for (uint64_t i = startCount; i < endCount; ++i) {
+        events->push_back(m_events[i % SHIN_PROFILER_EVENTS_PER_THREAD]);
+    }
+
+    //The owning thread may have kept writing while we were copying. Drop the slots that could have been overwritten.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t latestCount = m_writeCount.load(std::memory_order_relaxed);
+    const uint64_t firstValid = (latestCount >= SHIN_PROFILER_EVENTS_PER_THREAD)
+        ? latestCount - SHIN_PROFILER_EVENTS_PER_THREAD + 1 : 0;
+    if (firstValid > startCount) {
+        const size_t numInvalid = static_cast<size_t>(std::min(firstValid, endCount) - startCount);
+        events->erase(events->begin() + prevSize, events->begin() + prevSize + numInvalid);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ProfilerThreadBuffer::SetName(const char* name) {
+    m_name = name;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+ProfilerThreadBuffer* Profiler::GetThreadBuffer() {
+    if (nullptr != t_profilerThreadBuffer)
+        return t_profilerThreadBuffer;
+
+    //Buffers are kept alive until the process ends so that zones of finished threads can still be exported
+    std::lock_guard<std::mutex> lock(g_profilerRegistryMutex);
+    const uint32_t threadID = static_cast<uint32_t>(g_profilerThreadBuffers.size());
+    g_profilerThreadBuffers.push_back(std::unique_ptr<ProfilerThreadBuffer>(new ProfilerThreadBuffer(threadID)));
+    t_profilerThreadBuffer = g_profilerThreadBuffers.back().get();
+    return t_profilerThreadBuffer;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void Profiler::SetThreadName(const char* name) {
+    ProfilerThreadBuffer* buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(g_profilerRegistryMutex);
+    buffer->SetName(name);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint64_t Profiler::GetTimeNs() {
+    //+1 so that 0 can be used as "not started" by ProfilerScope
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_profilerEpoch).count()) + 1;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void Profiler::Record(const char* name, const uint64_t startNs, const uint64_t endNs) {
+    GetThreadBuffer()->Push(name, startNs, endNs);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void Profiler::BeginCapture() {
+    std::lock_guard<std::mutex> lock(g_profilerCaptureMutex);
+    g_profilerCaptureStartNs = GetTimeNs();
+    g_profilerCaptureEndNs = UINT64_MAX;
+    s_capturing.store(true, std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void Profiler::EndCapture() {
+    std::lock_guard<std::mutex> lock(g_profilerCaptureMutex);
+    g_profilerCaptureEndNs = GetTimeNs();
+    s_capturing.store(false, std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void Profiler::BeginTimedCapture(const float durationSeconds, const std::string& path) {
+    BeginCapture();
+    std::lock_guard<std::mutex> lock(g_profilerCaptureMutex);
+    g_profilerTimedCaptureEndNs = g_profilerCaptureStartNs + static_cast<uint64_t>(durationSeconds * 1.0e9);
+    g_profilerTimedCapturePath = path;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void Profiler::UpdateCapture() {
+    if (!IsCapturing())
+        return;
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(g_profilerCaptureMutex);
+        if (g_profilerTimedCapturePath.empty() || GetTimeNs() < g_profilerTimedCaptureEndNs)
+            return;
+
+        path.swap(g_profilerTimedCapturePath);
+    }
+
+    EndCapture();
+    ExportChromeTrace(path);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+static void WriteJSONString(std::ofstream& file, const char* str) {
+    file << '"';
+    for (const char* c = str; '\0' != *c; ++c) {
+        switch (*c) {
+            case '"':  file << "\\\""; break;
+            case '\\': file << "\\\\"; break;
+            case '\n': file << "\\n"; break;
+            case '\t': file << "\\t"; break;
+            default:   file << *c; break;
+        }
+    }
+    file << '"';
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Writes complete events ("ph":"X") and thread name metadata, which chrome://tracing and Perfetto can both open
+bool Profiler::ExportChromeTrace(const std::string& path) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    uint64_t captureStartNs = 0;
+    uint64_t captureEndNs = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_profilerCaptureMutex);
+        captureStartNs = g_profilerCaptureStartNs;
+        captureEndNs = IsCapturing() ? UINT64_MAX : g_profilerCaptureEndNs;
+    }
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool firstEvent = true;
+
+    std::vector<ProfilerEvent> events;
+    std::lock_guard<std::mutex> lock(g_profilerRegistryMutex);
+    for (const std::unique_ptr<ProfilerThreadBuffer>& buffer : g_profilerThreadBuffers) {
+        const uint32_t tid = buffer->GetThreadID();
+
+        if (!firstEvent)
+            file << ",\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid << ",\"args\":{\"name\":";
+        WriteJSONString(file, buffer->GetName().c_str());
+        file << "}}";
+        firstEvent = false;
+
+        events.clear();
+        buffer->CopyEventsInto(&events);
+        for (const ProfilerEvent& ev : events) {
+            if (ev.StartNs < captureStartNs || ev.EndNs > captureEndNs)
+                continue;
+
+            //Chrome trace timestamps are in microseconds
+            file << ",\n{\"name\":";
+            WriteJSONString(file, ev.Name);
+            file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid
+                 << ",\"ts\":" << static_cast<double>(ev.StartNs - captureStartNs) * 0.001
+                 << ",\"dur\":" << static_cast<double>(ev.EndNs - ev.StartNs) * 0.001 << "}";
+        }
+    }
+
+    file << "\n]}\n";
+    file.close();
+    return true;
+}
+
+} //end namespace
+
+#endif //ENABLE_SHIN_PROFILER
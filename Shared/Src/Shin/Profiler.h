@@ -0,0 +1,134 @@
+#pragma once
+
+#include "SharedConfig.h"
+
+//CPU scoped-zone profiler.
+//Zones are written into per-thread ring buffers (single producer, no locks on the hot path) and can be exported
+//as Chrome trace JSON (chrome://tracing, Perfetto). When ENABLE_SHIN_PROFILER is not defined, all the macros below
+//expand to nothing and this header declares no symbols.
+
+#ifdef ENABLE_SHIN_PROFILER
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+//Number of zones kept per thread. Older zones are overwritten when the ring is full.
+#ifndef SHIN_PROFILER_EVENTS_PER_THREAD
+#define SHIN_PROFILER_EVENTS_PER_THREAD (1 << 18)
+#endif
+
+namespace Shin {
+
+struct ProfilerEvent {
+    const char* Name;       //must outlive the capture (string literals, __FUNCTION__)
+    uint64_t    StartNs;
+    uint64_t    EndNs;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+class ProfilerThreadBuffer {
+public:
+    ProfilerThreadBuffer(const uint32_t threadID);
+
+    inline void Push(const char* name, const uint64_t startNs, const uint64_t endNs);
+    void CopyEventsInto(std::vector<ProfilerEvent>* events) const;
+
+    void SetName(const char* name);
+    inline const std::string& GetName() const;
+    inline uint32_t GetThreadID() const;
+
+private:
+    std::vector<ProfilerEvent>  m_events;
+    std::atomic<uint64_t>       m_writeCount;   //only written by the owning thread
+    std::string                 m_name;
+    uint32_t                    m_threadID;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+class Profiler {
+public:
+    static void SetThreadName(const char* name);
+
+    static void BeginCapture();
+    static void EndCapture();
+
+    //Captures for durationSeconds, then exports to path. UpdateCapture() has to be called regularly (once per frame)
+    static void BeginTimedCapture(const float durationSeconds, const std::string& path);
+    static void UpdateCapture();
+
+    static bool ExportChromeTrace(const std::string& path);
+
+    static inline bool IsCapturing();
+    static uint64_t GetTimeNs();
+    static void Record(const char* name, const uint64_t startNs, const uint64_t endNs);
+
+private:
+    static ProfilerThreadBuffer* GetThreadBuffer();
+
+    static std::atomic<bool> s_capturing;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+class ProfilerScope {
+public:
+    inline ProfilerScope(const char* name);
+    inline ~ProfilerScope();
+
+private:
+    const char* m_name;
+    uint64_t    m_startNs;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ProfilerThreadBuffer::Push(const char* name, const uint64_t startNs, const uint64_t endNs) {
+    const uint64_t count = m_writeCount.load(std::memory_order_relaxed);
+    ProfilerEvent& ev = m_events[count % SHIN_PROFILER_EVENTS_PER_THREAD];
+    ev.Name = name;
+    ev.StartNs = startNs;
+    ev.EndNs = endNs;
+    m_writeCount.store(count + 1, std::memory_order_release);
+}
+
+const std::string& ProfilerThreadBuffer::GetName() const { return m_name; }
+uint32_t ProfilerThreadBuffer::GetThreadID() const { return m_threadID; }
+
+bool Profiler::IsCapturing() { return s_capturing.load(std::memory_order_relaxed); }
+
+ProfilerScope::ProfilerScope(const char* name) : m_name(name), m_startNs(0) {
+    if (Profiler::IsCapturing()) {
+        m_startNs = Profiler::GetTimeNs();
+    }
+}
+
+ProfilerScope::~ProfilerScope() {
+    if (0 != m_startNs) {
+        Profiler::Record(m_name, m_startNs, Profiler::GetTimeNs());
+    }
+}
+
+} //end namespace
+
+#define SHIN_PROFILE_CONCAT_INNER(a, b) a##b
+#define SHIN_PROFILE_CONCAT(a, b) SHIN_PROFILE_CONCAT_INNER(a, b)
+
+#define SHIN_PROFILE_SCOPE(name)    Shin::ProfilerScope SHIN_PROFILE_CONCAT(shinProfilerScope, __LINE__)(name)
+#define SHIN_PROFILE_FUNCTION()     SHIN_PROFILE_SCOPE(__FUNCTION__)
+#define SHIN_PROFILE_THREAD_NAME(name) Shin::Profiler::SetThreadName(name)
+#define SHIN_PROFILE_BEGIN_TIMED_CAPTURE(durationSeconds, path) Shin::Profiler::BeginTimedCapture(durationSeconds, path)
+#define SHIN_PROFILE_UPDATE_CAPTURE() Shin::Profiler::UpdateCapture()
+
+#else
+
+#define SHIN_PROFILE_SCOPE(name)
+#define SHIN_PROFILE_FUNCTION()
+#define SHIN_PROFILE_THREAD_NAME(name)
+#define SHIN_PROFILE_BEGIN_TIMED_CAPTURE(durationSeconds, path)
+#define SHIN_PROFILE_UPDATE_CAPTURE()
+
+#endif //ENABLE_SHIN_PROFILER
@@ -0,0 +1,551 @@
+#include "ReadbackRing.h"
+#include <stdexcept> //std::runtime_error
+
+#include "Shin/Utilities/Macros.h"
+#include "Shin/ColorConversionPass.h"
+#include "Shin/SharedFrameRing.h"
+
+namespace Shin {
+
+ReadbackRing::ReadbackRing() : m_device(VK_NULL_HANDLE), m_commandPool(VK_NULL_HANDLE), m_format(VK_FORMAT_UNDEFINED)
+    , m_coherent(true), m_sharedFrameRing(nullptr), m_nextSequence(0), m_numSubmittedFrames(0)
+    , m_numDroppedFrames(0)
+{
+
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ReadbackRing::Init(const VkPhysicalDevice physicalDevice, const VkDevice device,
+    const VkAllocationCallbacks* allocator, const uint32_t queueFamilyIndex, const VkExtent2D& maxExtent,
+    const VkFormat format, const uint32_t numSlots)
+{
+    CreateSlots(device, allocator, queueFamilyIndex, format, numSlots);
+
+    const VkDeviceSize size = GetFrameSize(maxExtent, format);
+    for (Slot& slot : m_slots) {
+        CreateSlotBuffer(physicalDevice, allocator, size, nullptr, 0, &slot);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ReadbackRing::InitWithSharedFrameRing(const VkPhysicalDevice physicalDevice, const VkDevice device,
+    const VkAllocationCallbacks* allocator, const uint32_t queueFamilyIndex, SharedFrameRing* sharedFrameRing,
+    const VkDeviceSize alignment)
+{
+    if (!sharedFrameRing->IsOpen() || !sharedFrameRing->IsProducer()) {
+        throw std::runtime_error("failed to import shared frames: the ring hasn't been created!");
+    }
+
+    const uint32_t numSlots = sharedFrameRing->GetNumSlots();
+    const VkDeviceSize slotSize = sharedFrameRing->GetSlotSize();
+    const VkDeviceSize size = GetFrameSize(sharedFrameRing->GetMaxExtent(), sharedFrameRing->GetFormat());
+    if (slotSize < size || 0 != slotSize % alignment) {
+        throw std::runtime_error("failed to import shared frames: unsupported slot size!");
+    }
+    for (uint32_t i = 0; i < numSlots; ++i) {
+        if (0 != reinterpret_cast<uintptr_t>(sharedFrameRing->GetSlotData(i)) % alignment) {
+            throw std::runtime_error("failed to import shared frames: unaligned slots!");
+        }
+    }
+
+    CreateSlots(device, allocator, queueFamilyIndex, sharedFrameRing->GetFormat(), numSlots);
+    for (uint32_t i = 0; i < numSlots; ++i) {
+        CreateSlotBuffer(physicalDevice, allocator, size, sharedFrameRing->GetSlotData(i), slotSize, &m_slots[i]);
+    }
+    m_sharedFrameRing = sharedFrameRing;
+    m_nextSequence = sharedFrameRing->GetNumPublished();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkDeviceSize ReadbackRing::GetFrameSize(const VkExtent2D& extent, const VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB: {
+            return static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+        }
+        case VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM_KHR:
+        case VK_FORMAT_G8_B8R8_2PLANE_420_UNORM_KHR: {
+            return ColorConversionPass::GetOutputSize(extent);
+        }
+        default: {
+            throw std::runtime_error("failed to create readback ring: unsupported format!");
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool ReadbackRing::IsYUVFormat(const VkFormat format) {
+    return VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM_KHR == format || VK_FORMAT_G8_B8R8_2PLANE_420_UNORM_KHR == format;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Everything but the buffers
+void ReadbackRing::CreateSlots(const VkDevice device, const VkAllocationCallbacks* allocator, 
+    const uint32_t queueFamilyIndex, const VkFormat format, const uint32_t numSlots) 
+{
+    GetFrameSize(VkExtent2D(), format); //Throws if the format isn't supported
+    m_format = format;
+    m_device = device;
+
+    //The command buffers are recorded again for every copy
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    if (vkCreateCommandPool(device, &poolInfo, allocator, &m_commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create readback command pool!");
+    }
+
+    m_slots.resize(numSlots);
+    std::vector<VkCommandBuffer> commandBuffers(numSlots);
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = numSlots;
+    if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate readback command buffers!");
+    }
+
+    for (uint32_t i = 0; i < numSlots; ++i) {
+        Slot& slot = m_slots[i];
+        slot = {};
+        slot.CommandBuffer = commandBuffers[i];
+        slot.State = SLOT_STATE_FREE;
+
+        //Unsignaled: reset after each copy has been polled
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(device, &fenceInfo, allocator, &slot.Fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create readback fence!");
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ReadbackRing::CleanUp(const VkDevice device, const VkAllocationCallbacks* allocator) {
+    for (Slot& slot : m_slots) {
+        if (nullptr != slot.MappedData) {
+            vkUnmapMemory(device, slot.Memory);
+        }
+        SAFE_DESTROY_BUFFER(device, slot.Buffer, allocator);
+        SAFE_FREE_MEMORY(device, slot.Memory, allocator);
+        if (VK_NULL_HANDLE != slot.Fence) {
+            vkDestroyFence(device, slot.Fence, allocator);
+        }
+    }
+    m_slots.clear();
+
+    //Frees the command buffers
+    SAFE_DESTROY_COMMAND_POOL(device, m_commandPool, allocator);
+    m_device = VK_NULL_HANDLE;
+    m_sharedFrameRing = nullptr;
+    m_nextSequence = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Cached memory is much faster to read on the CPU. It may not be coherent.
+//Imported memory can only use the types which the driver reports for the host pointer
+void ReadbackRing::CreateSlotBuffer(const VkPhysicalDevice physicalDevice, const VkAllocationCallbacks* allocator,
+    const VkDeviceSize size, void* hostMemory, const VkDeviceSize hostMemorySize, Slot* slot) 
+{
+    const bool imported = (nullptr != hostMemory);
+
+    VkExternalMemoryBufferCreateInfoKHR externalInfo = {};
+    externalInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO_KHR;
+    externalInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.pNext = imported ? &externalInfo : nullptr;
+    bufferInfo.size = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    if (IsYUVFormat(m_format)) {
+        bufferInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT; //Written by ColorConversionPass
+    }
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(m_device, &bufferInfo, allocator, &slot->Buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create readback buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(m_device, slot->Buffer, &memRequirements);
+    uint32_t memoryTypeBits = memRequirements.memoryTypeBits;
+
+    VkImportMemoryHostPointerInfoEXT importInfo = {};
+    if (imported) {
+        auto getHostPointerProperties = (PFN_vkGetMemoryHostPointerPropertiesEXT) 
+            vkGetDeviceProcAddr(m_device, "vkGetMemoryHostPointerPropertiesEXT");
+        if (nullptr == getHostPointerProperties) {
+            throw std::runtime_error("failed to import readback host memory: extension not enabled!");
+        }
+
+        VkMemoryHostPointerPropertiesEXT hostPointerProperties = {};
+        hostPointerProperties.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+        if (getHostPointerProperties(m_device, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, hostMemory,
+            &hostPointerProperties) != VK_SUCCESS) 
+        {
+            throw std::runtime_error("failed to get readback host memory properties!");
+        }
+        memoryTypeBits &= hostPointerProperties.memoryTypeBits;
+
+        importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+        importInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+        importInfo.pHostPointer = hostMemory;
+    }
+
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+    const VkMemoryPropertyFlags preferredFlags[] = {
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+    };
+    uint32_t memoryTypeIndex = UINT32_MAX;
+    for (const VkMemoryPropertyFlags flags : preferredFlags) {
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount && UINT32_MAX == memoryTypeIndex; ++i) {
+            const VkMemoryPropertyFlags typeFlags = memProperties.memoryTypes[i].propertyFlags;
+            if ((memoryTypeBits & (1 << i)) && (typeFlags & flags) == flags) {
+                memoryTypeIndex = i;
+                m_coherent = (0 != (typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+            }
+        }
+    }
+    if (UINT32_MAX == memoryTypeIndex) {
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = imported ? &importInfo : nullptr;
+    allocInfo.allocationSize = imported ? hostMemorySize : memRequirements.size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+    if (vkAllocateMemory(m_device, &allocInfo, allocator, &slot->Memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate readback buffer memory!");
+    }
+    vkBindBufferMemory(m_device, slot->Buffer, slot->Memory, 0);
+
+    //Mapped for the lifetime of the ring. Imported memory is mapped too, so that it can be invalidated
+    void* data = nullptr;
+    if (vkMapMemory(m_device, slot->Memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS) {
+        throw std::runtime_error("failed to map readback buffer memory!");
+    }
+    slot->MappedData = static_cast<uint8_t*>(data);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool ReadbackRing::Submit(const VkQueue queue, const VkImage image, const uint32_t layer,
+    const VkExtent2D& extent, const uint64_t frameIndex)
+{
+    if (IsYUVFormat(m_format)) {
+        throw std::runtime_error("failed to submit readback: the ring expects converted frames!");
+    }
+
+    const uint32_t slotIndex = BeginSubmit(extent, frameIndex);
+    if (UINT32_MAX == slotIndex) {
+        return false;
+    }
+
+    const Slot& slot = m_slots[slotIndex];
+    RecordCopy(slot, image, layer);
+    EndSubmit(queue, slot);
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool ReadbackRing::SubmitConversion(const VkQueue queue, const ColorConversionPass& pass,
+    const VkImageView imageView, const VkSampler sampler, const VkExtent2D& extent, const uint64_t frameIndex)
+{
+    if (pass.GetOutputFormat() != m_format || pass.GetNumSets() < m_slots.size()) {
+        throw std::runtime_error("failed to submit readback: incompatible color conversion!");
+    }
+
+    const uint32_t slotIndex = BeginSubmit(extent, frameIndex);
+    if (UINT32_MAX == slotIndex) {
+        return false;
+    }
+
+    RecordConversion(slotIndex, pass, imageView, sampler);
+    EndSubmit(queue, m_slots[slotIndex]);
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t ReadbackRing::BeginSubmit(const VkExtent2D& extent, const uint64_t frameIndex) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    PollPendingSlots();
+    const uint32_t slotIndex = FindSlotToSubmit();
+    if (UINT32_MAX == slotIndex) {
+        ++m_numDroppedFrames;
+        return UINT32_MAX;
+    }
+
+    //Consumers can't see the slot until it is ready again. Neither can the other processes
+    Slot& slot = m_slots[slotIndex];
+    slot.State = SLOT_STATE_PENDING;
+    slot.Extent = extent;
+    slot.FrameIndex = frameIndex;
+    if (nullptr != m_sharedFrameRing) {
+        slot.Sequence = m_nextSequence++;
+        m_sharedFrameRing->BeginWriteInPlace(slot.Sequence);
+    }
+    return slotIndex;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ReadbackRing::EndSubmit(const VkQueue queue, const Slot& slot) {
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &slot.CommandBuffer;
+    if (vkQueueSubmit(queue, 1, &submitInfo, slot.Fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit readback command buffer!");
+    }
+
+    ++m_numSubmittedFrames;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The image was last written by the render graph which was submitted before, and may have been transitioned by
+//its final barrier: wait for all the commands before the copy
+void ReadbackRing::RecordCopy(const Slot& slot, const VkImage image, const uint32_t layer) const {
+    const VkCommandBuffer commandBuffer = slot.CommandBuffer;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording readback command buffer!");
+    }
+
+    VkImageMemoryBarrier imageBarrier = {};
+    imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image = image;
+    imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageBarrier.subresourceRange.baseMipLevel = 0;
+    imageBarrier.subresourceRange.levelCount = 1;
+    imageBarrier.subresourceRange.baseArrayLayer = layer;
+    imageBarrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+        0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+    //Tightly packed
+    VkBufferImageCopy region = {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = layer;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = { slot.Extent.width, slot.Extent.height, 1 };
+    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.Buffer, 1, &region);
+
+    //Back to the layout which the next users expect. The writes of the next frame wait for the fragment shader
+    imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkBufferMemoryBarrier bufferBarrier = {};
+    bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.buffer = slot.Buffer;
+    bufferBarrier.offset = 0;
+    bufferBarrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+        0, nullptr, 0, nullptr, 1, &imageBarrier);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+        0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record readback command buffer!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The same dependencies as RecordCopy(), with the compute shader instead of the transfer. The image stays in 
+//VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+void ReadbackRing::RecordConversion(const uint32_t slotIndex, const ColorConversionPass& pass,
+    const VkImageView imageView, const VkSampler sampler) const
+{
+    const Slot& slot = m_slots[slotIndex];
+    const VkCommandBuffer commandBuffer = slot.CommandBuffer;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording readback command buffer!");
+    }
+
+    VkMemoryBarrier memoryBarrier = {};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+    pass.Record(m_device, commandBuffer, slotIndex, imageView, sampler, slot.Buffer, slot.Extent);
+
+    //The writes of the next frame wait for the fragment shader
+    VkBufferMemoryBarrier bufferBarrier = {};
+    bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.buffer = slot.Buffer;
+    bufferBarrier.offset = 0;
+    bufferBarrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 0, nullptr);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+        0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record readback command buffer!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool ReadbackRing::Acquire(ReadbackFrame* frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    PollPendingSlots();
+
+    uint32_t oldest = UINT32_MAX;
+    const uint32_t numSlots = static_cast<uint32_t>(m_slots.size());
+    for (uint32_t i = 0; i < numSlots; ++i) {
+        const Slot& slot = m_slots[i];
+        if (SLOT_STATE_READY == slot.State
+            && (UINT32_MAX == oldest || slot.FrameIndex < m_slots[oldest].FrameIndex))
+        {
+            oldest = i;
+        }
+    }
+    if (UINT32_MAX == oldest) {
+        return false;
+    }
+
+    Slot& slot = m_slots[oldest];
+    slot.State = SLOT_STATE_ACQUIRED;
+    frame->Data = slot.MappedData;
+    frame->RowPitch = IsYUVFormat(m_format) ? slot.Extent.width : slot.Extent.width * 4;
+    frame->Extent = slot.Extent;
+    frame->FrameIndex = slot.FrameIndex;
+    frame->Slot = oldest;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ReadbackRing::Release(const ReadbackFrame& frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_slots[frame.Slot].State = SLOT_STATE_FREE;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ReadbackRing::PollPendingSlots() {
+    for (Slot& slot : m_slots) {
+        if (SLOT_STATE_PENDING != slot.State || VK_SUCCESS != vkGetFenceStatus(m_device, slot.Fence))
+            continue;
+
+        vkResetFences(m_device, 1, &slot.Fence);
+        if (!m_coherent) {
+            VkMappedMemoryRange range = {};
+            range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            range.memory = slot.Memory;
+            range.offset = 0;
+            range.size = VK_WHOLE_SIZE;
+            vkInvalidateMappedMemoryRanges(m_device, 1, &range);
+        }
+        slot.State = SLOT_STATE_READY;
+    }
+
+    if (nullptr != m_sharedFrameRing) {
+        PublishReadySlots();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The copies finish in the order of their submission, but the slots are polled in their own order
+void ReadbackRing::PublishReadySlots() {
+    const uint32_t numSlots = static_cast<uint32_t>(m_slots.size());
+    for (uint64_t sequence = m_sharedFrameRing->GetNumPublished(); sequence < m_nextSequence; ++sequence) {
+        const Slot& slot = m_slots[sequence % numSlots];
+        if (SLOT_STATE_READY != slot.State || sequence != slot.Sequence) {
+            return;
+        }
+
+        const uint32_t rowPitch = slot.Extent.width * 4;
+        m_sharedFrameRing->EndWriteInPlace(sequence, slot.Extent, rowPitch, slot.FrameIndex);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//A free slot, or else the oldest frame which no consumer has acquired: newer frames are more useful.
+//With a shared frame ring, only the slot of the next sequence, whose frame is the oldest one
+uint32_t ReadbackRing::FindSlotToSubmit() {
+    const uint32_t numSlots = static_cast<uint32_t>(m_slots.size());
+    if (nullptr != m_sharedFrameRing) {
+        const uint32_t slotIndex = static_cast<uint32_t>(m_nextSequence % numSlots);
+        const SlotState state = m_slots[slotIndex].State;
+        if (SLOT_STATE_READY == state) {
+            ++m_numDroppedFrames;
+        }
+        return (SLOT_STATE_FREE == state || SLOT_STATE_READY == state) ? slotIndex : UINT32_MAX;
+    }
+
+    uint32_t oldestReady = UINT32_MAX;
+    for (uint32_t i = 0; i < numSlots; ++i) {
+        const Slot& slot = m_slots[i];
+        if (SLOT_STATE_FREE == slot.State) {
+            return i;
+        }
+
+        if (SLOT_STATE_READY == slot.State
+            && (UINT32_MAX == oldestReady || slot.FrameIndex < m_slots[oldestReady].FrameIndex))
+        {
+            oldestReady = i;
+        }
+    }
+
+    if (UINT32_MAX != oldestReady) {
+        ++m_numDroppedFrames;
+    }
+    return oldestReady;
+}
+
+} //end namespace
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+
+namespace Shin {
+
+class ColorConversionPass;
+class SharedFrameRing;
+
+//A frame which has been copied to host memory. Data points into a persistently mapped buffer of the ring,
+//and stays valid until the frame is released
+struct ReadbackFrame {
+    const uint8_t*  Data;
+    uint32_t        RowPitch;   //Bytes. The rows are tightly packed. YUV: the pitch of the Y plane
+    VkExtent2D      Extent;
+    uint64_t        FrameIndex; //Given to Submit()
+    uint32_t        Slot;
+};
+
+//Copies rendered images into a ring of host visible buffers, without waiting for the GPU.
+//Submit() records a copy into the command buffer of a free slot, and submits it after the commands which render
+//the image: the barriers of the copy wait for the earlier submissions on the same queue.
+//Each slot has a fence. Acquire() polls them, and returns the oldest frame which has been copied.
+//If there is no free slot, Submit() reuses the oldest frame which hasn't been acquired, or drops the new frame.
+//The buffers are either allocated by the ring, or import the slots of a SharedFrameRing, so that the GPU writes
+//directly into the memory which other processes read.
+//A ring with a YUV 4:2:0 format receives the output of a ColorConversionPass through SubmitConversion() instead,
+//which halves the bytes of each frame.
+//
+//Submit() must be called on the thread which submits to the queue. Acquire() and Release() can be called on
+//any thread
+class ReadbackRing {
+public:
+    ReadbackRing();
+
+    //maxExtent: the largest extent which will be copied. format: 4 bytes per pixel, or the output format of a 
+    //ColorConversionPass
+    void Init(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkAllocationCallbacks* allocator,
+        const uint32_t queueFamilyIndex, const VkExtent2D& maxExtent, const VkFormat format,
+        const uint32_t numSlots);
+
+    //One slot per slot of sharedFrameRing, which this process has created, and which is imported with 
+    //VK_EXT_external_memory_host. It must stay open until CleanUp(). Throws if the driver can't import it.
+    //The frames are published in place, in the order of their submission, as soon as they have been copied.
+    //The slots are used in turn instead of the first free one, so that each frame stays readable by the other
+    //processes until its slot is submitted again, and a frame is dropped if its slot hasn't been released yet.
+    //alignment: minImportedHostPointerAlignment
+    void InitWithSharedFrameRing(const VkPhysicalDevice physicalDevice, const VkDevice device,
+        const VkAllocationCallbacks* allocator, const uint32_t queueFamilyIndex, SharedFrameRing* sharedFrameRing,
+        const VkDeviceSize alignment);
+
+    //The submitted copies must have been finished, e.g. after vkDeviceWaitIdle()
+    void CleanUp(const VkDevice device, const VkAllocationCallbacks* allocator);
+
+    //Copies the top-left extent of a layer of image, which is in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL after
+    //the earlier submissions, and is returned to that layout. Returns false if the frame was dropped
+    bool Submit(const VkQueue queue, const VkImage image, const uint32_t layer, const VkExtent2D& extent,
+        const uint64_t frameIndex);
+
+    //Converts the top-left extent of imageView, which is in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL after the
+    //earlier submissions, with pass. The pass needs a descriptor set per slot, and the output format of the ring
+    bool SubmitConversion(const VkQueue queue, const ColorConversionPass& pass, const VkImageView imageView,
+        const VkSampler sampler, const VkExtent2D& extent, const uint64_t frameIndex);
+
+    //Doesn't wait. Returns false if no frame has been copied yet
+    bool Acquire(ReadbackFrame* frame);
+    void Release(const ReadbackFrame& frame);
+
+    inline bool IsInitialized() const;
+    inline bool PublishesSharedFrames() const; //Initialized by InitWithSharedFrameRing()
+    inline uint32_t GetNumSlots() const;
+    inline const uint8_t* GetSlotData(const uint32_t slot) const; //The frames of the slot. Valid until CleanUp()
+    inline uint64_t GetNumSubmittedFrames() const;
+    inline uint64_t GetNumDroppedFrames() const;
+
+private:
+    enum SlotState {
+        SLOT_STATE_FREE = 0,
+        SLOT_STATE_PENDING,     //Submitted
+        SLOT_STATE_READY,       //Copied, waiting for a consumer
+        SLOT_STATE_ACQUIRED,
+    };
+
+    struct Slot {
+        VkBuffer        Buffer;
+        VkDeviceMemory  Memory;
+        uint8_t*        MappedData;
+        VkCommandBuffer CommandBuffer;
+        VkFence         Fence;
+        SlotState       State;
+        VkExtent2D      Extent;
+        uint64_t        FrameIndex;
+        uint64_t        Sequence;   //In the shared frame ring
+    };
+
+    static VkDeviceSize GetFrameSize(const VkExtent2D& extent, const VkFormat format); //Tightly packed
+    static bool IsYUVFormat(const VkFormat format);
+
+    void CreateSlots(const VkDevice device, const VkAllocationCallbacks* allocator, const uint32_t queueFamilyIndex,
+        const VkFormat format, const uint32_t numSlots);
+
+    //hostMemory: nullptr to allocate the memory
+    void CreateSlotBuffer(const VkPhysicalDevice physicalDevice, const VkAllocationCallbacks* allocator,
+        const VkDeviceSize size, void* hostMemory, const VkDeviceSize hostMemorySize, Slot* slot);
+    void RecordCopy(const Slot& slot, const VkImage image, const uint32_t layer) const;
+    void RecordConversion(const uint32_t slotIndex, const ColorConversionPass& pass, const VkImageView imageView,
+        const VkSampler sampler) const;
+
+    uint32_t BeginSubmit(const VkExtent2D& extent, const uint64_t frameIndex); //UINT32_MAX if the frame is dropped
+    void EndSubmit(const VkQueue queue, const Slot& slot);
+    void PollPendingSlots(); //m_mutex must be locked
+    void PublishReadySlots(); //m_mutex must be locked
+    uint32_t FindSlotToSubmit(); //m_mutex must be locked. UINT32_MAX if none
+
+    VkDevice                        m_device;
+    VkCommandPool                   m_commandPool;
+    std::vector<Slot>               m_slots;
+    VkFormat                        m_format;
+    bool                            m_coherent; //false: the memory is invalidated before it is read
+    SharedFrameRing*                m_sharedFrameRing; //nullptr if the buffers are allocated by the ring
+    uint64_t                        m_nextSequence;    //Of the next frame which is submitted into m_sharedFrameRing
+
+    std::mutex                      m_mutex; //Guards the states of the slots
+    uint64_t                        m_numSubmittedFrames;
+    uint64_t                        m_numDroppedFrames;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool ReadbackRing::IsInitialized() const { return !m_slots.empty(); }
+bool ReadbackRing::PublishesSharedFrames() const { return nullptr != m_sharedFrameRing; }
+uint32_t ReadbackRing::GetNumSlots() const { return static_cast<uint32_t>(m_slots.size()); }
+const uint8_t* ReadbackRing::GetSlotData(const uint32_t slot) const { return m_slots[slot].MappedData; }
+uint64_t ReadbackRing::GetNumSubmittedFrames() const { return m_numSubmittedFrames; }
+uint64_t ReadbackRing::GetNumDroppedFrames() const { return m_numDroppedFrames; }
+
+} //end namespace
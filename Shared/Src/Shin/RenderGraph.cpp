@@ -0,0 +1,825 @@
+#include "RenderGraph.h"
+
+#include <stdexcept> //std::runtime_error
+#include <algorithm> //std::sort
+
+#include "Shin/Utilities/GraphicsUtility.h"
+#include "Shin/Utilities/Macros.h"
+
+namespace Shin {
+
+//Indexed by RenderGraphAccess
+struct RenderGraphAccessInfo {
+    VkPipelineStageFlags    Stage;
+    VkAccessFlags           Access;
+    VkImageLayout           Layout;
+    VkImageUsageFlags       Usage;
+    bool                    IsWrite;
+};
+
+static const RenderGraphAccessInfo ACCESS_INFOS[RENDER_GRAPH_ACCESS_COUNT] = {
+    //COLOR_ATTACHMENT_WRITE. Read as well because of blending
+    { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true },
+    //FRAGMENT_SHADER_READ
+    { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, false },
+    //COMPUTE_SHADER_READ
+    { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, false },
+    //COMPUTE_SHADER_WRITE
+    { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+      VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true },
+    //TRANSFER_READ
+    { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false },
+    //TRANSFER_WRITE
+    { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true },
+    //VERTEX_INPUT_READ. Buffers only
+    { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT,
+      VK_IMAGE_LAYOUT_UNDEFINED, 0, false },
+    //DEPTH_ATTACHMENT_WRITE. Read as well because of the depth test
+    { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true },
+};
+
+RenderGraph::RenderGraph() : m_transientMemorySize(0), m_unaliasedTransientMemorySize(0)
+    , m_cmdBeginRendering(nullptr), m_cmdEndRendering(nullptr)
+{
+    ClearBarriers(&m_finalBarriers);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+RenderGraphResource RenderGraph::ImportImage(const char* name, const VkImage image, const uint32_t layer, 
+        const VkImageView imageView, const VkFormat format, const VkExtent2D& extent,
+        const VkImageLayout initialLayout, const VkPipelineStageFlags initialStage, const VkAccessFlags initialAccess,
+        const VkImageLayout finalLayout, const VkPipelineStageFlags finalStage, const VkAccessFlags finalAccess)
+{
+    Resource resource = {};
+    resource.Name = name;
+    resource.Imported = true;
+    resource.IsBuffer = false;
+    resource.Image = image;
+    resource.Layer = layer;
+    resource.ImageView = imageView;
+    resource.Format = format;
+    resource.Extent = extent;
+    resource.InitialLayout = initialLayout;
+    resource.InitialStage = initialStage;
+    resource.InitialAccess = initialAccess;
+    resource.FinalLayout = finalLayout;
+    resource.FinalStage = finalStage;
+    resource.FinalAccess = finalAccess;
+
+    m_resources.push_back(resource);
+    return static_cast<RenderGraphResource>(m_resources.size() - 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+RenderGraphResource RenderGraph::ImportBuffer(const char* name, const VkBuffer buffer,
+        const VkPipelineStageFlags initialStage, const VkAccessFlags initialAccess,
+        const VkPipelineStageFlags finalStage, const VkAccessFlags finalAccess)
+{
+    Resource resource = {};
+    resource.Name = name;
+    resource.Imported = true;
+    resource.IsBuffer = true;
+    resource.Buffer = buffer;
+    resource.InitialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resource.InitialStage = initialStage;
+    resource.InitialAccess = initialAccess;
+    resource.FinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resource.FinalStage = finalStage;
+    resource.FinalAccess = finalAccess;
+
+    m_resources.push_back(resource);
+    return static_cast<RenderGraphResource>(m_resources.size() - 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+RenderGraphResource RenderGraph::CreateImage(const char* name, const VkFormat format, const VkExtent2D& extent) {
+    Resource resource = {};
+    resource.Name = name;
+    resource.Imported = false;
+    resource.IsBuffer = false;
+    resource.Format = format;
+    resource.Extent = extent;
+    resource.InitialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resource.FinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    m_resources.push_back(resource);
+    return static_cast<RenderGraphResource>(m_resources.size() - 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t RenderGraph::AddPass(const char* name, const RenderGraphExecuteFunc& execute) {
+    Pass pass = {};
+    pass.Name = name;
+    pass.Execute = execute;
+    pass.DepthAttachment = INVALID_RENDER_GRAPH_RESOURCE;
+    pass.ClearDepthAttachment = false;
+    pass.StoreDepthAttachment = false;
+    pass.RenderPass = VK_NULL_HANDLE;
+    pass.FrameBuffer = VK_NULL_HANDLE;
+    ClearBarriers(&pass.BeforeBarriers);
+
+    m_passes.push_back(pass);
+    return static_cast<uint32_t>(m_passes.size() - 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraph::AddColorAttachment(const uint32_t passIndex, const RenderGraphResource resource,
+        const VkClearValue* clearValue)
+{
+    Pass& pass = m_passes[passIndex];
+    pass.ColorAttachments.push_back(resource);
+    pass.ClearColorAttachments.push_back(nullptr != clearValue);
+    pass.ClearValues.push_back(nullptr != clearValue ? *clearValue : VkClearValue());
+    AddWrite(passIndex, resource, RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT_WRITE);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraph::SetDepthAttachment(const uint32_t passIndex, const RenderGraphResource resource,
+        const VkClearValue* clearValue)
+{
+    Pass& pass = m_passes[passIndex];
+    if (INVALID_RENDER_GRAPH_RESOURCE != pass.DepthAttachment) {
+        throw std::runtime_error("failed to set render graph depth attachment: already set!");
+    }
+    pass.DepthAttachment = resource;
+    pass.ClearDepthAttachment = (nullptr != clearValue);
+    pass.DepthClearValue = (nullptr != clearValue) ? *clearValue : VkClearValue();
+    AddWrite(passIndex, resource, RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT_WRITE);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraph::AddRead(const uint32_t passIndex, const RenderGraphResource resource,
+        const RenderGraphAccess access)
+{
+    if (ACCESS_INFOS[access].IsWrite) {
+        throw std::runtime_error("failed to add render graph read: access is a write!");
+    }
+    ResourceUsage usage = { resource, access };
+    m_passes[passIndex].Reads.push_back(usage);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraph::AddWrite(const uint32_t passIndex, const RenderGraphResource resource,
+        const RenderGraphAccess access)
+{
+    if (!ACCESS_INFOS[access].IsWrite) {
+        throw std::runtime_error("failed to add render graph write: access is a read!");
+    }
+    ResourceUsage usage = { resource, access };
+    m_passes[passIndex].Writes.push_back(usage);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraph::EnableDynamicRendering(const VkDevice device) {
+    m_cmdBeginRendering = (PFN_vkCmdBeginRenderingKHR) vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR");
+    m_cmdEndRendering = (PFN_vkCmdEndRenderingKHR) vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR");
+    if (nullptr == m_cmdBeginRendering || nullptr == m_cmdEndRendering) {
+        throw std::runtime_error("failed to load vkCmdBeginRenderingKHR!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The graph can be compiled again: what the previous Compile() has created or accumulated is discarded first
+void RenderGraph::Compile(const VkPhysicalDevice physicalDevice, const VkDevice device,
+        const VkAllocationCallbacks* allocator)
+{
+    DestroyCompiledObjects(device, allocator);
+    for (Resource& resource : m_resources) {
+        resource.Usage = 0;
+    }
+    for (Pass& pass : m_passes) {
+        pass.ClearValues.resize(pass.ColorAttachments.size()); //Without the depth clear value
+        ClearBarriers(&pass.BeforeBarriers);
+    }
+
+    CullPasses();
+    ComputeLifetimes();
+    AllocateTransientImages(physicalDevice, device, allocator);
+    ComputeBarriers();
+    CreateRenderPasses(device, allocator);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraph::Record(const VkCommandBuffer commandBuffer) const {
+    const uint32_t numPasses = static_cast<uint32_t>(m_passes.size());
+    for (uint32_t i = 0; i < numPasses; ++i) {
+        const Pass& pass = m_passes[i];
+        if (pass.Culled)
+            continue;
+
+        RecordBarriers(commandBuffer, pass.BeforeBarriers);
+
+        if (pass.ColorAttachments.empty()) {
+            pass.Execute(commandBuffer);
+            continue;
+        }
+
+        if (nullptr != m_cmdBeginRendering) {
+            BeginRendering(commandBuffer, pass);
+            pass.Execute(commandBuffer);
+            m_cmdEndRendering(commandBuffer);
+            continue;
+        }
+
+        VkRenderPassBeginInfo renderPassInfo = {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = pass.RenderPass;
+        renderPassInfo.framebuffer = pass.FrameBuffer;
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = pass.Extent;
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.ClearValues.size()); //Depth is the last one
+        renderPassInfo.pClearValues = pass.ClearValues.data(); //Ignored for attachments which are loaded
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        pass.Execute(commandBuffer);
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+    RecordBarriers(commandBuffer, m_finalBarriers);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraph::CleanUp(const VkDevice device, const VkAllocationCallbacks* allocator) {
+    DestroyCompiledObjects(device, allocator);
+    m_passes.clear();
+    m_resources.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Keeps the passes and the resources
+void RenderGraph::DestroyCompiledObjects(const VkDevice device, const VkAllocationCallbacks* allocator) {
+    for (Pass& pass : m_passes) {
+        if (VK_NULL_HANDLE != pass.FrameBuffer) {
+            vkDestroyFramebuffer(device, pass.FrameBuffer, allocator);
+            pass.FrameBuffer = VK_NULL_HANDLE;
+        }
+        SAFE_DESTROY_RENDER_PASS(device, pass.RenderPass, allocator);
+    }
+
+    for (Resource& resource : m_resources) {
+        if (resource.Imported)
+            continue;
+
+        SAFE_DESTROY_IMAGE_VIEW(device, resource.ImageView, allocator);
+        SAFE_DESTROY_IMAGE(device, resource.Image, allocator);
+    }
+
+    for (MemoryBlock& block : m_memoryBlocks) {
+        SAFE_FREE_MEMORY(device, block.Memory, allocator);
+    }
+    m_memoryBlocks.clear();
+
+    ClearBarriers(&m_finalBarriers);
+    m_transientMemorySize = 0;
+    m_unaliasedTransientMemorySize = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//A pass is culled if nothing reads what it writes, which includes passes that don't write anything.
+//Imported resources count as being read after the graph. Culling a pass releases the resources it reads, which may
+//cull their writers in turn
+void RenderGraph::CullPasses() {
+    const uint32_t numResources = static_cast<uint32_t>(m_resources.size());
+    const uint32_t numPasses = static_cast<uint32_t>(m_passes.size());
+
+    for (Resource& resource : m_resources) {
+        resource.NumReaders = resource.Imported ? 1 : 0;
+    }
+    for (Pass& pass : m_passes) {
+        pass.Culled = false;
+        pass.RefCount = static_cast<uint32_t>(pass.Writes.size());
+        for (const ResourceUsage& usage : pass.Reads) {
+            ++m_resources[usage.Resource].NumReaders;
+        }
+    }
+
+    std::vector<uint32_t> unreferencedPasses;
+    for (uint32_t i = 0; i < numPasses; ++i) {
+        if (0 == m_passes[i].RefCount) {
+            unreferencedPasses.push_back(i);
+        }
+    }
+    for (uint32_t i = 0; i < numResources; ++i) {
+        if (0 == m_resources[i].NumReaders) {
+            ReleaseWritersInto(i, &unreferencedPasses);
+        }
+    }
+
+    while (!unreferencedPasses.empty()) {
+        Pass& pass = m_passes[unreferencedPasses.back()];
+        unreferencedPasses.pop_back();
+
+        pass.Culled = true;
+        for (const ResourceUsage& usage : pass.Reads) {
+            Resource& readResource = m_resources[usage.Resource];
+            --readResource.NumReaders;
+            if (0 == readResource.NumReaders) {
+                ReleaseWritersInto(usage.Resource, &unreferencedPasses);
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Decrements the RefCount of the passes which write the unreferenced resource, and adds those which reach 0
+void RenderGraph::ReleaseWritersInto(const RenderGraphResource resource, std::vector<uint32_t>* unreferencedPasses) {
+    const uint32_t numPasses = static_cast<uint32_t>(m_passes.size());
+    for (uint32_t i = 0; i < numPasses; ++i) {
+        Pass& pass = m_passes[i];
+        if (0 == pass.RefCount)
+            continue;
+
+        for (const ResourceUsage& usage : pass.Writes) {
+            if (usage.Resource == resource) {
+                --pass.RefCount;
+            }
+        }
+        if (0 == pass.RefCount) {
+            unreferencedPasses->push_back(i);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraph::ComputeLifetimes() {
+    for (Resource& resource : m_resources) {
+        resource.FirstPass = UINT32_MAX;
+        resource.LastPass = 0;
+        resource.MemoryBlock = UINT32_MAX;
+    }
+
+    const uint32_t numPasses = static_cast<uint32_t>(m_passes.size());
+    for (uint32_t i = 0; i < numPasses; ++i) {
+        const Pass& pass = m_passes[i];
+        if (pass.Culled)
+            continue;
+
+        for (uint32_t j = 0; j < 2; ++j) {
+            const std::vector<ResourceUsage>& usages = (0 == j) ? pass.Reads : pass.Writes;
+            for (const ResourceUsage& usage : usages) {
+                Resource& resource = m_resources[usage.Resource];
+                resource.FirstPass = std::min(resource.FirstPass, i);
+                resource.LastPass = std::max(resource.LastPass, i);
+                resource.Usage |= ACCESS_INFOS[usage.Access].Usage;
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Transient images are sorted by size and put into the first memory block whose images are not used at the same time.
+void RenderGraph::AllocateTransientImages(const VkPhysicalDevice physicalDevice, const VkDevice device,
+        const VkAllocationCallbacks* allocator)
+{
+    std::vector<RenderGraphResource> transients;
+    std::vector<VkMemoryRequirements> memRequirements(m_resources.size());
+
+    const uint32_t numResources = static_cast<uint32_t>(m_resources.size());
+    for (uint32_t i = 0; i < numResources; ++i) {
+        Resource& resource = m_resources[i];
+        if (resource.Imported || UINT32_MAX == resource.FirstPass)
+            continue;
+
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = resource.Extent.width;
+        imageInfo.extent.height = resource.Extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = resource.Format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = resource.Usage;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateImage(device, &imageInfo, allocator, &resource.Image) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create render graph image!");
+        }
+        vkGetImageMemoryRequirements(device, resource.Image, &memRequirements[i]);
+        m_unaliasedTransientMemorySize += memRequirements[i].size;
+        transients.push_back(i);
+    }
+
+    std::sort(transients.begin(), transients.end(),
+        [&memRequirements](const RenderGraphResource a, const RenderGraphResource b) {
+            return memRequirements[a].size > memRequirements[b].size;
+        }
+    );
+
+    for (const RenderGraphResource transient : transients) {
+        Resource& resource = m_resources[transient];
+        const VkMemoryRequirements& curRequirements = memRequirements[transient];
+
+        uint32_t blockIndex = 0;
+        const uint32_t numBlocks = static_cast<uint32_t>(m_memoryBlocks.size());
+        for (; blockIndex < numBlocks; ++blockIndex) {
+            const MemoryBlock& block = m_memoryBlocks[blockIndex];
+            if (0 == (block.MemoryTypeBits & curRequirements.memoryTypeBits))
+                continue;
+
+            bool overlapped = false;
+            for (const RenderGraphResource occupant : block.Resources) {
+                const Resource& occupantResource = m_resources[occupant];
+                if (resource.FirstPass <= occupantResource.LastPass
+                    && occupantResource.FirstPass <= resource.LastPass)
+                {
+                    overlapped = true;
+                    break;
+                }
+            }
+            if (!overlapped)
+                break;
+        }
+
+        if (blockIndex == numBlocks) {
+            MemoryBlock block = {};
+            block.Memory = VK_NULL_HANDLE;
+            block.Size = 0;
+            block.MemoryTypeBits = curRequirements.memoryTypeBits;
+            m_memoryBlocks.push_back(block);
+        }
+
+        //All images are bound at offset 0, which satisfies any alignment
+        MemoryBlock& block = m_memoryBlocks[blockIndex];
+        block.Size = std::max(block.Size, curRequirements.size);
+        block.MemoryTypeBits &= curRequirements.memoryTypeBits;
+        block.Resources.push_back(transient);
+        resource.MemoryBlock = blockIndex;
+    }
+
+    for (MemoryBlock& block : m_memoryBlocks) {
+        VkMemoryAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = block.Size;
+        allocInfo.memoryTypeIndex = GraphicsUtility::FindMemoryType(physicalDevice, block.MemoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if (vkAllocateMemory(device, &allocInfo, allocator, &block.Memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate render graph memory!");
+        }
+        m_transientMemorySize += block.Size;
+
+        for (const RenderGraphResource occupant : block.Resources) {
+            Resource& resource = m_resources[occupant];
+            vkBindImageMemory(device, resource.Image, block.Memory, 0);
+            resource.ImageView = GraphicsUtility::CreateImageView(device, allocator, resource.Image, resource.Format);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraph::ComputeBarriers() {
+    std::vector<ResourceState> states(m_resources.size());
+    const uint32_t numResources = static_cast<uint32_t>(m_resources.size());
+    for (uint32_t i = 0; i < numResources; ++i) {
+        const Resource& resource = m_resources[i];
+        ResourceState& state = states[i];
+        state.Layout = resource.InitialLayout;
+        state.WriteStage = resource.InitialStage;
+        state.WriteAccess = resource.InitialAccess;
+        state.ReadStages = 0;
+    }
+    for (MemoryBlock& block : m_memoryBlocks) {
+        block.LastOccupant = INVALID_RENDER_GRAPH_RESOURCE;
+    }
+
+    const uint32_t numPasses = static_cast<uint32_t>(m_passes.size());
+    for (uint32_t i = 0; i < numPasses; ++i) {
+        Pass& pass = m_passes[i];
+        if (pass.Culled)
+            continue;
+
+        //Combine the usages of the same resource, so that there is at most one barrier per resource
+        std::vector<RenderGraphResource> resources;
+        std::vector<RenderGraphAccessInfo> combined;
+        for (uint32_t j = 0; j < 2; ++j) {
+            const std::vector<ResourceUsage>& usages = (0 == j) ? pass.Reads : pass.Writes;
+            for (const ResourceUsage& usage : usages) {
+                const RenderGraphAccessInfo& info = ACCESS_INFOS[usage.Access];
+                const std::vector<RenderGraphResource>::iterator it =
+                    std::find(resources.begin(), resources.end(), usage.Resource);
+                if (it == resources.end()) {
+                    resources.push_back(usage.Resource);
+                    combined.push_back(info);
+                    continue;
+                }
+
+                RenderGraphAccessInfo& curInfo = combined[it - resources.begin()];
+                if (!m_resources[usage.Resource].IsBuffer && curInfo.Layout != info.Layout) {
+                    throw std::runtime_error("failed to compile render graph: conflicting image layouts!");
+                }
+                curInfo.Stage |= info.Stage;
+                curInfo.Access |= info.Access;
+                curInfo.IsWrite |= info.IsWrite;
+            }
+        }
+
+        const uint32_t numUsedResources = static_cast<uint32_t>(resources.size());
+        for (uint32_t j = 0; j < numUsedResources; ++j) {
+            const RenderGraphResource resourceIndex = resources[j];
+            const Resource& resource = m_resources[resourceIndex];
+            ResourceState& state = states[resourceIndex];
+
+            //The first use of a transient image has to wait for the previous image in the same memory
+            if (!resource.Imported && resource.FirstPass == i) {
+                MemoryBlock& block = m_memoryBlocks[resource.MemoryBlock];
+                if (INVALID_RENDER_GRAPH_RESOURCE != block.LastOccupant) {
+                    const ResourceState& prevState = states[block.LastOccupant];
+                    state.WriteStage = prevState.WriteStage | prevState.ReadStages;
+                    state.WriteAccess = prevState.WriteAccess;
+                }
+                block.LastOccupant = resourceIndex;
+            }
+
+            const RenderGraphAccessInfo& info = combined[j];
+            AddBarrierInto(resourceIndex, info.Stage, info.Access, info.Layout, info.IsWrite,
+                &state, &pass.BeforeBarriers);
+        }
+    }
+
+    //Final states of imported resources
+    for (uint32_t i = 0; i < numResources; ++i) {
+        const Resource& resource = m_resources[i];
+        if (!resource.Imported || UINT32_MAX == resource.FirstPass)
+            continue;
+
+        ResourceState& state = states[i];
+        const VkImageLayout finalLayout = (VK_IMAGE_LAYOUT_UNDEFINED == resource.FinalLayout)
+            ? state.Layout : resource.FinalLayout;
+        if (finalLayout == state.Layout && (0 == state.WriteAccess || 0 == resource.FinalAccess))
+            continue;
+
+        AddBarrierInto(i, resource.FinalStage, resource.FinalAccess, finalLayout, false, &state, &m_finalBarriers);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool RenderGraph::AddBarrierInto(const RenderGraphResource resource, const VkPipelineStageFlags stage,
+        const VkAccessFlags access, const VkImageLayout layout, const bool isWrite,
+        ResourceState* state, Barriers* barriers) const
+{
+    const Resource& curResource = m_resources[resource];
+    const bool layoutChanged = !curResource.IsBuffer && state->Layout != layout;
+
+    VkPipelineStageFlags srcStage = 0;
+    VkAccessFlags srcAccess = 0;
+    if (isWrite || layoutChanged) {
+        //WAW, WAR, or a layout transition (which is a write)
+        //The first write of a resource which hasn't been used doesn't wait, but later usages wait for it
+        srcStage = state->WriteStage | state->ReadStages;
+        srcAccess = state->WriteAccess;
+        state->WriteStage = stage;
+        state->WriteAccess = isWrite ? access : 0;
+        state->ReadStages = isWrite ? 0 : stage;
+        if (!layoutChanged && 0 == srcStage)
+            return false;
+    } else {
+        //RAW. Readers which already waited for the last write don't need another barrier
+        if (0 == state->WriteStage || (state->ReadStages & stage) == stage)
+            return false;
+
+        srcStage = state->WriteStage;
+        srcAccess = state->WriteAccess;
+        state->ReadStages |= stage;
+    }
+
+    barriers->SrcStages |= (0 != srcStage) ? srcStage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    barriers->DstStages |= stage;
+
+    if (curResource.IsBuffer) {
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = access;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = curResource.Buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        barriers->BufferBarriers.push_back(barrier);
+        return true;
+    }
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = access;
+    barrier.oldLayout = state->Layout;
+    barrier.newLayout = layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = curResource.Image;
+    barrier.subresourceRange.aspectMask = GraphicsUtility::GetImageAspectFlags(curResource.Format);
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = curResource.Layer;
+    barrier.subresourceRange.layerCount = 1;
+    barriers->ImageBarriers.push_back(barrier);
+
+    state->Layout = layout;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Whether the contents of the depth attachment are used after the pass
+bool RenderGraph::IsDepthAttachmentStored(const uint32_t passIndex) const {
+    const Resource& resource = m_resources[m_passes[passIndex].DepthAttachment];
+    return resource.LastPass > passIndex || (resource.Imported && 0 != resource.FinalAccess);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Layout transitions are done by the barriers, so the attachments stay in VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+//or VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL for the depth attachment, which comes after the colors
+void RenderGraph::CreateRenderPasses(const VkDevice device, const VkAllocationCallbacks* allocator) {
+    const uint32_t numPasses = static_cast<uint32_t>(m_passes.size());
+    for (uint32_t passIndex = 0; passIndex < numPasses; ++passIndex) {
+        Pass& pass = m_passes[passIndex];
+        if (pass.Culled || pass.ColorAttachments.empty())
+            continue;
+
+        const uint32_t numColorAttachments = static_cast<uint32_t>(pass.ColorAttachments.size());
+        const bool hasDepth = (INVALID_RENDER_GRAPH_RESOURCE != pass.DepthAttachment);
+        const uint32_t numAttachments = numColorAttachments + (hasDepth ? 1 : 0);
+        std::vector<VkAttachmentDescription> attachments(numAttachments);
+        std::vector<VkAttachmentReference> colorReferences(numColorAttachments);
+        std::vector<VkImageView> imageViews(numAttachments);
+        pass.Extent = m_resources[pass.ColorAttachments[0]].Extent;
+
+        for (uint32_t i = 0; i < numColorAttachments; ++i) {
+            const Resource& resource = m_resources[pass.ColorAttachments[i]];
+            if (resource.Extent.width != pass.Extent.width || resource.Extent.height != pass.Extent.height) {
+                throw std::runtime_error("failed to create render graph pass: attachments have different extents!");
+            }
+
+            VkAttachmentDescription& attachment = attachments[i];
+            attachment.format = resource.Format;
+            attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            attachment.loadOp = pass.ClearColorAttachments[i] ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+            attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            colorReferences[i].attachment = i;
+            colorReferences[i].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            imageViews[i] = resource.ImageView;
+        }
+
+        VkAttachmentReference depthReference = { numColorAttachments, 
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+        if (hasDepth) {
+            const Resource& resource = m_resources[pass.DepthAttachment];
+            if (resource.Extent.width != pass.Extent.width || resource.Extent.height != pass.Extent.height) {
+                throw std::runtime_error("failed to create render graph pass: attachments have different extents!");
+            }
+            pass.StoreDepthAttachment = IsDepthAttachmentStored(passIndex);
+            pass.ClearValues.push_back(pass.DepthClearValue);
+
+            VkAttachmentDescription& attachment = attachments[numColorAttachments];
+            attachment.format = resource.Format;
+            attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            attachment.loadOp = pass.ClearDepthAttachment ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+            attachment.storeOp = pass.StoreDepthAttachment ? VK_ATTACHMENT_STORE_OP_STORE 
+                : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            imageViews[numColorAttachments] = resource.ImageView;
+        }
+
+        //Dynamic rendering: recorded directly on the image views
+        if (nullptr != m_cmdBeginRendering)
+            continue;
+
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = numColorAttachments;
+        subpass.pColorAttachments = colorReferences.data();
+        subpass.pDepthStencilAttachment = hasDepth ? &depthReference : nullptr;
+
+        VkRenderPassCreateInfo renderPassInfo = {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = numAttachments;
+        renderPassInfo.pAttachments = attachments.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = 0; //Handled by the barriers before the pass
+        renderPassInfo.pDependencies = nullptr;
+
+        if (vkCreateRenderPass(device, &renderPassInfo, allocator, &pass.RenderPass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create render graph render pass!");
+        }
+
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = pass.RenderPass;
+        framebufferInfo.attachmentCount = numAttachments;
+        framebufferInfo.pAttachments = imageViews.data();
+        framebufferInfo.width = pass.Extent.width;
+        framebufferInfo.height = pass.Extent.height;
+        framebufferInfo.layers = 1;
+
+        if (vkCreateFramebuffer(device, &framebufferInfo, allocator, &pass.FrameBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create render graph framebuffer!");
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The barriers before the pass have already transitioned the attachments to their attachment layouts
+void RenderGraph::BeginRendering(const VkCommandBuffer commandBuffer, const Pass& pass) const {
+    const uint32_t numAttachments = static_cast<uint32_t>(pass.ColorAttachments.size());
+    std::vector<VkRenderingAttachmentInfoKHR> colorAttachments(numAttachments);
+    for (uint32_t i = 0; i < numAttachments; ++i) {
+        VkRenderingAttachmentInfoKHR& attachment = colorAttachments[i];
+        attachment = {};
+        attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        attachment.imageView = m_resources[pass.ColorAttachments[i]].ImageView;
+        attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachment.resolveMode = VK_RESOLVE_MODE_NONE_KHR;
+        attachment.loadOp = pass.ClearColorAttachments[i] ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachment.clearValue = pass.ClearValues[i];
+    }
+
+    VkRenderingAttachmentInfoKHR depthAttachment = {};
+    const bool hasDepth = (INVALID_RENDER_GRAPH_RESOURCE != pass.DepthAttachment);
+    if (hasDepth) {
+        depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        depthAttachment.imageView = m_resources[pass.DepthAttachment].ImageView;
+        depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.resolveMode = VK_RESOLVE_MODE_NONE_KHR;
+        depthAttachment.loadOp = pass.ClearDepthAttachment ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+        depthAttachment.storeOp = pass.StoreDepthAttachment ? VK_ATTACHMENT_STORE_OP_STORE 
+            : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.clearValue = pass.DepthClearValue;
+    }
+
+    VkRenderingInfoKHR renderingInfo = {};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    renderingInfo.renderArea.offset = {0, 0};
+    renderingInfo.renderArea.extent = pass.Extent;
+    renderingInfo.layerCount = 1;
+    renderingInfo.colorAttachmentCount = numAttachments;
+    renderingInfo.pColorAttachments = colorAttachments.data();
+    renderingInfo.pDepthAttachment = hasDepth ? &depthAttachment : nullptr;
+    m_cmdBeginRendering(commandBuffer, &renderingInfo);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraph::RecordBarriers(const VkCommandBuffer commandBuffer, const Barriers& barriers) {
+    if (barriers.ImageBarriers.empty() && barriers.BufferBarriers.empty())
+        return;
+
+    vkCmdPipelineBarrier(commandBuffer, barriers.SrcStages, barriers.DstStages, 0,
+        0, nullptr,
+        static_cast<uint32_t>(barriers.BufferBarriers.size()), barriers.BufferBarriers.data(),
+        static_cast<uint32_t>(barriers.ImageBarriers.size()), barriers.ImageBarriers.data()
+    );
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraph::ClearBarriers(Barriers* barriers) {
+    barriers->SrcStages = 0;
+    barriers->DstStages = 0;
+    barriers->ImageBarriers.clear();
+    barriers->BufferBarriers.clear();
+}
+
+} //end namespace
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <functional>
+
+namespace Shin {
+
+typedef uint32_t RenderGraphResource; //Index of a resource in the graph
+const RenderGraphResource INVALID_RENDER_GRAPH_RESOURCE = UINT32_MAX;
+
+//How a pass uses a resource. Decides the layout, pipeline stage and access mask of the barriers
+enum RenderGraphAccess {
+    RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT_WRITE = 0, //Added by AddColorAttachment()
+    RENDER_GRAPH_ACCESS_FRAGMENT_SHADER_READ,       //Sampled image, uniform/storage buffer
+    RENDER_GRAPH_ACCESS_COMPUTE_SHADER_READ,
+    RENDER_GRAPH_ACCESS_COMPUTE_SHADER_WRITE,       //Storage image/buffer
+    RENDER_GRAPH_ACCESS_TRANSFER_READ,
+    RENDER_GRAPH_ACCESS_TRANSFER_WRITE,
+    RENDER_GRAPH_ACCESS_VERTEX_INPUT_READ,          //Vertex/index buffer
+    RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT_WRITE,     //Added by SetDepthAttachment()
+    RENDER_GRAPH_ACCESS_COUNT,
+};
+
+//Records the commands of a pass. Raster passes are called inside the render pass created by the graph
+typedef std::function<void(const VkCommandBuffer)> RenderGraphExecuteFunc;
+
+//Passes declare the resources they read and write, and are executed in the order they are added.
+//Compile() then:
+//1. Culls the passes whose results are not used by other passes or imported resources, which includes the passes
+//   that don't write anything
+//2. Computes the barriers before each pass and batches them into one vkCmdPipelineBarrier
+//3. Creates the transient images, aliasing the memory of those whose lifetimes don't overlap
+//4. Creates the render passes and framebuffers of raster passes. The render passes are compatible with
+//   other render passes which have the same attachment formats, so they can be used with existing pipelines.
+//   With dynamic rendering, nothing is created: the raster passes are recorded directly on the image views
+//
+//The imported resources are fixed after Compile().
+//For per-image resources (swap chain images, etc), use one graph per image.
+class RenderGraph {
+public:
+    //Batched into one vkCmdPipelineBarrier
+    struct Barriers {
+        VkPipelineStageFlags                SrcStages;
+        VkPipelineStageFlags                DstStages;
+        std::vector<VkImageMemoryBarrier>   ImageBarriers;
+        std::vector<VkBufferMemoryBarrier>  BufferBarriers;
+    };
+
+    RenderGraph();
+
+    //layer: the array layer of image which imageView refers to.
+    //initialStage/initialAccess: the last usage before the graph is executed, e.g.
+    //VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT for swap chain images acquired with a semaphore.
+    //finalLayout/finalStage/finalAccess: the state after the graph is executed
+    RenderGraphResource ImportImage(const char* name, const VkImage image, const uint32_t layer, 
+        const VkImageView imageView, const VkFormat format, const VkExtent2D& extent,
+        const VkImageLayout initialLayout, const VkPipelineStageFlags initialStage, const VkAccessFlags initialAccess,
+        const VkImageLayout finalLayout, const VkPipelineStageFlags finalStage, const VkAccessFlags finalAccess);
+
+    RenderGraphResource ImportBuffer(const char* name, const VkBuffer buffer,
+        const VkPipelineStageFlags initialStage, const VkAccessFlags initialAccess,
+        const VkPipelineStageFlags finalStage, const VkAccessFlags finalAccess);
+
+    //Transient: only lives inside the graph, and may share memory with other transient images
+    RenderGraphResource CreateImage(const char* name, const VkFormat format, const VkExtent2D& extent);
+
+    uint32_t AddPass(const char* name, const RenderGraphExecuteFunc& execute);
+
+    //Makes the pass a raster pass. clearValue: nullptr to load the previous contents
+    void AddColorAttachment(const uint32_t passIndex, const RenderGraphResource resource,
+        const VkClearValue* clearValue);
+
+    //Must have the extent of the color attachments. clearValue: nullptr to load the previous contents.
+    //The contents are only stored if a later pass, or an imported resource, needs them (finalAccess is not 0)
+    void SetDepthAttachment(const uint32_t passIndex, const RenderGraphResource resource,
+        const VkClearValue* clearValue);
+    void AddRead(const uint32_t passIndex, const RenderGraphResource resource, const RenderGraphAccess access);
+    void AddWrite(const uint32_t passIndex, const RenderGraphResource resource, const RenderGraphAccess access);
+
+    //Records the raster passes with vkCmdBeginRenderingKHR instead of render passes and framebuffers.
+    //VK_KHR_dynamic_rendering must be enabled. Kept after CleanUp()
+    void EnableDynamicRendering(const VkDevice device);
+
+    //Can be called again: the objects of the previous Compile() are destroyed
+    void Compile(const VkPhysicalDevice physicalDevice, const VkDevice device,
+        const VkAllocationCallbacks* allocator);
+    void Record(const VkCommandBuffer commandBuffer) const;
+
+    //Destroys the created objects and removes all passes and resources
+    void CleanUp(const VkDevice device, const VkAllocationCallbacks* allocator);
+
+    inline bool IsPassCulled(const uint32_t passIndex) const;
+    inline VkRenderPass GetRenderPass(const uint32_t passIndex) const; //VK_NULL_HANDLE with dynamic rendering
+    inline VkImage GetImage(const RenderGraphResource resource) const;
+    inline VkImageView GetImageView(const RenderGraphResource resource) const;
+    inline const Barriers& GetBarriers(const uint32_t passIndex) const; //Recorded before the pass
+    inline const Barriers& GetFinalBarriers() const;
+    inline VkDeviceSize GetTransientMemorySize() const;
+    inline VkDeviceSize GetUnaliasedTransientMemorySize() const;
+
+private:
+
+    struct ResourceUsage {
+        RenderGraphResource Resource;
+        RenderGraphAccess   Access;
+    };
+
+    struct Resource {
+        std::string             Name;
+        bool                    Imported;
+        bool                    IsBuffer;
+
+        VkImage                 Image;
+        uint32_t                Layer;
+        VkImageView             ImageView;
+        VkFormat                Format;
+        VkExtent2D              Extent;
+        VkImageUsageFlags       Usage;  //Transient only
+        VkBuffer                Buffer;
+
+        VkImageLayout           InitialLayout;
+        VkPipelineStageFlags    InitialStage;
+        VkAccessFlags           InitialAccess;
+        VkImageLayout           FinalLayout;
+        VkPipelineStageFlags    FinalStage;
+        VkAccessFlags           FinalAccess;
+
+        //Compile
+        uint32_t                NumReaders;
+        uint32_t                FirstPass;   //Lifetime of transient images
+        uint32_t                LastPass;
+        uint32_t                MemoryBlock;
+    };
+
+    //The state of a resource while the passes are being processed
+    struct ResourceState {
+        VkImageLayout           Layout;
+        VkPipelineStageFlags    WriteStage;  //The last write or layout transition
+        VkAccessFlags           WriteAccess;
+        VkPipelineStageFlags    ReadStages;  //Stages which have already waited for the last write
+    };
+
+    struct Pass {
+        std::string                 Name;
+        RenderGraphExecuteFunc      Execute;
+        std::vector<ResourceUsage>  Reads;
+        std::vector<ResourceUsage>  Writes;
+        std::vector<RenderGraphResource> ColorAttachments;
+        std::vector<VkClearValue>   ClearValues;
+        std::vector<bool>           ClearColorAttachments;  //false: load
+        RenderGraphResource         DepthAttachment;        //INVALID_RENDER_GRAPH_RESOURCE if none
+        VkClearValue                DepthClearValue;
+        bool                        ClearDepthAttachment;
+        bool                        StoreDepthAttachment;   //Compile
+
+        //Compile
+        uint32_t                    RefCount;
+        bool                        Culled;
+        VkRenderPass                RenderPass;
+        VkFramebuffer               FrameBuffer;
+        VkExtent2D                  Extent;
+        Barriers                    BeforeBarriers;
+    };
+
+    struct MemoryBlock {
+        VkDeviceMemory          Memory;
+        VkDeviceSize            Size;
+        uint32_t                MemoryTypeBits;
+        std::vector<RenderGraphResource> Resources;
+        RenderGraphResource     LastOccupant; //Used while computing barriers
+    };
+
+    void DestroyCompiledObjects(const VkDevice device, const VkAllocationCallbacks* allocator);
+    void CullPasses();
+    void ReleaseWritersInto(const RenderGraphResource resource, std::vector<uint32_t>* unreferencedPasses);
+    void ComputeLifetimes();
+    void AllocateTransientImages(const VkPhysicalDevice physicalDevice, const VkDevice device, 
+        const VkAllocationCallbacks* allocator);
+    void ComputeBarriers();
+    void CreateRenderPasses(const VkDevice device, const VkAllocationCallbacks* allocator);
+    void BeginRendering(const VkCommandBuffer commandBuffer, const Pass& pass) const;
+    bool IsDepthAttachmentStored(const uint32_t passIndex) const;
+
+    //Returns true if a barrier was added
+    bool AddBarrierInto(const RenderGraphResource resource, const VkPipelineStageFlags stage, 
+        const VkAccessFlags access, const VkImageLayout layout, const bool isWrite, 
+        ResourceState* state, Barriers* barriers) const;
+    static void RecordBarriers(const VkCommandBuffer commandBuffer, const Barriers& barriers);
+    static void ClearBarriers(Barriers* barriers);
+
+    std::vector<Resource>       m_resources;
+    std::vector<Pass>           m_passes;
+    std::vector<MemoryBlock>    m_memoryBlocks;
+    Barriers                    m_finalBarriers; //Transitions the imported resources to their final states
+
+    VkDeviceSize                m_transientMemorySize;
+    VkDeviceSize                m_unaliasedTransientMemorySize;
+
+    PFN_vkCmdBeginRenderingKHR  m_cmdBeginRendering; //Not null with dynamic rendering
+    PFN_vkCmdEndRenderingKHR    m_cmdEndRendering;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool RenderGraph::IsPassCulled(const uint32_t passIndex) const { return m_passes[passIndex].Culled; }
+VkRenderPass RenderGraph::GetRenderPass(const uint32_t passIndex) const { return m_passes[passIndex].RenderPass; }
+VkImage RenderGraph::GetImage(const RenderGraphResource resource) const { return m_resources[resource].Image; }
+VkImageView RenderGraph::GetImageView(const RenderGraphResource resource) const { 
+    return m_resources[resource].ImageView; 
+}
+const RenderGraph::Barriers& RenderGraph::GetBarriers(const uint32_t passIndex) const {
+    return m_passes[passIndex].BeforeBarriers;
+}
+const RenderGraph::Barriers& RenderGraph::GetFinalBarriers() const { return m_finalBarriers; }
+VkDeviceSize RenderGraph::GetTransientMemorySize() const { return m_transientMemorySize; }
+VkDeviceSize RenderGraph::GetUnaliasedTransientMemorySize() const { return m_unaliasedTransientMemorySize; }
+
+
+} //end namespace
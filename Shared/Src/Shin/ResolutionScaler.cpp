@@ -0,0 +1,92 @@
+#include "ResolutionScaler.h"
+#include <algorithm> //std::min, std::max
+#include <cmath>     //std::sqrt
+
+namespace Shin {
+
+//Covers the frames which were recorded with the previous extent, and are still in flight
+const uint32_t NUM_IGNORED_SAMPLES_AFTER_CHANGE = 8;
+
+const uint32_t NUM_FRAMES_TO_SCALE_DOWN = 3;
+const uint32_t NUM_FRAMES_TO_SCALE_UP   = 60;
+const float    SCALE_UP_THRESHOLD       = 0.7f;  //Of the budget
+const float    SCALE_UP_STEP            = 0.05f;
+const float    AVERAGE_WEIGHT           = 0.2f;  //Of the new sample
+const uint32_t EXTENT_ALIGNMENT         = 8;     //Pixels. Also keeps the extent even for the encoder
+
+//---------------------------------------------------------------------------------------------------------------------
+
+ResolutionScaler::ResolutionScaler() : m_budgetMs(0.0f), m_minScale(1.0f), m_scale(1.0f), m_averageMs(0.0f)
+    , m_numIgnoredSamples(0), m_numFramesOverBudget(0), m_numFramesUnderBudget(0)
+{
+    m_maxExtent = { 0, 0 };
+    m_extent = { 0, 0 };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ResolutionScaler::Init(const VkExtent2D& maxExtent, const float budgetMs, const float minScale) {
+    m_maxExtent = maxExtent;
+    m_budgetMs = budgetMs;
+    m_minScale = minScale;
+    SetScale(1.0f);
+    m_numIgnoredSamples = 0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool ResolutionScaler::AddGPUTime(const float gpuTimeMs) {
+    if (m_numIgnoredSamples > 0) {
+        --m_numIgnoredSamples;
+        return false;
+    }
+
+    m_averageMs = (m_averageMs <= 0.0f) ? gpuTimeMs : (m_averageMs + (gpuTimeMs - m_averageMs) * AVERAGE_WEIGHT);
+
+    if (m_averageMs > m_budgetMs) {
+        m_numFramesUnderBudget = 0;
+        ++m_numFramesOverBudget;
+    } else if (m_averageMs < m_budgetMs * SCALE_UP_THRESHOLD) {
+        m_numFramesOverBudget = 0;
+        ++m_numFramesUnderBudget;
+    } else {
+        m_numFramesOverBudget = 0;
+        m_numFramesUnderBudget = 0;
+    }
+
+    float scale = m_scale;
+    if (m_numFramesOverBudget >= NUM_FRAMES_TO_SCALE_DOWN && m_scale > m_minScale) {
+        //The GPU time is roughly proportional to the number of pixels: the square of the scale
+        scale = std::max(m_minScale, m_scale * std::sqrt(m_budgetMs / m_averageMs));
+    } else if (m_numFramesUnderBudget >= NUM_FRAMES_TO_SCALE_UP && m_scale < 1.0f) {
+        scale = std::min(1.0f, m_scale + SCALE_UP_STEP);
+    } else {
+        return false;
+    }
+
+    const VkExtent2D prevExtent = m_extent;
+    SetScale(scale);
+    m_numIgnoredSamples = NUM_IGNORED_SAMPLES_AFTER_CHANGE;
+    return (prevExtent.width != m_extent.width || prevExtent.height != m_extent.height);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ResolutionScaler::SetScale(const float scale) {
+    m_scale = scale;
+    m_averageMs = 0.0f;
+    m_numFramesOverBudget = 0;
+    m_numFramesUnderBudget = 0;
+
+    if (scale >= 1.0f) {
+        m_extent = m_maxExtent;
+        return;
+    }
+
+    const uint32_t width  = static_cast<uint32_t>(static_cast<float>(m_maxExtent.width) * scale);
+    const uint32_t height = static_cast<uint32_t>(static_cast<float>(m_maxExtent.height) * scale);
+    m_extent.width  = std::min(m_maxExtent.width,  std::max(EXTENT_ALIGNMENT, width / EXTENT_ALIGNMENT * EXTENT_ALIGNMENT));
+    m_extent.height = std::min(m_maxExtent.height, std::max(EXTENT_ALIGNMENT, height / EXTENT_ALIGNMENT * EXTENT_ALIGNMENT));
+}
+
+} //end namespace
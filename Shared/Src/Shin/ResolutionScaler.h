@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+
+namespace Shin {
+
+//Chooses the extent to render at, inside a render target of maxExtent, from the GPU time of the rendering.
+//The scale goes down after a few frames over the budget, and up by small steps after many frames well under it,
+//so that it doesn't oscillate around the budget.
+//The samples of the frames recorded before a change are ignored.
+class ResolutionScaler {
+public:
+    ResolutionScaler();
+
+    //minScale: the smallest scale of each dimension
+    void Init(const VkExtent2D& maxExtent, const float budgetMs, const float minScale);
+
+    //Returns true if the extent has changed
+    bool AddGPUTime(const float gpuTimeMs);
+
+    inline VkExtent2D GetExtent() const;
+    inline VkExtent2D GetMaxExtent() const;
+    inline float GetScale() const;
+    inline float GetAverageGPUTimeMs() const;
+
+private:
+    void SetScale(const float scale);
+
+    VkExtent2D  m_maxExtent;
+    VkExtent2D  m_extent;
+    float       m_budgetMs;
+    float       m_minScale;
+    float       m_scale;
+
+    float       m_averageMs;            //Exponential moving average since the last change
+    uint32_t    m_numIgnoredSamples;    //Left to ignore after a change
+    uint32_t    m_numFramesOverBudget;
+    uint32_t    m_numFramesUnderBudget;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkExtent2D ResolutionScaler::GetExtent() const { return m_extent; }
+VkExtent2D ResolutionScaler::GetMaxExtent() const { return m_maxExtent; }
+float ResolutionScaler::GetScale() const { return m_scale; }
+float ResolutionScaler::GetAverageGPUTimeMs() const { return m_averageMs; }
+
+} //end namespace
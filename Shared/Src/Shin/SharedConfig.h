@@ -5,3 +5,6 @@
 #define ENABLE_VULKAN_DEBUG
 
 #endif //NDEBUG
+
+//Uncomment to compile in the CPU profiler (Shin/Profiler.h). When disabled, the profiling macros expand to nothing.
+//#define ENABLE_SHIN_PROFILER
@@ -0,0 +1,320 @@
+#include "SharedFrameRing.h"
+#include <stdexcept> //std::runtime_error
+#include <chrono>
+#include <cstring>   //memcpy
+#include <new>       //placement new
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>    //O_CREAT
+#include <sys/mman.h> //shm_open, mmap
+#include <sys/stat.h> //fstat
+#include <unistd.h>   //ftruncate, close
+#endif
+
+namespace Shin {
+
+//The atomics are used across processes
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "std::atomic<uint64_t> must not have a lock");
+
+//---------------------------------------------------------------------------------------------------------------------
+
+static uint64_t AlignUp(const uint64_t value, const uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+SharedFrameRing::SharedFrameRing() : m_producer(false), m_memory(nullptr), m_size(0), m_header(nullptr)
+    , m_writeSequence(0), m_writeExtent()
+#ifdef _WIN32
+    , m_mapping(nullptr)
+#else
+    , m_fd(-1)
+#endif
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void SharedFrameRing::Create(const std::string& name, const VkExtent2D& maxExtent, const VkFormat format,
+    const uint32_t numSlots)
+{
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB: {
+            break;
+        }
+        default: {
+            throw std::runtime_error("failed to create shared frame ring: unsupported format!");
+        }
+    }
+
+    const uint64_t slotSize = AlignUp(static_cast<uint64_t>(maxExtent.width) * maxExtent.height * 4,
+        SHARED_FRAME_SLOT_ALIGNMENT);
+    uint64_t dataOffset = 0;
+    const uint64_t size = GetSharedMemorySize(numSlots, slotSize, &dataOffset);
+
+    m_producer = true;
+    MapSharedMemory(name, size, true);
+
+    //The new memory is zeroed: all the slots have never been written
+    SharedFrameRingHeader* header = reinterpret_cast<SharedFrameRingHeader*>(m_memory);
+    header->Version = SHARED_FRAME_RING_VERSION;
+    header->NumSlots = numSlots;
+    header->Format = static_cast<uint32_t>(format);
+    header->MaxWidth = maxExtent.width;
+    header->MaxHeight = maxExtent.height;
+    header->SlotSize = slotSize;
+    header->DataOffset = dataOffset;
+    new (&header->NumPublished) std::atomic<uint64_t>(0);
+    for (uint32_t i = 0; i < numSlots; ++i) {
+        new (&(reinterpret_cast<SharedFrameSlotHeader*>(m_memory + sizeof(SharedFrameRingHeader)) + i)->Sequence)
+            std::atomic<uint64_t>(0);
+    }
+
+    //Consumers which open it early see a wrong magic until the rest has been written
+    std::atomic_thread_fence(std::memory_order_release);
+    header->Magic = SHARED_FRAME_RING_MAGIC;
+    m_header = header;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void SharedFrameRing::Open(const std::string& name) {
+    m_producer = false;
+    MapSharedMemory(name, 0, false);
+
+    SharedFrameRingHeader* header = reinterpret_cast<SharedFrameRingHeader*>(m_memory);
+    if (m_size < sizeof(SharedFrameRingHeader) || SHARED_FRAME_RING_MAGIC != header->Magic) {
+        Close();
+        throw std::runtime_error("failed to open shared frame ring: not initialized!");
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    uint64_t dataOffset = 0;
+    if (SHARED_FRAME_RING_VERSION != header->Version
+        || m_size < GetSharedMemorySize(header->NumSlots, header->SlotSize, &dataOffset)
+        || dataOffset != header->DataOffset)
+    {
+        Close();
+        throw std::runtime_error("failed to open shared frame ring: unsupported layout!");
+    }
+    m_header = header;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The producer removes the name. Consumers which have it open keep the memory until they close it
+void SharedFrameRing::Close() {
+#ifdef _WIN32
+    if (nullptr != m_memory) {
+        UnmapViewOfFile(m_memory);
+    }
+    if (nullptr != m_mapping) {
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+        m_mapping = nullptr;
+    }
+#else
+    if (nullptr != m_memory) {
+        munmap(m_memory, static_cast<size_t>(m_size));
+    }
+    if (m_fd >= 0) {
+        if (m_producer) {
+            shm_unlink(m_name.c_str());
+        }
+        close(m_fd);
+        m_fd = -1;
+    }
+#endif
+    m_memory = nullptr;
+    m_header = nullptr;
+    m_size = 0;
+    m_name.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint8_t* SharedFrameRing::BeginWrite(const VkExtent2D& extent, uint32_t* rowPitch) {
+    if (extent.width > m_header->MaxWidth || extent.height > m_header->MaxHeight) {
+        throw std::runtime_error("failed to write shared frame: extent is too large!");
+    }
+
+    //Only the producer changes NumPublished
+    m_writeSequence = m_header->NumPublished.load(std::memory_order_relaxed);
+    m_writeExtent = extent;
+    BeginWriteInPlace(m_writeSequence);
+
+    *rowPitch = extent.width * 4;
+    return GetSlotData(static_cast<uint32_t>(m_writeSequence % m_header->NumSlots));
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void SharedFrameRing::EndWrite(const uint64_t frameIndex) {
+    EndWriteInPlace(m_writeSequence, m_writeExtent, m_writeExtent.width * 4, frameIndex);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Marks the slot as being written before any of its data changes
+void SharedFrameRing::BeginWriteInPlace(const uint64_t sequence) {
+    const uint32_t slot = static_cast<uint32_t>(sequence % m_header->NumSlots);
+    GetSlotHeader(slot)->Sequence.store(sequence * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void SharedFrameRing::EndWriteInPlace(const uint64_t sequence, const VkExtent2D& extent, const uint32_t rowPitch,
+    const uint64_t frameIndex)
+{
+    if (sequence != m_header->NumPublished.load(std::memory_order_relaxed)) {
+        throw std::runtime_error("failed to publish shared frame: out of order!");
+    }
+    if (extent.width > m_header->MaxWidth || extent.height > m_header->MaxHeight 
+        || static_cast<uint64_t>(rowPitch) * extent.height > m_header->SlotSize) 
+    {
+        throw std::runtime_error("failed to publish shared frame: extent is too large!");
+    }
+
+    const uint32_t slot = static_cast<uint32_t>(sequence % m_header->NumSlots);
+    SharedFrameSlotHeader* slotHeader = GetSlotHeader(slot);
+    slotHeader->Width = extent.width;
+    slotHeader->Height = extent.height;
+    slotHeader->RowPitch = rowPitch;
+    slotHeader->FrameIndex = frameIndex;
+    slotHeader->TimestampNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+
+    slotHeader->Sequence.store(sequence * 2 + 2, std::memory_order_release);
+    m_header->NumPublished.store(sequence + 1, std::memory_order_release);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void SharedFrameRing::Publish(const uint8_t* data, const uint32_t srcRowPitch, const VkExtent2D& extent,
+    const uint64_t frameIndex)
+{
+    uint32_t dstRowPitch = 0;
+    uint8_t* dst = BeginWrite(extent, &dstRowPitch);
+    if (srcRowPitch == dstRowPitch) {
+        memcpy(dst, data, static_cast<size_t>(dstRowPitch) * extent.height);
+    } else {
+        for (uint32_t y = 0; y < extent.height; ++y) {
+            memcpy(dst + static_cast<size_t>(y) * dstRowPitch, data + static_cast<size_t>(y) * srcRowPitch,
+                dstRowPitch);
+        }
+    }
+    EndWrite(frameIndex);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint64_t SharedFrameRing::GetNumPublished() const {
+    return m_header->NumPublished.load(std::memory_order_acquire);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool SharedFrameRing::BeginRead(const uint64_t sequence, SharedFrameView* view) const {
+    if (sequence >= m_header->NumPublished.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    const uint32_t slot = static_cast<uint32_t>(sequence % m_header->NumSlots);
+    const SharedFrameSlotHeader* slotHeader = GetSlotHeader(slot);
+    if (slotHeader->Sequence.load(std::memory_order_acquire) != sequence * 2 + 2) {
+        return false;
+    }
+
+    view->Data = GetSlotData(slot);
+    view->RowPitch = slotHeader->RowPitch;
+    view->Extent = { slotHeader->Width, slotHeader->Height };
+    view->FrameIndex = slotHeader->FrameIndex;
+    view->TimestampNs = slotHeader->TimestampNs;
+    view->Sequence = sequence;
+
+    //The fields may have been read while being overwritten
+    return EndRead(*view);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool SharedFrameRing::EndRead(const SharedFrameView& view) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint32_t slot = static_cast<uint32_t>(view.Sequence % m_header->NumSlots);
+    return GetSlotHeader(slot)->Sequence.load(std::memory_order_relaxed) == view.Sequence * 2 + 2;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint64_t SharedFrameRing::GetSharedMemorySize(const uint32_t numSlots, const uint64_t slotSize,
+    uint64_t* dataOffset)
+{
+    *dataOffset = AlignUp(sizeof(SharedFrameRingHeader) + sizeof(SharedFrameSlotHeader) * numSlots,
+        SHARED_FRAME_SLOT_ALIGNMENT);
+    return *dataOffset + slotSize * numSlots;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//size: only used when creating. Consumers map it read only
+void SharedFrameRing::MapSharedMemory(const std::string& name, const uint64_t size, const bool create) {
+    m_name = name;
+
+#ifdef _WIN32
+    if (create) {
+        m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFF), name.c_str());
+    } else {
+        m_mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+    }
+    if (nullptr == m_mapping) {
+        throw std::runtime_error("failed to open shared memory!");
+    }
+
+    m_memory = static_cast<uint8_t*>(MapViewOfFile(static_cast<HANDLE>(m_mapping),
+        create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0));
+    if (nullptr == m_memory) {
+        Close();
+        throw std::runtime_error("failed to map shared memory!");
+    }
+
+    MEMORY_BASIC_INFORMATION info = {};
+    VirtualQuery(m_memory, &info, sizeof(info));
+    m_size = create ? size : static_cast<uint64_t>(info.RegionSize);
+#else
+    if (create) {
+        //Left behind by a producer which crashed. Consumers which still have it open keep their memory
+        shm_unlink(name.c_str());
+        m_fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        if (m_fd < 0 || 0 != ftruncate(m_fd, static_cast<off_t>(size))) {
+            Close();
+            throw std::runtime_error("failed to create shared memory!");
+        }
+        m_size = size;
+    } else {
+        m_fd = shm_open(name.c_str(), O_RDONLY, 0);
+        struct stat fileStat = {};
+        if (m_fd < 0 || 0 != fstat(m_fd, &fileStat)) {
+            Close();
+            throw std::runtime_error("failed to open shared memory!");
+        }
+        m_size = static_cast<uint64_t>(fileStat.st_size);
+    }
+
+    void* memory = mmap(nullptr, static_cast<size_t>(m_size), create ? (PROT_READ | PROT_WRITE) : PROT_READ,
+        MAP_SHARED, m_fd, 0);
+    if (MAP_FAILED == memory) {
+        Close();
+        throw std::runtime_error("failed to map shared memory!");
+    }
+    m_memory = static_cast<uint8_t*>(memory);
+#endif
+}
+
+} //end namespace
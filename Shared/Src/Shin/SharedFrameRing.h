@@ -0,0 +1,145 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+namespace Shin {
+
+//The layout of the shared memory: SharedFrameRingHeader, then NumSlots SharedFrameSlotHeaders,
+//then the pixels of each slot at DataOffset + slot * SlotSize.
+//Only fixed size types, so that processes built separately agree on it
+const uint32_t SHARED_FRAME_RING_MAGIC   = 0x53465252; //"SFRR"
+const uint32_t SHARED_FRAME_RING_VERSION = 1;
+
+//Of DataOffset and SlotSize, so that the slots can be imported as host memory, e.g. as the buffers of a ReadbackRing.
+//The mapping itself is only page aligned on POSIX
+const uint64_t SHARED_FRAME_SLOT_ALIGNMENT = 64 * 1024;
+
+struct SharedFrameRingHeader {
+    uint32_t                Magic;
+    uint32_t                Version;
+    uint32_t                NumSlots;
+    uint32_t                Format;         //VkFormat
+    uint32_t                MaxWidth;
+    uint32_t                MaxHeight;
+    uint64_t                SlotSize;       //Bytes
+    uint64_t                DataOffset;     //Bytes, from the beginning of the shared memory
+    std::atomic<uint64_t>   NumPublished;   //The frame with sequence N is in slot N % NumSlots
+};
+
+//Sequence is 2 * (frame sequence) + 1 while the slot is being written, and 2 * (frame sequence) + 2 after.
+//0: never written
+struct SharedFrameSlotHeader {
+    std::atomic<uint64_t>   Sequence;
+    uint64_t                FrameIndex;     //Given by the producer
+    uint64_t                TimestampNs;    //std::chrono::steady_clock, which is CLOCK_MONOTONIC on Linux
+    uint32_t                Width;
+    uint32_t                Height;
+    uint32_t                RowPitch;       //Bytes
+    uint32_t                Padding;
+};
+
+//A frame which is read in place from the shared memory
+struct SharedFrameView {
+    const uint8_t*  Data;
+    uint32_t        RowPitch;
+    VkExtent2D      Extent;
+    uint64_t        FrameIndex;
+    uint64_t        TimestampNs;
+    uint64_t        Sequence;
+};
+
+//A ring of frames in named shared memory, from one producer to any number of consumer processes.
+//Lock free: the producer never waits for the consumers, and overwrites the oldest slot.
+//Consumers read a slot in place between BeginRead() and EndRead(), which tells whether the producer has
+//started overwriting it meanwhile, like a seqlock.
+//
+//POSIX: shm_open(), so the consumers can open it by name. Windows: a named file mapping
+class SharedFrameRing {
+public:
+    SharedFrameRing();
+
+    //Producer. The name is e.g. "/NvEncodingFrames" on POSIX. format: 4 bytes per pixel
+    void Create(const std::string& name, const VkExtent2D& maxExtent, const VkFormat format,
+        const uint32_t numSlots);
+
+    //Consumer. Throws if the producer hasn't created it, or if it has a different layout version
+    void Open(const std::string& name);
+
+    void Close();
+
+    //Producer. Returns the pixels of the next slot, to be written with rows of RowPitch bytes
+    uint8_t* BeginWrite(const VkExtent2D& extent, uint32_t* rowPitch);
+    void EndWrite(const uint64_t frameIndex);
+
+    //Producer. Copies rows of srcRowPitch bytes with BeginWrite() and EndWrite()
+    void Publish(const uint8_t* data, const uint32_t srcRowPitch, const VkExtent2D& extent,
+        const uint64_t frameIndex);
+
+    //Producer, for frames which are written in place by someone else, several at a time, e.g. by the GPU into the
+    //imported slots. The frame with sequence N is written into GetSlotData(N % NumSlots) between the two calls.
+    //EndWriteInPlace() publishes the frames: it must be called in the order of their sequences, from 
+    //GetNumPublished()
+    void BeginWriteInPlace(const uint64_t sequence);
+    void EndWriteInPlace(const uint64_t sequence, const VkExtent2D& extent, const uint32_t rowPitch,
+        const uint64_t frameIndex);
+
+    //Consumer. The sequence of the next frame which will be published
+    uint64_t GetNumPublished() const;
+
+    //Consumer. Returns false if the frame has not been published yet, is being written, or has been overwritten
+    bool BeginRead(const uint64_t sequence, SharedFrameView* view) const;
+
+    //Consumer. Returns false if the producer started overwriting the frame while it was being read:
+    //the data which was read must be discarded
+    bool EndRead(const SharedFrameView& view) const;
+
+    inline bool IsOpen() const;
+    inline bool IsProducer() const;
+    inline uint32_t GetNumSlots() const;
+    inline uint64_t GetSlotSize() const;
+    inline VkExtent2D GetMaxExtent() const;
+    inline VkFormat GetFormat() const;
+    inline uint8_t* GetSlotData(const uint32_t slot) const; //Consumers must not write it: it is mapped read only
+
+private:
+    static uint64_t GetSharedMemorySize(const uint32_t numSlots, const uint64_t slotSize, uint64_t* dataOffset);
+
+    void MapSharedMemory(const std::string& name, const uint64_t size, const bool create);
+    inline SharedFrameSlotHeader* GetSlotHeader(const uint32_t slot) const;
+
+    std::string             m_name;
+    bool                    m_producer;
+    uint8_t*                m_memory;
+    uint64_t                m_size;
+    SharedFrameRingHeader*  m_header;
+    uint64_t                m_writeSequence;    //Producer. Between BeginWrite() and EndWrite()
+    VkExtent2D              m_writeExtent;
+
+#ifdef _WIN32
+    void*                   m_mapping;          //HANDLE
+#else
+    int                     m_fd;
+#endif
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool SharedFrameRing::IsOpen() const { return nullptr != m_header; }
+bool SharedFrameRing::IsProducer() const { return m_producer; }
+uint32_t SharedFrameRing::GetNumSlots() const { return m_header->NumSlots; }
+uint64_t SharedFrameRing::GetSlotSize() const { return m_header->SlotSize; }
+VkExtent2D SharedFrameRing::GetMaxExtent() const { return { m_header->MaxWidth, m_header->MaxHeight }; }
+VkFormat SharedFrameRing::GetFormat() const { return static_cast<VkFormat>(m_header->Format); }
+
+SharedFrameSlotHeader* SharedFrameRing::GetSlotHeader(const uint32_t slot) const {
+    return reinterpret_cast<SharedFrameSlotHeader*>(m_memory + sizeof(SharedFrameRingHeader)) + slot;
+}
+
+uint8_t* SharedFrameRing::GetSlotData(const uint32_t slot) const {
+    return m_memory + m_header->DataOffset + m_header->SlotSize * slot;
+}
+
+} //end namespace
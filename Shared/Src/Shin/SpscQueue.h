@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include <utility> //std::swap
+
+namespace Shin {
+
+//A lock-free ring buffer with a fixed capacity, between exactly one producer thread and one consumer thread.
+//The items are exchanged with std::swap instead of being copied: TryPush() leaves the previous content of the
+//slot in the pushed item, and TryPop() leaves the content of the popped item in the slot, so that e.g. the
+//allocations of vectors circulate between the two threads instead of being freed and allocated again.
+//Unlike StageQueue, it never blocks: the caller decides what to do when the queue is full or empty
+template <typename T>
+class SpscQueue {
+public:
+    SpscQueue(const uint32_t capacity); //Has to be a power of two
+
+    bool TryPush(T* item);  //Producer only. false if the queue is full
+    bool TryPop(T* item);   //Consumer only. false if the queue is empty
+
+    inline bool IsEmpty() const; //Approximate when called by the producer
+    inline uint32_t GetCapacity() const;
+
+private:
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    std::vector<T>          m_items;
+    uint64_t                m_mask;
+
+    //Keep head and tail in different cache lines. Head is written by the consumer, tail by the producer
+    char                    m_padding0[64];
+    std::atomic<uint64_t>   m_head;
+    char                    m_padding1[64];
+    std::atomic<uint64_t>   m_tail;
+    char                    m_padding2[64];
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+SpscQueue<T>::SpscQueue(const uint32_t capacity) : m_items(capacity), m_mask(capacity - 1), m_head(0), m_tail(0) {
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+bool SpscQueue<T>::TryPush(T* item) {
+    const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) >= m_items.size()) {
+        return false;
+    }
+
+    std::swap(m_items[tail & m_mask], *item);
+    m_tail.store(tail + 1, std::memory_order_release); //Publishes the item
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+bool SpscQueue<T>::TryPop(T* item) {
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    std::swap(m_items[head & m_mask], *item);
+    m_head.store(head + 1, std::memory_order_release); //Gives the slot back to the producer
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+bool SpscQueue<T>::IsEmpty() const {
+    return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+}
+
+template <typename T>
+uint32_t SpscQueue<T>::GetCapacity() const { return static_cast<uint32_t>(m_items.size()); }
+
+} //end namespace
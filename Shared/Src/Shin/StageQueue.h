@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+namespace Shin {
+
+//A bounded blocking queue to hand items from one pipeline stage (thread) to the next.
+//Push() blocks while the queue is full, and Pop() blocks while it is empty, so a stage can't run further ahead
+//of the next one than the capacity allows.
+//After Close(), Push() fails and Pop() returns the remaining items before failing.
+template <typename T>
+class StageQueue {
+public:
+    StageQueue(const uint32_t capacity);
+
+    bool Push(const T& item); //false if the queue has been closed
+    bool Pop(T* item);        //false if the queue has been closed and is empty
+    void Close();
+    void Reset();             //Removes all the items and opens the queue again. Not thread-safe
+
+private:
+    std::deque<T>           m_items;
+    uint32_t                m_capacity;
+    bool                    m_closed;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+StageQueue<T>::StageQueue(const uint32_t capacity) : m_capacity(capacity), m_closed(false) {
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+bool StageQueue<T>::Push(const T& item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+    if (m_closed) {
+        return false;
+    }
+
+    m_items.push_back(item);
+    lock.unlock();
+    m_notEmpty.notify_one();
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+bool StageQueue<T>::Pop(T* item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+    if (m_items.empty()) {
+        return false;
+    }
+
+    *item = m_items.front();
+    m_items.pop_front();
+    lock.unlock();
+    m_notFull.notify_one();
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+void StageQueue<T>::Close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+    m_notFull.notify_all();
+    m_notEmpty.notify_all();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+void StageQueue<T>::Reset() {
+    m_items.clear();
+    m_closed = false;
+}
+
+} //end namespace
@@ -0,0 +1,97 @@
+#include "StartupTimeline.h"
+#include <iomanip> //setw, setprecision
+
+namespace Shin {
+
+StartupTimeline::StartupTimeline() : m_startTime(std::chrono::steady_clock::now()), m_firstFrameMs(-1.0) {
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void StartupTimeline::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_startTime = std::chrono::steady_clock::now();
+    m_phases.clear();
+    m_threadIDs.clear();
+    m_firstFrameMs = -1.0;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t StartupTimeline::BeginPhase(const char* name) {
+    const double now = GetElapsedMs();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_phases.push_back({ name, now, -1.0, GetThreadIndex() });
+    return static_cast<uint32_t>(m_phases.size() - 1);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void StartupTimeline::EndPhase(const uint32_t phaseID) {
+    const double now = GetElapsedMs();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (phaseID < m_phases.size()) {
+        m_phases[phaseID].EndMs = now;
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void StartupTimeline::MarkFirstFrame() {
+    const double now = GetElapsedMs();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_firstFrameMs = now;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void StartupTimeline::Print(std::ostream& os) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const std::ios::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(2);
+    os << "Startup timeline (ms)" << std::endl;
+    os << std::setw(10) << "begin" << std::setw(10) << "end" << std::setw(10) << "duration"
+       << std::setw(8) << "thread" << "  phase" << std::endl;
+
+    for (const Phase& phase : m_phases) {
+        os << std::setw(10) << phase.BeginMs;
+        if (phase.EndMs >= 0.0) {
+            os << std::setw(10) << phase.EndMs << std::setw(10) << (phase.EndMs - phase.BeginMs);
+        } else {
+            os << std::setw(10) << "-" << std::setw(10) << "-";
+        }
+        os << std::setw(8) << phase.ThreadIndex << "  " << phase.Name << std::endl;
+    }
+
+    if (m_firstFrameMs >= 0.0) {
+        os << "Time to first frame: " << m_firstFrameMs << " ms" << std::endl;
+    }
+    os.flags(flags);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+double StartupTimeline::GetElapsedMs() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t StartupTimeline::GetThreadIndex() {
+    const std::thread::id threadID = std::this_thread::get_id();
+    const uint32_t numThreads = static_cast<uint32_t>(m_threadIDs.size());
+    for (uint32_t i = 0; i < numThreads; ++i) {
+        if (threadID == m_threadIDs[i]) {
+            return i;
+        }
+    }
+
+    m_threadIDs.push_back(threadID);
+    return numThreads;
+}
+
+} //end namespace
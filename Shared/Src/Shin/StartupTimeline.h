@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Shin {
+
+//Records when each startup phase begins and ends, and on which thread, until the first frame is presented.
+//Unlike the Profiler, it is always compiled in, so that the time to first frame can be checked in release builds.
+//Phases can be added from any thread.
+class StartupTimeline {
+public:
+    StartupTimeline();
+
+    void Start();
+    uint32_t BeginPhase(const char* name); //Returns the id to pass to EndPhase()
+    void EndPhase(const uint32_t phaseID);
+    void MarkFirstFrame();
+
+    void Print(std::ostream& os) const;
+
+    inline bool IsFirstFrameMarked() const;
+
+private:
+    struct Phase {
+        std::string Name;
+        double      BeginMs;
+        double      EndMs;
+        uint32_t    ThreadIndex; //0 for the first thread that added a phase
+    };
+
+    double GetElapsedMs() const;
+    uint32_t GetThreadIndex(); //Requires m_mutex
+
+    std::chrono::steady_clock::time_point   m_startTime;
+    mutable std::mutex                      m_mutex;
+    std::vector<Phase>                      m_phases;
+    std::vector<std::thread::id>            m_threadIDs;
+    double                                  m_firstFrameMs;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+class StartupTimelineScope {
+public:
+    inline StartupTimelineScope(StartupTimeline* timeline, const char* name);
+    inline ~StartupTimelineScope();
+
+private:
+    StartupTimeline*    m_timeline;
+    uint32_t            m_phaseID;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool StartupTimeline::IsFirstFrameMarked() const { return m_firstFrameMs >= 0.0; }
+
+StartupTimelineScope::StartupTimelineScope(StartupTimeline* timeline, const char* name)
+    : m_timeline(timeline), m_phaseID(timeline->BeginPhase(name))
+{
+}
+
+StartupTimelineScope::~StartupTimelineScope() { m_timeline->EndPhase(m_phaseID); }
+
+} //end namespace
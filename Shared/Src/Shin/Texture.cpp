@@ -4,6 +4,7 @@
 #include "stb_image.h"  //for loading images
 #include <stdexcept> //std::runtime_error
 
+#include "UploadBatch.h"
 #include "Utilities/Macros.h"
 #include "Utilities/GraphicsUtility.h"
 
@@ -20,22 +21,55 @@ Texture::Texture() : m_textureImage(VK_NULL_HANDLE), m_textureImageMemory(VK_NUL
 void Texture::Init(const VkPhysicalDevice physicalDevice, const VkDevice device,  
     const VkAllocationCallbacks* allocator,  const VkCommandPool commandPool, VkQueue queue, const char* path)
 {
-    CreateTextureImage(physicalDevice, device, allocator, commandPool, queue, path);
+    std::vector<uint8_t> pixels;
+    uint32_t width = 0, height = 0;
+    LoadPixelsInto(path, &pixels, &width, &height);
+
+    UploadBatch uploadBatch;
+    uploadBatch.Begin(device, commandPool);
+    Init(physicalDevice, device, allocator, pixels, width, height, &uploadBatch);
+    uploadBatch.Submit(device, allocator, queue);
+    uploadBatch.Wait(device, allocator);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void Texture::Init(const VkPhysicalDevice physicalDevice, const VkDevice device, 
+    const VkAllocationCallbacks* allocator, const std::vector<uint8_t>& pixels, 
+    const uint32_t width, const uint32_t height, UploadBatch* uploadBatch)
+{
+    CreateTextureImage(physicalDevice, device, allocator, pixels, width, height, uploadBatch);
     CreateTextureImageView(device, allocator);
     CreateTextureSampler(device, allocator);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 
+void Texture::LoadPixelsInto(const char* path, std::vector<uint8_t>* pixels, uint32_t* width, uint32_t* height) {
+    int texWidth, texHeight, texChannels;
+    stbi_uc* data = stbi_load(path, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+    if (!data) {
+        throw std::runtime_error("failed to load texture image!");
+    }
+
+    const size_t imageSize = static_cast<size_t>(texWidth) * texHeight * 4;
+    pixels->assign(data, data + imageSize);
+    stbi_image_free(data);
+
+    *width = static_cast<uint32_t>(texWidth);
+    *height = static_cast<uint32_t>(texHeight);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
 void Texture::InitAsRenderTexture(const VkPhysicalDevice physicalDevice, const VkDevice device, 
-    const VkAllocationCallbacks* allocator, const uint32_t width, const uint32_t height) 
+    const VkAllocationCallbacks* allocator, const uint32_t width, const uint32_t height, const bool exportHandle) 
 {
-    const bool EXPORT_HANDLE = true;
     m_textureImageMemorySize = GraphicsUtility::CreateImage(physicalDevice,device,allocator, width, height,
         VK_IMAGE_TILING_OPTIMAL,
         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,VK_FORMAT_R8G8B8A8_UNORM, &m_textureImage,&m_textureImageMemory,
-        EXPORT_HANDLE
+        exportHandle
     );
     m_extent = { width, height};
 
@@ -45,57 +79,21 @@ void Texture::InitAsRenderTexture(const VkPhysicalDevice physicalDevice, const V
 
 //---------------------------------------------------------------------------------------------------------------------
 void Texture::CreateTextureImage(const VkPhysicalDevice physicalDevice, const VkDevice device, 
-    const VkAllocationCallbacks* allocator,  const VkCommandPool commandPool, VkQueue queue, const char* path) 
+    const VkAllocationCallbacks* allocator, const std::vector<uint8_t>& pixels, 
+    const uint32_t width, const uint32_t height, UploadBatch* uploadBatch)
 {
-    int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load(path, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    const VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-    if (!pixels) {
-        throw std::runtime_error("failed to load texture image!");
-    }
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-
-    GraphicsUtility::CreateBuffer(physicalDevice, device, allocator, imageSize, 
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-        &stagingBuffer, &stagingBufferMemory
-    );
-
-    GraphicsUtility::CopyCPUDataToBuffer(device,pixels,stagingBufferMemory,imageSize);
-
-    stbi_image_free(pixels);
-
     //Create Image buffer. 
     //VK_IMAGE_USAGE_SAMPLED_BIT: to allow access from the shader
-    m_textureImageMemorySize = GraphicsUtility::CreateImage(physicalDevice,device,allocator, texWidth, texHeight,
+    m_textureImageMemorySize = GraphicsUtility::CreateImage(physicalDevice,device,allocator, width, height,
         VK_IMAGE_TILING_OPTIMAL,
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,VK_FORMAT_R8G8B8A8_UNORM, &m_textureImage,&m_textureImageMemory
     );
-    m_extent = { static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight)};
-
-    //Transition the texture image to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-    GraphicsUtility::DoImageLayoutTransition(device, commandPool, queue, 
-        m_textureImage, VK_FORMAT_R8G8B8A8_UNORM, 
-        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-    );
-
-    //Execute the buffer to image copy operation
-    GraphicsUtility::CopyBufferToImage(device, commandPool, queue,stagingBuffer, 
-        m_textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-
-    //one last transition to prepare it for shader access:
-    GraphicsUtility::DoImageLayoutTransition(device, commandPool, queue, 
-        m_textureImage, VK_FORMAT_R8G8B8A8_UNORM, 
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-    );
-
-    vkDestroyBuffer(device, stagingBuffer, allocator);
-    vkFreeMemory(device, stagingBufferMemory, allocator);
+    m_extent = { width, height };
 
+    //Copy the pixels, and transition the image for shader access
+    uploadBatch->UploadToImage(physicalDevice, device, allocator, pixels.data(), pixels.size(), 
+        m_textureImage, width, height);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -108,27 +106,7 @@ void Texture::CreateTextureImageView(const VkDevice device, const VkAllocationCa
 
 //---------------------------------------------------------------------------------------------------------------------
 void Texture::CreateTextureSampler(const VkDevice device, const VkAllocationCallbacks* allocator) {
-    VkSamplerCreateInfo samplerInfo = {};
-    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerInfo.magFilter = VK_FILTER_LINEAR;
-    samplerInfo.minFilter = VK_FILTER_LINEAR;
-    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.anisotropyEnable = VK_TRUE;
-    samplerInfo.maxAnisotropy = 16;
-    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-    samplerInfo.unnormalizedCoordinates = VK_FALSE; //[0..1] range
-    samplerInfo.compareEnable = VK_FALSE;
-    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    samplerInfo.mipLodBias = 0.0f;
-    samplerInfo.minLod = 0.0f;
-    samplerInfo.maxLod = 0.0f;
-    
-    if (vkCreateSampler(device, &samplerInfo, allocator, &m_textureSampler) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create texture sampler!");
-    }
+    m_textureSampler = GraphicsUtility::CreateSampler(device, allocator);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -1,8 +1,13 @@
 #pragma once
 
 #include <vulkan/vulkan.h> 
+#include <stdint.h>
+#include <vector>
 
 namespace Shin {
+
+class UploadBatch;
+
 class Texture {
 
 public:
@@ -10,11 +15,20 @@ public:
     void Init(const VkPhysicalDevice physicalDevice, const VkDevice device, 
         const VkAllocationCallbacks* allocator,  const VkCommandPool commandPool, VkQueue queue, const char* path);
 
+    //Records the upload of RGBA8 pixels into uploadBatch. The pixels can be released after this call
+    void Init(const VkPhysicalDevice physicalDevice, const VkDevice device, 
+        const VkAllocationCallbacks* allocator, const std::vector<uint8_t>& pixels, 
+        const uint32_t width, const uint32_t height, UploadBatch* uploadBatch);
+
+    //Decodes an image file into RGBA8 pixels. Doesn't use Vulkan, and can be called from any thread
+    static void LoadPixelsInto(const char* path, std::vector<uint8_t>* pixels, uint32_t* width, uint32_t* height);
+
     void InitAsRenderTexture(const VkPhysicalDevice physicalDevice, const VkDevice device, 
-        const VkAllocationCallbacks* allocator, const uint32_t width, const uint32_t height);
+        const VkAllocationCallbacks* allocator, const uint32_t width, const uint32_t height, const bool exportHandle);
 
     void CleanUp(const VkDevice device, const VkAllocationCallbacks* allocator);
 
+    inline VkImage GetImage() const;
     inline VkImageView GetImageView() const;
     inline VkSampler GetSampler() const;
     inline VkDeviceMemory GetTextureImageMemory() const;
@@ -24,7 +38,8 @@ public:
 private:
 
     void CreateTextureImage(const VkPhysicalDevice physicalDevice, const VkDevice device, 
-        const VkAllocationCallbacks* allocator,  const VkCommandPool commandPool, VkQueue queue, const char* path);
+        const VkAllocationCallbacks* allocator, const std::vector<uint8_t>& pixels, 
+        const uint32_t width, const uint32_t height, UploadBatch* uploadBatch);
     void CreateTextureImageView(const VkDevice device, const VkAllocationCallbacks* allocator);
     void CreateTextureSampler(const VkDevice device, const VkAllocationCallbacks* allocator);
 
@@ -40,6 +55,7 @@ private:
 
 //---------------------------------------------------------------------------------------------------------------------
 
+VkImage         Texture::GetImage() const               { return m_textureImage; }
 VkImageView     Texture::GetImageView() const           { return m_textureImageView; }
 VkSampler       Texture::GetSampler() const             { return m_textureSampler; }
 VkDeviceMemory  Texture::GetTextureImageMemory() const  { return m_textureImageMemory; }
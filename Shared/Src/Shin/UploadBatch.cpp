@@ -0,0 +1,148 @@
+#include "UploadBatch.h"
+#include <stdexcept> //std::runtime_error
+
+#include "Utilities/GraphicsUtility.h"
+#include "Utilities/Macros.h"
+
+namespace Shin {
+
+UploadBatch::UploadBatch() : m_commandPool(VK_NULL_HANDLE), m_commandBuffer(VK_NULL_HANDLE), m_fence(VK_NULL_HANDLE)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void UploadBatch::Begin(const VkDevice device, const VkCommandPool commandPool) {
+    m_commandPool = commandPool;
+    if (VK_SUCCESS != GraphicsUtility::BeginOneTimeCommandBufferInto(device, commandPool, &m_commandBuffer)) {
+        throw std::runtime_error("failed to begin the upload command buffer!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void UploadBatch::UploadToBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device,
+    const VkAllocationCallbacks* allocator, const void* data, const VkDeviceSize size, const VkBuffer dstBuffer)
+{
+    const VkBuffer stagingBuffer = CreateStagingBuffer(physicalDevice, device, allocator, data, size);
+
+    VkBufferCopy copyRegion = {};
+    copyRegion.srcOffset = 0;
+    copyRegion.dstOffset = 0;
+    copyRegion.size = size;
+    vkCmdCopyBuffer(m_commandBuffer, stagingBuffer, dstBuffer, 1, &copyRegion);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void UploadBatch::UploadToImage(const VkPhysicalDevice physicalDevice, const VkDevice device,
+    const VkAllocationCallbacks* allocator, const void* data, const VkDeviceSize size, const VkImage dstImage,
+    const uint32_t width, const uint32_t height)
+{
+    const VkBuffer stagingBuffer = CreateStagingBuffer(physicalDevice, device, allocator, data, size);
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = dstImage;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    //Undefined -> transfer destination
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+        0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy region = {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = { 0, 0, 0 };
+    region.imageExtent = { width, height, 1 };
+    vkCmdCopyBufferToImage(m_commandBuffer, stagingBuffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    //Transfer destination -> shader reading in the fragment shader
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+        0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void UploadBatch::Submit(const VkDevice device, const VkAllocationCallbacks* allocator, const VkQueue queue) {
+    if (VK_SUCCESS != vkEndCommandBuffer(m_commandBuffer)) {
+        throw std::runtime_error("failed to record the upload command buffer!");
+    }
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (VK_SUCCESS != vkCreateFence(device, &fenceInfo, allocator, &m_fence)) {
+        throw std::runtime_error("failed to create the upload fence!");
+    }
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &m_commandBuffer;
+    if (VK_SUCCESS != vkQueueSubmit(queue, 1, &submitInfo, m_fence)) {
+        throw std::runtime_error("failed to submit the upload command buffer!");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void UploadBatch::Wait(const VkDevice device, const VkAllocationCallbacks* allocator) {
+    if (VK_NULL_HANDLE != m_fence) {
+        vkWaitForFences(device, 1, &m_fence, VK_TRUE, UINT64_MAX);
+        vkDestroyFence(device, m_fence, allocator);
+        m_fence = VK_NULL_HANDLE;
+    }
+
+    if (VK_NULL_HANDLE != m_commandBuffer) {
+        vkFreeCommandBuffers(device, m_commandPool, 1, &m_commandBuffer);
+        m_commandBuffer = VK_NULL_HANDLE;
+    }
+
+    const size_t numStagingBuffers = m_stagingBuffers.size();
+    for (size_t i = 0; i < numStagingBuffers; ++i) {
+        SAFE_DESTROY_BUFFER(device, m_stagingBuffers[i], allocator);
+        SAFE_FREE_MEMORY(device, m_stagingBufferMemories[i], allocator);
+    }
+    m_stagingBuffers.clear();
+    m_stagingBufferMemories.clear();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkBuffer UploadBatch::CreateStagingBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device,
+    const VkAllocationCallbacks* allocator, const void* data, const VkDeviceSize size)
+{
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
+    GraphicsUtility::CreateBuffer(physicalDevice, device, allocator, size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &stagingBuffer, &stagingBufferMemory
+    );
+    m_stagingBuffers.push_back(stagingBuffer);
+    m_stagingBufferMemories.push_back(stagingBufferMemory);
+
+    GraphicsUtility::CopyCPUDataToBuffer(device, data, stagingBufferMemory, size);
+    return stagingBuffer;
+}
+
+} //end namespace
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+
+namespace Shin {
+
+//Records the copies of several uploads into one command buffer, so that they are executed with one submission and
+//one wait, instead of one vkQueueWaitIdle per copy.
+//The source data is copied into staging buffers immediately, so it can be released after the Upload calls.
+//Usage: Begin() -> UploadToBuffer()/UploadToImage() -> Submit() -> Wait()
+class UploadBatch {
+public:
+    UploadBatch();
+
+    void Begin(const VkDevice device, const VkCommandPool commandPool);
+
+    void UploadToBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device,
+        const VkAllocationCallbacks* allocator, const void* data, const VkDeviceSize size, const VkBuffer dstBuffer);
+
+    //Transitions the image from VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    void UploadToImage(const VkPhysicalDevice physicalDevice, const VkDevice device,
+        const VkAllocationCallbacks* allocator, const void* data, const VkDeviceSize size, const VkImage dstImage,
+        const uint32_t width, const uint32_t height);
+
+    void Submit(const VkDevice device, const VkAllocationCallbacks* allocator, const VkQueue queue);
+
+    //Waits for the submission, and destroys the staging buffers, the command buffer and the fence
+    void Wait(const VkDevice device, const VkAllocationCallbacks* allocator);
+
+    inline uint32_t GetNumUploads() const;
+
+private:
+    VkBuffer CreateStagingBuffer(const VkPhysicalDevice physicalDevice, const VkDevice device,
+        const VkAllocationCallbacks* allocator, const void* data, const VkDeviceSize size);
+
+    VkCommandPool               m_commandPool;
+    VkCommandBuffer             m_commandBuffer;
+    VkFence                     m_fence;
+
+    std::vector<VkBuffer>       m_stagingBuffers;
+    std::vector<VkDeviceMemory> m_stagingBufferMemories;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t UploadBatch::GetNumUploads() const { return static_cast<uint32_t>(m_stagingBuffers.size()); }
+
+} //end namespace
@@ -8,9 +8,11 @@
 #endif
 
 #ifndef _WIN32
-#define EXTERNAL_MEMORY_HANDLE_SUPPORTED_TYPE    VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT_KHR
+#define EXTERNAL_MEMORY_HANDLE_SUPPORTED_TYPE       VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT_KHR
+#define EXTERNAL_SEMAPHORE_HANDLE_SUPPORTED_TYPE    VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT_KHR
 #else
-#define EXTERNAL_MEMORY_HANDLE_SUPPORTED_TYPE    VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT_KHR
+#define EXTERNAL_MEMORY_HANDLE_SUPPORTED_TYPE       VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT_KHR
+#define EXTERNAL_SEMAPHORE_HANDLE_SUPPORTED_TYPE    VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_WIN32_BIT_KHR
 #endif
 
 VkShaderModule GraphicsUtility::CreateShaderModule(const VkDevice device, const VkAllocationCallbacks* allocator, 
@@ -102,16 +104,24 @@ VkResult GraphicsUtility::CopyBuffer(const VkDevice device, const VkCommandPool
 //---------------------------------------------------------------------------------------------------------------------
 VkImageView  GraphicsUtility::CreateImageView(const VkDevice device, const VkAllocationCallbacks* allocator,
                                               const VkImage image, const VkFormat format)
+{
+    return CreateImageView(device, allocator, image, format, 0);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkImageView  GraphicsUtility::CreateImageView(const VkDevice device, const VkAllocationCallbacks* allocator,
+                                              const VkImage image, const VkFormat format, const uint32_t layer)
 {
     VkImageViewCreateInfo viewInfo = {};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = image;
     viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
     viewInfo.format = format;
-    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.aspectMask = GetImageAspectFlags(format);
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = 1;
-    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.baseArrayLayer = layer;
     viewInfo.subresourceRange.layerCount = 1;
     viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
     viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -129,6 +139,70 @@ VkImageView  GraphicsUtility::CreateImageView(const VkDevice device, const VkAll
 
 //---------------------------------------------------------------------------------------------------------------------
 
+VkFormat GraphicsUtility::FindDepthFormat(const VkPhysicalDevice physicalDevice) {
+    const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT };
+    for (const VkFormat format : candidates) {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+        if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+            return format;
+        }
+    }
+
+    throw std::runtime_error("failed to find supported depth format!");
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkImageAspectFlags GraphicsUtility::GetImageAspectFlags(const VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT: {
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        }
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT: {
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        }
+        default: {
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkSampler GraphicsUtility::CreateSampler(const VkDevice device, const VkAllocationCallbacks* allocator) {
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.anisotropyEnable = VK_TRUE;
+    samplerInfo.maxAnisotropy = 16;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE; //[0..1] range
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.mipLodBias = 0.0f;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = 0.0f;
+
+    VkSampler sampler = VK_NULL_HANDLE;
+    if (vkCreateSampler(device, &samplerInfo, allocator, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture sampler!");
+    }
+
+    return sampler;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
 //initialLayout must be either VK_IMAGE_LAYOUT_UNDEFINED or VK_IMAGE_LAYOUT_PREINITIALIZED
 //We use VK_IMAGE_LAYOUT_UNDEFINED here.
 VkDeviceSize GraphicsUtility::CreateImage(const VkPhysicalDevice physicalDevice, const VkDevice device, 
@@ -138,15 +212,34 @@ VkDeviceSize GraphicsUtility::CreateImage(const VkPhysicalDevice physicalDevice,
     const VkFormat format,
     VkImage* image, VkDeviceMemory* imageMemory, bool exportHandle) 
 {
+    return CreateImageArray(physicalDevice, device, allocator, width, height, 1, tiling, usage, properties, format,
+        image, imageMemory, exportHandle);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkDeviceSize GraphicsUtility::CreateImageArray(const VkPhysicalDevice physicalDevice, const VkDevice device, 
+    const VkAllocationCallbacks* allocator,
+    const uint32_t width, const uint32_t height, const uint32_t numLayers,
+    const VkImageTiling tiling, const VkImageUsageFlags usage, const VkMemoryPropertyFlags properties,
+    const VkFormat format,
+    VkImage* image, VkDeviceMemory* imageMemory, bool exportHandle) 
+{
+
+    //Exported memory can only be bound to images which are created for it
+    VkExternalMemoryImageCreateInfoKHR externalInfo = {};
+    externalInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO_KHR;
+    externalInfo.handleTypes = EXTERNAL_MEMORY_HANDLE_SUPPORTED_TYPE;
 
     VkImageCreateInfo imageInfo = {};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.pNext = exportHandle ? &externalInfo : nullptr;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
     imageInfo.extent.width = static_cast<uint32_t>(width);
     imageInfo.extent.height = static_cast<uint32_t>(height);
     imageInfo.extent.depth = 1;
     imageInfo.mipLevels = 1;
-    imageInfo.arrayLayers = 1;
+    imageInfo.arrayLayers = numLayers;
     imageInfo.format = format;
     imageInfo.tiling = tiling;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -169,7 +262,7 @@ VkDeviceSize GraphicsUtility::CreateImage(const VkPhysicalDevice physicalDevice,
     VkExportMemoryAllocateInfoKHR exportInfo = {};
     if (exportHandle)  {
         exportInfo.sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO_KHR;
-        exportInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT_KHR;
+        exportInfo.handleTypes = EXTERNAL_MEMORY_HANDLE_SUPPORTED_TYPE;
         allocInfo.pNext = &exportInfo;
     }
 
@@ -377,6 +470,26 @@ void* GraphicsUtility::GetExportHandle(const VkDevice device, const VkDeviceMemo
 
     return (void *)(uintptr_t)fd;
 }
+
+void* GraphicsUtility::GetSemaphoreExportHandle(const VkDevice device, const VkSemaphore semaphore)
+{
+    int fd = -1;
+
+    VkSemaphoreGetFdInfoKHR fdInfo = {};
+    fdInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_FD_INFO_KHR;
+    fdInfo.semaphore = semaphore;
+    fdInfo.handleType = EXTERNAL_SEMAPHORE_HANDLE_SUPPORTED_TYPE;
+
+    auto func = (PFN_vkGetSemaphoreFdKHR) \
+        vkGetDeviceProcAddr(device, "vkGetSemaphoreFdKHR");
+
+    if (!func ||
+        func(device, &fdInfo, &fd) != VK_SUCCESS) {
+        return nullptr;
+    }
+
+    return (void *)(uintptr_t)fd;
+}
 #else
 void* GraphicsUtility::GetExportHandle(const VkDevice device, const VkDeviceMemory memory)
 {
@@ -397,5 +510,51 @@ void* GraphicsUtility::GetExportHandle(const VkDevice device, const VkDeviceMemo
 
     return (void *)handle;
 }
+
+void* GraphicsUtility::GetSemaphoreExportHandle(const VkDevice device, const VkSemaphore semaphore)
+{
+    HANDLE handle = nullptr;
+
+    VkSemaphoreGetWin32HandleInfoKHR handleInfo = {};
+    handleInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_WIN32_HANDLE_INFO_KHR;
+    handleInfo.semaphore = semaphore;
+    handleInfo.handleType = EXTERNAL_SEMAPHORE_HANDLE_SUPPORTED_TYPE;
+
+    auto func = (PFN_vkGetSemaphoreWin32HandleKHR) \
+        vkGetDeviceProcAddr(device, "vkGetSemaphoreWin32HandleKHR");
+
+    if (!func ||
+        func(device, &handleInfo, &handle) != VK_SUCCESS) {
+        return nullptr;
+    }
+
+    return (void *)handle;
+}
 #endif
 
+//---------------------------------------------------------------------------------------------------------------------
+
+VkSemaphore GraphicsUtility::CreateTimelineSemaphore(const VkDevice device, const VkAllocationCallbacks* allocator,
+    const uint64_t initialValue, const bool exportHandle)
+{
+    VkExportSemaphoreCreateInfoKHR exportInfo = {};
+    exportInfo.sType = VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO_KHR;
+    exportInfo.handleTypes = EXTERNAL_SEMAPHORE_HANDLE_SUPPORTED_TYPE;
+
+    VkSemaphoreTypeCreateInfoKHR typeInfo = {};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+    typeInfo.pNext = exportHandle ? &exportInfo : nullptr;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeInfo.initialValue = initialValue;
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    if (vkCreateSemaphore(device, &semaphoreInfo, allocator, &semaphore) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timeline semaphore!");
+    }
+    return semaphore;
+}
+
@@ -23,6 +23,19 @@ class GraphicsUtility {
         static VkImageView  CreateImageView(const VkDevice device, const VkAllocationCallbacks* allocator, 
                                             const VkImage image, const VkFormat format);
 
+        //A 2D view of one layer of an array image
+        static VkImageView  CreateImageView(const VkDevice device, const VkAllocationCallbacks* allocator, 
+                                            const VkImage image, const VkFormat format, const uint32_t layer);
+
+        //The first depth format which can be used as a depth attachment with optimal tiling
+        static VkFormat     FindDepthFormat(const VkPhysicalDevice physicalDevice);
+
+        //Depth (and stencil) for depth formats, color for the others
+        static VkImageAspectFlags GetImageAspectFlags(const VkFormat format);
+
+        //Linear filtering and repeat addressing
+        static VkSampler    CreateSampler(const VkDevice device, const VkAllocationCallbacks* allocator);
+
         static VkDeviceSize CreateImage(const VkPhysicalDevice physicalDevice, const VkDevice device, 
                                 const VkAllocationCallbacks* allocator,
                                 const uint32_t width, const uint32_t height, 
@@ -30,6 +43,14 @@ class GraphicsUtility {
                                 const VkMemoryPropertyFlags properties, const VkFormat format,
                                 VkImage* image, VkDeviceMemory* imageMemory, bool exportHandle = false);
 
+        //A 2D image with numLayers array layers, in one allocation
+        static VkDeviceSize CreateImageArray(const VkPhysicalDevice physicalDevice, const VkDevice device, 
+                                const VkAllocationCallbacks* allocator,
+                                const uint32_t width, const uint32_t height, const uint32_t numLayers,
+                                const VkImageTiling tiling, const VkImageUsageFlags usage,
+                                const VkMemoryPropertyFlags properties, const VkFormat format,
+                                VkImage* image, VkDeviceMemory* imageMemory, bool exportHandle = false);
+
         static VkResult DoImageLayoutTransition(const VkDevice device, const VkCommandPool commandPool, const VkQueue queue, 
                                           VkImage image, VkFormat format, 
                                           VkImageLayout oldLayout, VkImageLayout newLayout); 
@@ -57,6 +78,13 @@ class GraphicsUtility {
 
         static void* GetExportHandle(const VkDevice device, const VkDeviceMemory memory);
 
+        //The semaphore must have been created with exportHandle. A file descriptor on Linux
+        static void* GetSemaphoreExportHandle(const VkDevice device, const VkSemaphore semaphore);
+
+        //Needs VK_KHR_timeline_semaphore, and VK_KHR_external_semaphore to export it
+        static VkSemaphore CreateTimelineSemaphore(const VkDevice device, const VkAllocationCallbacks* allocator,
+                                                   const uint64_t initialValue, const bool exportHandle);
+
 
 };
     
@@ -91,6 +91,13 @@
     } \
 }
 
+#define SAFE_DESTROY_QUERY_POOL(device, obj, allocator) { \
+    if (VK_NULL_HANDLE != obj) { \
+        vkDestroyQueryPool(device, obj, allocator); \
+        obj = VK_NULL_HANDLE; \
+    } \
+}
+
 #define SAFE_DESTROY_DEVICE(device, allocator) { \
     if (VK_NULL_HANDLE != device) { \
         vkDestroyDevice(device, allocator); \
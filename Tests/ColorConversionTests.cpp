@@ -0,0 +1,417 @@
+#include "ColorConversionTests.h"
+
+#include <iostream> //cout
+#include <algorithm> //std::min
+#include <cstring> //memcpy
+#include <stdexcept> //std::runtime_error
+
+#include "Shin/ColorConversionPass.h"
+#include "Shin/JobSystem.h"
+#include "Shin/Utilities/GraphicsUtility.h"
+
+using namespace Shin;
+
+//Relative to the project directory, as in NvEncoding
+const char* RGBA_TO_YUV_SHADER_PATH = "../Shared/Shaders/RGBAToYUV.comp.spv";
+
+const char* COLOR_MATRIX_NAMES[] = { "BT.601", "BT.709" };
+const char* YUV_FORMAT_NAMES[] = { "I420", "NV12" };
+
+//8 bits of fraction. The rows of Y, U and V, per ColorMatrix
+const int REFERENCE_COEFFICIENTS[][3][3] = {
+    { {  66, 129,  25 }, { -38, -74, 112 }, { 112,  -94, -18 } },
+    { {  47, 157,  16 }, { -26, -86, 112 }, { 112, -102, -10 } },
+};
+
+struct SolidColor {
+    const char* Name;
+    uint8_t     RGB[3];
+    uint8_t     YUV[2][3]; //Per ColorMatrix
+};
+
+//Computed by hand: ((k0 * r + k1 * g + k2 * b + 128) >> 8) + 16 for Y, and + 128 for U and V.
+//The shift rounds negative sums down
+const SolidColor SOLID_COLORS[] = {
+    { "red",   { 255,   0,   0 }, { {  82,  90, 240 }, {  63, 102, 240 } } },
+    { "green", {   0, 255,   0 }, { { 144,  54,  34 }, { 172,  42,  26 } } },
+    { "blue",  {   0,   0, 255 }, { {  41, 240, 110 }, {  32, 240, 118 } } },
+    { "white", { 255, 255, 255 }, { { 235, 128, 128 }, { 235, 128, 128 } } },
+    { "black", {   0,   0,   0 }, { {  16, 128, 128 }, {  16, 128, 128 } } },
+};
+
+static uint8_t ApplyCoefficients(const int* k, const int* rgb, const int offset) {
+    return static_cast<uint8_t>(((k[0] * rgb[0] + k[1] * rgb[1] + k[2] * rgb[2] + 128) >> 8) + offset);
+}
+
+//stride: 2 for the interleaved chroma of NV12
+static bool IsPlaneFilledWith(const uint8_t* plane, const size_t numSamples, const size_t stride,
+    const uint8_t value)
+{
+    for (size_t i = 0; i < numSamples; ++i) {
+        if (value != plane[i * stride])
+            return false;
+    }
+    return true;
+}
+
+static void RecordImageBarrier(const VkCommandBuffer commandBuffer, const VkImage image,
+    const VkImageLayout oldLayout, const VkImageLayout newLayout,
+    const VkPipelineStageFlags srcStage, const VkAccessFlags srcAccess,
+    const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess)
+{
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+ColorConversionTests::ColorConversionTests(const VkPhysicalDevice physicalDevice, const VkDevice device,
+    const VkQueue queue, const uint32_t queueFamilyIndex)
+    : m_physicalDevice(physicalDevice), m_device(device), m_queue(queue), m_queueFamilyIndex(queueFamilyIndex)
+    , m_testName(""), m_numChecks(0), m_numFailures(0)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t ColorConversionTests::Run() {
+    m_numChecks = 0;
+    m_numFailures = 0;
+
+    TestSolidColors();
+    TestOddSizes();
+    TestJobSystem();
+    TestComputeShader();
+
+    std::cout << "ColorConversion: " << (m_numChecks - m_numFailures) << "/" << m_numChecks << " checks passed"
+        << " (SIMD: " << ColorConversion::GetSIMDLevelName(ColorConversion::GetSupportedSIMDLevel()) << ")"
+        << std::endl;
+    return m_numFailures;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Every sample of a plane has the value of the color. The odd width also covers the columns after the SIMD ones
+void ColorConversionTests::TestSolidColors() {
+    m_testName = "SolidColors";
+
+    const uint32_t width = 35;
+    const uint32_t height = 5;
+    const size_t numLumaSamples = static_cast<size_t>(width) * height;
+    const size_t numChromaSamples = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+
+    std::vector<uint8_t> rgba(numLumaSamples * 4);
+    std::vector<uint8_t> yuv(ColorConversion::GetYUVSize(width, height));
+    const SIMDLevel supportedLevel = ColorConversion::GetSupportedSIMDLevel();
+    for (const SolidColor& color : SOLID_COLORS) {
+        for (size_t i = 0; i < numLumaSamples; ++i) {
+            memcpy(&rgba[i * 4], color.RGB, 3);
+            rgba[i * 4 + 3] = 255;
+        }
+
+        for (uint32_t matrix = COLOR_MATRIX_BT601; matrix <= COLOR_MATRIX_BT709; ++matrix) {
+            const uint8_t* expected = color.YUV[matrix];
+            for (uint32_t format = YUV_FORMAT_I420; format <= YUV_FORMAT_NV12; ++format) {
+                for (uint32_t level = SIMD_LEVEL_SCALAR; level <= supportedLevel; ++level) {
+                    const ColorConversionDesc desc = GetDesc(width, height, static_cast<ColorMatrix>(matrix),
+                        static_cast<YUVFormat>(format), static_cast<SIMDLevel>(level));
+                    ColorConversion::Convert(desc, rgba.data(), yuv.data(), nullptr);
+
+                    const std::string caseName = std::string(color.Name) + " " + GetCaseName(desc);
+                    const uint8_t* u = yuv.data() + numLumaSamples;
+                    const bool nv12 = (YUV_FORMAT_NV12 == desc.Format);
+                    const uint8_t* v = nv12 ? (u + 1) : (u + numChromaSamples);
+                    const size_t chromaStride = nv12 ? 2 : 1;
+                    Check(IsPlaneFilledWith(yuv.data(), numLumaSamples, 1, expected[0]), caseName + ": Y");
+                    Check(IsPlaneFilledWith(u, numChromaSamples, chromaStride, expected[1]), caseName + ": U");
+                    Check(IsPlaneFilledWith(v, numChromaSamples, chromaStride, expected[2]), caseName + ": V");
+                }
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Odd sizes repeat the last row and column in the chroma blocks. The rows of the source are padded
+void ColorConversionTests::TestOddSizes() {
+    m_testName = "OddSizes";
+
+    const uint32_t sizes[][2] = { { 1, 1 }, { 3, 5 }, { 17, 9 }, { 33, 7 }, { 65, 3 } };
+    std::vector<uint8_t> rgba;
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> actual;
+    const SIMDLevel supportedLevel = ColorConversion::GetSupportedSIMDLevel();
+    for (const uint32_t* size : sizes) {
+        for (uint32_t matrix = COLOR_MATRIX_BT601; matrix <= COLOR_MATRIX_BT709; ++matrix) {
+            for (uint32_t format = YUV_FORMAT_I420; format <= YUV_FORMAT_NV12; ++format) {
+                for (uint32_t level = SIMD_LEVEL_SCALAR; level <= supportedLevel; ++level) {
+                    ColorConversionDesc desc = GetDesc(size[0], size[1], static_cast<ColorMatrix>(matrix),
+                        static_cast<YUVFormat>(format), static_cast<SIMDLevel>(level));
+                    desc.SrcRowPitch = size[0] * 4 + 16;
+                    GenerateFrameInto(desc.Width, desc.Height, desc.SrcRowPitch, &rgba);
+                    ConvertReferenceInto(desc, rgba, &expected);
+
+                    actual.assign(expected.size(), 0);
+                    ColorConversion::Convert(desc, rgba.data(), actual.data(), nullptr);
+                    Check(actual == expected, GetCaseName(desc) + " " + std::to_string(size[0]) + "x"
+                        + std::to_string(size[1]));
+                }
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The bands converted on the job threads produce the same bytes as the whole frame on the calling thread
+void ColorConversionTests::TestJobSystem() {
+    m_testName = "JobSystem";
+
+    const uint32_t width = 250;
+    const uint32_t height = 203; //Several bands, and a last one which isn't full
+    JobSystem jobSystem;
+    jobSystem.Init(4);
+
+    std::vector<uint8_t> rgba;
+    GenerateFrameInto(width, height, width * 4, &rgba);
+    std::vector<uint8_t> expected(ColorConversion::GetYUVSize(width, height));
+    std::vector<uint8_t> actual(expected.size());
+    const SIMDLevel supportedLevel = ColorConversion::GetSupportedSIMDLevel();
+    for (uint32_t format = YUV_FORMAT_I420; format <= YUV_FORMAT_NV12; ++format) {
+        for (uint32_t level = SIMD_LEVEL_SCALAR; level <= supportedLevel; ++level) {
+            const ColorConversionDesc desc = GetDesc(width, height, COLOR_MATRIX_BT709,
+                static_cast<YUVFormat>(format), static_cast<SIMDLevel>(level));
+            ColorConversion::Convert(desc, rgba.data(), expected.data(), nullptr);
+            ColorConversion::Convert(desc, rgba.data(), actual.data(), &jobSystem);
+            Check(actual == expected, GetCaseName(desc));
+        }
+    }
+
+    jobSystem.CleanUp();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//RGBAToYUV.comp produces the same bytes as the CPU
+void ColorConversionTests::TestComputeShader() {
+    m_testName = "ComputeShader";
+
+    const uint32_t width = 64;
+    const uint32_t height = 34;
+    std::vector<uint8_t> rgba;
+    GenerateFrameInto(width, height, width * 4, &rgba);
+    std::vector<uint8_t> expected(ColorConversion::GetYUVSize(width, height));
+    std::vector<uint8_t> actual;
+    for (uint32_t matrix = COLOR_MATRIX_BT601; matrix <= COLOR_MATRIX_BT709; ++matrix) {
+        for (uint32_t format = YUV_FORMAT_I420; format <= YUV_FORMAT_NV12; ++format) {
+            const ColorConversionDesc desc = GetDesc(width, height, static_cast<ColorMatrix>(matrix),
+                static_cast<YUVFormat>(format), SIMD_LEVEL_SCALAR);
+            ColorConversion::Convert(desc, rgba.data(), expected.data(), nullptr);
+            ConvertOnGPUInto(desc, rgba, &actual);
+            Check(actual == expected, std::string(COLOR_MATRIX_NAMES[desc.Matrix]) + " "
+                + YUV_FORMAT_NAMES[desc.Format]);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Uploads the tightly packed rgba, converts it, and waits for the conversion
+void ColorConversionTests::ConvertOnGPUInto(const ColorConversionDesc& desc, const std::vector<uint8_t>& rgba,
+    std::vector<uint8_t>* yuv) const
+{
+    const VkExtent2D extent = { desc.Width, desc.Height };
+    const VkFormat imageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    const VkMemoryPropertyFlags hostMemoryProperties =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    ColorConversionPass pass;
+    pass.Init(m_device, nullptr, RGBA_TO_YUV_SHADER_PATH, desc.Matrix, desc.Format, 1);
+
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+    const VkDeviceSize rgbaSize = static_cast<VkDeviceSize>(rgba.size());
+    GraphicsUtility::CreateBuffer(m_physicalDevice, m_device, nullptr, rgbaSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        hostMemoryProperties, &stagingBuffer, &stagingMemory);
+    GraphicsUtility::CopyCPUDataToBuffer(m_device, rgba.data(), stagingMemory, rgbaSize);
+
+    VkBuffer outputBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory outputMemory = VK_NULL_HANDLE;
+    const VkDeviceSize yuvSize = ColorConversionPass::GetOutputSize(extent);
+    GraphicsUtility::CreateBuffer(m_physicalDevice, m_device, nullptr, yuvSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        hostMemoryProperties, &outputBuffer, &outputMemory);
+
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+    GraphicsUtility::CreateImage(m_physicalDevice, m_device, nullptr, desc.Width, desc.Height,
+        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, imageFormat, &image, &imageMemory);
+    const VkImageView imageView = GraphicsUtility::CreateImageView(m_device, nullptr, image, imageFormat);
+    const VkSampler sampler = GraphicsUtility::CreateSampler(m_device, nullptr);
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = m_queueFamilyIndex;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create command pool!");
+    }
+
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    GraphicsUtility::BeginOneTimeCommandBufferInto(m_device, commandPool, &commandBuffer);
+    RecordImageBarrier(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    VkBufferImageCopy region = {};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { desc.Width, desc.Height, 1 };
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    RecordImageBarrier(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    pass.Record(m_device, commandBuffer, 0, imageView, sampler, outputBuffer, extent);
+
+    VkBufferMemoryBarrier outputBarrier = {};
+    outputBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    outputBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    outputBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    outputBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    outputBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    outputBarrier.buffer = outputBuffer;
+    outputBarrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+        0, nullptr, 1, &outputBarrier, 0, nullptr);
+    GraphicsUtility::EndAndSubmitOneTimeCommandBuffer(m_device, commandPool, m_queue, commandBuffer);
+
+    void* data = nullptr;
+    if (vkMapMemory(m_device, outputMemory, 0, yuvSize, 0, &data) != VK_SUCCESS) {
+        throw std::runtime_error("failed to map the converted frame!");
+    }
+    yuv->resize(static_cast<size_t>(yuvSize));
+    memcpy(yuv->data(), data, yuv->size());
+    vkUnmapMemory(m_device, outputMemory);
+
+    vkDestroyCommandPool(m_device, commandPool, nullptr);
+    vkDestroySampler(m_device, sampler, nullptr);
+    vkDestroyImageView(m_device, imageView, nullptr);
+    vkDestroyImage(m_device, image, nullptr);
+    vkFreeMemory(m_device, imageMemory, nullptr);
+    vkDestroyBuffer(m_device, outputBuffer, nullptr);
+    vkFreeMemory(m_device, outputMemory, nullptr);
+    vkDestroyBuffer(m_device, stagingBuffer, nullptr);
+    vkFreeMemory(m_device, stagingMemory, nullptr);
+    pass.CleanUp(m_device, nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void ColorConversionTests::Check(const bool condition, const std::string& description) {
+    ++m_numChecks;
+    if (condition)
+        return;
+
+    ++m_numFailures;
+    std::cout << "FAILED ColorConversion " << m_testName << ": " << description << std::endl;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+std::string ColorConversionTests::GetCaseName(const ColorConversionDesc& desc) {
+    return std::string(COLOR_MATRIX_NAMES[desc.Matrix]) + " " + YUV_FORMAT_NAMES[desc.Format] + " "
+        + ColorConversion::GetSIMDLevelName(desc.SIMD);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+ColorConversionDesc ColorConversionTests::GetDesc(const uint32_t width, const uint32_t height,
+    const ColorMatrix matrix, const YUVFormat format, const SIMDLevel simd)
+{
+    ColorConversionDesc desc = {};
+    desc.Width = width;
+    desc.Height = height;
+    desc.SrcRowPitch = width * 4;
+    desc.Matrix = matrix;
+    desc.Format = format;
+    desc.SIMD = simd;
+    return desc;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Deterministic noise, so that neighbouring pixels differ. The padding of the rows is filled too
+void ColorConversionTests::GenerateFrameInto(const uint32_t width, const uint32_t height, const uint32_t rowPitch,
+    std::vector<uint8_t>* rgba)
+{
+    rgba->resize(static_cast<size_t>(rowPitch) * height);
+    uint32_t state = 0x12345678u ^ (width * 31 + height);
+    for (uint8_t& value : *rgba) {
+        state = state * 1664525u + 1013904223u;
+        value = static_cast<uint8_t>(state >> 24);
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//One sample at a time, without any of the shortcuts of ColorConversion
+void ColorConversionTests::ConvertReferenceInto(const ColorConversionDesc& desc, const std::vector<uint8_t>& rgba,
+    std::vector<uint8_t>* yuv)
+{
+    const uint32_t width = desc.Width;
+    const uint32_t height = desc.Height;
+    const uint32_t chromaWidth = (width + 1) / 2;
+    const uint32_t chromaHeight = (height + 1) / 2;
+    const int (*k)[3] = REFERENCE_COEFFICIENTS[desc.Matrix];
+
+    yuv->assign(ColorConversion::GetYUVSize(width, height), 0);
+    uint8_t* yPlane = yuv->data();
+    uint8_t* uPlane = yPlane + static_cast<size_t>(width) * height;
+    uint8_t* vPlane = uPlane + static_cast<size_t>(chromaWidth) * chromaHeight;
+
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const uint8_t* pixel = &rgba[static_cast<size_t>(y) * desc.SrcRowPitch + x * 4];
+            const int rgb[3] = { pixel[0], pixel[1], pixel[2] };
+            yPlane[static_cast<size_t>(y) * width + x] = ApplyCoefficients(k[0], rgb, 16);
+        }
+    }
+
+    for (uint32_t cy = 0; cy < chromaHeight; ++cy) {
+        for (uint32_t cx = 0; cx < chromaWidth; ++cx) {
+            int sum[3] = {};
+            for (uint32_t i = 0; i < 4; ++i) {
+                const uint32_t x = std::min(cx * 2 + (i & 1), width - 1);
+                const uint32_t y = std::min(cy * 2 + (i >> 1), height - 1);
+                const uint8_t* pixel = &rgba[static_cast<size_t>(y) * desc.SrcRowPitch + x * 4];
+                for (uint32_t c = 0; c < 3; ++c) {
+                    sum[c] += pixel[c];
+                }
+            }
+
+            const int rgb[3] = { (sum[0] + 2) >> 2, (sum[1] + 2) >> 2, (sum[2] + 2) >> 2 };
+            const uint8_t u = ApplyCoefficients(k[1], rgb, 128);
+            const uint8_t v = ApplyCoefficients(k[2], rgb, 128);
+            const size_t chromaIndex = static_cast<size_t>(cy) * chromaWidth + cx;
+            if (YUV_FORMAT_NV12 == desc.Format) {
+                uPlane[chromaIndex * 2] = u;
+                uPlane[chromaIndex * 2 + 1] = v;
+            } else {
+                uPlane[chromaIndex] = u;
+                vPlane[chromaIndex] = v;
+            }
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Shin/ColorConversion.h"
+
+//Converts small frames on the CPU with every supported SIMD level, on one thread and on a JobSystem, and with the
+//RGBAToYUV compute shader on the test device. Solid colors are checked against hand-computed values, and the other
+//frames against a straightforward per-pixel conversion
+class ColorConversionTests {
+public:
+    ColorConversionTests(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkQueue queue,
+        const uint32_t queueFamilyIndex);
+
+    //Returns the number of failed checks
+    uint32_t Run();
+
+private:
+    void TestSolidColors();
+    void TestOddSizes();
+    void TestJobSystem();
+    void TestComputeShader();
+
+    void ConvertOnGPUInto(const Shin::ColorConversionDesc& desc, const std::vector<uint8_t>& rgba,
+        std::vector<uint8_t>* yuv) const;
+    void Check(const bool condition, const std::string& description);
+
+    static std::string GetCaseName(const Shin::ColorConversionDesc& desc);
+    static Shin::ColorConversionDesc GetDesc(const uint32_t width, const uint32_t height,
+        const Shin::ColorMatrix matrix, const Shin::YUVFormat format, const Shin::SIMDLevel simd);
+    static void GenerateFrameInto(const uint32_t width, const uint32_t height, const uint32_t rowPitch,
+        std::vector<uint8_t>* rgba);
+    static void ConvertReferenceInto(const Shin::ColorConversionDesc& desc, const std::vector<uint8_t>& rgba,
+        std::vector<uint8_t>* yuv);
+
+    VkPhysicalDevice    m_physicalDevice;
+    VkDevice            m_device;
+    VkQueue             m_queue;
+    uint32_t            m_queueFamilyIndex;
+
+    const char*         m_testName;
+    uint32_t            m_numChecks;
+    uint32_t            m_numFailures;
+};
@@ -0,0 +1,189 @@
+#include "NvEncoderTests.h"
+
+#include <iostream>  //cout
+#include <stdexcept> //std::exception
+#include <thread>    //yield
+#include <vector>
+
+#include "NvEncoder.h"
+#include "FakeNvEncodeApi.h"
+#include "Cuda/CudaApi.h"
+#include "Cuda/FakeCudaApi.h"
+#include "Cuda/CudaContext.h"
+#include "Cuda/CudaImage.h"
+
+const uint32_t TEST_ENCODER_WIDTH = 320;
+const uint32_t TEST_ENCODER_HEIGHT = 240;
+const uint32_t TEST_ENCODER_NUM_INPUTS = 3;
+const uint32_t TEST_ENCODER_NUM_FRAMES = 24;
+
+//A CudaContext, and an NvEncoder with its inputs registered, like NvEncodingApp
+struct EncoderSession {
+    CudaContext             Context;
+    std::vector<CudaImage>  Images;
+    NvEncoder               Encoder;
+};
+
+static void InitSession(const NV_ENCODE_API_FUNCTION_LIST& nvenc, EncoderSession* session) {
+    const VkExtent2D extent = { TEST_ENCODER_WIDTH, TEST_ENCODER_HEIGHT };
+    const VkDeviceSize imageSize = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+    session->Context.InitWithDeviceUUID(FakeCudaApi::GetDeviceUUID());
+
+    //FakeCudaApi doesn't use the exported handles
+    session->Images.resize(TEST_ENCODER_NUM_INPUTS);
+    for (uint32_t i = 0; i < TEST_ENCODER_NUM_INPUTS; ++i) {
+        session->Images[i].InitWithHandle(reinterpret_cast<void*>(static_cast<uintptr_t>(i + 1)), imageSize, extent);
+    }
+
+    session->Encoder.SetApi(nvenc);
+    session->Encoder.Init(NV_ENC_DEVICE_TYPE_CUDA, session->Context.GetContext(), extent.width, extent.height);
+    session->Encoder.CreateBuffers(TEST_ENCODER_NUM_INPUTS);
+    for (uint32_t i = 0; i < TEST_ENCODER_NUM_INPUTS; ++i) {
+        FrameEncoderInput input = {};
+        input.Type = FRAME_ENCODER_INPUT_TYPE_CUDA_ARRAY;
+        input.Resource = session->Images[i].GetArray();
+        session->Encoder.RegisterInput(i, input);
+    }
+}
+
+static void CleanUpSession(EncoderSession* session) {
+    session->Encoder.DestroyBuffers();
+    session->Encoder.CleanUp();
+    for (CudaImage& image : session->Images) {
+        image.CleanUp();
+    }
+    session->Images.clear();
+    session->Context.CleanUp();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+NvEncoderTests::NvEncoderTests() : m_testName(""), m_numChecks(0), m_numFailures(0)
+{
+    m_nvenc = { NV_ENCODE_API_FUNCTION_LIST_VER };
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t NvEncoderTests::Run() {
+    m_numChecks = 0;
+    m_numFailures = 0;
+
+    CudaFunctionList cuda = {};
+    FakeCudaApi::FillFunctionList(&cuda);
+    CudaApi::SetFunctionList(cuda);
+
+    FakeNvEncodeParams fakeParams = {};
+    fakeParams.EncodeLatencyMs = 2.0f;
+    fakeParams.BitstreamSize = 1024;
+    fakeParams.KeyFrameBitstreamSize = 8192;
+    fakeParams.AsyncEncodeSupported = true;
+    FakeNvEncodeApi::FillFunctionList(fakeParams, &m_nvenc);
+
+    TestInputsStayMapped();
+    TestDestroyBuffersWhileEncoding();
+
+    std::cout << "NvEncoder: " << (m_numChecks - m_numFailures) << "/" << m_numChecks << " checks passed"
+        << std::endl;
+    return m_numFailures;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//The inputs are mapped once, when they are registered, and stay mapped while frames are encoded from them, even
+//when the encoded size changes
+void NvEncoderTests::TestInputsStayMapped() {
+    m_testName = "InputsStayMapped";
+    FakeNvEncodeApi::ResetCounters();
+
+    EncoderSession session;
+    InitSession(m_nvenc, &session);
+    const FakeNvEncodeCounters registeredCounters = FakeNvEncodeApi::GetCounters();
+    Check(TEST_ENCODER_NUM_INPUTS == registeredCounters.NumMappedResources,
+        "each input is mapped when it is registered");
+
+    //Like NvEncodingApp: Reconfigure() before each frame, and one input per frame in flight
+    NvEncoder& encoder = session.Encoder;
+    uint32_t numFramesInFlight = 0;
+    std::vector<uint8_t> bitstream;
+    for (uint32_t frame = 0; frame < TEST_ENCODER_NUM_FRAMES; ++frame) {
+        const uint32_t scale = (frame < TEST_ENCODER_NUM_FRAMES / 2) ? 1 : 2;
+        encoder.Reconfigure(TEST_ENCODER_WIDTH / scale, TEST_ENCODER_HEIGHT / scale);
+
+        const uint64_t numDroppedFrames = encoder.GetNumDroppedFrames();
+        encoder.EncodeFrame(frame % TEST_ENCODER_NUM_INPUTS);
+        if (encoder.GetNumDroppedFrames() == numDroppedFrames) {
+            ++numFramesInFlight;
+        }
+
+        while (true) {
+            while (encoder.RetrieveBitstream(&bitstream)) {
+                --numFramesInFlight;
+            }
+            if (numFramesInFlight < TEST_ENCODER_NUM_INPUTS)
+                break;
+            std::this_thread::yield();
+        }
+    }
+
+    const FakeNvEncodeCounters counters = FakeNvEncodeApi::GetCounters();
+    Check(registeredCounters.NumMappedResources == counters.NumMappedResources, "no input is mapped while encoding");
+    Check(0 == counters.NumUnmappedResources, "no input is unmapped while encoding");
+    Check(1 == counters.NumReconfigurations, "the size change reconfigures the encoder once");
+    Check(0 == encoder.GetNumDroppedFrames(), "no frame is dropped while an input is free");
+
+    try {
+        CleanUpSession(&session);
+    } catch (const std::exception& e) {
+        Check(false, std::string("cleaned up without errors: ") + e.what());
+    }
+    CheckReleased();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//DestroyBuffers() waits for the pictures which are still being encoded before it unmaps their inputs: the driver
+//fails to unmap an input which is being encoded
+void NvEncoderTests::TestDestroyBuffersWhileEncoding() {
+    m_testName = "DestroyBuffersWhileEncoding";
+    FakeNvEncodeApi::ResetCounters();
+
+    EncoderSession session;
+    InitSession(m_nvenc, &session);
+    for (uint32_t i = 0; i < TEST_ENCODER_NUM_INPUTS; ++i) {
+        session.Encoder.EncodeFrame(i);
+    }
+
+    try {
+        CleanUpSession(&session);
+    } catch (const std::exception& e) {
+        Check(false, std::string("cleaned up without errors: ") + e.what());
+    }
+
+    const FakeNvEncodeCounters counters = FakeNvEncodeApi::GetCounters();
+    Check(TEST_ENCODER_NUM_INPUTS == counters.NumEncodedPictures, "the pending pictures are encoded");
+    Check(TEST_ENCODER_NUM_INPUTS == counters.NumUnmappedResources, "every input is unmapped");
+    CheckReleased();
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//After a session has been cleaned up
+void NvEncoderTests::CheckReleased() {
+    const FakeNvEncodeCounters counters = FakeNvEncodeApi::GetCounters();
+    Check(counters.NumRegisteredResources == counters.NumUnregisteredResources,
+        "every registered resource is unregistered");
+    Check(counters.NumMappedResources == counters.NumUnmappedResources, "every mapped input is unmapped");
+    Check(0 == FakeCudaApi::GetNumLiveObjects(), "every CUDA object is destroyed");
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void NvEncoderTests::Check(const bool condition, const std::string& description) {
+    ++m_numChecks;
+    if (condition)
+        return;
+
+    ++m_numFailures;
+    std::cout << "FAILED NvEncoder " << m_testName << ": " << description << std::endl;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include "nvEncodeAPI.h"
+
+//Runs NvEncoder on FakeNvEncodeApi and FakeCudaApi, without a GPU, and checks the driver calls which it makes:
+//the inputs are mapped once, when they are registered, and every registered or mapped resource and every CUDA
+//object is released again
+class NvEncoderTests {
+public:
+    NvEncoderTests();
+
+    //Returns the number of failed checks
+    uint32_t Run();
+
+private:
+    void TestInputsStayMapped();
+    void TestDestroyBuffersWhileEncoding();
+
+    void CheckReleased();
+    void Check(const bool condition, const std::string& description);
+
+    NV_ENCODE_API_FUNCTION_LIST m_nvenc;
+
+    const char*         m_testName;
+    uint32_t            m_numChecks;
+    uint32_t            m_numFailures;
+};
@@ -0,0 +1,290 @@
+#include "RenderGraphTests.h"
+
+#include <iostream> //cout
+
+using namespace Shin;
+
+const VkFormat TEST_IMAGE_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+const VkExtent2D TEST_IMAGE_EXTENT = { 64, 64 };
+
+static void ExecuteNothing(const VkCommandBuffer) {
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+RenderGraphTests::RenderGraphTests(const VkPhysicalDevice physicalDevice, const VkDevice device)
+    : m_physicalDevice(physicalDevice), m_device(device), m_testName(""), m_numChecks(0), m_numFailures(0)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+uint32_t RenderGraphTests::Run() {
+    m_numChecks = 0;
+    m_numFailures = 0;
+
+    TestCullUnreadPasses();
+    TestCullPassesWithoutWrites();
+    TestBarriers();
+    TestTransientAliasing();
+    TestRecompile();
+
+    std::cout << "RenderGraph: " << (m_numChecks - m_numFailures) << "/" << m_numChecks << " checks passed"
+        << std::endl;
+    return m_numFailures;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Passes whose writes are never read are culled, and so are the passes which were only read by culled passes
+void RenderGraphTests::TestCullUnreadPasses() {
+    m_testName = "CullUnreadPasses";
+
+    const RenderGraphResource out = m_graph.ImportBuffer("Out", VK_NULL_HANDLE, 0, 0,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+    const RenderGraphResource a = m_graph.CreateImage("A", TEST_IMAGE_FORMAT, TEST_IMAGE_EXTENT);
+    const RenderGraphResource b = m_graph.CreateImage("B", TEST_IMAGE_FORMAT, TEST_IMAGE_EXTENT);
+    const RenderGraphResource c = m_graph.CreateImage("C", TEST_IMAGE_FORMAT, TEST_IMAGE_EXTENT);
+    const RenderGraphResource d = m_graph.CreateImage("D", TEST_IMAGE_FORMAT, TEST_IMAGE_EXTENT);
+
+    const uint32_t writeA = m_graph.AddPass("WriteA", ExecuteNothing);
+    m_graph.AddWrite(writeA, a, RENDER_GRAPH_ACCESS_COMPUTE_SHADER_WRITE);
+    const uint32_t copyAToOut = m_graph.AddPass("CopyAToOut", ExecuteNothing);
+    m_graph.AddRead(copyAToOut, a, RENDER_GRAPH_ACCESS_TRANSFER_READ);
+    m_graph.AddWrite(copyAToOut, out, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    const uint32_t copyAToB = m_graph.AddPass("CopyAToB", ExecuteNothing);
+    m_graph.AddRead(copyAToB, a, RENDER_GRAPH_ACCESS_TRANSFER_READ);
+    m_graph.AddWrite(copyAToB, b, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    const uint32_t writeC = m_graph.AddPass("WriteC", ExecuteNothing);
+    m_graph.AddWrite(writeC, c, RENDER_GRAPH_ACCESS_COMPUTE_SHADER_WRITE);
+    const uint32_t copyCToD = m_graph.AddPass("CopyCToD", ExecuteNothing);
+    m_graph.AddRead(copyCToD, c, RENDER_GRAPH_ACCESS_TRANSFER_READ);
+    m_graph.AddWrite(copyCToD, d, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    Compile();
+
+    Check(!m_graph.IsPassCulled(writeA), "a pass read by a kept pass is kept");
+    Check(!m_graph.IsPassCulled(copyAToOut), "a pass writing an imported resource is kept");
+    Check(m_graph.IsPassCulled(copyAToB), "a pass whose write is not read is culled");
+    Check(m_graph.IsPassCulled(copyCToD), "a pass whose write is not read is culled");
+    Check(m_graph.IsPassCulled(writeC), "a pass only read by a culled pass is culled");
+    Check(VK_NULL_HANDLE == m_graph.GetImage(c), "the images of culled passes are not created");
+
+    m_graph.CleanUp(m_device, nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Passes without any write are culled even if every resource is read
+void RenderGraphTests::TestCullPassesWithoutWrites() {
+    m_testName = "CullPassesWithoutWrites";
+
+    const RenderGraphResource in = m_graph.ImportBuffer("In", VK_NULL_HANDLE,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT, 0, 0);
+    const RenderGraphResource out = m_graph.ImportBuffer("Out", VK_NULL_HANDLE, 0, 0,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+    const RenderGraphResource a = m_graph.CreateImage("A", TEST_IMAGE_FORMAT, TEST_IMAGE_EXTENT);
+
+    const uint32_t writeA = m_graph.AddPass("WriteA", ExecuteNothing);
+    m_graph.AddWrite(writeA, a, RENDER_GRAPH_ACCESS_COMPUTE_SHADER_WRITE);
+    const uint32_t readA = m_graph.AddPass("ReadA", ExecuteNothing);
+    m_graph.AddRead(readA, a, RENDER_GRAPH_ACCESS_COMPUTE_SHADER_READ);
+    const uint32_t readIn = m_graph.AddPass("ReadIn", ExecuteNothing);
+    m_graph.AddRead(readIn, in, RENDER_GRAPH_ACCESS_COMPUTE_SHADER_READ);
+    const uint32_t empty = m_graph.AddPass("Empty", ExecuteNothing);
+    const uint32_t writeOut = m_graph.AddPass("WriteOut", ExecuteNothing);
+    m_graph.AddRead(writeOut, in, RENDER_GRAPH_ACCESS_TRANSFER_READ);
+    m_graph.AddWrite(writeOut, out, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    Compile();
+
+    Check(m_graph.IsPassCulled(readA), "a pass reading a transient image without writing is culled");
+    Check(m_graph.IsPassCulled(writeA), "a pass only read by a pass without writes is culled");
+    Check(m_graph.IsPassCulled(readIn), "a pass reading an imported buffer without writing is culled");
+    Check(m_graph.IsPassCulled(empty), "a pass without any usage is culled");
+    Check(!m_graph.IsPassCulled(writeOut), "a pass writing an imported resource is kept");
+
+    m_graph.CleanUp(m_device, nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Layout transitions, RAW and WAW hazards, reads which already waited for the last write, and the final states of
+//the imported resources
+void RenderGraphTests::TestBarriers() {
+    m_testName = "Barriers";
+
+    const RenderGraphResource in = m_graph.ImportBuffer("In", VK_NULL_HANDLE,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT, 0, 0);
+    const RenderGraphResource out = m_graph.ImportBuffer("Out", VK_NULL_HANDLE, 0, 0,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+    const RenderGraphResource target = m_graph.ImportImage("Target", VK_NULL_HANDLE, 0, VK_NULL_HANDLE,
+        TEST_IMAGE_FORMAT, TEST_IMAGE_EXTENT, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    const RenderGraphResource a = m_graph.CreateImage("A", TEST_IMAGE_FORMAT, TEST_IMAGE_EXTENT);
+
+    const uint32_t compute = m_graph.AddPass("Compute", ExecuteNothing);
+    m_graph.AddRead(compute, in, RENDER_GRAPH_ACCESS_COMPUTE_SHADER_READ);
+    m_graph.AddWrite(compute, a, RENDER_GRAPH_ACCESS_COMPUTE_SHADER_WRITE);
+    const uint32_t copy0 = m_graph.AddPass("Copy0", ExecuteNothing);
+    m_graph.AddRead(copy0, a, RENDER_GRAPH_ACCESS_TRANSFER_READ);
+    m_graph.AddWrite(copy0, out, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    const uint32_t copy1 = m_graph.AddPass("Copy1", ExecuteNothing);
+    m_graph.AddRead(copy1, a, RENDER_GRAPH_ACCESS_TRANSFER_READ);
+    m_graph.AddWrite(copy1, out, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    m_graph.AddWrite(copy1, target, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    Compile();
+
+    const VkImage image = m_graph.GetImage(a);
+    const RenderGraph::Barriers& computeBarriers = m_graph.GetBarriers(compute);
+    Check(HasBufferBarrier(computeBarriers, VK_ACCESS_HOST_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT),
+        "a read waits for the initial write of an imported buffer");
+    Check(HasImageBarrier(computeBarriers, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL),
+        "the first write of a transient image discards its contents");
+    Check((VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT) == computeBarriers.SrcStages
+        && VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT == computeBarriers.DstStages,
+        "the stages of the first barriers are batched");
+
+    const RenderGraph::Barriers& copy0Barriers = m_graph.GetBarriers(copy0);
+    Check(1 == copy0Barriers.ImageBarriers.size()
+        && HasImageBarrier(copy0Barriers, image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+        && (VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT) == copy0Barriers.ImageBarriers[0].srcAccessMask,
+        "a read waits for the compute write and changes the layout");
+    Check(copy0Barriers.BufferBarriers.empty(), "the first write of an unused imported buffer doesn't wait");
+    Check(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT == copy0Barriers.SrcStages
+        && VK_PIPELINE_STAGE_TRANSFER_BIT == copy0Barriers.DstStages,
+        "the copy waits for the compute pass only");
+
+    const RenderGraph::Barriers& copy1Barriers = m_graph.GetBarriers(copy1);
+    Check(!HasImageBarrier(copy1Barriers, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL), "a read which already waited for the last write doesn't wait again");
+    Check(HasBufferBarrier(copy1Barriers, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT),
+        "a write waits for the previous write");
+    Check(HasImageBarrier(copy1Barriers, m_graph.GetImage(target), VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL), "an imported image is transitioned from its initial layout");
+
+    const RenderGraph::Barriers& finalBarriers = m_graph.GetFinalBarriers();
+    Check(1 == finalBarriers.BufferBarriers.size()
+        && HasBufferBarrier(finalBarriers, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT),
+        "only the imported buffer with a final access waits for the last write");
+    Check(1 == finalBarriers.ImageBarriers.size()
+        && HasImageBarrier(finalBarriers, m_graph.GetImage(target), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL), "an imported image is transitioned to its final layout");
+    Check((VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) == finalBarriers.DstStages,
+        "the final barriers wait for the final stages");
+
+    m_graph.CleanUp(m_device, nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//A, B and C are used in turn, and only the lifetimes of A and C don't overlap: both are bound at offset 0 of the
+//same memory block. The first use of C has to wait for the last use of A, which is a fragment shader read
+void RenderGraphTests::TestTransientAliasing() {
+    m_testName = "TransientAliasing";
+
+    const RenderGraphResource out = m_graph.ImportBuffer("Out", VK_NULL_HANDLE, 0, 0,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+    const RenderGraphResource a = m_graph.CreateImage("A", TEST_IMAGE_FORMAT, TEST_IMAGE_EXTENT);
+    const RenderGraphResource b = m_graph.CreateImage("B", TEST_IMAGE_FORMAT, TEST_IMAGE_EXTENT);
+    const RenderGraphResource c = m_graph.CreateImage("C", TEST_IMAGE_FORMAT, TEST_IMAGE_EXTENT);
+
+    const uint32_t writeA = m_graph.AddPass("WriteA", ExecuteNothing);
+    m_graph.AddWrite(writeA, a, RENDER_GRAPH_ACCESS_COMPUTE_SHADER_WRITE);
+    const uint32_t readAWriteB = m_graph.AddPass("ReadAWriteB", ExecuteNothing);
+    m_graph.AddRead(readAWriteB, a, RENDER_GRAPH_ACCESS_FRAGMENT_SHADER_READ);
+    m_graph.AddWrite(readAWriteB, b, RENDER_GRAPH_ACCESS_COMPUTE_SHADER_WRITE);
+    const uint32_t copyBToC = m_graph.AddPass("CopyBToC", ExecuteNothing);
+    m_graph.AddRead(copyBToC, b, RENDER_GRAPH_ACCESS_TRANSFER_READ);
+    m_graph.AddWrite(copyBToC, c, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    const uint32_t copyCToOut = m_graph.AddPass("CopyCToOut", ExecuteNothing);
+    m_graph.AddRead(copyCToOut, c, RENDER_GRAPH_ACCESS_TRANSFER_READ);
+    m_graph.AddWrite(copyCToOut, out, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    Compile();
+
+    Check(m_graph.GetTransientMemorySize() < m_graph.GetUnaliasedTransientMemorySize(),
+        "images whose lifetimes don't overlap share memory");
+    Check(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT == m_graph.GetBarriers(writeA).SrcStages,
+        "the first image in a memory block doesn't wait");
+    Check((VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT)
+        == m_graph.GetBarriers(readAWriteB).SrcStages, "an image in another memory block doesn't wait for A");
+
+    const RenderGraph::Barriers& copyBarriers = m_graph.GetBarriers(copyBToC);
+    Check(HasImageBarrier(copyBarriers, m_graph.GetImage(c), VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL), "the first use of an aliased image discards its contents");
+    Check((VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) == copyBarriers.SrcStages,
+        "the first use of an aliased image waits for the last use of the previous image in the block");
+
+    m_graph.CleanUp(m_device, nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+//Compiling the same graph again gives the same barriers and the same transient memory, instead of adding to them
+void RenderGraphTests::TestRecompile() {
+    m_testName = "Recompile";
+
+    const RenderGraphResource out = m_graph.ImportBuffer("Out", VK_NULL_HANDLE, 0, 0,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+    const RenderGraphResource a = m_graph.CreateImage("A", TEST_IMAGE_FORMAT, TEST_IMAGE_EXTENT);
+
+    const uint32_t writeA = m_graph.AddPass("WriteA", ExecuteNothing);
+    m_graph.AddWrite(writeA, a, RENDER_GRAPH_ACCESS_COMPUTE_SHADER_WRITE);
+    const uint32_t copyAToOut = m_graph.AddPass("CopyAToOut", ExecuteNothing);
+    m_graph.AddRead(copyAToOut, a, RENDER_GRAPH_ACCESS_TRANSFER_READ);
+    m_graph.AddWrite(copyAToOut, out, RENDER_GRAPH_ACCESS_TRANSFER_WRITE);
+    Compile();
+
+    const size_t numImageBarriers = m_graph.GetBarriers(copyAToOut).ImageBarriers.size();
+    const size_t numFinalBarriers = m_graph.GetFinalBarriers().BufferBarriers.size();
+    const VkDeviceSize memorySize = m_graph.GetTransientMemorySize();
+    Compile();
+
+    Check(numImageBarriers == m_graph.GetBarriers(copyAToOut).ImageBarriers.size(),
+        "the barriers of a pass are not added again");
+    Check(numFinalBarriers == m_graph.GetFinalBarriers().BufferBarriers.size(),
+        "the final barriers are not added again");
+    Check(memorySize == m_graph.GetTransientMemorySize(), "the transient memory is allocated again, not added");
+    Check(VK_NULL_HANDLE != m_graph.GetImage(a), "the transient images are created again");
+
+    m_graph.CleanUp(m_device, nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraphTests::Compile() {
+    m_graph.Compile(m_physicalDevice, m_device, nullptr);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void RenderGraphTests::Check(const bool condition, const char* description) {
+    ++m_numChecks;
+    if (condition)
+        return;
+
+    ++m_numFailures;
+    std::cout << "FAILED RenderGraph " << m_testName << ": " << description << std::endl;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool RenderGraphTests::HasImageBarrier(const RenderGraph::Barriers& barriers, const VkImage image,
+        const VkImageLayout oldLayout, const VkImageLayout newLayout)
+{
+    for (const VkImageMemoryBarrier& barrier : barriers.ImageBarriers) {
+        if (barrier.image == image && barrier.oldLayout == oldLayout && barrier.newLayout == newLayout)
+            return true;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+bool RenderGraphTests::HasBufferBarrier(const RenderGraph::Barriers& barriers, const VkAccessFlags srcAccess,
+        const VkAccessFlags dstAccess)
+{
+    for (const VkBufferMemoryBarrier& barrier : barriers.BufferBarriers) {
+        if (barrier.srcAccessMask == srcAccess && barrier.dstAccessMask == dstAccess)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+
+#include "Shin/RenderGraph.h"
+
+//Compiles small graphs and checks which passes are culled, the barriers before and after the passes, and which
+//transient images share memory. The graphs only use compute and transfer passes, so that no render pass is created,
+//and are never recorded: the imported resources are VK_NULL_HANDLE
+class RenderGraphTests {
+public:
+    RenderGraphTests(const VkPhysicalDevice physicalDevice, const VkDevice device);
+
+    //Returns the number of failed checks
+    uint32_t Run();
+
+private:
+    void TestCullUnreadPasses();
+    void TestCullPassesWithoutWrites();
+    void TestBarriers();
+    void TestTransientAliasing();
+    void TestRecompile();
+
+    void Compile();
+    void Check(const bool condition, const char* description);
+
+    static bool HasImageBarrier(const Shin::RenderGraph::Barriers& barriers, const VkImage image,
+        const VkImageLayout oldLayout, const VkImageLayout newLayout);
+    static bool HasBufferBarrier(const Shin::RenderGraph::Barriers& barriers, const VkAccessFlags srcAccess,
+        const VkAccessFlags dstAccess);
+
+    VkPhysicalDevice    m_physicalDevice;
+    VkDevice            m_device;
+    Shin::RenderGraph   m_graph;
+
+    const char*         m_testName;
+    uint32_t            m_numChecks;
+    uint32_t            m_numFailures;
+};
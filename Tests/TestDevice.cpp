@@ -0,0 +1,90 @@
+#include "TestDevice.h"
+
+#include <stdexcept> //std::runtime_error
+#include <vector>
+
+//---------------------------------------------------------------------------------------------------------------------
+
+TestDevice::TestDevice() : m_instance(VK_NULL_HANDLE), m_physicalDevice(VK_NULL_HANDLE), m_device(VK_NULL_HANDLE)
+    , m_queue(VK_NULL_HANDLE), m_queueFamilyIndex(UINT32_MAX)
+{
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void TestDevice::Init(const uint32_t deviceIndex) {
+    VkApplicationInfo appInfo = {};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "Tests";
+    appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.pEngineName = "No Engine";
+    appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.apiVersion = VK_API_VERSION_1_0;
+
+    VkInstanceCreateInfo instanceInfo = {};
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pApplicationInfo = &appInfo;
+    if (vkCreateInstance(&instanceInfo, nullptr, &m_instance) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create instance!");
+    }
+
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(m_instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(m_instance, &deviceCount, devices.data());
+    const uint32_t index = (UINT32_MAX == deviceIndex) ? 0 : deviceIndex;
+    if (index >= deviceCount) {
+        throw std::runtime_error("failed to find GPUs with Vulkan support!");
+    }
+    m_physicalDevice = devices[index];
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+    m_deviceName = properties.deviceName;
+
+    //Compute queues also support transfers
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, queueFamilies.data());
+    for (uint32_t i = 0; i < queueFamilyCount && UINT32_MAX == m_queueFamilyIndex; ++i) {
+        if (queueFamilies[i].queueCount > 0 && (queueFamilies[i].queueFlags & VK_QUEUE_COMPUTE_BIT)) {
+            m_queueFamilyIndex = i;
+        }
+    }
+    if (UINT32_MAX == m_queueFamilyIndex) {
+        throw std::runtime_error("failed to find a compute queue family!");
+    }
+
+    const float queuePriority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = m_queueFamilyIndex;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &queuePriority;
+
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    deviceInfo.queueCreateInfoCount = 1;
+    if (vkCreateDevice(m_physicalDevice, &deviceInfo, nullptr, &m_device) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create logical device!");
+    }
+    vkGetDeviceQueue(m_device, m_queueFamilyIndex, 0, &m_queue);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+void TestDevice::CleanUp() {
+    if (VK_NULL_HANDLE != m_device) {
+        vkDestroyDevice(m_device, nullptr);
+        m_device = VK_NULL_HANDLE;
+    }
+    if (VK_NULL_HANDLE != m_instance) {
+        vkDestroyInstance(m_instance, nullptr);
+        m_instance = VK_NULL_HANDLE;
+    }
+    m_physicalDevice = VK_NULL_HANDLE;
+    m_queue = VK_NULL_HANDLE;
+    m_queueFamilyIndex = UINT32_MAX;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <string>
+
+//A headless instance and device without any extension, for the tests which need to create Vulkan objects.
+//The queue supports compute and transfer, for the tests which submit work. Any device will do, e.g. lavapipe on
+//machines without a GPU
+class TestDevice {
+public:
+    TestDevice();
+
+    //deviceIndex: UINT32_MAX for the first device
+    void Init(const uint32_t deviceIndex);
+    void CleanUp();
+
+    inline VkPhysicalDevice GetPhysicalDevice() const;
+    inline VkDevice GetDevice() const;
+    inline VkQueue GetQueue() const;
+    inline uint32_t GetQueueFamilyIndex() const;
+    inline const std::string& GetDeviceName() const;
+
+private:
+    VkInstance          m_instance;
+    VkPhysicalDevice    m_physicalDevice;
+    VkDevice            m_device;
+    VkQueue             m_queue;
+    uint32_t            m_queueFamilyIndex;
+    std::string         m_deviceName;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+VkPhysicalDevice TestDevice::GetPhysicalDevice() const { return m_physicalDevice; }
+VkDevice TestDevice::GetDevice() const { return m_device; }
+VkQueue TestDevice::GetQueue() const { return m_queue; }
+uint32_t TestDevice::GetQueueFamilyIndex() const { return m_queueFamilyIndex; }
+const std::string& TestDevice::GetDeviceName() const { return m_deviceName; }
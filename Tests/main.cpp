@@ -0,0 +1,51 @@
+#include <iostream> //std::exception, EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>  //strcmp
+#include <cstdlib>  //atoi
+#include "TestDevice.h"
+#include "RenderGraphTests.h"
+#include "ColorConversionTests.h"
+#include "NvEncoderTests.h"
+
+static void PrintUsage() {
+    std::cout << "Usage: Tests [--device index]" << std::endl;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    uint32_t deviceIndex = UINT32_MAX;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (nullptr == value || 0 != strcmp(arg, "--device")) {
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+        deviceIndex = static_cast<uint32_t>(atoi(value));
+        ++i;
+    }
+
+    TestDevice device;
+    uint32_t numFailures = 0;
+    try {
+        device.Init(deviceIndex);
+        std::cout << "Device: " << device.GetDeviceName() << std::endl;
+
+        RenderGraphTests renderGraphTests(device.GetPhysicalDevice(), device.GetDevice());
+        numFailures += renderGraphTests.Run();
+
+        ColorConversionTests colorConversionTests(device.GetPhysicalDevice(), device.GetDevice(),
+            device.GetQueue(), device.GetQueueFamilyIndex());
+        numFailures += colorConversionTests.Run();
+
+        NvEncoderTests nvEncoderTests;
+        numFailures += nvEncoderTests.Run();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        device.CleanUp();
+        return EXIT_FAILURE;
+    }
+
+    device.CleanUp();
+    return (0 == numFailures) ? EXIT_SUCCESS : EXIT_FAILURE;
+}